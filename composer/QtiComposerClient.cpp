@@ -1552,19 +1552,23 @@ Error QtiComposerClient::CommandReader::postPresentDisplay(shared_ptr<Fence>* pr
     return Error::NONE;
   }
 
-  std::vector<Layer> layers;
-  std::vector<shared_ptr<Fence>> releaseFences;
-  layers.resize(count);
-  releaseFences.resize(count);
-  err = mClient.hwc_session_->GetReleaseFences(mDisplay, &count, layers.data(), &releaseFences);
+  mReleaseLayers.resize(count);
+  mReleaseFences.resize(count);
+  err = mClient.hwc_session_->GetReleaseFences(mDisplay, &count, mReleaseLayers.data(),
+                                               &mReleaseFences);
   if (err != HWC2_ERROR_NONE) {
     ALOGW("failed to get release fences");
-    layers.clear();
-    releaseFences.clear();
+    mReleaseLayers.clear();
+    mReleaseFences.clear();
     return Error::NONE;
   }
+  mReleaseLayers.resize(count);
+  mReleaseFences.resize(count);
   mWriter.setPresentFence(*presentFence);
-  mWriter.setReleaseFences(layers, releaseFences);
+  mWriter.setReleaseFences(mReleaseLayers, mReleaseFences);
+  // Keeps the capacity, drops the fence references until the next present.
+  mReleaseLayers.clear();
+  mReleaseFences.clear();
 
   return Error::NONE;
 }
@@ -337,6 +337,9 @@ class QtiComposerClient : public IQtiComposerClient {
     CommandWriter& mWriter;
     Display mDisplay;
     Layer mLayer;
+    // Reused across frames, the release fences of a present are written out right away.
+    std::vector<Layer> mReleaseLayers;
+    std::vector<shared_ptr<Fence>> mReleaseFences;
 
     // Buffer cache impl
     enum class BufferCache {
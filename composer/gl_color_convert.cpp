@@ -53,6 +53,16 @@ GLColorConvert* GLColorConvert::GetInstance(GLRenderTarget target, bool secure)
   return color_convert;
 }
 
+void GLColorConvert::WarmUp(GLRenderTarget target) {
+  GLColorConvertImpl* color_convert = new GLColorConvertImpl(target, false /* Non-secure */);
+  color_convert->SetWarmUp(true);
+  if (color_convert->Init() == 0) {
+    color_convert->Deinit();
+  }
+
+  delete color_convert;
+}
+
 void GLColorConvert::Destroy(GLColorConvert* intf) {
   GLColorConvertImpl* color_convert = static_cast<GLColorConvertImpl*>(intf);
   if (color_convert->Deinit() != 0) {
@@ -43,6 +43,9 @@ class GLColorConvert {
  public:
   static GLColorConvert* GetInstance(GLRenderTarget target, bool secure);
   static void Destroy(GLColorConvert* intf);
+  // Links the programs in a context of its own, for the program cache, without raising the
+  // priority of the calling thread.
+  static void WarmUp(GLRenderTarget target);
 
   virtual int Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
                    const GLRect &src_rect, const GLRect &dst_rect,
@@ -50,6 +53,7 @@ class GLColorConvert {
                    const shared_ptr<Fence> &dst_acquire_fence,
                    shared_ptr<Fence> *release_fence) = 0;
   virtual void Reset() = 0;
+  virtual EGLImageCacheStats GetImageCacheStats() const = 0;
  protected:
   virtual ~GLColorConvert() { }
 };
@@ -50,6 +50,9 @@ class GLColorConvertImpl : public GLColorConvert, public GLCommon {
   virtual int Init();
   virtual int Deinit();
   virtual void Reset();
+  virtual EGLImageCacheStats GetImageCacheStats() const {
+    return GLCommon::GetImageCacheStats();
+  }
  private:
   GLRenderTarget target_ = kTargetRGBA;
   bool secure_ = false;
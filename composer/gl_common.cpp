@@ -31,38 +31,26 @@
 #include <string>
 
 #include "gl_common.h"
+#include "engine.h"
 
 #define __CLASS__ "GLCommon"
 
 namespace sdm {
 
-GLuint GLCommon::LoadProgram(int vertex_entries, const char **vertex, int fragment_entries,
-                           const char **fragment) {
-  GLuint prog_id = glCreateProgram();
-
-  int vert_id = glCreateShader(GL_VERTEX_SHADER);
-  int frag_id = glCreateShader(GL_FRAGMENT_SHADER);
-
-  GL(glShaderSource(vert_id, vertex_entries, vertex, 0));
-  GL(glCompileShader(vert_id));
-  DumpShaderLog(vert_id);
-
-  GL(glShaderSource(frag_id, fragment_entries, fragment, 0));
-  GL(glCompileShader(frag_id));
-  DumpShaderLog(frag_id);
-
-  GL(glAttachShader(prog_id, vert_id));
-  GL(glAttachShader(prog_id, frag_id));
-
-  GL(glLinkProgram(prog_id));
-
-  GL(glDetachShader(prog_id, vert_id));
-  GL(glDetachShader(prog_id, frag_id));
+static uint32_t GetImageCacheCapacity() {
+  int capacity = 0;
+  Debug::GetProperty(EGL_IMAGE_CACHE_SIZE, &capacity);
+  return capacity > 0 ? UINT32(capacity) : EGLImageWrapper::kDefaultCapacity;
+}
 
-  GL(glDeleteShader(vert_id));
-  GL(glDeleteShader(frag_id));
+GLCommon::GLCommon() : image_wrapper_(GetImageCacheCapacity()) {
+}
 
-  return prog_id;
+GLuint GLCommon::LoadProgram(int vertex_entries, const char **vertex, int fragment_entries,
+                           const char **fragment) {
+  DTRACE_SCOPED();
+  // Shared with the tonemapper, restores the program from the persistent binary cache if present.
+  return engine_loadProgram(vertex_entries, vertex, fragment_entries, fragment);
 }
 
 void GLCommon::DumpShaderLog(int shader) {
@@ -169,7 +157,8 @@ void GLCommon::DestroyContext(GLContext* ctx) {
   EGL(eglMakeCurrent(ctx->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT));
   EGL(eglDestroySurface(ctx->egl_display, ctx->egl_surface));
   EGL(eglDestroyContext(ctx->egl_display, ctx->egl_context));
-  EGL(eglTerminate(ctx->egl_display));
+  // The default display is shared with the other GL users of the process, terminating it would
+  // pull it from under their contexts. It stays initialized for the life of the process.
 }
 
 void GLCommon::ClearCache() {
@@ -179,6 +168,10 @@ void GLCommon::ClearCache() {
 }
 
 void GLCommon::SetRealTimePriority() {
+  if (warm_up_) {
+    return;
+  }
+
   // same as composer thread
   struct sched_param param = {0};
   param.sched_priority = 2;
@@ -56,6 +56,7 @@ struct GLContext {
 
 class GLCommon {
  public:
+  GLCommon();
   virtual GLuint LoadProgram(int vertex_entries, const char **vertex, int fragment_entries,
                              const char **fragment);
   virtual void DumpShaderLog(int shader);
@@ -70,12 +71,17 @@ class GLCommon {
   virtual void ClearCache();
   virtual void SetRealTimePriority();
   virtual void SetViewport(const GLRect &dst_rect);
+  EGLImageCacheStats GetImageCacheStats() const { return image_wrapper_.GetStats(); }
+  // A context only created to link its programs ahead of time keeps the priority of the calling
+  // thread.
+  void SetWarmUp(bool warm_up) { warm_up_ = warm_up; }
 
  protected:
   virtual ~GLCommon() { }
 
  private:
   EGLImageWrapper image_wrapper_;
+  bool warm_up_ = false;
 };
 
 }  // namespace sdm
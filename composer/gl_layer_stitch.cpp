@@ -53,6 +53,16 @@ GLLayerStitch* GLLayerStitch::GetInstance(bool secure) {
   return layer_stitch;
 }
 
+void GLLayerStitch::WarmUp() {
+  GLLayerStitchImpl *layer_stitch = new GLLayerStitchImpl(false /* Non-secure */);
+  layer_stitch->SetWarmUp(true);
+  if (layer_stitch->Init() == 0) {
+    layer_stitch->Deinit();
+  }
+
+  delete layer_stitch;
+}
+
 void GLLayerStitch::Destroy(GLLayerStitch *intf) {
   GLLayerStitchImpl *layer_stitch = static_cast<GLLayerStitchImpl *>(intf);
   if (layer_stitch->Deinit() != 0) {
@@ -48,8 +48,12 @@ class GLLayerStitch {
  public:
   static GLLayerStitch* GetInstance(bool secure);
   static void Destroy(GLLayerStitch *intf);
+  // Links the programs in a context of its own, for the program cache, without raising the
+  // priority of the calling thread.
+  static void WarmUp();
   virtual int Blit(const std::vector<StitchParams> &stitch_params,
                    shared_ptr<Fence> *release_fence) = 0;
+  virtual EGLImageCacheStats GetImageCacheStats() const = 0;
 
  protected:
   virtual ~GLLayerStitch() { }
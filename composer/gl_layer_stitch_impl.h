@@ -47,6 +47,9 @@ class GLLayerStitchImpl : public GLLayerStitch, public GLCommon {
   virtual int CreateContext(bool secure);
   virtual int Init();
   virtual int Deinit();
+  virtual EGLImageCacheStats GetImageCacheStats() const {
+    return GLCommon::GetImageCacheStats();
+  }
  private:
   bool secure_ = false;
   GLContext ctx_;
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "hwc_blit_timeline.h"
+
+#define __CLASS__ "HWCBlitTimeline"
+
+// sw_sync ABI, as in libsync which does not export it.
+struct sw_sync_create_fence_data {
+  uint32_t value;
+  char name[32];
+  int32_t fence;
+};
+
+#define SW_SYNC_IOC_MAGIC 'W'
+#define SW_SYNC_IOC_CREATE_FENCE _IOWR(SW_SYNC_IOC_MAGIC, 0, struct sw_sync_create_fence_data)
+#define SW_SYNC_IOC_INC _IOW(SW_SYNC_IOC_MAGIC, 1, uint32_t)
+
+namespace sdm {
+
+namespace {
+
+class SwSyncTimeline : public SyncTimeline {
+ public:
+  explicit SwSyncTimeline(int fd) : fd_(fd) { }
+  ~SwSyncTimeline() {
+    // Fences of points not reached yet are signaled with an error.
+    close(fd_);
+  }
+
+  shared_ptr<Fence> CreateFence(uint32_t point) override {
+    struct sw_sync_create_fence_data data = {};
+    data.value = point;
+    strlcpy(data.name, "vds_retire", sizeof(data.name));
+    if (ioctl(fd_, SW_SYNC_IOC_CREATE_FENCE, &data) < 0) {
+      DLOGE("Failed to create fence for point %u, error = %s", point, strerror(errno));
+      return nullptr;
+    }
+
+    return Fence::Create(data.fence, "vds_retire");
+  }
+
+  void Advance() override {
+    uint32_t increment = 1;
+    if (ioctl(fd_, SW_SYNC_IOC_INC, &increment) < 0) {
+      DLOGE("Failed to advance timeline, error = %s", strerror(errno));
+    }
+  }
+
+ private:
+  int fd_;
+};
+
+}  // namespace
+
+std::unique_ptr<SyncTimeline> HWCBlitTimeline::CreateSwSyncTimeline() {
+  for (auto path : {"/sys/kernel/debug/sync/sw_sync", "/dev/sw_sync"}) {
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd >= 0) {
+      return std::unique_ptr<SyncTimeline>(new SwSyncTimeline(fd));
+    }
+  }
+
+  return nullptr;
+}
+
+HWCBlitTimeline::HWCBlitTimeline(std::unique_ptr<SyncTimeline> timeline, uint32_t max_in_flight)
+  : timeline_(std::move(timeline)), max_in_flight_(std::max(max_in_flight, 1U)),
+    retire_task_(*this, max_in_flight_) {
+}
+
+HWCBlitTimeline::~HWCBlitTimeline() {
+  retire_task_.Flush();
+
+  // Blits that were never submitted, the fences handed out for them must not be left pending.
+  std::lock_guard<std::mutex> lock(lock_);
+  for (; in_flight_; in_flight_--) {
+    if (timeline_) {
+      timeline_->Advance();
+    }
+  }
+}
+
+shared_ptr<Fence> HWCBlitTimeline::AddBlit() {
+  std::unique_lock<std::mutex> lock(lock_);
+  cv_.wait(lock, [this] { return in_flight_ < max_in_flight_; });
+  in_flight_++;
+  next_point_++;
+
+  return timeline_ ? timeline_->CreateFence(next_point_) : nullptr;
+}
+
+void HWCBlitTimeline::OnBlitSubmitted(const shared_ptr<Fence> &blit_fence) {
+  auto ctx = std::make_shared<BlitRetireContext>();
+  ctx->blit_fence = blit_fence;
+  // Never blocks, there are no more retires pending than blits in flight.
+  retire_task_.PostTask(BlitRetireTaskCode::kCodeRetire, ctx);
+}
+
+void HWCBlitTimeline::Flush() {
+  std::unique_lock<std::mutex> lock(lock_);
+  cv_.wait(lock, [this] { return !in_flight_; });
+}
+
+uint32_t HWCBlitTimeline::GetInFlightCount() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return in_flight_;
+}
+
+void HWCBlitTimeline::OnTask(const BlitRetireTaskCode &task_code,
+                             AsyncTask<BlitRetireTaskCode>::TaskContext *task_context) {
+  switch (task_code) {
+    case BlitRetireTaskCode::kCodeRetire: {
+        BlitRetireContext *ctx = reinterpret_cast<BlitRetireContext *>(task_context);
+        // The blit may wait for the consumer to release the output buffer, which can take long.
+        // Signaling before the GPU is done would let the client reuse the buffers it reads.
+        while (Fence::Wait(ctx->blit_fence) == -ETIME) { }
+        Retire();
+      }
+      break;
+  }
+}
+
+void HWCBlitTimeline::Retire() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (timeline_) {
+      timeline_->Advance();
+    }
+    in_flight_--;
+  }
+  cv_.notify_all();
+}
+
+}  // namespace sdm
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_BLIT_TIMELINE_H__
+#define __HWC_BLIT_TIMELINE_H__
+
+#include <utils/async_task.h>
+#include <utils/fence.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace sdm {
+
+// Fences signaled in the order of their points, such as those of a sw_sync timeline.
+class SyncTimeline {
+ public:
+  virtual ~SyncTimeline() { }
+  // Returns a fence signaled once the timeline has been advanced point times.
+  virtual shared_ptr<Fence> CreateFence(uint32_t point) = 0;
+  virtual void Advance() = 0;
+};
+
+enum class BlitRetireTaskCode : int32_t {
+  kCodeRetire,
+};
+
+struct BlitRetireContext : public AsyncTask<BlitRetireTaskCode>::TaskContext {
+  shared_ptr<Fence> blit_fence = nullptr;
+};
+
+// Hands out the retire fence of a GPU blit before the blit is submitted, so that the composer
+// thread does not wait for the blit worker. Retire fences are points on a sync timeline, which is
+// advanced once the native fence of each blit signals, in the order the blits were added. At most
+// max_in_flight blits are queued or running on the GPU, AddBlit blocks only once they are.
+class HWCBlitTimeline : public AsyncTask<BlitRetireTaskCode>::TaskHandler {
+ public:
+  // Without a timeline the blits are still bounded, but AddBlit returns no retire fence.
+  HWCBlitTimeline(std::unique_ptr<SyncTimeline> timeline, uint32_t max_in_flight);
+  ~HWCBlitTimeline();
+
+  // Called for each blit before it is queued. Returns its retire fence, or nullptr without a
+  // timeline, in which case the native fence of the blit is the retire fence.
+  shared_ptr<Fence> AddBlit();
+  // Called by the blit worker once the oldest blit not yet submitted is, with its native fence.
+  // A null fence retires the blit right away, as for a blit that failed.
+  void OnBlitSubmitted(const shared_ptr<Fence> &blit_fence);
+  // Blocks until all blits added so far are retired.
+  void Flush();
+  uint32_t GetInFlightCount();
+
+  // Returns nullptr when sw_sync is not available, as on user builds.
+  static std::unique_ptr<SyncTimeline> CreateSwSyncTimeline();
+
+ private:
+  void OnTask(const BlitRetireTaskCode &task_code,
+              AsyncTask<BlitRetireTaskCode>::TaskContext *task_context);
+  void Retire();
+
+  std::unique_ptr<SyncTimeline> timeline_;
+  const uint32_t max_in_flight_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  uint32_t next_point_ = 0;
+  uint32_t in_flight_ = 0;
+  // Last member, so that its worker is joined before the timeline goes away.
+  AsyncTask<BlitRetireTaskCode> retire_task_;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_BLIT_TIMELINE_H__
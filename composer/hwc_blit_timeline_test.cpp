@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "hwc_blit_timeline.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+const int kFenceTimeoutMs = 1000;
+
+// Fences are eventfds, signaled by writing to them.
+class TestSyncHandler : public BufferSyncHandler {
+ public:
+  int SyncWait(int fd, int timeout) override {
+    if (fd < 0) {
+      return 0;
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ret = poll(&pfd, 1, timeout);
+    return (ret > 0) ? 0 : (ret == 0 ? -ETIME : -errno);
+  }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override { }
+};
+
+void Signal(int fd) {
+  uint64_t value = 1;
+  ASSERT_EQ(ssize_t(sizeof(value)), write(fd, &value, sizeof(value)));
+}
+
+class TestFence {
+ public:
+  TestFence() : fd_(eventfd(0, EFD_CLOEXEC)) { }
+  ~TestFence() { close(fd_); }
+
+  // The Fence owns a dup, the test keeps the fd to signal it.
+  shared_ptr<Fence> Get() { return Fence::Create(dup(fd_), "blit"); }
+  void Signal() { sdm::Signal(fd_); }
+
+ private:
+  int fd_;
+};
+
+// Stands in for sw_sync, with an eventfd per point.
+class TestTimeline : public SyncTimeline {
+ public:
+  ~TestTimeline() {
+    for (int fd : fds_) {
+      close(fd);
+    }
+  }
+
+  shared_ptr<Fence> CreateFence(uint32_t point) override {
+    while (fds_.size() < point) {
+      fds_.push_back(eventfd(0, EFD_CLOEXEC));
+      if (fds_.size() <= value_) {
+        Signal(fds_.back());
+      }
+    }
+    return Fence::Create(dup(fds_[point - 1]), "retire");
+  }
+
+  void Advance() override {
+    value_++;
+    if (value_ <= fds_.size()) {
+      Signal(fds_[value_ - 1]);
+    }
+  }
+
+ private:
+  std::vector<int> fds_;
+  uint32_t value_ = 0;
+};
+
+bool IsSignaled(const shared_ptr<Fence> &fence) {
+  return Fence::GetStatus(fence) == Fence::Status::kSignaled;
+}
+
+bool WaitSignaled(const shared_ptr<Fence> &fence) {
+  return Fence::Wait(fence, kFenceTimeoutMs) == 0;
+}
+
+// Plays the blit worker and the GPU. Submitted blits run one after the other on the GPU thread
+// for blit_time each. The retire fence of a blit must not be signaled before the blit is done.
+class FakeBlitter {
+ public:
+  FakeBlitter(HWCBlitTimeline *timeline, milliseconds blit_time)
+    : timeline_(timeline), blit_time_(blit_time), gpu_(&FakeBlitter::Run, this) { }
+
+  ~FakeBlitter() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      exit_ = true;
+    }
+    cv_.notify_all();
+    gpu_.join();
+  }
+
+  void Submit(const shared_ptr<Fence> &retire_fence) {
+    Blit blit;
+    blit.native_fence = std::make_shared<TestFence>();
+    blit.retire_fence = retire_fence;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      blits_.push_back(blit);
+      max_in_flight_ = std::max(max_in_flight_, static_cast<uint32_t>(blits_.size()));
+    }
+    cv_.notify_all();
+    timeline_->OnBlitSubmitted(blit.native_fence->Get());
+  }
+
+  uint32_t max_in_flight() { return max_in_flight_; }
+  uint32_t early_retires() { return early_retires_; }
+
+ private:
+  struct Blit {
+    std::shared_ptr<TestFence> native_fence;
+    shared_ptr<Fence> retire_fence;
+  };
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(lock_);
+    while (true) {
+      cv_.wait(lock, [this] { return exit_ || !blits_.empty(); });
+      if (blits_.empty()) {
+        return;
+      }
+      Blit blit = blits_.front();
+      lock.unlock();
+      std::this_thread::sleep_for(blit_time_);
+      early_retires_ += IsSignaled(blit.retire_fence);
+      blit.native_fence->Signal();
+      lock.lock();
+      blits_.pop_front();
+    }
+  }
+
+  HWCBlitTimeline *timeline_;
+  milliseconds blit_time_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::deque<Blit> blits_;
+  bool exit_ = false;
+  uint32_t max_in_flight_ = 0;
+  std::atomic<uint32_t> early_retires_ {0};
+  std::thread gpu_;
+};
+
+class HWCBlitTimelineTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { Fence::Set(&sync_handler_); }
+
+  static std::unique_ptr<SyncTimeline> CreateTimeline() {
+    return std::unique_ptr<SyncTimeline>(new TestTimeline());
+  }
+
+  static TestSyncHandler sync_handler_;
+};
+
+TestSyncHandler HWCBlitTimelineTest::sync_handler_;
+
+}  // namespace
+
+// The retire fence is handed out before the blit is submitted, and signaled once the GPU is done.
+TEST_F(HWCBlitTimelineTest, RetiredAfterBlit) {
+  HWCBlitTimeline timeline(CreateTimeline(), 2);
+  shared_ptr<Fence> retire_fence = timeline.AddBlit();
+  ASSERT_NE(nullptr, retire_fence);
+  EXPECT_FALSE(IsSignaled(retire_fence));
+
+  TestFence blit_fence;
+  timeline.OnBlitSubmitted(blit_fence.Get());
+  EXPECT_EQ(-ETIME, Fence::Wait(retire_fence, 50));
+
+  blit_fence.Signal();
+  EXPECT_TRUE(WaitSignaled(retire_fence));
+  timeline.Flush();
+  EXPECT_EQ(0u, timeline.GetInFlightCount());
+}
+
+// Blits completing out of order on the GPU still retire in order.
+TEST_F(HWCBlitTimelineTest, RetiredInOrder) {
+  HWCBlitTimeline timeline(CreateTimeline(), 3);
+  std::vector<shared_ptr<Fence>> retire_fences;
+  TestFence blit_fences[3];
+  for (auto &blit_fence : blit_fences) {
+    retire_fences.push_back(timeline.AddBlit());
+    timeline.OnBlitSubmitted(blit_fence.Get());
+  }
+
+  blit_fences[2].Signal();
+  blit_fences[1].Signal();
+  EXPECT_EQ(-ETIME, Fence::Wait(retire_fences[2], 50));
+  EXPECT_FALSE(IsSignaled(retire_fences[1]));
+  EXPECT_FALSE(IsSignaled(retire_fences[0]));
+
+  blit_fences[0].Signal();
+  for (auto &retire_fence : retire_fences) {
+    EXPECT_TRUE(WaitSignaled(retire_fence));
+  }
+}
+
+// A blit that failed has no native fence, it must not hold the ones after it.
+TEST_F(HWCBlitTimelineTest, FailedBlit) {
+  HWCBlitTimeline timeline(CreateTimeline(), 2);
+  shared_ptr<Fence> failed = timeline.AddBlit();
+  shared_ptr<Fence> next = timeline.AddBlit();
+  TestFence blit_fence;
+  timeline.OnBlitSubmitted(nullptr);
+  timeline.OnBlitSubmitted(blit_fence.Get());
+
+  EXPECT_TRUE(WaitSignaled(failed));
+  blit_fence.Signal();
+  EXPECT_TRUE(WaitSignaled(next));
+}
+
+// AddBlit returns right away below the cap, and blocks at the cap until the oldest blit retires.
+TEST_F(HWCBlitTimelineTest, BlocksOnlyAtCap) {
+  HWCBlitTimeline timeline(CreateTimeline(), 2);
+  TestFence blit_fences[2];
+  for (auto &blit_fence : blit_fences) {
+    timeline.AddBlit();
+    timeline.OnBlitSubmitted(blit_fence.Get());
+  }
+  EXPECT_EQ(2u, timeline.GetInFlightCount());
+
+  auto added = std::async(std::launch::async, [&timeline] { return timeline.AddBlit(); });
+  EXPECT_EQ(std::future_status::timeout, added.wait_for(milliseconds(50)));
+
+  blit_fences[0].Signal();
+  ASSERT_EQ(std::future_status::ready, added.wait_for(milliseconds(kFenceTimeoutMs)));
+  EXPECT_FALSE(IsSignaled(added.get()));
+  EXPECT_EQ(2u, timeline.GetInFlightCount());
+
+  blit_fences[1].Signal();
+  timeline.OnBlitSubmitted(nullptr);
+  timeline.Flush();
+}
+
+// Without sw_sync no retire fence is handed out, the blits are still bounded.
+TEST_F(HWCBlitTimelineTest, NoTimeline) {
+  HWCBlitTimeline timeline(nullptr, 1);
+  EXPECT_EQ(nullptr, timeline.AddBlit());
+
+  TestFence blit_fence;
+  timeline.OnBlitSubmitted(blit_fence.Get());
+  auto added = std::async(std::launch::async, [&timeline] { return timeline.AddBlit(); });
+  EXPECT_EQ(std::future_status::timeout, added.wait_for(milliseconds(50)));
+
+  blit_fence.Signal();
+  ASSERT_EQ(std::future_status::ready, added.wait_for(milliseconds(kFenceTimeoutMs)));
+  EXPECT_EQ(nullptr, added.get());
+  timeline.OnBlitSubmitted(nullptr);
+}
+
+// Fences handed out for blits never submitted, as on teardown, are signaled.
+TEST_F(HWCBlitTimelineTest, DestroyedWithPendingBlits) {
+  shared_ptr<Fence> retire_fence = nullptr;
+  {
+    HWCBlitTimeline timeline(CreateTimeline(), 2);
+    retire_fence = timeline.AddBlit();
+  }
+  EXPECT_TRUE(IsSignaled(retire_fence));
+}
+
+// The composer prepares the next frame while the GPU runs the previous blits, so frames come at
+// the pace of the slower of the two rather than of both in turn. Retire fences are never
+// signaled before their blit is done, and no more blits than the cap are on the GPU.
+TEST_F(HWCBlitTimelineTest, Throughput) {
+  const uint32_t kFrames = 40;
+  const milliseconds kFrameTime(4);
+  HWCBlitTimeline timeline(CreateTimeline(), 2);
+  std::vector<shared_ptr<Fence>> retire_fences;
+
+  auto start = steady_clock::now();
+  {
+    FakeBlitter blitter(&timeline, kFrameTime);
+    for (uint32_t i = 0; i < kFrames; i++) {
+      std::this_thread::sleep_for(kFrameTime);
+      retire_fences.push_back(timeline.AddBlit());
+      blitter.Submit(retire_fences.back());
+    }
+    timeline.Flush();
+
+    EXPECT_EQ(0u, blitter.early_retires());
+    EXPECT_LE(blitter.max_in_flight(), 2u);
+  }
+  auto elapsed = steady_clock::now() - start;
+
+  for (auto &retire_fence : retire_fences) {
+    EXPECT_TRUE(IsSignaled(retire_fence));
+  }
+  // Serialized, the frames would take 2 * kFrames * kFrameTime.
+  EXPECT_LT(elapsed, kFrames * kFrameTime * 3 / 2);
+}
+
+}  // namespace sdm
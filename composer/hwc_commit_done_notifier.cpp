@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <utils/debug.h>
+#include <memory>
+#include <utility>
+
+#include "hwc_commit_done_notifier.h"
+
+#define __CLASS__ "HWCCommitDoneNotifier"
+
+namespace sdm {
+
+std::shared_future<int> HWCCommitDoneNotifier::Subscribe(hwc2_display_t display, int client_id) {
+  CommitDoneSubscriber subscriber;
+  subscriber.client_id = client_id;
+  std::shared_future<int> done = subscriber.done.get_future().share();
+
+  std::lock_guard<std::mutex> lock(lock_);
+  subscribers_[display].push_back(std::move(subscriber));
+
+  return done;
+}
+
+void HWCCommitDoneNotifier::CommitDone(hwc2_display_t display,
+                                       const shared_ptr<Fence> &retire_fence, int timeout_ms) {
+  auto ctx = std::make_shared<CommitDoneContext>();
+  AsyncTask<CommitDoneTaskCode> *fence_wait_task = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = subscribers_.find(display);
+    if (it == subscribers_.end()) {
+      return;
+    }
+    ctx->subscribers = std::move(it->second);
+    subscribers_.erase(it);
+
+    auto &task = fence_wait_tasks_[display];
+    if (!task) {
+      task = std::make_unique<AsyncTask<CommitDoneTaskCode>>(*this, kMaxPendingCommits);
+    }
+    // Workers live as long as the notifier, the pointer stays valid without the lock.
+    fence_wait_task = task.get();
+  }
+
+  ctx->display = display;
+  ctx->retire_fence = retire_fence;
+  ctx->timeout_ms = timeout_ms;
+  fence_wait_task->PostTask(CommitDoneTaskCode::kCodeWaitRetireFence, ctx);
+}
+
+bool HWCCommitDoneNotifier::HasSubscribers(hwc2_display_t display) {
+  std::lock_guard<std::mutex> lock(lock_);
+  return (subscribers_.find(display) != subscribers_.end());
+}
+
+void HWCCommitDoneNotifier::CommitFailed(hwc2_display_t display, int error) {
+  if (Resolve(display, error)) {
+    DLOGE("Commit done failed with error %d for display %" PRIu64, error, display);
+  }
+}
+
+void HWCCommitDoneNotifier::RemoveDisplay(hwc2_display_t display) {
+  Resolve(display, -ENODEV);
+}
+
+size_t HWCCommitDoneNotifier::Resolve(hwc2_display_t display, int result) {
+  std::vector<CommitDoneSubscriber> subscribers;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = subscribers_.find(display);
+    if (it == subscribers_.end()) {
+      return 0;
+    }
+    subscribers = std::move(it->second);
+    subscribers_.erase(it);
+  }
+
+  for (auto &subscriber : subscribers) {
+    subscriber.done.set_value(result);
+  }
+
+  return subscribers.size();
+}
+
+void HWCCommitDoneNotifier::OnTask(const CommitDoneTaskCode &task_code,
+                                   AsyncTask<CommitDoneTaskCode>::TaskContext *task_context) {
+  switch (task_code) {
+    case CommitDoneTaskCode::kCodeWaitRetireFence: {
+        DTRACE_SCOPED();
+        CommitDoneContext *ctx = reinterpret_cast<CommitDoneContext *>(task_context);
+        int ret = Fence::Wait(ctx->retire_fence, ctx->timeout_ms);
+        for (auto &subscriber : ctx->subscribers) {
+          if (ret != 0) {
+            DLOGE("Retire fence wait failed with error %d for client %d display %" PRIu64, ret,
+                  subscriber.client_id, ctx->display);
+          }
+          subscriber.done.set_value(ret);
+        }
+      }
+      break;
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_COMMIT_DONE_NOTIFIER_H__
+#define __HWC_COMMIT_DONE_NOTIFIER_H__
+
+#include <hardware/hwcomposer2.h>
+#include <utils/async_task.h>
+#include <utils/fence.h>
+#include <future>   // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sdm {
+
+enum class CommitDoneTaskCode : int32_t {
+  kCodeWaitRetireFence,
+};
+
+struct CommitDoneSubscriber {
+  int client_id = -1;
+  std::promise<int> done;
+};
+
+struct CommitDoneContext : public AsyncTask<CommitDoneTaskCode>::TaskContext {
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  int timeout_ms = 0;
+  std::vector<CommitDoneSubscriber> subscribers;
+};
+
+// Lets clients wait for the next commit of a display to be retired. Subscriptions are resolved
+// with 0 once the retire fence of that commit signals, or with an error if the commit fails, the
+// fence wait times out or the display goes away. Each display has a worker of its own that waits
+// on its retire fences, so clients need no thread of their own and a late fence of one display
+// does not hold back the subscribers of the others.
+class HWCCommitDoneNotifier : public AsyncTask<CommitDoneTaskCode>::TaskHandler {
+ public:
+  std::shared_future<int> Subscribe(hwc2_display_t display, int client_id);
+  // Hands the subscriptions of display over to the commit that retires with retire_fence.
+  void CommitDone(hwc2_display_t display, const shared_ptr<Fence> &retire_fence, int timeout_ms);
+  bool HasSubscribers(hwc2_display_t display);
+  void CommitFailed(hwc2_display_t display, int error);
+  void RemoveDisplay(hwc2_display_t display);
+
+ private:
+  // Commits of one display with subscribers whose retire fence is being waited for.
+  static constexpr uint32_t kMaxPendingCommits = 4;
+
+  // AsyncTask methods.
+  void OnTask(const CommitDoneTaskCode &task_code,
+              AsyncTask<CommitDoneTaskCode>::TaskContext *task_context);
+  size_t Resolve(hwc2_display_t display, int result);
+
+  std::mutex lock_;
+  std::map<hwc2_display_t, std::vector<CommitDoneSubscriber>> subscribers_;
+  // Created on the first commit of each display with subscribers. Declared last, so that the
+  // workers are stopped before the state they use goes away.
+  std::map<hwc2_display_t, std::unique_ptr<AsyncTask<CommitDoneTaskCode>>> fence_wait_tasks_;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_COMMIT_DONE_NOTIFIER_H__
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hwc_commit_done_notifier.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const int kFenceTimeoutMs = 1000;
+const milliseconds kTimeout(2000);
+
+// Fences are eventfds, signaled by writing to them.
+class TestSyncHandler : public BufferSyncHandler {
+ public:
+  int SyncWait(int fd, int timeout) override {
+    if (fd < 0) {
+      return 0;
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ret = poll(&pfd, 1, timeout);
+    return (ret > 0) ? 0 : (ret == 0 ? -ETIME : -errno);
+  }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override { }
+};
+
+class TestFence {
+ public:
+  TestFence() : fd_(eventfd(0, EFD_CLOEXEC)) { }
+
+  // The Fence owns a dup, the test keeps the fd to signal it.
+  shared_ptr<Fence> Get() { return Fence::Create(dup(fd_), "retire"); }
+
+  void Signal() {
+    uint64_t value = 1;
+    ASSERT_EQ(ssize_t(sizeof(value)), write(fd_, &value, sizeof(value)));
+  }
+
+  ~TestFence() { close(fd_); }
+
+ private:
+  int fd_;
+};
+
+class HWCCommitDoneNotifierTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { Fence::Set(&sync_handler_); }
+
+  static bool IsReady(const std::shared_future<int> &done) {
+    return done.wait_for(milliseconds(0)) == std::future_status::ready;
+  }
+
+  static bool WaitReady(const std::shared_future<int> &done) {
+    return done.wait_for(kTimeout) == std::future_status::ready;
+  }
+
+  static TestSyncHandler sync_handler_;
+  HWCCommitDoneNotifier notifier_;
+};
+
+TestSyncHandler HWCCommitDoneNotifierTest::sync_handler_;
+
+}  // namespace
+
+TEST_F(HWCCommitDoneNotifierTest, ResolvedWhenRetired) {
+  auto done = notifier_.Subscribe(0, 1);
+  EXPECT_TRUE(notifier_.HasSubscribers(0));
+
+  TestFence fence;
+  notifier_.CommitDone(0, fence.Get(), kFenceTimeoutMs);
+  EXPECT_FALSE(notifier_.HasSubscribers(0));
+  std::this_thread::sleep_for(milliseconds(20));
+  EXPECT_FALSE(IsReady(done));
+
+  fence.Signal();
+  ASSERT_TRUE(WaitReady(done));
+  EXPECT_EQ(0, done.get());
+}
+
+// Commits of displays nobody waits for are not queued.
+TEST_F(HWCCommitDoneNotifierTest, CommitWithoutSubscribers) {
+  TestFence fence;
+  notifier_.CommitDone(0, fence.Get(), kFenceTimeoutMs);
+  auto done = notifier_.Subscribe(0, 1);
+  EXPECT_FALSE(IsReady(done));
+
+  notifier_.CommitDone(0, nullptr, kFenceTimeoutMs);
+  ASSERT_TRUE(WaitReady(done));
+  EXPECT_EQ(0, done.get());
+}
+
+TEST_F(HWCCommitDoneNotifierTest, FenceTimeout) {
+  auto done = notifier_.Subscribe(0, 1);
+  TestFence fence;
+  notifier_.CommitDone(0, fence.Get(), 20);
+  ASSERT_TRUE(WaitReady(done));
+  EXPECT_EQ(-ETIME, done.get());
+}
+
+TEST_F(HWCCommitDoneNotifierTest, CommitFailed) {
+  auto done = notifier_.Subscribe(0, 1);
+  notifier_.CommitFailed(0, -EINVAL);
+  ASSERT_TRUE(IsReady(done));
+  EXPECT_EQ(-EINVAL, done.get());
+  EXPECT_FALSE(notifier_.HasSubscribers(0));
+}
+
+TEST_F(HWCCommitDoneNotifierTest, RemoveDisplay) {
+  auto removed = notifier_.Subscribe(1, 1);
+  auto other = notifier_.Subscribe(2, 1);
+  notifier_.RemoveDisplay(1);
+  ASSERT_TRUE(IsReady(removed));
+  EXPECT_EQ(-ENODEV, removed.get());
+  EXPECT_FALSE(IsReady(other));
+  EXPECT_TRUE(notifier_.HasSubscribers(2));
+
+  // Waits already handed over to a commit are not affected.
+  TestFence fence;
+  notifier_.CommitDone(2, fence.Get(), kFenceTimeoutMs);
+  notifier_.RemoveDisplay(2);
+  fence.Signal();
+  ASSERT_TRUE(WaitReady(other));
+  EXPECT_EQ(0, other.get());
+}
+
+// Subscribers of one display share the next commit, later ones wait for the one after.
+TEST_F(HWCCommitDoneNotifierTest, SubscribersShareCommit) {
+  std::vector<std::shared_future<int>> first;
+  for (int client = 0; client < 4; client++) {
+    first.push_back(notifier_.Subscribe(0, client));
+  }
+  TestFence fence;
+  notifier_.CommitDone(0, fence.Get(), kFenceTimeoutMs);
+  auto second = notifier_.Subscribe(0, 5);
+
+  fence.Signal();
+  for (auto &done : first) {
+    ASSERT_TRUE(WaitReady(done));
+    EXPECT_EQ(0, done.get());
+  }
+  EXPECT_FALSE(IsReady(second));
+  notifier_.CommitDone(0, nullptr, kFenceTimeoutMs);
+  ASSERT_TRUE(WaitReady(second));
+}
+
+// A retire fence that does not signal holds back its own display only.
+TEST_F(HWCCommitDoneNotifierTest, DisplaysDoNotBlockEachOther) {
+  auto stuck = notifier_.Subscribe(0, 1);
+  TestFence stuck_fence;
+  notifier_.CommitDone(0, stuck_fence.Get(), kFenceTimeoutMs);
+
+  auto done = notifier_.Subscribe(1, 1);
+  TestFence fence;
+  notifier_.CommitDone(1, fence.Get(), kFenceTimeoutMs);
+  fence.Signal();
+  ASSERT_EQ(std::future_status::ready, done.wait_for(milliseconds(kFenceTimeoutMs / 2)));
+  EXPECT_EQ(0, done.get());
+  EXPECT_FALSE(IsReady(stuck));
+
+  stuck_fence.Signal();
+  ASSERT_TRUE(WaitReady(stuck));
+  EXPECT_EQ(0, stuck.get());
+}
+
+// Clients of several displays subscribe while the displays commit.
+TEST_F(HWCCommitDoneNotifierTest, ConcurrentSubscribers) {
+  const int kDisplays = 3;
+  const int kClients = 4;
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> committers;
+  for (int display = 0; display < kDisplays; display++) {
+    committers.emplace_back([&, display] {
+      while (!stop) {
+        std::this_thread::sleep_for(milliseconds(2));
+        notifier_.CommitDone(display, nullptr, kFenceTimeoutMs);
+      }
+    });
+  }
+
+  std::atomic<int> failures(0);
+  std::vector<std::thread> clients;
+  for (int client = 0; client < kClients; client++) {
+    clients.emplace_back([&, client] {
+      for (int i = 0; i < 50; i++) {
+        auto done = notifier_.Subscribe(hwc2_display_t(i % kDisplays), client);
+        if (done.wait_for(kTimeout) != std::future_status::ready || done.get() != 0) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto &client : clients) {
+    client.join();
+  }
+  stop = true;
+  for (auto &committer : committers) {
+    committer.join();
+  }
+  EXPECT_EQ(0, failures);
+}
+
+}  // namespace sdm
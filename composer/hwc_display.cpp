@@ -641,6 +641,22 @@ HWCLayer *HWCDisplay::GetHWCLayer(hwc2_layer_t layer_id) {
   }
 }
 
+HWC2::Error HWCDisplay::SetLayerBuffer(hwc2_layer_t layer_id, buffer_handle_t buffer,
+                                       shared_ptr<Fence> acquire_fence) {
+  HWCLayer *hwc_layer = GetHWCLayer(layer_id);
+  if (hwc_layer == nullptr) {
+    return HWC2::Error::BadLayer;
+  }
+
+  auto status = hwc_layer->SetLayerBuffer(buffer, acquire_fence);
+  if (status == HWC2::Error::None && hwc_layer->NeedsBufferPrefetch()) {
+    // Have the framebuffer object ready by the time this buffer gets committed.
+    display_intf_->PrefetchBuffer(hwc_layer->GetSDMLayer()->input_buffer);
+  }
+
+  return status;
+}
+
 HWC2::Error HWCDisplay::DestroyLayer(hwc2_layer_t layer_id) {
   // ToDo: Replace layer destroy with smart pointer.
   // Work around to block main thread execution until async commit finishes.
@@ -652,6 +668,7 @@ HWC2::Error HWCDisplay::DestroyLayer(hwc2_layer_t layer_id) {
   }
   const auto layer = map_layer->second;
   layer_map_.erase(map_layer);
+  release_fences_.RemoveLayer(layer_id);
   const auto z_range = layer_set_.equal_range(layer);
   for (auto current = z_range.first; current != z_range.second; ++current) {
     if (*current == layer) {
@@ -1273,6 +1290,9 @@ HWC2::Error HWCDisplay::SetClientTarget(buffer_handle_t target, shared_ptr<Fence
   sdm_layer->frame_rate = std::min(current_refresh_rate_, HWCDisplay::GetThrottlingRefreshRate());
   client_target_->SetLayerSurfaceDamage(damage);
   client_target_->SetLayerBuffer(target, acquire_fence);
+  if (client_target_->NeedsBufferPrefetch()) {
+    display_intf_->PrefetchBuffer(sdm_layer->input_buffer);
+  }
   client_target_handle_ = target;
   client_acquire_fence_ = acquire_fence;
   client_dataspace_     = dataspace;
@@ -1499,6 +1519,14 @@ DisplayError HWCDisplay::HandleEvent(DisplayEvent event) {
               id_);
       }
     } break;
+    case kResourcesReleased: {
+      if (event_handler_) {
+        event_handler_->ResourcesReleased(id_);
+      } else {
+        DLOGW("Cannot execute ResourcesReleased (client_id = %" PRId64 "), event_handler_ is null",
+              id_);
+      }
+    } break;
     case kIdleTimeout:
       ReqPerfHintRelease();
       break;
@@ -1663,19 +1691,35 @@ HWC2::Error HWCDisplay::GetReleaseFences(uint32_t *out_num_elements, hwc2_layer_
     return HWC2::Error::BadParameter;
   }
 
+  // Layers whose release fence and buffer are the same as when last returned need no update.
+  uint32_t num_elements = 0;
   if (out_layers != nullptr && out_fences != nullptr) {
-    *out_num_elements = std::min(*out_num_elements, UINT32(layer_set_.size()));
-    auto it = layer_set_.begin();
-    for (uint32_t i = 0; i < *out_num_elements; i++, it++) {
-      auto hwc_layer = *it;
-      out_layers[i] = hwc_layer->GetId();
+    for (auto hwc_layer : layer_set_) {
+      if (num_elements >= *out_num_elements) {
+        break;
+      }
+      hwc2_layer_t layer_id = hwc_layer->GetId();
+      uint64_t handle_id = hwc_layer->GetSDMLayer()->input_buffer.handle_id;
+      shared_ptr<Fence> release_fence = hwc_layer->GetReleaseFence();
+      if (!release_fences_.NeedsUpdate(layer_id, handle_id, release_fence)) {
+        continue;
+      }
 
-      shared_ptr<Fence> &fence = (*out_fences)[i];
-      fence = hwc_layer->GetReleaseFence();
+      out_layers[num_elements] = layer_id;
+      (*out_fences)[num_elements] = release_fence;
+      release_fences_.Update(layer_id, handle_id, release_fence);
+      num_elements++;
     }
   } else {
-    *out_num_elements = UINT32(layer_set_.size());
+    for (auto hwc_layer : layer_set_) {
+      if (release_fences_.NeedsUpdate(hwc_layer->GetId(),
+                                      hwc_layer->GetSDMLayer()->input_buffer.handle_id,
+                                      hwc_layer->GetReleaseFence())) {
+        num_elements++;
+      }
+    }
   }
+  *out_num_elements = num_elements;
 
   return HWC2::Error::None;
 }
@@ -2633,6 +2677,11 @@ void HWCDisplay::Dump(std::ostringstream *os) {
     color_mode_->Dump(os);
   }
 
+  if (tone_mapper_ && tone_mapper_->IsActive()) {
+    *os << "\n-----------Tonemapper----------\n";
+    tone_mapper_->Dump(os);
+  }
+
   if (display_intf_) {
     *os << "\n------------SDM----------------\n";
     *os << display_intf_->Dump();
@@ -46,6 +46,7 @@
 #include "hwc_callbacks.h"
 #include "hwc_display_event_handler.h"
 #include "hwc_layers.h"
+#include "hwc_release_fences.h"
 #include "hwc_buffer_sync_handler.h"
 #include <vendor/qti/hardware/display/composer/3.1/IQtiComposerClient.h>
 
@@ -296,6 +297,8 @@ class HWCDisplay : public DisplayEventHandler {
   void BuildLayerStack(void);
   void BuildSolidFillStack(void);
   HWCLayer *GetHWCLayer(hwc2_layer_t layer_id);
+  HWC2::Error SetLayerBuffer(hwc2_layer_t layer_id, buffer_handle_t buffer,
+                             shared_ptr<Fence> acquire_fence);
   uint32_t GetGeometryChanges() { return geometry_changes_; }
   ColorMode GetCurrentColorMode() {
     return (color_mode_ ? color_mode_->GetCurrentColorMode() : ColorMode::SRGB);
@@ -591,6 +594,7 @@ class HWCDisplay : public DisplayEventHandler {
   bool is_cmd_mode_ = false;
   bool partial_update_enabled_ = false;
   bool skip_commit_ = false;
+  HWCReleaseFences release_fences_;
   std::map<uint32_t, DisplayConfigVariableInfo> variable_config_map_;
   std::vector<uint32_t> hwc_config_map_;
   bool client_connected_ = true;
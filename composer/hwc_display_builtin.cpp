@@ -167,6 +167,17 @@ int HWCDisplayBuiltIn::Init() {
   HWCDebugHandler::Get()->GetProperty(ENABLE_PERF_HINT_LARGE_COMP_CYCLE,
                                       &perf_hint_large_comp_cycle_);
 
+  value = 0;
+  HWCDebugHandler::Get()->GetProperty(ENABLE_PERF_HINT_PREDICTION, &value);
+  perf_hint_prediction_ = (value == 1);
+  if (perf_hint_large_comp_cycle_ && perf_hint_prediction_) {
+    value = 0;
+    if (HWCDebugHandler::Get()->GetProperty(PERF_HINT_SLACK_THRESHOLD, &value) == kErrorNone) {
+      perf_hint_predictor_.SetSlackThreshold(UINT32(value));
+    }
+    DLOGI("Perf hint prediction enabled on display %" PRIu64, id_);
+  }
+
   value = 0;
   DebugHandler::Get()->GetProperty(DISABLE_DYNAMIC_FPS, &value);
   disable_dyn_fps_ = (value == 1);
@@ -196,6 +207,14 @@ int HWCDisplayBuiltIn::Init() {
 void HWCDisplayBuiltIn::Dump(std::ostringstream *os) {
   HWCDisplay::Dump(os);
   *os << histogram.Dump();
+  if (perf_hint_large_comp_cycle_ && perf_hint_prediction_) {
+    perf_hint_predictor_.Dump(os);
+  }
+  if (gl_layer_stitch_) {
+    EGLImageCacheStats stats = gl_layer_stitch_->GetImageCacheStats();
+    *os << "Layer stitch image cache hits: " << stats.hits << " misses: " << stats.misses
+        << " evictions: " << stats.evictions << std::endl;
+  }
 }
 
 void HWCDisplayBuiltIn::ValidateUiScaling() {
@@ -415,10 +434,12 @@ HWC2::Error HWCDisplayBuiltIn::Present(shared_ptr<Fence> *out_retire_fence) {
       return status;
     }
 
+    nsecs_t commit_start = systemTime(SYSTEM_TIME_MONOTONIC);
     status = CommitLayerStack();
     if (status == HWC2::Error::None) {
       status = PostCommitLayerStack(out_retire_fence);
     }
+    perf_hint_predictor_.AddPresentTime(systemTime(SYSTEM_TIME_MONOTONIC) - commit_start);
   }
 
   // In case of scaling UI layer for command mode, clear LUTs
@@ -1172,6 +1193,7 @@ void HWCDisplayBuiltIn::OnTask(const LayerStitchTaskCode &task_code,
     case LayerStitchTaskCode::kCodeDestroyInstance: {
         if (gl_layer_stitch_) {
           GLLayerStitch::Destroy(gl_layer_stitch_);
+          gl_layer_stitch_ = nullptr;
         }
       }
       break;
@@ -1445,6 +1467,7 @@ HWC2::Error HWCDisplayBuiltIn::CommitOrPrepare(bool validate_only,
                                                uint32_t *out_num_requests, bool *needs_commit) {
   DTRACE_SCOPED();
 
+  nsecs_t prepare_start = systemTime(SYSTEM_TIME_MONOTONIC);
   if(!validate_only) {
     skip_commit_ = CanSkipCommit();
     if (skip_commit_) {
@@ -1459,13 +1482,40 @@ HWC2::Error HWCDisplayBuiltIn::CommitOrPrepare(bool validate_only,
                                             out_num_requests, needs_commit);
 
   if (perf_hint_large_comp_cycle_) {
-    bool needs_hint = NeedsLargeCompPerfHint();
+    bool needs_hint = false;
+    nsecs_t prepare_time = systemTime(SYSTEM_TIME_MONOTONIC) - prepare_start;
+    if (!perf_hint_prediction_ || !PredictLargeCompPerfHint(prepare_time, &needs_hint)) {
+      needs_hint = NeedsLargeCompPerfHint();
+    }
     HandleLargeCompositionHint(!needs_hint);
+    perf_hint_predictor_.SetBoosted(large_comp_hint_held_);
   }
 
   return status;
 }
 
+bool HWCDisplayBuiltIn::PredictLargeCompPerfHint(nsecs_t prepare_time, bool *needs_hint) {
+  if (!cpu_hint_) {
+    return false;
+  }
+
+  PerfHintFrameInfo info = {};
+  info.refresh_rate = active_refresh_rate_;
+  info.skip_present = layer_stack_.flags.skip_present;
+  info.multi_display = is_multi_display_;
+  for (auto hwc_layer : layer_set_) {
+    Layer *layer = hwc_layer->GetSDMLayer();
+    if (layer->composition == kCompositionGPU) {
+      LayerRect &dst = layer->dst_rect;
+      info.gpu_layer_count++;
+      info.gpu_pixels += UINT64((dst.right - dst.left) * (dst.bottom - dst.top));
+    }
+  }
+
+  // Frames without an estimate yet fall back to the static rules.
+  return perf_hint_predictor_.Predict(info, prepare_time, needs_hint);
+}
+
 void HWCDisplayBuiltIn::LoadMixedModePerfHintThreshold() {
   // For mixed mode composition, if perf hint for large composition cycles is enabled and if the
   // use case meets the threshold, SF and HWC will be running on the gold CPU cores.
@@ -1563,6 +1613,7 @@ void HWCDisplayBuiltIn::HandleLargeCompositionHint(bool release) {
 
     if (num_basic_frames_ >= active_refresh_rate_) {
       cpu_hint_->ReqHintRelease();
+      large_comp_hint_held_ = false;
     }
     return;
   }
@@ -1577,6 +1628,7 @@ void HWCDisplayBuiltIn::HandleLargeCompositionHint(bool release) {
   }
 
   num_basic_frames_ = 0;
+  large_comp_hint_held_ = true;
 }
 
 void HWCDisplayBuiltIn::ReqPerfHintRelease() {
@@ -1584,6 +1636,7 @@ void HWCDisplayBuiltIn::ReqPerfHintRelease() {
     return;
   }
   cpu_hint_->ReqHintRelease();
+  large_comp_hint_held_ = false;
 }
 
 }  // namespace sdm
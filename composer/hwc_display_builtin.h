@@ -45,6 +45,7 @@
 #include "utils/sync_task.h"
 #include "utils/constants.h"
 #include "cpuhint.h"
+#include "perf_hint_predictor.h"
 #include "hwc_display.h"
 #include "hwc_layers.h"
 
@@ -173,6 +174,7 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   bool AllocateStitchBuffer();
   void PostCommitStitchLayers();
   bool NeedsLargeCompPerfHint();
+  bool PredictLargeCompPerfHint(nsecs_t prepare_time, bool *needs_hint);
   void ValidateUiScaling();
   void EnablePartialUpdate();
   uint32_t GetUpdatingAppLayersCount();
@@ -213,6 +215,8 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   bool vndservice_sampling_vote = false;
 
   int perf_hint_large_comp_cycle_ = 0;
+  bool perf_hint_prediction_ = false;
+  PerfHintPredictor perf_hint_predictor_;
   bool force_reset_lut_ = false;
   bool disable_dyn_fps_ = false;
   bool enable_round_corner_ = false;
@@ -224,6 +228,7 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   // Long term large composition hint
   int hwc_tid_ = 0;
   uint32_t num_basic_frames_ = 0;
+  bool large_comp_hint_held_ = false;
 };
 
 }  // namespace sdm
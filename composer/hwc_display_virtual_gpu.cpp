@@ -43,6 +43,15 @@
 namespace sdm {
 
 int HWCDisplayVirtualGPU::Init() {
+  int frames_in_flight = 0;
+  if ((HWCDebugHandler::Get()->GetProperty(VDS_GPU_FRAMES_IN_FLIGHT, &frames_in_flight) !=
+       kErrorNone) || (frames_in_flight <= 0)) {
+    frames_in_flight = kDefaultFramesInFlight;
+  }
+  frames_in_flight = std::min(frames_in_flight, INT(kMaxFramesInFlight));
+  blit_timeline_.reset(new HWCBlitTimeline(HWCBlitTimeline::CreateSwSyncTimeline(),
+                                           UINT32(frames_in_flight)));
+
   // Create client target.
   client_target_ = new HWCLayer(id_, buffer_allocator_);
 
@@ -62,7 +71,9 @@ int HWCDisplayVirtualGPU::Init() {
 int HWCDisplayVirtualGPU::Deinit() {
   // Destory color convert instance. This destroys thread and underlying GL resources.
   if (gl_color_convert_) {
-    color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeDestroyInstance, nullptr);
+    // GL resources go away once the blits still on the GPU are done.
+    blit_timeline_->Flush();
+    PerformTask(ColorConvertTaskCode::kCodeDestroyInstance, nullptr);
   }
 
   DisplayError error = core_intf_->DestroyNullDisplay(display_intf_);
@@ -87,7 +98,7 @@ HWCDisplayVirtualGPU::HWCDisplayVirtualGPU(CoreInterface *core_intf, HWCBufferAl
                                            uint32_t height, float min_lum, float max_lum) :
   HWCDisplayVirtual(core_intf, buffer_allocator, callbacks, event_handler, id, sdm_id,
                     width, height),
-  color_convert_task_(*this) {
+  color_convert_task_(*this, kMaxPendingTasks) {
 }
 
 HWC2::Error HWCDisplayVirtualGPU::Validate(uint32_t *out_num_types, uint32_t *out_num_requests) {
@@ -167,7 +178,8 @@ HWC2::Error HWCDisplayVirtualGPU::SetOutputBuffer(buffer_handle_t buf,
                                                   &new_aligned_h);
       output_buffer_.width = UINT32(new_aligned_w);
       output_buffer_.height = UINT32(new_aligned_h);
-      color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeReset, nullptr);
+      // Ordered after the blits queued so far, nothing to wait for here.
+      color_convert_task_.PostTask(ColorConvertTaskCode::kCodeReset, nullptr);
     }
   }
 
@@ -193,7 +205,7 @@ HWC2::Error HWCDisplayVirtualGPU::Present(shared_ptr<Fence> *out_retire_fence) {
   // GPU context gets in secure or non-secure mode depending on output buffer provided.
   if (!gl_color_convert_) {
     // Get instance.
-    color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeGetInstance, nullptr);
+    PerformTask(ColorConvertTaskCode::kCodeGetInstance, nullptr);
     if (gl_color_convert_ == nullptr) {
       DLOGE("Failed to get Color Convert Instance");
       return HWC2::Error::NoResources;
@@ -202,29 +214,62 @@ HWC2::Error HWCDisplayVirtualGPU::Present(shared_ptr<Fence> *out_retire_fence) {
     }
   }
 
-  ColorConvertBlitContext ctx = {};
+  auto ctx = std::make_shared<ColorConvertBlitContext>();
 
   Layer *sdm_layer = client_target_->GetSDMLayer();
   LayerBuffer &input_buffer = sdm_layer->input_buffer;
-  ctx.src_hnd = reinterpret_cast<const native_handle_t *>(input_buffer.buffer_id);
-  ctx.dst_hnd = reinterpret_cast<const native_handle_t *>(output_handle_);
-  ctx.dst_rect = {0, 0, FLOAT(output_buffer_.unaligned_width),
-                  FLOAT(output_buffer_.unaligned_height)};
-  ctx.src_acquire_fence = input_buffer.acquire_fence;
-  ctx.dst_acquire_fence = output_buffer_.acquire_fence;
+  ctx->src_hnd = reinterpret_cast<const native_handle_t *>(input_buffer.buffer_id);
+  ctx->dst_hnd = reinterpret_cast<const native_handle_t *>(output_handle_);
+  ctx->dst_rect = {0, 0, FLOAT(output_buffer_.unaligned_width),
+                   FLOAT(output_buffer_.unaligned_height)};
+  ctx->src_acquire_fence = input_buffer.acquire_fence;
+  ctx->dst_acquire_fence = output_buffer_.acquire_fence;
+
+  // The consumer of the output still holds the buffer, the blit will wait on the GPU for it.
+  frames_++;
+  if (Fence::GetStatus(ctx->dst_acquire_fence) == Fence::Status::kPending) {
+    consumer_lag_frames_++;
+  }
 
-  color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeBlit, &ctx);
+  // Blocks only once the blits of vds_gpu_frames_in_flight frames are queued or on the GPU. The
+  // retire fence is signaled once the native fence of the blit is, the blit worker submits it
+  // while the composer moves on.
+  shared_ptr<Fence> retire_fence = blit_timeline_->AddBlit();
+  auto blit_done = color_convert_task_.PostTask(ColorConvertTaskCode::kCodeBlit, ctx);
+  if (!retire_fence) {
+    // No sw_sync, the native fence is the retire fence once the blit is submitted.
+    blit_done.get();
+    retire_fence = ctx->release_fence;
+  }
+  layer_stack_.retire_fence = retire_fence;
 
   // todo blit
   DumpVDSBuffer();
 
-  *out_retire_fence = ctx.release_fence;
+  *out_retire_fence = retire_fence;
 
   return status;
 }
 
+void HWCDisplayVirtualGPU::PerformTask(
+    const ColorConvertTaskCode &task_code,
+    const std::shared_ptr<ColorConvertBlitContext> &task_context) {
+  color_convert_task_.PostTask(task_code, task_context).get();
+}
+
+void HWCDisplayVirtualGPU::Dump(std::ostringstream *os) {
+  HWCDisplayVirtual::Dump(os);
+  *os << "GPU blits: " << frames_ << " waiting on the output consumer: " << consumer_lag_frames_
+      << " in flight: " << blit_timeline_->GetInFlightCount() << std::endl;
+  if (gl_color_convert_) {
+    EGLImageCacheStats stats = gl_color_convert_->GetImageCacheStats();
+    *os << "Color convert image cache hits: " << stats.hits << " misses: " << stats.misses
+        << " evictions: " << stats.evictions << std::endl;
+  }
+}
+
 void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
-                                  SyncTask<ColorConvertTaskCode>::TaskContext *task_context) {
+                                  AsyncTask<ColorConvertTaskCode>::TaskContext *task_context) {
   switch (task_code) {
     case ColorConvertTaskCode::kCodeGetInstance: {
         gl_color_convert_ = GLColorConvert::GetInstance(kTargetYUV, output_buffer_.flags.secure);
@@ -236,6 +281,7 @@ void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
         gl_color_convert_->Blit(ctx->src_hnd, ctx->dst_hnd, ctx->src_rect, ctx->dst_rect,
                                 ctx->src_acquire_fence, ctx->dst_acquire_fence,
                                 &(ctx->release_fence));
+        blit_timeline_->OnBlitSubmitted(ctx->release_fence);
       }
       break;
     case ColorConvertTaskCode::kCodeReset: {
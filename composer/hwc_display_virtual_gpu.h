@@ -66,7 +66,10 @@
 #ifndef __HWC_DISPLAY_VIRTUAL_GPU_H__
 #define __HWC_DISPLAY_VIRTUAL_GPU_H__
 
-#include "utils/sync_task.h"
+#include <memory>
+
+#include "utils/async_task.h"
+#include "hwc_blit_timeline.h"
 #include "hwc_display_virtual.h"
 #include "gl_color_convert.h"
 
@@ -79,11 +82,11 @@ enum class ColorConvertTaskCode : int32_t {
   kCodeDestroyInstance,
 };
 
-struct ColorConvertGetInstanceContext : public SyncTask<ColorConvertTaskCode>::TaskContext {
+struct ColorConvertGetInstanceContext : public AsyncTask<ColorConvertTaskCode>::TaskContext {
   LayerBuffer *output_buffer = NULL;
 };
 
-struct ColorConvertBlitContext : public SyncTask<ColorConvertTaskCode>::TaskContext {
+struct ColorConvertBlitContext : public AsyncTask<ColorConvertTaskCode>::TaskContext {
   const native_handle_t *src_hnd = nullptr;
   const native_handle_t *dst_hnd = nullptr;
   GLRect src_rect = {};
@@ -94,7 +97,7 @@ struct ColorConvertBlitContext : public SyncTask<ColorConvertTaskCode>::TaskCont
 };
 
 class HWCDisplayVirtualGPU : public HWCDisplayVirtual,
-                             public SyncTask<ColorConvertTaskCode>::TaskHandler {
+                             public AsyncTask<ColorConvertTaskCode>::TaskHandler {
  public:
   HWCDisplayVirtualGPU(CoreInterface *core_intf, HWCBufferAllocator *buffer_allocator,
                        HWCCallbacks *callbacks, HWCDisplayEventHandler *event_handler,
@@ -109,14 +112,27 @@ class HWCDisplayVirtualGPU : public HWCDisplayVirtual,
                                       uint32_t *out_num_types,
                                       uint32_t *out_num_requests, bool *needs_commit);
   virtual bool FreezeScreen();
+  virtual void Dump(std::ostringstream *os);
 
  private:
-  // SyncTask methods.
+  static const uint32_t kDefaultFramesInFlight = 2;
+  static const uint32_t kMaxFramesInFlight = 4;
+  // Blits of the frames in flight, and a reset.
+  static const uint32_t kMaxPendingTasks = kMaxFramesInFlight + 1;
+
+  // AsyncTask methods.
   void OnTask(const ColorConvertTaskCode &task_code,
-              SyncTask<ColorConvertTaskCode>::TaskContext *task_context);
+              AsyncTask<ColorConvertTaskCode>::TaskContext *task_context);
+  void PerformTask(const ColorConvertTaskCode &task_code,
+                   const std::shared_ptr<ColorConvertBlitContext> &task_context);
 
-  SyncTask<ColorConvertTaskCode> color_convert_task_;
+  // Declared before the task, so that the blit worker is joined first.
+  std::unique_ptr<HWCBlitTimeline> blit_timeline_;
+  AsyncTask<ColorConvertTaskCode> color_convert_task_;
   GLColorConvert *gl_color_convert_ = nullptr;
+  uint64_t frames_ = 0;
+  // Blits submitted while the consumer of the output still held the buffer.
+  uint64_t consumer_lag_frames_ = 0;
 
   bool disable_animation_ = false;
   bool animation_in_progress_ = false;
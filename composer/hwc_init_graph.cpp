@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <utils/debug.h>
+#include <chrono>
+#include <thread>
+
+#include "hwc_init_graph.h"
+
+#define __CLASS__ "HWCInitGraph"
+
+namespace sdm {
+
+void HWCInitGraph::AddStep(const std::string &name, const std::vector<std::string> &deps,
+                           const Step &step) {
+  Node node;
+  node.name = name;
+  node.step = step;
+  for (auto &dep : deps) {
+    size_t i = 0;
+    while (i < nodes_.size() && nodes_[i].name != dep) {
+      i++;
+    }
+    if (i == nodes_.size()) {
+      // Dropping it would lose an ordering guarantee without notice.
+      DLOGE("%s depends on %s, which is not an earlier step", name.c_str(), dep.c_str());
+      invalid_ = true;
+      continue;
+    }
+    node.deps.push_back(i);
+  }
+
+  nodes_.push_back(node);
+}
+
+int HWCInitGraph::Run(uint32_t num_threads) {
+  if (invalid_) {
+    DLOGE("Not running, a step has an unknown dependency");
+    return -EINVAL;
+  }
+
+  run_start_us_ = GetTimeUs();
+
+  std::vector<std::thread> workers;
+  for (uint32_t i = 1; i < num_threads && i < nodes_.size(); i++) {
+    workers.emplace_back(&HWCInitGraph::RunSteps, this);
+  }
+  RunSteps();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  run_duration_us_ = GetTimeUs() - run_start_us_;
+  DLOGI("Ran %zu steps in %" PRId64 " us", nodes_.size(), run_duration_us_);
+
+  for (auto &node : nodes_) {
+    if (node.state == kDone && node.status != 0) {
+      return node.status;
+    }
+  }
+  for (auto &node : nodes_) {
+    if (node.state != kDone) {
+      return -EINVAL;
+    }
+  }
+
+  return 0;
+}
+
+void HWCInitGraph::Dump(std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(lock_);
+  *os << "init: " << run_duration_us_ << " us" << std::endl;
+  for (auto &node : nodes_) {
+    *os << " " << node.name << ": ";
+    if (node.state == kSkipped) {
+      *os << "skipped" << std::endl;
+      continue;
+    }
+    *os << "start " << node.start_us << " us took " << node.duration_us << " us";
+    *os << " status " << node.status << std::endl;
+  }
+}
+
+void HWCInitGraph::RunSteps() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    size_t index = nodes_.size();
+    cv_.wait(lock, [this, &index] {
+      index = GetReadyStepLocked();
+      return (index < nodes_.size()) || IsFinishedLocked();
+    });
+    if (index == nodes_.size()) {
+      break;
+    }
+
+    Node &node = nodes_[index];
+    node.state = kRunning;
+    node.start_us = GetTimeUs() - run_start_us_;
+    lock.unlock();
+
+    int status = node.step();
+
+    lock.lock();
+    node.duration_us = GetTimeUs() - run_start_us_ - node.start_us;
+    node.status = status;
+    node.state = kDone;
+    DLOGI("%s: status %d, started at %" PRId64 " us, took %" PRId64 " us", node.name.c_str(),
+          status, node.start_us, node.duration_us);
+    cv_.notify_all();
+  }
+}
+
+size_t HWCInitGraph::GetReadyStepLocked() {
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    Node &node = nodes_[i];
+    if (node.state != kPending) {
+      continue;
+    }
+
+    bool ready = true;
+    for (size_t dep : node.deps) {
+      const Node &dep_node = nodes_[dep];
+      if (dep_node.state == kSkipped || (dep_node.state == kDone && dep_node.status != 0)) {
+        // Steps are added after their dependencies, those of later steps are updated below.
+        node.state = kSkipped;
+        ready = false;
+        break;
+      }
+      ready = ready && (dep_node.state == kDone);
+    }
+
+    if (ready) {
+      return i;
+    }
+  }
+
+  return nodes_.size();
+}
+
+bool HWCInitGraph::IsFinishedLocked() {
+  for (auto &node : nodes_) {
+    if (node.state == kPending || node.state == kRunning) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int64_t HWCInitGraph::GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace sdm
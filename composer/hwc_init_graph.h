@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_INIT_GRAPH_H__
+#define __HWC_INIT_GRAPH_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sdm {
+
+// Runs initialization steps concurrently, each once the steps it depends on have succeeded, and
+// records how long each one took. A step that fails, or depends on one that did, fails the run.
+class HWCInitGraph {
+ public:
+  // Returns 0 on success.
+  typedef std::function<int()> Step;
+
+  // deps name steps added earlier, so the graph has no cycles. A name that is not one of them fails
+  // the run.
+  void AddStep(const std::string &name, const std::vector<std::string> &deps, const Step &step);
+  // Runs the steps on up to num_threads threads including the caller, which returns once no step
+  // is running. Returns the status of the first failed step in the order they were added, or
+  // -EINVAL without running any step if one has an unknown dependency.
+  int Run(uint32_t num_threads);
+  void Dump(std::ostringstream *os);
+
+ private:
+  enum State {
+    kPending,
+    kRunning,
+    kDone,
+    kSkipped,  // A dependency failed.
+  };
+
+  struct Node {
+    std::string name;
+    std::vector<size_t> deps;
+    Step step = nullptr;
+    State state = kPending;
+    int status = 0;
+    int64_t start_us = 0;  // Relative to the start of the run.
+    int64_t duration_us = 0;
+  };
+
+  void RunSteps();
+  // Returns the index of a step that can run, or nodes_.size() if there is none for now.
+  size_t GetReadyStepLocked();
+  bool IsFinishedLocked();
+  static int64_t GetTimeUs();
+
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::vector<Node> nodes_;
+  int64_t run_start_us_ = 0;
+  int64_t run_duration_us_ = 0;
+  bool invalid_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_INIT_GRAPH_H__
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hwc_init_graph.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Records the order steps start and finish in.
+class Recorder {
+ public:
+  HWCInitGraph::Step GetStep(const std::string &name, int status = 0,
+                             milliseconds duration = milliseconds(0)) {
+    return [this, name, status, duration] {
+      Record("+" + name);
+      running_++;
+      max_running_ = std::max(max_running_.load(), running_.load());
+      std::this_thread::sleep_for(duration);
+      running_--;
+      Record("-" + name);
+      return status;
+    };
+  }
+
+  std::vector<std::string> events() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return events_;
+  }
+
+  bool Ran(const std::string &name) {
+    auto events = this->events();
+    return std::find(events.begin(), events.end(), "+" + name) != events.end();
+  }
+
+  // Whether first finished before second started.
+  bool Before(const std::string &first, const std::string &second) {
+    auto events = this->events();
+    auto end = std::find(events.begin(), events.end(), "-" + first);
+    auto start = std::find(events.begin(), events.end(), "+" + second);
+    return end != events.end() && start != events.end() && end < start;
+  }
+
+  int max_running() { return max_running_; }
+
+ private:
+  void Record(const std::string &event) {
+    std::lock_guard<std::mutex> lock(lock_);
+    events_.push_back(event);
+  }
+
+  std::mutex lock_;
+  std::vector<std::string> events_;
+  std::atomic<int> running_{0};
+  std::atomic<int> max_running_{0};
+};
+
+std::string Dump(HWCInitGraph *graph) {
+  std::ostringstream os;
+  graph->Dump(&os);
+  return os.str();
+}
+
+}  // namespace
+
+TEST(HWCInitGraph, Empty) {
+  HWCInitGraph graph;
+  EXPECT_EQ(0, graph.Run(3));
+}
+
+// The steps of HWCSession::Init, with the primary display last.
+TEST(HWCInitGraph, RunsDependenciesFirst) {
+  for (uint32_t threads : {1u, 2u, 3u, 8u}) {
+    Recorder recorder;
+    HWCInitGraph graph;
+    graph.AddStep("qservice", {}, recorder.GetStep("qservice", 0, milliseconds(5)));
+    graph.AddStep("properties", {}, recorder.GetStep("properties"));
+    graph.AddStep("display_slots", {"properties"}, recorder.GetStep("display_slots"));
+    graph.AddStep("color_manager", {}, recorder.GetStep("color_manager", 0, milliseconds(5)));
+    graph.AddStep("primary_display", {"qservice", "display_slots"},
+                  recorder.GetStep("primary_display"));
+    ASSERT_EQ(0, graph.Run(threads));
+
+    EXPECT_EQ(10u, recorder.events().size());
+    EXPECT_TRUE(recorder.Before("properties", "display_slots")) << threads;
+    EXPECT_TRUE(recorder.Before("qservice", "primary_display")) << threads;
+    EXPECT_TRUE(recorder.Before("display_slots", "primary_display")) << threads;
+    EXPECT_LE(recorder.max_running(), int(threads));
+  }
+}
+
+TEST(HWCInitGraph, OverlapsIndependentSteps) {
+  Recorder recorder;
+  HWCInitGraph graph;
+  for (int i = 0; i < 3; i++) {
+    std::string name = "step" + std::to_string(i);
+    graph.AddStep(name, {}, recorder.GetStep(name, 0, milliseconds(50)));
+  }
+  ASSERT_EQ(0, graph.Run(3));
+  EXPECT_EQ(3, recorder.max_running());
+}
+
+TEST(HWCInitGraph, FailureSkipsDependents) {
+  Recorder recorder;
+  HWCInitGraph graph;
+  graph.AddStep("core", {}, recorder.GetStep("core", -ENODEV));
+  graph.AddStep("other", {}, recorder.GetStep("other"));
+  graph.AddStep("display", {"core"}, recorder.GetStep("display"));
+  graph.AddStep("late", {"display", "other"}, recorder.GetStep("late"));
+  EXPECT_EQ(-ENODEV, graph.Run(2));
+
+  EXPECT_TRUE(recorder.Ran("other"));
+  EXPECT_FALSE(recorder.Ran("display"));
+  EXPECT_FALSE(recorder.Ran("late"));
+  std::string dump = Dump(&graph);
+  EXPECT_NE(std::string::npos, dump.find(" core: start ")) << dump;
+  EXPECT_NE(std::string::npos, dump.find("status -19")) << dump;
+  EXPECT_NE(std::string::npos, dump.find(" display: skipped")) << dump;
+  EXPECT_NE(std::string::npos, dump.find(" late: skipped")) << dump;
+}
+
+// The first failed step in the order they were added is reported, not the first to fail.
+TEST(HWCInitGraph, ReturnsFirstAddedFailure) {
+  Recorder recorder;
+  HWCInitGraph graph;
+  graph.AddStep("slow", {}, recorder.GetStep("slow", -EINVAL, milliseconds(20)));
+  graph.AddStep("fast", {}, recorder.GetStep("fast", -ENOMEM));
+  EXPECT_EQ(-EINVAL, graph.Run(2));
+}
+
+// A misspelt dependency must not silently drop the ordering.
+TEST(HWCInitGraph, UnknownDependencyFailsRun) {
+  Recorder recorder;
+  HWCInitGraph graph;
+  graph.AddStep("qservice", {}, recorder.GetStep("qservice"));
+  graph.AddStep("primary_display", {"qservce"}, recorder.GetStep("primary_display"));
+  EXPECT_EQ(-EINVAL, graph.Run(2));
+  EXPECT_TRUE(recorder.events().empty());
+}
+
+// Dependencies name earlier steps only, a later one is as unknown as a typo.
+TEST(HWCInitGraph, LaterDependencyFailsRun) {
+  Recorder recorder;
+  HWCInitGraph graph;
+  graph.AddStep("display", {"core"}, recorder.GetStep("display"));
+  graph.AddStep("core", {}, recorder.GetStep("core"));
+  EXPECT_EQ(-EINVAL, graph.Run(1));
+  EXPECT_TRUE(recorder.events().empty());
+}
+
+TEST(HWCInitGraph, DumpsTiming) {
+  Recorder recorder;
+  HWCInitGraph graph;
+  graph.AddStep("qservice", {}, recorder.GetStep("qservice", 0, milliseconds(10)));
+  graph.AddStep("primary_display", {"qservice"}, recorder.GetStep("primary_display"));
+  ASSERT_EQ(0, graph.Run(2));
+
+  std::string dump = Dump(&graph);
+  EXPECT_EQ(0u, dump.find("init: ")) << dump;
+  EXPECT_NE(std::string::npos, dump.find(" qservice: start ")) << dump;
+  EXPECT_NE(std::string::npos, dump.find(" primary_display: start ")) << dump;
+}
+
+}  // namespace sdm
@@ -57,6 +57,7 @@
 #include <qd_utils.h>
 #include <utils/debug.h>
 #include <stdint.h>
+#include <algorithm>
 #include <utility>
 #include <cmath>
 
@@ -429,6 +430,18 @@ HWC2::Error HWCLayer::SetLayerBuffer(buffer_handle_t buffer, shared_ptr<Fence> a
   layer_buffer->buffer_id = reinterpret_cast<uint64_t>(handle);
   layer_buffer->handle_id = handle->id;
   layer_buffer->usage = handle->usage;
+
+  // GPU composed buffers are not mapped to framebuffer objects.
+  buffer_prefetch_ = false;
+  if (std::find(recent_handle_ids_.begin(), recent_handle_ids_.end(), handle->id) ==
+      recent_handle_ids_.end()) {
+    if (recent_handle_ids_.size() >= kMaxRecentHandleIds) {
+      recent_handle_ids_.pop_front();
+    }
+    recent_handle_ids_.push_back(handle->id);
+    buffer_prefetch_ = (device_selected_ != HWC2::Composition::Client);
+  }
+
   return HWC2::Error::None;
 }
 
@@ -42,6 +42,7 @@
 #include <android/hardware/graphics/composer/2.3/IComposerClient.h>
 #include <vendor/qti/hardware/display/composer/3.1/IQtiComposerClient.h>
 
+#include <deque>
 #include <map>
 #include <set>
 
@@ -125,6 +126,8 @@ class HWCLayer {
   void SetLayerAsMask();
   bool BufferLatched() { return buffer_flipped_; }
   void ResetBufferFlip() { buffer_flipped_ = false; }
+  // The buffer set last has not been on this layer recently and has no framebuffer object yet.
+  bool NeedsBufferPrefetch() { return buffer_prefetch_; }
   shared_ptr<Fence> GetReleaseFence();
   void SetReleaseFence(const shared_ptr<Fence> &release_fence);
   bool IsLayerCompatible() { return compatible_; }
@@ -136,6 +139,9 @@ class HWCLayer {
 #endif
 
  private:
+  // Buffers whose framebuffer objects are likely still cached, same as the core UI fb_id limit.
+  static const uint32_t kMaxRecentHandleIds = 4;
+
   Layer *layer_ = nullptr;
   LayerTypes type_ = kLayerUnknown;
   uint32_t z_ = 0;
@@ -156,6 +162,8 @@ class HWCLayer {
   bool has_metadata_refresh_rate_ = false;
   bool color_transform_matrix_set_ = false;
   bool buffer_flipped_ = false;
+  bool buffer_prefetch_ = false;
+  std::deque<uint64_t> recent_handle_ids_ = {};
   bool secure_ = false;
   bool compatible_ = false;
   bool ignore_sdr_content_md_ = false;
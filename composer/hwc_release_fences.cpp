@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "hwc_release_fences.h"
+
+namespace sdm {
+
+bool HWCReleaseFences::NeedsUpdate(hwc2_layer_t layer_id, uint64_t handle_id,
+                                   const shared_ptr<Fence> &release_fence) const {
+  auto it = returned_.find(layer_id);
+  if (it == returned_.end()) {
+    return true;
+  }
+
+  // A new buffer is returned even with the same fence, e.g. a -1 while flushing, as before.
+  return (it->second.handle_id != handle_id) || (it->second.release_fence != release_fence);
+}
+
+void HWCReleaseFences::Update(hwc2_layer_t layer_id, uint64_t handle_id,
+                              const shared_ptr<Fence> &release_fence) {
+  Returned &returned = returned_[layer_id];
+  returned.handle_id = handle_id;
+  returned.release_fence = release_fence;
+}
+
+void HWCReleaseFences::RemoveLayer(hwc2_layer_t layer_id) {
+  returned_.erase(layer_id);
+}
+
+}  // namespace sdm
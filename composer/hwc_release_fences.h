@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_RELEASE_FENCES_H__
+#define __HWC_RELEASE_FENCES_H__
+
+#include <hardware/hwcomposer2.h>
+#include <utils/fence.h>
+#include <unordered_map>
+
+namespace sdm {
+
+// Keeps track of the release fence and buffer last returned to the client for each layer of a
+// display, so that a layer is returned only when either of them changed. The release fence of a
+// commit covers the buffers scanned out in that commit, and the client attaches it to the buffer
+// the layer holds. A static layer thus gets the fence of every commit that displays its buffer,
+// and the buffer carries the fence of the last of them when the client releases it, whether the
+// buffer is replaced or the layer destroyed. Only presents that did not change the fence, such as
+// those without a commit, return nothing for the layer.
+class HWCReleaseFences {
+ public:
+  bool NeedsUpdate(hwc2_layer_t layer_id, uint64_t handle_id,
+                   const shared_ptr<Fence> &release_fence) const;
+  // Called for each layer returned to the client.
+  void Update(hwc2_layer_t layer_id, uint64_t handle_id, const shared_ptr<Fence> &release_fence);
+  void RemoveLayer(hwc2_layer_t layer_id);
+
+ private:
+  struct Returned {
+    uint64_t handle_id = 0;
+    shared_ptr<Fence> release_fence = nullptr;
+  };
+
+  std::unordered_map<hwc2_layer_t, Returned> returned_;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_RELEASE_FENCES_H__
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "hwc_release_fences.h"
+
+namespace sdm {
+
+namespace {
+
+class TestSyncHandler : public BufferSyncHandler {
+ public:
+  int SyncWait(int fd, int timeout) override {
+    if (fd < 0) {
+      return 0;
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ret = poll(&pfd, 1, timeout);
+    return (ret > 0) ? 0 : (ret == 0 ? -ETIME : -errno);
+  }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override { }
+};
+
+// The release fence of one commit, an eventfd signaled once the commit is off screen.
+class TestFence {
+ public:
+  TestFence() : fd_(eventfd(0, EFD_CLOEXEC)), fence_(Fence::Create(dup(fd_), "release")) { }
+  ~TestFence() { close(fd_); }
+
+  const shared_ptr<Fence> &Get() { return fence_; }
+
+  void Signal() {
+    uint64_t value = 1;
+    ASSERT_EQ(ssize_t(sizeof(value)), write(fd_, &value, sizeof(value)));
+  }
+
+ private:
+  int fd_;
+  shared_ptr<Fence> fence_;
+};
+
+// Plays the client: a returned fence is attached to the buffer the layer holds, and a buffer is
+// released with the fence attached last, once it is replaced or its layer destroyed.
+class TestClient {
+ public:
+  void SetBuffer(hwc2_layer_t layer_id, uint64_t handle_id) {
+    auto it = buffers_.find(layer_id);
+    if (it != buffers_.end() && it->second != handle_id) {
+      released_[it->second] = fences_[it->second];
+    }
+    buffers_[layer_id] = handle_id;
+  }
+
+  void DestroyLayer(hwc2_layer_t layer_id) {
+    released_[buffers_[layer_id]] = fences_[buffers_[layer_id]];
+    buffers_.erase(layer_id);
+  }
+
+  // Returns the number of layers that got a fence.
+  int Present(HWCReleaseFences *release_fences, const shared_ptr<Fence> &release_fence) {
+    int returned = 0;
+    for (auto &it : buffers_) {
+      if (release_fences->NeedsUpdate(it.first, it.second, release_fence)) {
+        release_fences->Update(it.first, it.second, release_fence);
+        fences_[it.second] = release_fence;
+        returned++;
+      }
+    }
+    return returned;
+  }
+
+  // The fence a released buffer went back to its producer with.
+  shared_ptr<Fence> GetReleasedFence(uint64_t handle_id) { return released_.at(handle_id); }
+
+ private:
+  std::map<hwc2_layer_t, uint64_t> buffers_;
+  std::map<uint64_t, shared_ptr<Fence>> fences_;
+  std::map<uint64_t, shared_ptr<Fence>> released_;
+};
+
+class HWCReleaseFencesTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { Fence::Set(&sync_handler_); }
+
+  static TestSyncHandler sync_handler_;
+  HWCReleaseFences release_fences_;
+  TestClient client_;
+};
+
+TestSyncHandler HWCReleaseFencesTest::sync_handler_;
+
+}  // namespace
+
+TEST_F(HWCReleaseFencesTest, NewLayer) {
+  TestFence fence;
+  EXPECT_TRUE(release_fences_.NeedsUpdate(1, 10, fence.Get()));
+  EXPECT_TRUE(release_fences_.NeedsUpdate(1, 10, nullptr));
+}
+
+// A static buffer is scanned out again by every commit, and gets the fence of each of them.
+TEST_F(HWCReleaseFencesTest, StaticLayerGetsEveryFence) {
+  std::vector<TestFence> commits(3);
+  client_.SetBuffer(1, 10);
+  for (auto &commit : commits) {
+    EXPECT_EQ(1, client_.Present(&release_fences_, commit.Get()));
+  }
+}
+
+// A present without a commit leaves the fences as they were.
+TEST_F(HWCReleaseFencesTest, UnchangedFence) {
+  TestFence commit;
+  client_.SetBuffer(1, 10);
+  client_.SetBuffer(2, 20);
+  EXPECT_EQ(2, client_.Present(&release_fences_, commit.Get()));
+  EXPECT_EQ(0, client_.Present(&release_fences_, commit.Get()));
+}
+
+// A new buffer is returned even if the fence did not change, e.g. -1 on every flushed present.
+TEST_F(HWCReleaseFencesTest, NewBufferWithUnchangedFence) {
+  client_.SetBuffer(1, 10);
+  EXPECT_EQ(1, client_.Present(&release_fences_, nullptr));
+  EXPECT_EQ(0, client_.Present(&release_fences_, nullptr));
+  client_.SetBuffer(1, 11);
+  EXPECT_EQ(1, client_.Present(&release_fences_, nullptr));
+}
+
+// A buffer that stayed on screen for several commits goes back to its producer with the fence of
+// the last of them, and is not written to while that commit may still be scanning it out.
+TEST_F(HWCReleaseFencesTest, ReplacedBufferWaitsForLastScanout) {
+  std::vector<TestFence> commits(5);
+  client_.SetBuffer(1, 10);
+  client_.SetBuffer(2, 20);
+  for (auto &commit : commits) {
+    client_.Present(&release_fences_, commit.Get());
+  }
+  for (size_t i = 0; i < commits.size() - 1; i++) {
+    commits[i].Signal();
+  }
+
+  client_.SetBuffer(1, 11);
+  TestFence replaced;
+  EXPECT_EQ(2, client_.Present(&release_fences_, replaced.Get()));
+
+  shared_ptr<Fence> fence = client_.GetReleasedFence(10);
+  EXPECT_EQ(commits.back().Get(), fence);
+  EXPECT_EQ(Fence::Status::kPending, Fence::GetStatus(fence));
+  commits.back().Signal();
+  EXPECT_EQ(Fence::Status::kSignaled, Fence::GetStatus(fence));
+}
+
+// Same for the buffer of a destroyed layer, and a new layer with the id starts over.
+TEST_F(HWCReleaseFencesTest, DestroyedLayerWaitsForLastScanout) {
+  std::vector<TestFence> commits(3);
+  client_.SetBuffer(1, 10);
+  for (auto &commit : commits) {
+    client_.Present(&release_fences_, commit.Get());
+  }
+  commits[0].Signal();
+  commits[1].Signal();
+
+  client_.DestroyLayer(1);
+  release_fences_.RemoveLayer(1);
+  shared_ptr<Fence> fence = client_.GetReleasedFence(10);
+  EXPECT_EQ(commits.back().Get(), fence);
+  EXPECT_EQ(Fence::Status::kPending, Fence::GetStatus(fence));
+
+  EXPECT_TRUE(release_fences_.NeedsUpdate(1, 10, commits.back().Get()));
+}
+
+}  // namespace sdm
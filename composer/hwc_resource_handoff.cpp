@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/constants.h>
+#include <algorithm>
+
+#include "hwc_resource_handoff.h"
+
+namespace sdm {
+
+void HWCResourceHandoff::Begin() {
+  std::lock_guard<std::mutex> lock(lock_);
+  released_ = false;
+  start_ = std::chrono::steady_clock::now();
+}
+
+void HWCResourceHandoff::ResourcesReleased(hwc2_display_t display) {
+  if (display >= kMaxDisplays) {
+    return;
+  }
+  // The waiter is woken up once the commit is done, with the retire fence of this commit.
+  std::lock_guard<std::mutex> lock(lock_);
+  pending_release_.set(display);
+}
+
+void HWCResourceHandoff::CommitDone(hwc2_display_t display,
+                                    const shared_ptr<Fence> &retire_fence) {
+  std::lock_guard<std::mutex> lock(lock_);
+  bool released = (display < kMaxDisplays) && pending_release_.test(display);
+  if (display < kMaxDisplays) {
+    pending_release_.reset(display);
+  }
+  if (!committed_ || released) {
+    committed_ = true;
+    released_ |= released;
+    display_ = display;
+    retire_fence_ = retire_fence;
+    cv_.notify_one();
+  }
+}
+
+bool HWCResourceHandoff::Wait(bool first_cycle, std::chrono::milliseconds timeout,
+                              hwc2_display_t *display, shared_ptr<Fence> *retire_fence) {
+  std::unique_lock<std::mutex> lock(lock_);
+  committed_ = false;
+  bool done = cv_.wait_for(lock, timeout, [this, first_cycle] {
+    return first_cycle ? committed_ : released_;
+  });
+  released_ = false;
+  *display = display_;
+  *retire_fence = retire_fence_;
+  retire_fence_ = nullptr;
+
+  return done;
+}
+
+uint64_t HWCResourceHandoff::End() {
+  std::lock_guard<std::mutex> lock(lock_);
+  uint64_t wait_ms = UINT64(std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - start_).count());
+  count_++;
+  total_ms_ += wait_ms;
+  max_ms_ = std::max(max_ms_, wait_ms);
+
+  return wait_ms;
+}
+
+void HWCResourceHandoff::Dump(std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(lock_);
+  *os << "resource handoff: count: " << count_;
+  *os << " total: " << total_ms_ << " ms";
+  *os << " max: " << max_ms_ << " ms" << std::endl;
+}
+
+}  // namespace sdm
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_RESOURCE_HANDOFF_H__
+#define __HWC_RESOURCE_HANDOFF_H__
+
+#include <hardware/hwcomposer2.h>
+#include <utils/fence.h>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+
+namespace sdm {
+
+// Wakes up WaitForResources when display resources move from one display to another. The first
+// wait of a handoff ends on the next commit of any display, which applies the new configuration
+// of the built-in display. Later waits end only on the commit that SDM reported as releasing the
+// resources, commits that release nothing do not wake the waiter up.
+class HWCResourceHandoff {
+ public:
+  static const uint32_t kMaxDisplays = 32;
+
+  void Begin();
+  // Called from the commit of display, before CommitDone is called for it.
+  void ResourcesReleased(hwc2_display_t display);
+  void CommitDone(hwc2_display_t display, const shared_ptr<Fence> &retire_fence);
+  // Returns false on timeout. Otherwise display and retire_fence are those of the commit that
+  // ended the wait.
+  bool Wait(bool first_cycle, std::chrono::milliseconds timeout, hwc2_display_t *display,
+            shared_ptr<Fence> *retire_fence);
+  // Returns the time spent since Begin, in ms.
+  uint64_t End();
+  void Dump(std::ostringstream *os);
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool committed_ = false;
+  // Set by the commit that released the resources being waited for.
+  bool released_ = false;
+  std::bitset<kMaxDisplays> pending_release_;
+  hwc2_display_t display_ = 0;
+  shared_ptr<Fence> retire_fence_ = nullptr;
+  std::chrono::steady_clock::time_point start_;
+  uint32_t count_ = 0;
+  uint64_t total_ms_ = 0;
+  uint64_t max_ms_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_RESOURCE_HANDOFF_H__
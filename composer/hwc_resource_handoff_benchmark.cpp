@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "hwc_resource_handoff.h"
+
+namespace sdm {
+
+// Handoffs between displays that commit every period, one of which releases the resources on
+// its fourth commit. Reports the time from the releasing commit to the end of the wait.
+static void BM_ResourceHandoff(benchmark::State &state) {
+  const std::chrono::microseconds period(state.range(0));
+  HWCResourceHandoff handoff;
+  for (auto _ : state) {
+    std::atomic<bool> stop(false);
+    std::atomic<int64_t> release_ns(0);
+    handoff.Begin();
+    std::thread committer([&] {
+      for (uint32_t i = 0; !stop; i++) {
+        std::this_thread::sleep_for(period);
+        handoff.CommitDone(0, nullptr);
+        if (i == 4) {
+          handoff.ResourcesReleased(1);
+          release_ns = std::chrono::steady_clock::now().time_since_epoch().count();
+        }
+        handoff.CommitDone(1, nullptr);
+      }
+    });
+
+    hwc2_display_t display = 0;
+    shared_ptr<Fence> retire_fence = nullptr;
+    handoff.Wait(true, std::chrono::milliseconds(100), &display, &retire_fence);
+    while (!handoff.Wait(false, std::chrono::milliseconds(100), &display, &retire_fence)) {
+    }
+    int64_t now_ns = std::chrono::steady_clock::now().time_since_epoch().count();
+    state.SetIterationTime(static_cast<double>(now_ns - release_ns) / 1e9);
+    handoff.End();
+    stop = true;
+    committer.join();
+  }
+}
+BENCHMARK(BM_ResourceHandoff)->ArgName("period_us")->Arg(1000)->Arg(16666)->UseManualTime()
+    ->Iterations(20);
+
+}  // namespace sdm
+
+BENCHMARK_MAIN();
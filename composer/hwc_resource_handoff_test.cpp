@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "hwc_resource_handoff.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const milliseconds kTimeout(100);
+const milliseconds kShortTimeout(20);
+
+shared_ptr<Fence> CreateFence(const std::string &name) {
+  return Fence::Create(eventfd(0, EFD_CLOEXEC), name);
+}
+
+// Commits a display every period until stopped, reporting a release on the given commit.
+class Committer {
+ public:
+  Committer(HWCResourceHandoff *handoff, hwc2_display_t display, milliseconds period,
+            uint32_t release_at)
+    : thread_([=] {
+        for (uint32_t i = 0; !stop_; i++) {
+          std::this_thread::sleep_for(period);
+          if (i == release_at) {
+            handoff->ResourcesReleased(display);
+          }
+          handoff->CommitDone(display, nullptr);
+          commits_++;
+        }
+      }) { }
+
+  ~Committer() {
+    stop_ = true;
+    thread_.join();
+  }
+
+  uint32_t commits() const { return commits_; }
+
+ private:
+  std::atomic<bool> stop_{false};
+  std::atomic<uint32_t> commits_{0};
+  std::thread thread_;
+};
+
+}  // namespace
+
+// As before the notification, the first wait ends on the next commit of any display.
+TEST(HWCResourceHandoff, FirstWaitEndsOnAnyCommit) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  auto fence = CreateFence("retire");
+  std::thread committer([&] {
+    std::this_thread::sleep_for(milliseconds(10));
+    handoff.CommitDone(2, fence);
+  });
+
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  EXPECT_TRUE(handoff.Wait(true, kTimeout * 10, &display, &retire_fence));
+  EXPECT_EQ(2u, display);
+  EXPECT_EQ(fence, retire_fence);
+  committer.join();
+}
+
+TEST(HWCResourceHandoff, FirstWaitTimesOut) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  EXPECT_FALSE(handoff.Wait(true, kShortTimeout, &display, &retire_fence));
+  EXPECT_EQ(nullptr, retire_fence);
+}
+
+// Commits that release nothing do not end the later waits.
+TEST(HWCResourceHandoff, LaterWaitsIgnoreCommits) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  Committer committer(&handoff, 1, milliseconds(2), UINT32_MAX);
+
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  EXPECT_TRUE(handoff.Wait(true, kTimeout * 10, &display, &retire_fence));
+  EXPECT_FALSE(handoff.Wait(false, kTimeout, &display, &retire_fence));
+  EXPECT_GT(committer.commits(), 5u);
+}
+
+// A release reported by a commit ends the wait once that commit is done, with its fence.
+TEST(HWCResourceHandoff, ReleaseEndsWaitWithItsCommit) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+
+  handoff.ResourcesReleased(3);
+  EXPECT_FALSE(handoff.Wait(false, kShortTimeout, &display, &retire_fence));
+
+  auto fence = CreateFence("release");
+  std::thread committer([&] {
+    std::this_thread::sleep_for(milliseconds(10));
+    handoff.CommitDone(1, nullptr);
+    handoff.CommitDone(3, fence);
+  });
+  EXPECT_TRUE(handoff.Wait(false, kTimeout * 10, &display, &retire_fence));
+  EXPECT_EQ(3u, display);
+  EXPECT_EQ(fence, retire_fence);
+  committer.join();
+}
+
+// A release that happened before the waiter got to wait is not lost.
+TEST(HWCResourceHandoff, ReleaseBeforeWait) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  handoff.ResourcesReleased(4);
+  handoff.CommitDone(4, nullptr);
+
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  EXPECT_TRUE(handoff.Wait(false, kShortTimeout, &display, &retire_fence));
+  EXPECT_EQ(4u, display);
+  // It is consumed by that wait.
+  EXPECT_FALSE(handoff.Wait(false, kShortTimeout, &display, &retire_fence));
+}
+
+// A new handoff does not end on a release left over from the previous one.
+TEST(HWCResourceHandoff, BeginDropsStaleRelease) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  handoff.ResourcesReleased(1);
+  handoff.CommitDone(1, nullptr);
+  handoff.End();
+
+  handoff.Begin();
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  EXPECT_FALSE(handoff.Wait(false, kShortTimeout, &display, &retire_fence));
+}
+
+TEST(HWCResourceHandoff, IgnoresOutOfRangeDisplays) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  handoff.ResourcesReleased(HWCResourceHandoff::kMaxDisplays);
+  handoff.CommitDone(HWCResourceHandoff::kMaxDisplays, nullptr);
+
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  EXPECT_FALSE(handoff.Wait(false, kShortTimeout, &display, &retire_fence));
+}
+
+// A handoff over displays committing at 60 fps takes about as long as the releasing commit,
+// while the polling it replaced woke up on every commit.
+TEST(HWCResourceHandoff, MultiDisplayLatency) {
+  HWCResourceHandoff handoff;
+  handoff.Begin();
+  Committer builtin(&handoff, 0, milliseconds(16), UINT32_MAX);
+  Committer pluggable(&handoff, 1, milliseconds(16), 5);
+
+  hwc2_display_t display = 0;
+  shared_ptr<Fence> retire_fence = nullptr;
+  ASSERT_TRUE(handoff.Wait(true, kTimeout * 10, &display, &retire_fence));
+  int timeouts = 0;
+  while (!handoff.Wait(false, kTimeout * 10, &display, &retire_fence)) {
+    timeouts++;
+  }
+  uint64_t wait_ms = handoff.End();
+  EXPECT_EQ(0, timeouts);
+  EXPECT_EQ(1u, display);
+  EXPECT_LT(wait_ms, 500u);
+
+  std::ostringstream os;
+  handoff.Dump(&os);
+  EXPECT_NE(std::string::npos, os.str().find("count: 1"));
+}
+
+}  // namespace sdm
@@ -49,6 +49,8 @@
 #include <thread>
 #include <vector>
 
+#include "gl_color_convert.h"
+#include "gl_layer_stitch.h"
 #include "hwc_buffer_allocator.h"
 #include "hwc_session.h"
 #include "hwc_debugger.h"
@@ -67,10 +69,6 @@ static HWCUEvent g_hwc_uevent_;
 Locker HWCSession::locker_[HWCCallbacks::kNumDisplays];
 bool HWCSession::pending_power_mode_[HWCCallbacks::kNumDisplays];
 Locker HWCSession::hdr_locker_[HWCCallbacks::kNumDisplays];
-std::bitset<HWCSession::kClientMax>
-    HWCSession::clients_waiting_for_commit_[HWCCallbacks::kNumDisplays];
-shared_ptr<Fence> HWCSession::retire_fence_[HWCCallbacks::kNumDisplays];
-int HWCSession::commit_error_[HWCCallbacks::kNumDisplays] = { 0 };
 Locker HWCSession::display_config_locker_;
 std::mutex HWCSession::command_seq_mutex_;
 static const int kSolidFillDelay = 100 * 1000;
@@ -169,7 +167,6 @@ int HWCSession::Init() {
   DLOGI("Initializing HWCSession");
 
   int status = -EINVAL;
-  const char *qservice_name = "display.qservice";
 
   if (!g_hwc_uevent_.InitDone()) {
     DLOGE("HWCUEvent initialization is not done!");
@@ -178,6 +175,69 @@ int HWCSession::Init() {
     DLOGI("HWCUEvent initialization confirmed to be completed");
   }
 
+  // QService, core creation and the color manager libraries do not depend on each other and are
+  // dominated by binder calls, ioctls and library loading, overlap them. The primary display needs
+  // QService and the core, the color manager libraries load alongside it.
+  HWCColorManager *color_mgr = nullptr;
+  init_graph_.AddStep("qservice", {}, [this] { return InitQService(); });
+  init_graph_.AddStep("properties", {}, [this] {
+    ReadProperties();
+    return 0;
+  });
+  init_graph_.AddStep("display_slots", {"properties"}, [this] {
+    DLOGI("Initializing supported display slots");
+    InitSupportedDisplaySlots();
+    DLOGI("Initializing supported display slots...done!");
+    return 0;
+  });
+  init_graph_.AddStep("color_manager", {}, [this, &color_mgr] {
+    color_mgr = HWCColorManager::CreateColorManager(&buffer_allocator_);
+    if (!color_mgr) {
+      DLOGW("Failed to load HWCColorManager.");
+    }
+    return 0;
+  });
+  // Remaining builtin displays will be created after client has set display indexes which may
+  // happen sometime before callback is registered.
+  init_graph_.AddStep("primary_display", {"qservice", "display_slots"}, [this] {
+    DLOGI("Creating the Primary display");
+    int status = CreatePrimaryDisplay();
+    if (status) {
+      DLOGE("Creating the Primary display...failed!");
+    } else {
+      DLOGI("Creating the Primary display...done!");
+    }
+    return status;
+  });
+  status = init_graph_.Run(kInitThreads);
+  if (status) {
+    if (color_mgr) {
+      color_mgr->DestroyColorManager();
+    }
+    Deinit();
+    return status;
+  }
+
+  // Set once the primary display exists, QDCM commands are dispatched to it.
+  color_mgr_ = color_mgr;
+
+  is_composer_up_ = true;
+  StartServices();
+
+  PostInit();
+
+  int value = 0;
+  Debug::Get()->GetProperty(DISABLE_GL_PROGRAM_WARMUP, &value);
+  if (value != 1) {
+    gl_warm_up_thread_ = std::thread(&HWCSession::WarmGLPrograms);
+  }
+
+  DLOGI("Initializing HWCSession...done!");
+  return 0;
+}
+
+int HWCSession::InitQService() {
+  const char *qservice_name = "display.qservice";
 
   // Start QService and connect to it.
   DLOGI("Initializing QService");
@@ -198,6 +258,10 @@ int HWCSession::Init() {
     return -EINVAL;
   }
 
+  return 0;
+}
+
+void HWCSession::ReadProperties() {
   int value = 0;  // Default value when property is not present.
   HWCDebugHandler::Get()->GetProperty(ENABLE_VERBOSE_LOG, &value);
   if (value == 1) {
@@ -229,30 +293,17 @@ int HWCSession::Init() {
   Debug::Get()->GetProperty(ENABLE_HWC_VDS, prop_str);
   debug_enable_hwc_vds_ = (strcmp(prop_str, "true") == 0);
   DLOGI("debug_enable_hwc_vds: %d", debug_enable_hwc_vds_);
+}
 
-  DLOGI("Initializing supported display slots");
-  InitSupportedDisplaySlots();
-  DLOGI("Initializing supported display slots...done!");
-
-  // Create primary display here. Remaining builtin displays will be created after client has set
-  // display indexes which may happen sometime before callback is registered.
-  DLOGI("Creating the Primary display");
-  status = CreatePrimaryDisplay();
-  if (status) {
-    DLOGE("Creating the Primary display...failed!");
-    Deinit();
-    return status;
-  } else {
-    DLOGI("Creating the Primary display...done!");
-  }
-
-  is_composer_up_ = true;
-  StartServices();
-
-  PostInit();
-
-  DLOGI("Initializing HWCSession...done!");
-  return 0;
+void HWCSession::WarmGLPrograms() {
+  // Link the GPU composition programs once in the background, so that their binaries are in the
+  // program cache before the first layer-stitch frame or virtual display needs them.
+  // The thread keeps the normal priority it was created with, so it does not compete with the
+  // composer threads during boot.
+  DTRACE_SCOPED();
+  GLLayerStitch::WarmUp();
+  GLColorConvert::WarmUp(kTargetYUV);
+  DLOGI("GL programs warmed up");
 }
 
 void HWCSession::PostInit() {
@@ -263,6 +314,11 @@ void HWCSession::PostInit() {
 }
 
 int HWCSession::Deinit() {
+  // The GL teardown of the displays must not overlap the warm-up contexts.
+  if (gl_warm_up_thread_.joinable()) {
+    gl_warm_up_thread_.join();
+  }
+
   // Destroy all connected displays
   DestroyDisplay(&map_info_primary_);
 
@@ -537,6 +593,8 @@ void HWCSession::Dump(uint32_t *out_size, char *out_buffer) {
       }
     }
     Fence::Dump(&os);
+    init_graph_.Dump(&os);
+    resource_handoff_.Dump(&os);
 
     std::string s = os.str();
     auto copied = s.copy(out_buffer, std::min(s.size(), max_dump_size), 0);
@@ -845,11 +903,7 @@ int32_t HWCSession::PresentDisplay(hwc2_display_t display, shared_ptr<Fence> *ou
   }
 
   if (status != HWC2::Error::None && status != HWC2::Error::NotValidated) {
-    if (clients_waiting_for_commit_[display].any()) {
-      retire_fence_[display] = nullptr;
-      commit_error_[display] = -EINVAL;
-      clients_waiting_for_commit_[display].reset();
-    }
+    commit_done_notifier_.CommitFailed(display, -EINVAL);
     SEQUENCE_CANCEL_SCOPE_LOCK(locker_[display]);
   }
 
@@ -861,11 +915,23 @@ int32_t HWCSession::PresentDisplay(hwc2_display_t display, shared_ptr<Fence> *ou
 void HWCSession::PostCommitLocked(hwc2_display_t display, shared_ptr<Fence> &retire_fence) {
   PerformIdleStatusCallback(display);
 
-  if (clients_waiting_for_commit_[display].any()) {
-    retire_fence_[display] = retire_fence;
-    commit_error_[display] = 0;
-    clients_waiting_for_commit_[display].reset();
+  if (!commit_done_notifier_.HasSubscribers(display)) {
+    return;
   }
+
+  int timeout_ms = GetCommitDoneTimeoutMs(display);
+  DLOGI("timeout in ms %d", timeout_ms);
+  commit_done_notifier_.CommitDone(display, retire_fence, timeout_ms);
+}
+
+int HWCSession::GetCommitDoneTimeoutMs(hwc2_display_t display) {
+  uint32_t config = 0;
+  hwc_display_[display]->GetActiveDisplayConfig(&config);
+  DisplayConfigVariableInfo display_attributes = {};
+  hwc_display_[display]->GetDisplayAttributesForConfig(config, &display_attributes);
+
+  return INT32(kNumDrawCycles * (display_attributes.vsync_period_ns / kDenomNstoMs)) +
+         kCommitDoneTimeoutMs;
 }
 
 void HWCSession::PostCommitUnlocked(hwc2_display_t display, const shared_ptr<Fence> &retire_fence,
@@ -877,13 +943,7 @@ void HWCSession::PostCommitUnlocked(hwc2_display_t display, const shared_ptr<Fen
     cwb_.PresentDisplayDone(display);
   }
   display_ready_.set(UINT32(display));
-  std::unique_lock<std::mutex> caller_lock(hotplug_mutex_);
-  if (!resource_ready_) {
-    resource_ready_ = true;
-    active_display_id_ = display;
-    cached_retire_fence_ = retire_fence;
-    hotplug_cv_.notify_one();
-  }
+  resource_handoff_.CommitDone(display, retire_fence);
 }
 
 void HWCSession::HandlePendingRefresh() {
@@ -948,6 +1008,8 @@ void HWCSession::RegisterCallback(int32_t descriptor, hwc2_callback_data_t callb
       DLOGW("Failed handling built-in displays.");
     }
     DLOGI("Handling pluggable displays...");
+    // Hotplug uevents were dropped until now.
+    core_intf_->NotifyHotplug();
     int32_t err = HandlePluggableDisplays(false);
     if (err) {
       DLOGW("All displays could not be created. Error %d '%s'. Hotplug handling %s.", err,
@@ -1067,7 +1129,7 @@ int32_t HWCSession::SetLayerBlendMode(hwc2_display_t display, hwc2_layer_t layer
 int32_t HWCSession::SetLayerBuffer(hwc2_display_t display, hwc2_layer_t layer,
                                    buffer_handle_t buffer,
                                    const shared_ptr<Fence> &acquire_fence) {
-  return CallLayerFunction(display, layer, &HWCLayer::SetLayerBuffer, buffer, acquire_fence);
+  return CallDisplayFunction(display, &HWCDisplay::SetLayerBuffer, layer, buffer, acquire_fence);
 }
 
 int32_t HWCSession::SetLayerColor(hwc2_display_t display, hwc2_layer_t layer, hwc_color_t color) {
@@ -1309,8 +1371,17 @@ HWC2::Error HWCSession::CreateVirtualDisplayObj(uint32_t width, uint32_t height,
   core_intf_->ReserveDisplay(kVirtual);
   // Trigger Refresh.
   callbacks_.Refresh(HWC_DISPLAY_PRIMARY);
-  // Ideally we need to wait on all connected displays.
-  WaitForCommitDoneAsync(HWC_DISPLAY_PRIMARY, kClientVirtualDisplay);
+  // Ideally we need to wait on all connected displays. The wait is only for the primary commit
+  // that stops using the reserved resources, bound it by a couple of frames of that display
+  // rather than by the generic bound, which would hold the WFD client for seconds.
+  int timeout_ms = kCommitDoneAsyncTimeoutMs;
+  {
+    SCOPE_LOCK(locker_[HWC_DISPLAY_PRIMARY]);
+    if (hwc_display_[HWC_DISPLAY_PRIMARY]) {
+      timeout_ms = 2 * GetCommitDoneTimeoutMs(HWC_DISPLAY_PRIMARY);
+    }
+  }
+  WaitForCommitDoneAsync(HWC_DISPLAY_PRIMARY, kClientVirtualDisplay, timeout_ms);
   // Lock confined to this scope
   int status = -EINVAL;
   for (auto &map_info : map_info_virtual_) {
@@ -2597,6 +2668,7 @@ void HWCSession::UEventHandler(const char *uevent_data, int length) {
           hpd_bpp_, hpd_pattern_);
 
     // Handle hotplug.
+    core_intf_->NotifyHotplug();
     int32_t err = HandlePluggableDisplays(true);
     if (err) {
       DLOGW("Hotplug handling failed. Error %d '%s'. Hotplug handling %s.", err,
@@ -2713,11 +2785,6 @@ int HWCSession::CreatePrimaryDisplay() {
 
         map_info_primary_.disp_type = info.display_type;
         map_info_primary_.sdm_id = info.display_id;
-        color_mgr_ = HWCColorManager::CreateColorManager(&buffer_allocator_);
-        if (!color_mgr_) {
-          DLOGW("Failed to load HWCColorManager.");
-        }
-
       } else {
         DLOGE("Primary display creation has failed! status = %d", status);
         return status;
@@ -3073,6 +3140,9 @@ void HWCSession::DestroyDisplay(DisplayMapInfo *map_info) {
       DestroyNonPluggableDisplay(map_info);
       break;
     }
+
+  // Nothing will be committed for this display anymore.
+  commit_done_notifier_.RemoveDisplay(map_info->client_id);
 }
 
 void HWCSession::DestroyPluggableDisplay(DisplayMapInfo *map_info) {
@@ -3210,6 +3280,10 @@ void HWCSession::DisplayPowerReset() {
   std::thread(&HWCSession::PerformDisplayPowerReset, this).detach();
 }
 
+void HWCSession::ResourcesReleased(hwc2_display_t display) {
+  resource_handoff_.ResourcesReleased(display);
+}
+
 void HWCSession::VmReleaseDone(hwc2_display_t display) {
   SCOPE_LOCK(vm_release_locker_[display]);
   if (clients_waiting_for_vm_release_.test(display)) {
@@ -3730,6 +3804,7 @@ int HWCSession::WaitForResources(bool wait_for_resources, hwc2_display_t active_
   if (wait_for_resources) {
     bool res_wait = true;
     bool needs_active_builtin_reconfig = false;
+    resource_handoff_.Begin();
     if (enable_primary_reconfig_req_) {
       // todo (user): move this logic to wait for MDP resource reallocation/reconfiguration
       // to SDM module.
@@ -3767,26 +3842,28 @@ int HWCSession::WaitForResources(bool wait_for_resources, hwc2_display_t active_
         }
       }
     }
+    bool first_cycle = true;
     do {
       if (client_connected_) {
         Refresh(active_builtin_id);
       }
       {
-        std::unique_lock<std::mutex> caller_lock(hotplug_mutex_);
-        resource_ready_ = false;
-
+        // The first wait is for the refresh above to apply the new display configuration. Later
+        // waits are for the commit that releases the resources, SDM reports it once it happens.
+        // The deadline keeps refreshing in case no display commits on its own.
         const uint32_t min_vsync_period_ms = 100;
-        auto timeout = std::chrono::system_clock::now() +
-                         std::chrono::milliseconds(min_vsync_period_ms);
-        if (hotplug_cv_.wait_until(caller_lock, timeout) == std::cv_status::timeout) {
+        hwc2_display_t committed_display = 0;
+        shared_ptr<Fence> retire_fence = nullptr;
+        if (!resource_handoff_.Wait(first_cycle, std::chrono::milliseconds(min_vsync_period_ms),
+                                    &committed_display, &retire_fence)) {
           DLOGW("hotplug timeout");
         }
+        first_cycle = false;
 
-        if (active_display_id_ == active_builtin_id && needs_active_builtin_reconfig &&
-            cached_retire_fence_) {
-          Fence::Wait(cached_retire_fence_);
+        if (committed_display == active_builtin_id && needs_active_builtin_reconfig &&
+            retire_fence) {
+          Fence::Wait(retire_fence);
         }
-        cached_retire_fence_ == nullptr;
       }
       {
         SCOPE_LOCK(locker_[display_id]);
@@ -3802,6 +3879,9 @@ int HWCSession::WaitForResources(bool wait_for_resources, hwc2_display_t active_
         }
       }
     } while (res_wait || needs_active_builtin_reconfig);
+
+    uint64_t wait_ms = resource_handoff_.End();
+    DLOGI("Resources ready for display %" PRIu64 " after %" PRIu64 " ms", display_id, wait_ms);
   }
 
   return 0;
@@ -3827,62 +3907,28 @@ int32_t HWCSession::SetActiveConfigWithConstraints(
                              vsync_period_change_constraints, out_timeline);
 }
 
-int HWCSession::WaitForCommitDoneAsync(hwc2_display_t display, int client_id) {
-  std::chrono::milliseconds span(5000);
-  auto &future = client_id == kClientVirtualDisplay ? wfd_refresh_future_ : commit_done_future_[display];
-  if (future.valid()) {
-    if (client_id == kClientVirtualDisplay) {
-      return 0;	
-    }
-    std::future_status status = future.wait_for(std::chrono::milliseconds(0));
-    if (status != std::future_status::ready) {
-      // Previous task is stuck. Bail out early.
-      return -ETIMEDOUT;
-    }
-  }
+std::shared_future<int> HWCSession::SubscribeCommitDone(hwc2_display_t display, int client_id) {
+  // Wait for the draw cycle in progress, the subscription is for the one the refresh triggers.
+  SEQUENCE_WAIT_SCOPE_LOCK(locker_[display]);
+  std::shared_future<int> commit_done = commit_done_notifier_.Subscribe(display, client_id);
+  callbacks_.Refresh(display);
+
+  return commit_done;
+}
 
-  future = std::async([](HWCSession* session, hwc2_display_t display, int client_id) {
-                         return session->WaitForCommitDone(display, client_id);
-                         }, this, display, client_id);
-  if (future.wait_for(span) == std::future_status::timeout) {
+int HWCSession::WaitForCommitDoneAsync(hwc2_display_t display, int client_id, int timeout_ms) {
+  std::chrono::milliseconds span(timeout_ms);
+  std::shared_future<int> commit_done = SubscribeCommitDone(display, client_id);
+  if (commit_done.wait_for(span) == std::future_status::timeout) {
     DLOGW("WaitForCommitDoneAsync timed out");
     return -ETIMEDOUT;
   }
-  return future.get();
+
+  return commit_done.get();
 }
 
 int HWCSession::WaitForCommitDone(hwc2_display_t display, int client_id) {
-  shared_ptr<Fence> retire_fence = nullptr;
-  int timeout_ms = -1;
-  {
-    SEQUENCE_WAIT_SCOPE_LOCK(locker_[display]);
-    callbacks_.Refresh(display);
-    clients_waiting_for_commit_[display].set(client_id);
-    locker_[display].Wait();
-    if (commit_error_[display] != 0) {
-      DLOGE("Commit done failed with error %d for client %d display %" PRIu64,
-            commit_error_[display], client_id, display);
-      commit_error_[display] = 0;
-      return -EINVAL;
-    }
-    retire_fence = retire_fence_[display];
-    retire_fence_[display] = nullptr;
-    if (hwc_display_[display]) {
-      uint32_t config = 0;
-      hwc_display_[display]->GetActiveDisplayConfig(&config);
-      DisplayConfigVariableInfo display_attributes = {};
-      hwc_display_[display]->GetDisplayAttributesForConfig(config, &display_attributes);
-      timeout_ms = kNumDrawCycles * (display_attributes.vsync_period_ns / kDenomNstoMs);
-      DLOGI("timeout in ms %d", timeout_ms);
-    }
-  }
-
-  int ret = Fence::Wait(retire_fence, timeout_ms + kCommitDoneTimeoutMs);
-  if (ret != 0) {
-    DLOGE("Retire fence wait failed with error %d for client %d display %" PRIu64, ret,
-          client_id, display);
-  }
-  return ret;
+  return SubscribeCommitDone(display, client_id).get();
 }
 
 int HWCSession::WaitForVmRelease(hwc2_display_t display, int timeout_ms) {
@@ -47,6 +47,7 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <thread>
 #include <core/display_interface.h>
 
 #include "hwc_callbacks.h"
@@ -60,7 +61,10 @@
 #include "hwc_socket_handler.h"
 #include "hwc_display_event_handler.h"
 #include "hwc_buffer_sync_handler.h"
+#include "hwc_commit_done_notifier.h"
 #include "hwc_display_virtual_factory.h"
+#include "hwc_init_graph.h"
+#include "hwc_resource_handoff.h"
 
 using ::android::hardware::Return;
 using ::android::hardware::hidl_string;
@@ -313,6 +317,7 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   virtual void PerformQsyncCallback(hwc2_display_t display, bool qsync_enabled,
                                     uint32_t refresh_rate, uint32_t qsync_refresh_rate);
   virtual void VmReleaseDone(hwc2_display_t display);
+  virtual void ResourcesReleased(hwc2_display_t display);
   virtual void NotifyConcurrencyFps(const float fps, DisplayConcurrencyType concurrency,
                                     bool concurrency_begin);
 
@@ -339,9 +344,6 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   static Locker hdr_locker_[HWCCallbacks::kNumDisplays];
   static Locker display_config_locker_;
   static std::mutex command_seq_mutex_;
-  static std::bitset<kClientMax> clients_waiting_for_commit_[HWCCallbacks::kNumDisplays];
-  static shared_ptr<Fence> retire_fence_[HWCCallbacks::kNumDisplays];
-  static int commit_error_[HWCCallbacks::kNumDisplays];
   static Locker vm_release_locker_[HWCCallbacks::kNumDisplays];
   static std::bitset<HWCCallbacks::kNumDisplays> clients_waiting_for_vm_release_;
   static std::set<hwc2_display_t> active_displays_;
@@ -479,16 +481,16 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   static const int kExternalConnectionTimeoutMs = 500;
   static const int kVmReleaseTimeoutMs = 100;
   static const int kCommitDoneTimeoutMs = 100;
+  static const int kCommitDoneAsyncTimeoutMs = 5000;
   static const int kVmReleaseRetry = 3;
   static const int kDenomNstoMs = 1000000;
   static const int kNumDrawCycles = 3;
+  static const uint32_t kInitThreads = 3;
 
   uint32_t throttling_refresh_rate_ = 60;
-  std::mutex hotplug_mutex_;
-  std::condition_variable hotplug_cv_;
-  bool resource_ready_ = false;
-  hwc2_display_t active_display_id_ = 0;
-  shared_ptr<Fence> cached_retire_fence_ = nullptr;
+  static_assert(HWCCallbacks::kNumDisplays <= HWCResourceHandoff::kMaxDisplays,
+                "Resource handoff cannot track all displays");
+  HWCResourceHandoff resource_handoff_;
   void UpdateThrottlingRate();
   void SetNewThrottlingRate(uint32_t new_rate);
 
@@ -527,6 +529,9 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   int32_t getDisplayMaxBrightness(uint32_t display, uint32_t *max_brightness_level);
   bool HasHDRSupport(HWCDisplay *hwc_display);
   void PostInit();
+  int InitQService();
+  void ReadProperties();
+  static void WarmGLPrograms();
   int GetDispTypeFromPhysicalId(uint64_t physical_disp_id, DispType *disp_type);
   DisplayError WaitForPrimaryHotplug(HWDisplayInterfaceInfo *hw_disp_info);
   void HandlePluggablePrimaryDisplay(HWDisplaysInfo *hw_displays_info);
@@ -596,8 +601,13 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   void PostCommitUnlocked(hwc2_display_t display, const shared_ptr<Fence> &retire_fence,
                           HWC2::Error status);
   void PostCommitLocked(hwc2_display_t display, shared_ptr<Fence> &retire_fence);
+  // Bound of the retire fence wait of a commit. Called with locker_[display] held.
+  int GetCommitDoneTimeoutMs(hwc2_display_t display);
+  // Resolved once the commit triggered by this call is retired, see HWCCommitDoneNotifier.
+  std::shared_future<int> SubscribeCommitDone(hwc2_display_t display, int client_id);
   int WaitForCommitDone(hwc2_display_t display, int client_id);
-  int WaitForCommitDoneAsync(hwc2_display_t display, int client_id);
+  int WaitForCommitDoneAsync(hwc2_display_t display, int client_id,
+                             int timeout_ms = kCommitDoneAsyncTimeoutMs);
   void NotifyDisplayAttributes(hwc2_display_t display, hwc2_config_t config);
   int WaitForVmRelease(hwc2_display_t display, int timeout_ms);
 
@@ -610,6 +620,7 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   HWCBufferAllocator buffer_allocator_;
   HWCVirtualDisplayFactory virtual_display_factory_;
   HWCColorManager *color_mgr_ = nullptr;
+  HWCInitGraph init_graph_;
   DisplayMapInfo map_info_primary_;                 // Primary display (either builtin or pluggable)
   std::vector<DisplayMapInfo> map_info_builtin_;    // Builtin displays excluding primary
   std::vector<DisplayMapInfo> map_info_pluggable_;  // Pluggable displays excluding primary
@@ -657,8 +668,8 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   bool disable_non_wfd_vds_ = false;
   bool debug_enable_hwc_vds_ = false;
   bool tui_start_success_ = false;
-  std::map <hwc2_display_t, std::future<int>> commit_done_future_;
-  std::future<int> wfd_refresh_future_;
+  HWCCommitDoneNotifier commit_done_notifier_;
+  std::thread gl_warm_up_thread_;
 };
 }  // namespace sdm
 
@@ -73,10 +73,12 @@ void ToneMapSession::OnTask(const ToneMapTaskCode &task_code,
           grid_entries = lut_3d.gridEntries;
           grid_size = INT(lut_3d.gridSize);
         }
-        gpu_tone_mapper_ = TonemapperFactory_GetInstance(tone_map_config_.type,
-                                                         lut_3d.lutEntries, lut_3d.dim,
-                                                         grid_entries, grid_size,
-                                                         tone_map_config_.secure);
+        gpu_tone_mapper_ = TonemapperFactory_GetInstanceWithCacheSize(tone_map_config_.type,
+                                                                      lut_3d.lutEntries,
+                                                                      lut_3d.dim, grid_entries,
+                                                                      grid_size,
+                                                                      tone_map_config_.secure,
+                                                                      image_cache_size_);
       }
       break;
 
@@ -168,6 +170,13 @@ bool ToneMapSession::IsSameToneMapConfig(Layer *layer, PrimariesTransfer blend_c
           (layer->request.height == handle_unaligned_height));
 }
 
+HWCToneMapper::HWCToneMapper(HWCBufferAllocator *allocator) : buffer_allocator_(allocator) {
+  int value = 0;
+  if (Debug::GetProperty(EGL_IMAGE_CACHE_SIZE, &value) == kErrorNone && value > 0) {
+    image_cache_size_ = UINT32(value);
+  }
+}
+
 int HWCToneMapper::HandleToneMap(LayerStack *layer_stack) {
   uint32_t gpu_count = 0;
   DisplayError error = kErrorNone;
@@ -275,6 +284,20 @@ void HWCToneMapper::Terminate() {
   }
 }
 
+void HWCToneMapper::Dump(std::ostringstream *os) {
+  EGLImageCacheStats stats = {};
+  for (auto session : tone_map_sessions_) {
+    if (session->gpu_tone_mapper_) {
+      EGLImageCacheStats session_stats = session->gpu_tone_mapper_->getImageCacheStats();
+      stats.hits += session_stats.hits;
+      stats.misses += session_stats.misses;
+      stats.evictions += session_stats.evictions;
+    }
+  }
+  *os << "Tonemap sessions: " << tone_map_sessions_.size() << " image cache hits: " << stats.hits
+      << " misses: " << stats.misses << " evictions: " << stats.evictions << std::endl;
+}
+
 void HWCToneMapper::SetFrameDumpConfig(uint32_t count) {
   DLOGI("Dump FrameConfig count = %d", count);
   dump_frame_count_ = count;
@@ -350,6 +373,7 @@ DisplayError HWCToneMapper::AcquireToneMapSession(Layer *layer, uint32_t *sessio
   if (!session) {
     return kErrorMemory;
   }
+  session->image_cache_size_ = image_cache_size_;
 
   session->SetToneMapConfig(layer, blend_cs);
 
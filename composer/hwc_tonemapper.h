@@ -38,6 +38,7 @@
 #include <core/layer_stack.h>
 #include <utils/sys.h>
 #include <utils/sync_task.h>
+#include <sstream>
 #include <vector>
 #include "hwc_buffer_sync_handler.h"
 #include "hwc_buffer_allocator.h"
@@ -95,11 +96,12 @@ class ToneMapSession : public SyncTask<ToneMapTaskCode>::TaskHandler {
   shared_ptr<Fence> release_fence_[kNumIntermediateBuffers] = {nullptr, nullptr};
   bool acquired_ = false;
   int layer_index_ = -1;
+  uint32_t image_cache_size_ = 0;
 };
 
 class HWCToneMapper {
  public:
-  explicit HWCToneMapper(HWCBufferAllocator *allocator) : buffer_allocator_(allocator) {}
+  explicit HWCToneMapper(HWCBufferAllocator *allocator);
   ~HWCToneMapper() {}
 
   int HandleToneMap(LayerStack *layer_stack);
@@ -107,6 +109,7 @@ class HWCToneMapper {
   void PostCommit(LayerStack *layer_stack);
   void SetFrameDumpConfig(uint32_t count);
   void Terminate();
+  void Dump(std::ostringstream *os);
 
  private:
   void ToneMap(Layer *layer, ToneMapSession *session);
@@ -118,6 +121,7 @@ class HWCToneMapper {
   uint32_t dump_frame_count_ = 0;
   uint32_t dump_frame_index_ = 0;
   int fb_session_index_ = -1;
+  uint32_t image_cache_size_ = 0;
 };
 
 }  // namespace sdm
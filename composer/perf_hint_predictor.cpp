@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <inttypes.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <algorithm>
+
+#include "perf_hint_predictor.h"
+
+#define __CLASS__ "PerfHintPredictor"
+
+namespace sdm {
+
+void PerfHintPredictor::SetSlackThreshold(uint32_t percent) {
+  slack_threshold_ = std::min(percent, UINT32(100));
+}
+
+uint64_t PerfHintPredictor::GetSignature(const PerfHintFrameInfo &info) {
+  // Pixel load is bucketed by powers of two so that small geometry changes map to one signature.
+  uint32_t pixel_bucket = 0;
+  for (uint64_t pixels = info.gpu_pixels; pixels; pixels >>= 1) {
+    pixel_bucket++;
+  }
+  uint64_t signature = info.refresh_rate;
+  signature = (signature << 8) | std::min(info.gpu_layer_count, UINT32(0xff));
+  signature = (signature << 8) | pixel_bucket;
+  signature = (signature << 1) | info.skip_present;
+  signature = (signature << 1) | info.multi_display;
+  return signature;
+}
+
+void PerfHintPredictor::Update(Average *average, nsecs_t cost) {
+  if (!average->samples) {
+    average->cost = cost;
+  } else {
+    average->cost += (cost - average->cost) >> kEwmaShift;
+  }
+  average->samples++;
+}
+
+void PerfHintPredictor::Update(Estimate *estimate) {
+  if (!boosted_) {
+    Update(&estimate->unboosted, cost_);
+    estimate->last_unboosted = sequence_;
+    return;
+  }
+
+  Update(&estimate->boosted, cost_);
+  // The ratio is measured against the cost of the same layer stack, the global average mixes
+  // them all.
+  if (estimate != &global_ && estimate->unboosted.samples >= kMinSamples &&
+      estimate->unboosted.cost > 0 && sequence_ - estimate->last_unboosted <= kRatioWindow) {
+    nsecs_t ratio = std::clamp(cost_ * kRatioOne / estimate->unboosted.cost, nsecs_t(1),
+                               kRatioOne);
+    boost_ratio_ = boost_ratio_ ? (boost_ratio_ + ((ratio - boost_ratio_) >> kEwmaShift)) : ratio;
+  } else if (boost_ratio_) {
+    // Follow load changes while the hint is held, so that it is released once the load drops.
+    Update(&estimate->unboosted, cost_ * kRatioOne / boost_ratio_);
+  }
+}
+
+PerfHintPredictor::Estimate *PerfHintPredictor::GetEstimate(uint64_t signature) {
+  auto it = estimates_.find(signature);
+  if (it == estimates_.end()) {
+    if (estimates_.size() >= kMaxSignatures) {
+      auto lru = std::min_element(estimates_.begin(), estimates_.end(),
+                                  [](const auto &lhs, const auto &rhs) {
+                                    return lhs.second.last_used < rhs.second.last_used;
+                                  });
+      estimates_.erase(lru);
+    }
+    it = estimates_.emplace(signature, Estimate()).first;
+  }
+  it->second.last_used = ++sequence_;
+  return &it->second;
+}
+
+bool PerfHintPredictor::Predict(const PerfHintFrameInfo &info, nsecs_t prepare_time,
+                                bool *needs_hint) {
+  EndFrame();
+  if (!info.refresh_rate) {
+    return false;
+  }
+
+  frame_pending_ = true;
+  info_ = info;
+  prepare_time_ = prepare_time;
+  signature_ = GetSignature(info);
+  budget_ = s2ns(1) / info.refresh_rate;
+  cost_ = prepare_time;
+  hinted_ = false;
+  boosted_ = false;
+
+  const Average *average = &GetEstimate(signature_)->unboosted;
+  if (average->samples < kMinSamples) {
+    average = &global_.unboosted;
+  }
+  predicted_ = (average->samples >= kMinSamples);
+  if (!predicted_) {
+    return false;
+  }
+
+  // The prepare phase has been measured already, the frame costs at least that much.
+  nsecs_t predicted_cost = std::max(average->cost, prepare_time);
+  nsecs_t slack = budget_ - predicted_cost;
+  hinted_ = (slack * 100 < budget_ * slack_threshold_);
+  *needs_hint = hinted_;
+
+  stats_.predictions++;
+  stats_.hints += hinted_;
+  DLOGV_IF(kTagResources, "signature %" PRIx64 " prepare %" PRId64 " predicted %" PRId64
+           " budget %" PRId64 " hint %d", signature_, prepare_time, predicted_cost, budget_,
+           hinted_);
+
+  return true;
+}
+
+void PerfHintPredictor::SetBoosted(bool boosted) {
+  if (frame_pending_) {
+    boosted_ = boosted;
+  }
+}
+
+void PerfHintPredictor::AddPresentTime(nsecs_t present_time) {
+  if (frame_pending_) {
+    cost_ += present_time;
+  }
+}
+
+void PerfHintPredictor::EndFrame() {
+  if (!frame_pending_) {
+    return;
+  }
+  frame_pending_ = false;
+  stats_.frames++;
+
+  // Samples are logged so that they can be recorded and replayed offline.
+  DLOGV_IF(kTagResources, PERF_HINT_TRACE_FORMAT, info_.refresh_rate, info_.gpu_layer_count,
+           static_cast<unsigned long long>(info_.gpu_pixels), info_.skip_present,
+           info_.multi_display, static_cast<long long>(prepare_time_),
+           static_cast<long long>(cost_ - prepare_time_), boosted_);
+
+  stats_.boosted += boosted_;
+  if (predicted_ && !boosted_) {
+    bool overran = ((budget_ - cost_) * 100 < budget_ * slack_threshold_);
+    stats_.missed += (overran && !hinted_);
+  }
+
+  auto it = estimates_.find(signature_);
+  if (it != estimates_.end()) {
+    Update(&it->second);
+  }
+  Update(&global_);
+}
+
+void PerfHintPredictor::Reset() {
+  estimates_.clear();
+  global_ = {};
+  boost_ratio_ = 0;
+  frame_pending_ = false;
+}
+
+void PerfHintPredictor::Dump(std::ostringstream *os) const {
+  *os << "perf hint prediction: slack threshold: " << slack_threshold_ << "%";
+  *os << " frames: " << stats_.frames << " predictions: " << stats_.predictions;
+  *os << " hints: " << stats_.hints << " boosted: " << stats_.boosted;
+  *os << " missed: " << stats_.missed;
+  *os << " avg cost: " << ns2us(global_.unboosted.cost) << " us";
+  *os << " boosted: " << ns2us(global_.boosted.cost) << " us";
+  *os << " boost ratio: " << (boost_ratio_ * 100 / kRatioOne) << "%" << std::endl;
+}
+
+}  // namespace sdm
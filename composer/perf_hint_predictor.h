@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __PERF_HINT_PREDICTOR_H__
+#define __PERF_HINT_PREDICTOR_H__
+
+#include <utils/Timers.h>
+#include <sstream>
+#include <unordered_map>
+
+// Trace record logged for every frame with verbose resource logs enabled, one line per frame:
+//   perf_hint_frame fps <refresh rate> layers <GPU layers> pixels <GPU pixels> skip <0|1>
+//   multi <0|1> prepare <ns> present <ns> boosted <0|1>
+// Records are grepped out of the log into a trace file that is replayed offline, see
+// perf_hint_predictor_test.cpp. The same format is used to log and to parse them.
+#define PERF_HINT_TRACE_FORMAT "perf_hint_frame fps %u layers %u pixels %llu skip %d multi %d " \
+                               "prepare %lld present %lld boosted %d"
+
+namespace sdm {
+
+// Composition load of a frame, as known once the layer stack has been prepared.
+struct PerfHintFrameInfo {
+  uint32_t refresh_rate = 0;
+  uint32_t gpu_layer_count = 0;
+  uint64_t gpu_pixels = 0;
+  bool skip_present = false;
+  bool multi_display = false;
+};
+
+struct PerfHintPredictorStats {
+  uint64_t frames = 0;
+  uint64_t predictions = 0;
+  uint64_t hints = 0;
+  // Frames composed with the hint held.
+  uint64_t boosted = 0;
+  // Frames composed without the hint that were predicted to fit but overran the slack threshold.
+  uint64_t missed = 0;
+};
+
+// Predicts the CPU cost of composing a frame from the measured cost of previous frames with the
+// same layer stack signature, and decides whether the large composition hint is needed.
+// Costs are tracked as an exponentially weighted moving average per signature, with a global
+// average as fallback for signatures seen too rarely. Frames composed with the hint held run on
+// faster cores and are averaged apart, so that predictions are made from the unboosted cost only;
+// otherwise the cheaper boosted frames would pull the estimate down and release the hint that
+// made them cheap. The speedup of the hint is learned from the first boosted frames following
+// unboosted ones, and used to keep the unboosted estimate current while the hint is held.
+// A hint is requested when the predicted unboosted slack within the vsync period falls below
+// slack_threshold percent of the period.
+// The class only consumes timestamps and frame info so that recorded timings can be replayed
+// through it offline to tune the threshold, see PERF_HINT_TRACE_FORMAT.
+class PerfHintPredictor {
+ public:
+  void SetSlackThreshold(uint32_t percent);
+
+  // Called once the frame is prepared, prepare_time being the time spent so far. Returns false
+  // if there is no estimate for this kind of frame yet, otherwise sets needs_hint.
+  bool Predict(const PerfHintFrameInfo &info, nsecs_t prepare_time, bool *needs_hint);
+  // Tells whether the frame predicted last is composed with the hint held.
+  void SetBoosted(bool boosted);
+  // Accounts the time spent committing the frame predicted last.
+  void AddPresentTime(nsecs_t present_time);
+  // Folds the measured cost of the frame predicted last into the model.
+  void EndFrame();
+  void Reset();
+
+  void GetStats(PerfHintPredictorStats *stats) const { *stats = stats_; }
+  void Dump(std::ostringstream *os) const;
+
+ private:
+  struct Average {
+    nsecs_t cost = 0;
+    uint32_t samples = 0;
+  };
+
+  struct Estimate {
+    Average unboosted;
+    Average boosted;
+    uint64_t last_used = 0;
+    uint64_t last_unboosted = 0;
+  };
+
+  static const uint32_t kMaxSignatures = 32;
+  static const uint32_t kMinSamples = 3;
+  // EWMA weight of a new sample is 1 / 2^kEwmaShift.
+  static const uint32_t kEwmaShift = 2;
+  // Boosted frames at most this many frames after an unboosted one measure the boost ratio.
+  static const uint32_t kRatioWindow = 8;
+  // Boost ratio of 1, boosted cost over unboosted cost in fixed point.
+  static constexpr nsecs_t kRatioOne = 256;
+
+  static uint64_t GetSignature(const PerfHintFrameInfo &info);
+  static void Update(Average *average, nsecs_t cost);
+  void Update(Estimate *estimate);
+  Estimate *GetEstimate(uint64_t signature);
+
+  uint32_t slack_threshold_ = 25;
+  std::unordered_map<uint64_t, Estimate> estimates_;
+  Estimate global_;
+  nsecs_t boost_ratio_ = 0;
+  PerfHintPredictorStats stats_;
+  uint64_t sequence_ = 0;
+
+  // Frame in flight.
+  bool frame_pending_ = false;
+  bool predicted_ = false;
+  PerfHintFrameInfo info_;
+  nsecs_t prepare_time_ = 0;
+  uint64_t signature_ = 0;
+  nsecs_t budget_ = 0;
+  nsecs_t cost_ = 0;
+  bool hinted_ = false;
+  bool boosted_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __PERF_HINT_PREDICTOR_H__
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "perf_hint_predictor.h"
+
+namespace sdm {
+
+namespace {
+
+const uint32_t kRefreshRate = 60;
+const nsecs_t kBudget = s2ns(1) / kRefreshRate;
+// Composing with the hint held takes this share of the unboosted cost, in percent.
+const nsecs_t kBoostedCost = 55;
+// Share of the frame cost spent in prepare, in percent.
+const nsecs_t kPrepareCost = 30;
+
+struct SimResult {
+  uint32_t hinted_frames = 0;
+  uint32_t acquires = 0;
+  uint32_t releases = 0;
+  uint32_t first_hint = 0;
+  // Frames the hint was acquired and released on.
+  std::vector<uint32_t> acquired_at;
+  std::vector<uint32_t> released_at;
+};
+
+// A frame of a recorded trace.
+struct TraceFrame {
+  PerfHintFrameInfo info;
+  nsecs_t prepare_time = 0;
+  nsecs_t present_time = 0;
+  bool boosted = false;
+};
+
+// Reads the records of a trace in PERF_HINT_TRACE_FORMAT, from log lines or bare records.
+bool ReadTrace(const std::string &path, std::vector<TraceFrame> *frames) {
+  std::ifstream trace(path);
+  if (!trace) {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(trace, line)) {
+    const char *record = strstr(line.c_str(), "perf_hint_frame ");
+    if (line.empty() || line[0] == '#' || !record) {
+      continue;
+    }
+
+    TraceFrame frame;
+    unsigned long long pixels = 0;  // NOLINT
+    long long prepare = 0, present = 0;  // NOLINT
+    int skip = 0, multi = 0, boosted = 0;
+    if (sscanf(record, PERF_HINT_TRACE_FORMAT, &frame.info.refresh_rate,
+               &frame.info.gpu_layer_count, &pixels, &skip, &multi, &prepare, &present,
+               &boosted) != 8) {
+      return false;
+    }
+    frame.info.gpu_pixels = pixels;
+    frame.info.skip_present = skip;
+    frame.info.multi_display = multi;
+    frame.prepare_time = prepare;
+    frame.present_time = present;
+    frame.boosted = boosted;
+    frames->push_back(frame);
+  }
+
+  return true;
+}
+
+// Traces are installed in testdata next to the test binary.
+std::string GetTracePath(const char *name) {
+  char path[PATH_MAX] = {};
+  if (readlink("/proc/self/exe", path, sizeof(path) - 1) < 0) {
+    return name;
+  }
+  return std::string(dirname(path)) + "/testdata/" + name;
+}
+
+// Replays frames through the predictor the way HWCDisplayBuiltIn drives it, including the
+// release hysteresis of HandleLargeCompositionHint, with a CPU that gets faster while the hint
+// is held.
+class PerfHintSimulator {
+ public:
+  explicit PerfHintSimulator(PerfHintPredictor *predictor) : predictor_(predictor) { }
+
+  // cost returns the unboosted cost of frame i, in percent of the vsync period.
+  SimResult Run(uint32_t frames, std::function<nsecs_t(uint32_t)> cost,
+                PerfHintFrameInfo info = DefaultInfo()) {
+    SimResult result = {};
+    for (uint32_t i = 0; i < frames; i++) {
+      Step(i, info, kBudget * cost(i) / 100, kPrepareCost, &result);
+    }
+    predictor_->EndFrame();
+
+    return result;
+  }
+
+  // Replays recorded frames. Frames recorded with the hint held are scaled back to their
+  // unboosted cost, and the hint then follows the decisions of the predictor under test.
+  SimResult Replay(const std::vector<TraceFrame> &frames) {
+    SimResult result = {};
+    for (uint32_t i = 0; i < frames.size(); i++) {
+      const TraceFrame &frame = frames[i];
+      nsecs_t cost = frame.prepare_time + frame.present_time;
+      if (!cost) {
+        continue;
+      }
+      nsecs_t prepare_share = frame.prepare_time * 100 / cost;
+      if (frame.boosted) {
+        cost = cost * 100 / kBoostedCost;
+      }
+      Step(i, frame.info, cost, prepare_share, &result);
+    }
+    predictor_->EndFrame();
+
+    return result;
+  }
+
+  // Composes frame i, of the given unboosted cost in ns. prepare_share is the share of the cost
+  // spent in prepare, in percent.
+  void Step(uint32_t i, const PerfHintFrameInfo &info, nsecs_t cost, nsecs_t prepare_share,
+            SimResult *result) {
+    // The hint applies to the commit only, prepare runs at the speed of the previous frame.
+    nsecs_t prepare = GetCost(cost, held_) * prepare_share / 100;
+
+    bool needs_hint = false;
+    if (!predictor_->Predict(info, prepare, &needs_hint)) {
+      needs_hint = false;
+    }
+    if (needs_hint) {
+      if (!held_) {
+        result->acquires++;
+        result->acquired_at.push_back(i);
+      }
+      result->first_hint = result->hinted_frames ? result->first_hint : i;
+      result->hinted_frames++;
+      held_ = true;
+      basic_frames_ = 0;
+    } else if (held_ && ++basic_frames_ >= info.refresh_rate) {
+      result->releases++;
+      result->released_at.push_back(i);
+      held_ = false;
+    }
+
+    predictor_->SetBoosted(held_);
+    predictor_->AddPresentTime(GetCost(cost, held_) * (100 - prepare_share) / 100);
+  }
+
+  static nsecs_t GetCost(nsecs_t cost, bool boosted) {
+    return boosted ? (cost * kBoostedCost / 100) : cost;
+  }
+
+  static PerfHintFrameInfo DefaultInfo() {
+    PerfHintFrameInfo info = {};
+    info.refresh_rate = kRefreshRate;
+    info.gpu_layer_count = 4;
+    info.gpu_pixels = 1080 * 2400;
+    return info;
+  }
+
+ private:
+  PerfHintPredictor *predictor_;
+  bool held_ = false;
+  uint32_t basic_frames_ = 0;
+};
+
+}  // namespace
+
+TEST(PerfHintPredictor, NoPredictionWithoutSamples) {
+  PerfHintPredictor predictor;
+  bool needs_hint = false;
+  EXPECT_FALSE(predictor.Predict(PerfHintSimulator::DefaultInfo(), 0, &needs_hint));
+
+  PerfHintFrameInfo info = {};
+  EXPECT_FALSE(predictor.Predict(info, 0, &needs_hint));
+}
+
+TEST(PerfHintPredictor, LightLoadIsNotHinted) {
+  PerfHintPredictor predictor;
+  SimResult result = PerfHintSimulator(&predictor).Run(600, [](uint32_t) { return 40; });
+  EXPECT_EQ(0u, result.hinted_frames);
+
+  PerfHintPredictorStats stats;
+  predictor.GetStats(&stats);
+  EXPECT_EQ(600u, stats.frames);
+  EXPECT_EQ(0u, stats.missed);
+}
+
+// A load that only fits with the hint held must keep it, even though the boosted frames alone
+// would fit the threshold.
+TEST(PerfHintPredictor, HeavyLoadKeepsTheHint) {
+  PerfHintPredictor predictor;
+  SimResult result = PerfHintSimulator(&predictor).Run(1200, [](uint32_t) { return 85; });
+  EXPECT_EQ(1u, result.acquires);
+  EXPECT_EQ(0u, result.releases);
+  EXPECT_LT(result.first_hint, 10u);
+
+  PerfHintPredictorStats stats;
+  predictor.GetStats(&stats);
+  EXPECT_GT(stats.boosted, 1150u);
+  EXPECT_LT(stats.missed, 10u);
+}
+
+TEST(PerfHintPredictor, ReactsToLoadIncrease) {
+  PerfHintPredictor predictor;
+  PerfHintSimulator simulator(&predictor);
+  SimResult result = simulator.Run(600, [](uint32_t i) { return i < 300 ? 40 : 90; });
+  EXPECT_EQ(1u, result.acquires);
+  EXPECT_EQ(0u, result.releases);
+  EXPECT_GE(result.first_hint, 300u);
+  EXPECT_LT(result.first_hint, 310u);
+}
+
+TEST(PerfHintPredictor, ReleasesAfterLoadDrops) {
+  PerfHintPredictor predictor;
+  SimResult result = PerfHintSimulator(&predictor).Run(600, [](uint32_t i) {
+    return i < 300 ? 90 : 30;
+  });
+  EXPECT_EQ(1u, result.acquires);
+  EXPECT_EQ(1u, result.releases);
+}
+
+// A new layer stack is predicted from the global average until it has samples of its own.
+TEST(PerfHintPredictor, FallsBackToGlobalAverage) {
+  PerfHintPredictor predictor;
+  PerfHintSimulator simulator(&predictor);
+  simulator.Run(100, [](uint32_t) { return 40; });
+
+  PerfHintFrameInfo info = PerfHintSimulator::DefaultInfo();
+  info.gpu_layer_count = 8;
+  bool needs_hint = true;
+  ASSERT_TRUE(predictor.Predict(info, 0, &needs_hint));
+  EXPECT_FALSE(needs_hint);
+
+  // Prepare alone already overruns the threshold.
+  ASSERT_TRUE(predictor.Predict(info, kBudget * 80 / 100, &needs_hint));
+  EXPECT_TRUE(needs_hint);
+}
+
+TEST(PerfHintPredictor, ThresholdAndReset) {
+  PerfHintPredictor predictor;
+  predictor.SetSlackThreshold(0);
+  SimResult result = PerfHintSimulator(&predictor).Run(300, [](uint32_t) { return 95; });
+  EXPECT_EQ(0u, result.hinted_frames);
+
+  predictor.SetSlackThreshold(60);
+  result = PerfHintSimulator(&predictor).Run(300, [](uint32_t) { return 50; });
+  EXPECT_GT(result.hinted_frames, 290u);
+
+  predictor.Reset();
+  bool needs_hint = false;
+  EXPECT_FALSE(predictor.Predict(PerfHintSimulator::DefaultInfo(), 0, &needs_hint));
+}
+
+// The format logged by the predictor reads back into the same frame.
+TEST(PerfHintPredictor, TraceFormatRoundTrip) {
+  char record[256];
+  snprintf(record, sizeof(record), "PerfHintPredictor::EndFrame: " PERF_HINT_TRACE_FORMAT, 120u,
+           5u, 1234567ULL, 1, 0, 2000000LL, 3000000LL, 1);
+  std::string path = testing::TempDir() + "perf_hint_round_trip.txt";
+  std::ofstream(path) << "# comment\n" << record << "\nunrelated log line\n";
+
+  std::vector<TraceFrame> frames;
+  ASSERT_TRUE(ReadTrace(path, &frames));
+  unlink(path.c_str());
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(120u, frames[0].info.refresh_rate);
+  EXPECT_EQ(5u, frames[0].info.gpu_layer_count);
+  EXPECT_EQ(1234567u, frames[0].info.gpu_pixels);
+  EXPECT_TRUE(frames[0].info.skip_present);
+  EXPECT_FALSE(frames[0].info.multi_display);
+  EXPECT_EQ(2000000, frames[0].prepare_time);
+  EXPECT_EQ(3000000, frames[0].present_time);
+  EXPECT_TRUE(frames[0].boosted);
+}
+
+// Replays the checked-in trace, see the phases described in its header.
+TEST(PerfHintPredictor, ReplayTrace) {
+  std::vector<TraceFrame> frames;
+  ASSERT_TRUE(ReadTrace(GetTracePath("perf_hint_trace.txt"), &frames));
+  ASSERT_EQ(1200u, frames.size());
+
+  PerfHintPredictor predictor;
+  SimResult result = PerfHintSimulator(&predictor).Replay(frames);
+
+  // The single frame spikes of the first phase do not acquire the hint, the heavy phase does
+  // within a few frames and keeps it throughout, and it is released once the UI is back.
+  ASSERT_EQ(1u, result.acquires);
+  EXPECT_GE(result.acquired_at[0], 300u);
+  EXPECT_LT(result.acquired_at[0], 310u);
+  ASSERT_EQ(1u, result.releases);
+  EXPECT_GE(result.released_at[0], 600u);
+  EXPECT_LT(result.released_at[0], 600u + kRefreshRate + 10);
+  EXPECT_GT(result.hinted_frames, 285u);
+  EXPECT_LT(result.hinted_frames, 310u);
+
+  PerfHintPredictorStats stats;
+  predictor.GetStats(&stats);
+  EXPECT_EQ(1200u, stats.frames);
+  // The spikes and the first frames of the heavy phase, before it has samples of its own.
+  EXPECT_LE(stats.missed, 8u);
+}
+
+// A tighter threshold hints the same trace less, never more.
+TEST(PerfHintPredictor, ReplayTraceThresholds) {
+  std::vector<TraceFrame> frames;
+  ASSERT_TRUE(ReadTrace(GetTracePath("perf_hint_trace.txt"), &frames));
+
+  uint32_t previous = UINT32_MAX;
+  for (uint32_t threshold : {50u, 25u, 10u, 0u}) {
+    PerfHintPredictor predictor;
+    predictor.SetSlackThreshold(threshold);
+    SimResult result = PerfHintSimulator(&predictor).Replay(frames);
+    EXPECT_LE(result.hinted_frames, previous) << threshold;
+    previous = result.hinted_frames;
+  }
+  EXPECT_EQ(0u, previous);
+}
+
+}  // namespace sdm
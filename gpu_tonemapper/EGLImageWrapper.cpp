@@ -22,54 +22,28 @@
 #include <gralloc_priv.h>
 #include <qdMetaData.h>
 #include <ui/GraphicBuffer.h>
-#include <fcntl.h>
-#include <string>
-#include <map>
-#include <utility>
-#include <sys/stat.h>
-
-using std::string;
-using std::map;
-using std::pair;
-
-static string pidString = std::to_string(getpid());
 
 //-----------------------------------------------------------------------------
-static string get_ion_buff_str(int buff_fd)
-//-----------------------------------------------------------------------------
-{
-  string retStr = {};
-  if (buff_fd >= 0) {
-    struct stat stat1;
-    fstat(buff_fd, &stat1);
-    retStr = std::to_string(stat1.st_ino);
-  }
-
-  return retStr;
-}
-
-//-----------------------------------------------------------------------------
-void EGLImageWrapper::DeleteEGLImageCallback::operator()(int& buffInt, EGLImageBuffer*& eglImage)
+void EGLImageWrapper::DeleteEGLImageCallback::operator()(uint64_t& buffId,
+                                                         EGLImageBuffer*& eglImage)
 //-----------------------------------------------------------------------------
 {
   if (eglImage != 0) {
     delete eglImage;
   }
 
-  if (!mapClearPending) {
-    for (auto it = buffStrbuffIntMapPtr->begin(); it != buffStrbuffIntMapPtr->end(); it++) {
-      if (it->second == buffInt /* counter */) {
-        buffStrbuffIntMapPtr->erase(it);
-        return;
-      }
-    }
+  if (!clearPending) {
+    evictionsPtr->fetch_add(1, std::memory_order_relaxed);
   }
 }
 
 //-----------------------------------------------------------------------------
-EGLImageWrapper::EGLImageWrapper()
+EGLImageWrapper::EGLImageWrapper(uint32_t capacity)
 //-----------------------------------------------------------------------------
 {
+  if (capacity) {
+    cacheCapacity = capacity;
+  }
   Init();
 }
 
@@ -84,8 +58,8 @@ EGLImageWrapper::~EGLImageWrapper()
 void EGLImageWrapper::Init()
 //-----------------------------------------------------------------------------
 {
-  eglImageBufferCache = new android::LruCache<int, EGLImageBuffer*>(32);
-  callback = new DeleteEGLImageCallback(&buffStrbuffIntMap);
+  eglImageBufferCache = new android::LruCache<uint64_t, EGLImageBuffer*>(cacheCapacity);
+  callback = new DeleteEGLImageCallback(&evictions);
   eglImageBufferCache->setOnEntryRemovedListener(callback);
 }
 
@@ -95,12 +69,11 @@ void EGLImageWrapper::Deinit()
 {
   if (eglImageBufferCache != 0) {
     if (callback != 0) {
-      callback->mapClearPending = true;
+      callback->clearPending = true;
     }
     eglImageBufferCache->clear();
     delete eglImageBufferCache;
     eglImageBufferCache = 0;
-    buffStrbuffIntMap.clear();
   }
 
   if (callback != 0) {
@@ -155,21 +128,33 @@ EGLImageBuffer *EGLImageWrapper::wrap(const void *pvt_handle)
 {
   const private_handle_t *src = static_cast<const private_handle_t *>(pvt_handle);
 
-  string buffStr = get_ion_buff_str(src->fd);
-  EGLImageBuffer* eglImage = nullptr;
-  if (!buffStr.empty()) {
-    auto it = buffStrbuffIntMap.find(buffStr);
-    if (it != buffStrbuffIntMap.end()) {
-      eglImage = eglImageBufferCache->get(it->second);
-    } else {
-        eglImage = L_wrap(src);
-        buffStrbuffIntMap.insert(pair<string, int>(buffStr, buffInt));
-        eglImageBufferCache->put(buffInt, eglImage);
-        buffInt++;
-    }
-  } else {
-    ALOGE("Could not provide an eglImage for fd = %d, EGLImageWrapper = %p", src->fd, this);
+  if (!src || src->fd < 0) {
+    ALOGE("Could not provide an eglImage for handle = %p, EGLImageWrapper = %p", src, this);
+    return nullptr;
+  }
+
+  // Buffer ids are unique per allocation, unlike fds which get reused once closed.
+  EGLImageBuffer* eglImage = eglImageBufferCache->get(src->id);
+  if (eglImage) {
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return eglImage;
   }
 
+  misses.fetch_add(1, std::memory_order_relaxed);
+  eglImage = L_wrap(src);
+  eglImageBufferCache->put(src->id, eglImage);
+
   return eglImage;
 }
+
+//-----------------------------------------------------------------------------
+EGLImageCacheStats EGLImageWrapper::GetStats() const
+//-----------------------------------------------------------------------------
+{
+  EGLImageCacheStats stats;
+  stats.hits = hits.load(std::memory_order_relaxed);
+  stats.misses = misses.load(std::memory_order_relaxed);
+  stats.evictions = evictions.load(std::memory_order_relaxed);
+
+  return stats;
+}
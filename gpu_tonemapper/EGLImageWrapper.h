@@ -21,35 +21,46 @@
 #define __TONEMAPPER_EGLIMAGEWRAPPER_H__
 
 #include <utils/LruCache.h>
-#include <string>
-#include <map>
 #include <gr_utils.h>
+#include <atomic>
 #include "EGLImageBuffer.h"
 
-using std::string;
-using std::map;
+// A snapshot of the counters of an EGLImageWrapper.
+struct EGLImageCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+};
 
+// Caches the EGLImageBuffer created for a gralloc buffer, keyed by the buffer id.
+// The images are bound to the GL context they were created in, so each context owns a wrapper.
+// Only the counters may be read from other threads than the one driving the context.
 class EGLImageWrapper {
  private:
-  class DeleteEGLImageCallback : public android::OnEntryRemoved<int, EGLImageBuffer*> {
+  class DeleteEGLImageCallback : public android::OnEntryRemoved<uint64_t, EGLImageBuffer*> {
    public:
-     explicit DeleteEGLImageCallback(map<string, int>* mapPtr) { buffStrbuffIntMapPtr = mapPtr; }
-     void operator()(int& buffInt, EGLImageBuffer*& eglImage);
-     map<string, int>* buffStrbuffIntMapPtr = nullptr;
-     bool mapClearPending = false;
+     explicit DeleteEGLImageCallback(std::atomic<uint64_t> *evictions) : evictionsPtr(evictions) {}
+     void operator()(uint64_t& buffId, EGLImageBuffer*& eglImage);
+     std::atomic<uint64_t> *evictionsPtr = nullptr;
+     bool clearPending = false;
   };
 
-  android::LruCache<int, EGLImageBuffer *>* eglImageBufferCache;
-  map<string, int> buffStrbuffIntMap = {};
+  android::LruCache<uint64_t, EGLImageBuffer *>* eglImageBufferCache = nullptr;
   DeleteEGLImageCallback* callback = 0;
-  uint64_t buffInt = 0;
+  uint32_t cacheCapacity = kDefaultCapacity;
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> evictions{0};
 
  public:
-  EGLImageWrapper();
+  static constexpr uint32_t kDefaultCapacity = 32;
+
+  explicit EGLImageWrapper(uint32_t capacity = kDefaultCapacity);
   ~EGLImageWrapper();
   EGLImageBuffer* wrap(const void *pvt_handle);
   void Init();
   void Deinit();
+  EGLImageCacheStats GetStats() const;
 };
 
 #endif  // __TONEMAPPER_EGLIMAGEWRAPPER_H__
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ProgramCache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t kMagic = 0x43425051;  // "QPBC"
+const uint32_t kFileVersion = 1;
+const uint32_t kMaxBinarySize = 4 * 1024 * 1024;
+const uint32_t kMaxDriverVersionSize = 1024;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t binaryFormat;
+  uint32_t binarySize;
+  uint32_t driverVersionSize;
+  uint32_t checksum;
+};
+
+const uint64_t kFnvOffset = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t fnv1a(uint64_t hash, const void *data, size_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * kFnvPrime;
+  }
+  return hash;
+}
+
+uint64_t hashStrings(uint64_t hash, int entries, const char **strings)
+{
+  for (int i = 0; i < entries; i++) {
+    hash = fnv1a(hash, strings[i], strlen(strings[i]));
+    // Separate the entries so that moving text across entries changes the hash.
+    hash = fnv1a(hash, "\0", 1);
+  }
+  return hash;
+}
+
+bool readAll(int fd, void *data, size_t size)
+{
+  uint8_t *bytes = static_cast<uint8_t *>(data);
+  while (size) {
+    ssize_t ret = TEMP_FAILURE_RETRY(read(fd, bytes, size));
+    if (ret <= 0) {
+      return false;
+    }
+    bytes += ret;
+    size -= static_cast<size_t>(ret);
+  }
+  return true;
+}
+
+bool writeAll(int fd, const void *data, size_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  while (size) {
+    ssize_t ret = TEMP_FAILURE_RETRY(write(fd, bytes, size));
+    if (ret <= 0) {
+      return false;
+    }
+    bytes += ret;
+    size -= static_cast<size_t>(ret);
+  }
+  return true;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+ProgramCache::ProgramCache(const std::string &dir)
+//-----------------------------------------------------------------------------
+    : cacheDir(dir)
+{
+}
+
+//-----------------------------------------------------------------------------
+ProgramCache *ProgramCache::getInstance()
+//-----------------------------------------------------------------------------
+{
+  static ProgramCache instance(kDefaultDir);
+  return &instance;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t ProgramCache::hashSources(int vertexEntries, const char **vertex, int fragmentEntries,
+                                   const char **fragment)
+//-----------------------------------------------------------------------------
+{
+  uint64_t hash = hashStrings(kFnvOffset, vertexEntries, vertex);
+  return hashStrings(fnv1a(hash, "\1", 1), fragmentEntries, fragment);
+}
+
+//-----------------------------------------------------------------------------
+std::string ProgramCache::getPath(uint64_t key) const
+//-----------------------------------------------------------------------------
+{
+  char name[32];
+  snprintf(name, sizeof(name), "/%016" PRIx64 ".bin", key);
+  return cacheDir + name;
+}
+
+//-----------------------------------------------------------------------------
+bool ProgramCache::load(uint64_t key, const std::string &driverVersion, ProgramBinary *binary)
+//-----------------------------------------------------------------------------
+{
+  std::lock_guard<std::mutex> lock(cacheLock);
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    Entry entry;
+    if (!readFile(key, &entry)) {
+      return false;
+    }
+    it = entries.emplace(key, std::move(entry)).first;
+  }
+
+  if (it->second.driverVersion != driverVersion) {
+    ALOGI("Dropping program binary %" PRIx64 " built by another driver", key);
+    entries.erase(it);
+    unlink(getPath(key).c_str());
+    return false;
+  }
+
+  *binary = it->second.binary;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ProgramCache::store(uint64_t key, const std::string &driverVersion,
+                         const ProgramBinary &binary)
+//-----------------------------------------------------------------------------
+{
+  if (binary.data.empty() || binary.data.size() > kMaxBinarySize ||
+      driverVersion.size() > kMaxDriverVersionSize) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(cacheLock);
+  Entry &entry = entries[key];
+  entry.driverVersion = driverVersion;
+  entry.binary = binary;
+
+  return writeFile(key, entry);
+}
+
+//-----------------------------------------------------------------------------
+void ProgramCache::remove(uint64_t key)
+//-----------------------------------------------------------------------------
+{
+  std::lock_guard<std::mutex> lock(cacheLock);
+  entries.erase(key);
+  unlink(getPath(key).c_str());
+}
+
+//-----------------------------------------------------------------------------
+bool ProgramCache::readFile(uint64_t key, Entry *entry)
+//-----------------------------------------------------------------------------
+{
+  std::string path = getPath(key);
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  FileHeader header = {};
+  bool valid = readAll(fd, &header, sizeof(header)) && header.magic == kMagic &&
+               header.version == kFileVersion && header.binarySize &&
+               header.binarySize <= kMaxBinarySize &&
+               header.driverVersionSize <= kMaxDriverVersionSize;
+  if (valid) {
+    entry->driverVersion.resize(header.driverVersionSize);
+    entry->binary.format = header.binaryFormat;
+    entry->binary.data.resize(header.binarySize);
+    valid = readAll(fd, &entry->driverVersion[0], header.driverVersionSize) &&
+            readAll(fd, entry->binary.data.data(), header.binarySize) &&
+            static_cast<uint32_t>(fnv1a(kFnvOffset, entry->binary.data.data(),
+                                        header.binarySize)) == header.checksum;
+  }
+  close(fd);
+
+  if (!valid) {
+    ALOGW("Discarding corrupt program binary %s", path.c_str());
+    unlink(path.c_str());
+  }
+
+  return valid;
+}
+
+//-----------------------------------------------------------------------------
+bool ProgramCache::writeFile(uint64_t key, const Entry &entry)
+//-----------------------------------------------------------------------------
+{
+  if (mkdir(cacheDir.c_str(), 0770) && errno != EEXIST) {
+    ALOGW("Failed to create %s: %s", cacheDir.c_str(), strerror(errno));
+    return false;
+  }
+
+  FileHeader header = {};
+  header.magic = kMagic;
+  header.version = kFileVersion;
+  header.binaryFormat = entry.binary.format;
+  header.binarySize = static_cast<uint32_t>(entry.binary.data.size());
+  header.driverVersionSize = static_cast<uint32_t>(entry.driverVersion.size());
+  header.checksum = static_cast<uint32_t>(fnv1a(kFnvOffset, entry.binary.data.data(),
+                                                entry.binary.data.size()));
+
+  // Write to a temporary file and rename, so that readers never see a partial entry.
+  std::string path = getPath(key);
+  std::string tmpPath = path + ".tmp";
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+  if (fd < 0) {
+    ALOGW("Failed to create %s: %s", tmpPath.c_str(), strerror(errno));
+    return false;
+  }
+
+  bool written = writeAll(fd, &header, sizeof(header)) &&
+                 writeAll(fd, entry.driverVersion.data(), entry.driverVersion.size()) &&
+                 writeAll(fd, entry.binary.data.data(), entry.binary.data.size());
+  written = written && (fsync(fd) == 0);
+  close(fd);
+
+  if (!written || rename(tmpPath.c_str(), path.c_str())) {
+    ALOGW("Failed to write %s: %s", path.c_str(), strerror(errno));
+    unlink(tmpPath.c_str());
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __TONEMAPPER_PROGRAMCACHE_H__
+#define __TONEMAPPER_PROGRAMCACHE_H__
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ProgramBinary {
+  uint32_t format = 0;
+  std::vector<uint8_t> data;
+};
+
+// Persistent store of linked GL program binaries.
+// Entries are keyed by a hash of the shader sources and tagged with the driver version they were
+// produced by; entries from another driver are treated as misses and dropped. Binaries are kept
+// in memory once read and written through to one file per program under the cache directory.
+// This class does not call into GL, see engine_loadProgram for the GL side.
+class ProgramCache {
+ public:
+  static constexpr const char *kDefaultDir = "/data/vendor/display/program_cache";
+
+  explicit ProgramCache(const std::string &dir);
+  static ProgramCache *getInstance();
+
+  static uint64_t hashSources(int vertexEntries, const char **vertex, int fragmentEntries,
+                              const char **fragment);
+
+  bool load(uint64_t key, const std::string &driverVersion, ProgramBinary *binary);
+  bool store(uint64_t key, const std::string &driverVersion, const ProgramBinary &binary);
+  // Drops an entry the driver refused to load.
+  void remove(uint64_t key);
+
+ private:
+  struct Entry {
+    std::string driverVersion;
+    ProgramBinary binary;
+  };
+
+  std::string getPath(uint64_t key) const;
+  bool readFile(uint64_t key, Entry *entry);
+  bool writeFile(uint64_t key, const Entry &entry);
+
+  std::string cacheDir;
+  std::map<uint64_t, Entry> entries;
+  std::mutex cacheLock;
+};
+
+#endif  // __TONEMAPPER_PROGRAMCACHE_H__
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "ProgramCache.h"
+
+namespace {
+
+const char *kVertex[] = {"#version 300 es\n", "void main() { gl_Position = vec4(0.0); }\n"};
+const char *kFragment[] = {"#version 300 es\n", "void main() { }\n"};
+const char *kDriver = "OpenGL ES 3.2 V@1.0";
+
+class ProgramCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    char dir[] = "/data/local/tmp/program_cache_XXXXXX";
+    char hostDir[] = "/tmp/program_cache_XXXXXX";
+    const char *created = mkdtemp(dir);
+    if (!created) {
+      created = mkdtemp(hostDir);
+    }
+    ASSERT_NE(nullptr, created);
+    cacheDir = created;
+
+    key = ProgramCache::hashSources(2, kVertex, 2, kFragment);
+    binary.format = 0x8741;
+    for (int i = 0; i < 4096; i++) {
+      binary.data.push_back(static_cast<uint8_t>(i * 7));
+    }
+  }
+
+  void TearDown() override
+  {
+    DIR *dir = opendir(cacheDir.c_str());
+    if (dir) {
+      while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+          unlink((cacheDir + "/" + entry->d_name).c_str());
+        }
+      }
+      closedir(dir);
+    }
+    rmdir(cacheDir.c_str());
+  }
+
+  std::string getPath() const
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016" PRIx64 ".bin", key);
+    return cacheDir + name;
+  }
+
+  bool fileExists() const
+  {
+    struct stat st;
+    return stat(getPath().c_str(), &st) == 0;
+  }
+
+  std::string cacheDir;
+  uint64_t key = 0;
+  ProgramBinary binary;
+};
+
+}  // namespace
+
+TEST_F(ProgramCacheTest, HashDependsOnEntryBoundaries)
+{
+  const char *joined[] = {"#version 300 es\nvoid main() { gl_Position = vec4(0.0); }\n"};
+  EXPECT_EQ(key, ProgramCache::hashSources(2, kVertex, 2, kFragment));
+  EXPECT_NE(key, ProgramCache::hashSources(1, joined, 2, kFragment));
+  // Swapping the stages changes the key too.
+  EXPECT_NE(key, ProgramCache::hashSources(2, kFragment, 2, kVertex));
+}
+
+TEST_F(ProgramCacheTest, StoreThenLoad)
+{
+  ProgramCache cache(cacheDir);
+  ProgramBinary loaded;
+  EXPECT_FALSE(cache.load(key, kDriver, &loaded));
+
+  ASSERT_TRUE(cache.store(key, kDriver, binary));
+  ASSERT_TRUE(cache.load(key, kDriver, &loaded));
+  EXPECT_EQ(binary.format, loaded.format);
+  EXPECT_EQ(binary.data, loaded.data);
+}
+
+TEST_F(ProgramCacheTest, PersistsAcrossInstances)
+{
+  ASSERT_TRUE(ProgramCache(cacheDir).store(key, kDriver, binary));
+
+  ProgramCache cache(cacheDir);
+  ProgramBinary loaded;
+  ASSERT_TRUE(cache.load(key, kDriver, &loaded));
+  EXPECT_EQ(binary.format, loaded.format);
+  EXPECT_EQ(binary.data, loaded.data);
+}
+
+TEST_F(ProgramCacheTest, OtherDriverVersionIsAMiss)
+{
+  ASSERT_TRUE(ProgramCache(cacheDir).store(key, kDriver, binary));
+
+  ProgramCache cache(cacheDir);
+  ProgramBinary loaded;
+  EXPECT_FALSE(cache.load(key, "OpenGL ES 3.2 V@2.0", &loaded));
+  // The stale entry is dropped, also for the driver that built it.
+  EXPECT_FALSE(fileExists());
+  EXPECT_FALSE(cache.load(key, kDriver, &loaded));
+}
+
+TEST_F(ProgramCacheTest, CorruptFileIsDiscarded)
+{
+  ASSERT_TRUE(ProgramCache(cacheDir).store(key, kDriver, binary));
+
+  // Flip the last byte of the binary, so that the checksum no longer matches.
+  int fd = open(getPath().c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  off_t end = lseek(fd, 0, SEEK_END);
+  uint8_t byte = 0;
+  ASSERT_EQ(1, pread(fd, &byte, 1, end - 1));
+  byte ^= 0xff;
+  ASSERT_EQ(1, pwrite(fd, &byte, 1, end - 1));
+  close(fd);
+
+  ProgramCache cache(cacheDir);
+  ProgramBinary loaded;
+  EXPECT_FALSE(cache.load(key, kDriver, &loaded));
+  EXPECT_FALSE(fileExists());
+}
+
+TEST_F(ProgramCacheTest, TruncatedFileIsDiscarded)
+{
+  ASSERT_TRUE(ProgramCache(cacheDir).store(key, kDriver, binary));
+  ASSERT_EQ(0, truncate(getPath().c_str(), 16));
+
+  ProgramCache cache(cacheDir);
+  ProgramBinary loaded;
+  EXPECT_FALSE(cache.load(key, kDriver, &loaded));
+  EXPECT_FALSE(fileExists());
+}
+
+TEST_F(ProgramCacheTest, Remove)
+{
+  ProgramCache cache(cacheDir);
+  ASSERT_TRUE(cache.store(key, kDriver, binary));
+  ASSERT_TRUE(fileExists());
+
+  cache.remove(key);
+  EXPECT_FALSE(fileExists());
+  ProgramBinary loaded;
+  EXPECT_FALSE(cache.load(key, kDriver, &loaded));
+}
+
+TEST_F(ProgramCacheTest, RejectsEmptyBinary)
+{
+  ProgramCache cache(cacheDir);
+  EXPECT_FALSE(cache.store(key, kDriver, ProgramBinary()));
+  EXPECT_FALSE(fileExists());
+}
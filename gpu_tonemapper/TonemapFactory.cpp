@@ -26,9 +26,21 @@
 Tonemapper *TonemapperFactory_GetInstance(int type, void *colorMap, int colorMapSize,
                                           void *lutXform, int lutXformSize, bool isSecure)
 //----------------------------------------------------------------------------------------------------------------------------------------------------------
+{
+  return TonemapperFactory_GetInstanceWithCacheSize(type, colorMap, colorMapSize, lutXform,
+                                                    lutXformSize, isSecure, 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------
+Tonemapper *TonemapperFactory_GetInstanceWithCacheSize(int type, void *colorMap,
+                                                       int colorMapSize, void *lutXform,
+                                                       int lutXformSize, bool isSecure,
+                                                       unsigned int imageCacheSize)
+//----------------------------------------------------------------------------------------------------------------------------------------------------------
 {
   // build the tonemapper
-  Tonemapper *tonemapper = Tonemapper::build(type, colorMap, colorMapSize, lutXform, lutXformSize, isSecure);
+  Tonemapper *tonemapper = Tonemapper::build(type, colorMap, colorMapSize, lutXform, lutXformSize,
+                                             isSecure, imageCacheSize);
 
   return tonemapper;
 }
@@ -30,6 +30,13 @@ extern "C" {
 Tonemapper *TonemapperFactory_GetInstance(int type, void *colorMap, int colorMapSize,
                                           void *lutXform, int lutXformSize, bool isSecure);
 
+// returns an instance of Tonemapper
+// imageCacheSize bounds the EGLImages kept for source buffers, 0 for the default.
+Tonemapper *TonemapperFactory_GetInstanceWithCacheSize(int type, void *colorMap,
+                                                       int colorMapSize, void *lutXform,
+                                                       int lutXformSize, bool isSecure,
+                                                       unsigned int imageCacheSize);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,13 +26,13 @@
 #include "rgba_inverse_tonemap.inl"
 
 //-----------------------------------------------------------------------------
-Tonemapper::Tonemapper()
+Tonemapper::Tonemapper(unsigned int imageCacheSize)
 //-----------------------------------------------------------------------------
 {
   tonemapTexture = 0;
   lutXformTexture = 0;
   programID = 0;
-  eglImageWrapper = new EGLImageWrapper();
+  eglImageWrapper = new EGLImageWrapper(imageCacheSize);
 
   lutXformScaleOffset[0] = 1.0f;
   lutXformScaleOffset[1] = 0.0f;
@@ -61,7 +61,7 @@ Tonemapper::~Tonemapper()
 
 //-----------------------------------------------------------------------------
 Tonemapper *Tonemapper::build(int type, void *colorMap, int colorMapSize, void *lutXform,
-                              int lutXformSize, bool isSecure)
+                              int lutXformSize, bool isSecure, unsigned int imageCacheSize)
 //-----------------------------------------------------------------------------
 {
   if (colorMapSize <= 0) {
@@ -70,7 +70,7 @@ Tonemapper *Tonemapper::build(int type, void *colorMap, int colorMapSize, void *
   }
 
   // build new tonemapper
-  Tonemapper *tonemapper = new Tonemapper();
+  Tonemapper *tonemapper = new Tonemapper(imageCacheSize);
 
   tonemapper->engineContext = engine_initialize(isSecure);
 
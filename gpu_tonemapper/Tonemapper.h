@@ -35,13 +35,14 @@ class Tonemapper {
   float lutXformScaleOffset[2];
   float tonemapScaleOffset[2];
   EGLImageWrapper* eglImageWrapper;
-  Tonemapper();
+  explicit Tonemapper(unsigned int imageCacheSize);
 
  public:
   ~Tonemapper();
   static Tonemapper *build(int type, void *colorMap, int colorMapSize, void *lutXform,
-                           int lutXformSize, bool isSecure);
+                           int lutXformSize, bool isSecure, unsigned int imageCacheSize);
   int blit(const void *dst, const void *src, int srcFenceFd);
+  EGLImageCacheStats getImageCacheStats() const { return eglImageWrapper->GetStats(); }
 };
 
 #endif  //__TONEMAPPER_TONEMAP_H__
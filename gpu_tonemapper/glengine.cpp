@@ -19,7 +19,9 @@
 
 #include "glengine.h"
 #include <log/log.h>
+#include <string>
 #include "engine.h"
+#include "ProgramCache.h"
 
 void checkGlError(const char *, int);
 void checkEglError(const char *, int);
@@ -103,7 +105,7 @@ void engine_shutdown(void* context)
   EGL(eglMakeCurrent(engineContext->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT));
   EGL(eglDestroySurface(engineContext->eglDisplay, engineContext->eglSurface));
   EGL(eglDestroyContext(engineContext->eglDisplay, engineContext->eglContext));
-  EGL(eglTerminate(engineContext->eglDisplay));
+  // The default display is shared with the composer's GL contexts, it is left initialized.
   engineContext->eglDisplay = EGL_NO_DISPLAY;
   engineContext->eglContext = EGL_NO_CONTEXT;
   engineContext->eglSurface = EGL_NO_SURFACE;
@@ -184,6 +186,69 @@ void dumpShaderLog(int shader)
   }
 }
 
+//-----------------------------------------------------------------------------
+static std::string getDriverVersion()
+//-----------------------------------------------------------------------------
+{
+  std::string version;
+  const GLubyte *renderer = glGetString(GL_RENDERER);
+  const GLubyte *glVersion = glGetString(GL_VERSION);
+  if (renderer && glVersion) {
+    version = std::string(reinterpret_cast<const char *>(renderer)) + " " +
+              reinterpret_cast<const char *>(glVersion);
+  }
+  return version;
+}
+
+//-----------------------------------------------------------------------------
+static bool restoreProgramBinary(GLuint progId, uint64_t key, const std::string &driverVersion)
+//-----------------------------------------------------------------------------
+{
+  ProgramBinary binary;
+  if (driverVersion.empty() ||
+      !ProgramCache::getInstance()->load(key, driverVersion, &binary)) {
+    return false;
+  }
+
+  glProgramBinary(progId, binary.format, binary.data.data(), GLsizei(binary.data.size()));
+  GLint linked = GL_FALSE;
+  glGetProgramiv(progId, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    // Driver rejected the binary, fall back to compiling and refresh the entry.
+    ALOGI("%s: Program binary rejected, recompiling", __FUNCTION__);
+    ProgramCache::getInstance()->remove(key);
+    glGetError();
+    return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+static void saveProgramBinary(GLuint progId, uint64_t key, const std::string &driverVersion)
+//-----------------------------------------------------------------------------
+{
+  GLint linked = GL_FALSE;
+  GLint length = 0;
+  glGetProgramiv(progId, GL_LINK_STATUS, &linked);
+  glGetProgramiv(progId, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (driverVersion.empty() || linked != GL_TRUE || length <= 0) {
+    return;
+  }
+
+  ProgramBinary binary;
+  GLenum format = 0;
+  GLsizei written = 0;
+  binary.data.resize(size_t(length));
+  GL(glGetProgramBinary(progId, length, &written, &format, binary.data.data()));
+  if (written <= 0) {
+    return;
+  }
+  binary.data.resize(size_t(written));
+  binary.format = format;
+  ProgramCache::getInstance()->store(key, driverVersion, binary);
+}
+
 //-----------------------------------------------------------------------------
 GLuint engine_loadProgram(int vertexEntries, const char **vertex, int fragmentEntries,
                           const char **fragment)
@@ -191,6 +256,13 @@ GLuint engine_loadProgram(int vertexEntries, const char **vertex, int fragmentEn
 {
   GLuint progId = glCreateProgram();
 
+  // Reuse the program linked by an earlier session or boot when the driver is unchanged.
+  uint64_t key = ProgramCache::hashSources(vertexEntries, vertex, fragmentEntries, fragment);
+  std::string driverVersion = getDriverVersion();
+  if (restoreProgramBinary(progId, key, driverVersion)) {
+    return progId;
+  }
+
   int vertId = glCreateShader(GL_VERTEX_SHADER);
   int fragId = glCreateShader(GL_FRAGMENT_SHADER);
 
@@ -205,6 +277,7 @@ GLuint engine_loadProgram(int vertexEntries, const char **vertex, int fragmentEn
   GL(glAttachShader(progId, vertId));
   GL(glAttachShader(progId, fragId));
 
+  GL(glProgramParameteri(progId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
   GL(glLinkProgram(progId));
 
   GL(glDetachShader(progId, vertId));
@@ -213,6 +286,8 @@ GLuint engine_loadProgram(int vertexEntries, const char **vertex, int fragmentEn
   GL(glDeleteShader(vertId));
   GL(glDeleteShader(fragId));
 
+  saveProgramBinary(progId, key, driverVersion);
+
   return progId;
 }
 
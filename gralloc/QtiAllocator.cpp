@@ -46,6 +46,15 @@ static void get_properties(gralloc::GrallocProperties *props) {
   props->ubwc_disable = property_get_bool("vendor.gralloc.disable_ubwc", 0);
 
   props->ahardware_buffer_disable = property_get_bool("vendor.gralloc.disable_ahardware_buffer", 0);
+
+  props->layout_cache_disable = property_get_bool("vendor.gralloc.disable_layout_cache", 0);
+
+  props->buffer_pool_size = property_get_int64("vendor.gralloc.buffer_pool_size_kb", 0) * 1024;
+
+  char property[PROPERTY_VALUE_MAX];
+  if (property_get("vendor.gralloc.buffer_pool_usage", property, NULL) > 0) {
+    props->buffer_pool_usage = strtoull(property, NULL, 0);
+  }
 }
 
 namespace vendor {
@@ -82,14 +91,20 @@ Return<void> QtiAllocator::allocate(const hidl_vec<uint8_t> &descriptor, uint32_
 
   std::vector<hidl_handle> buffers;
   buffers.reserve(count);
-  for (uint32_t i = 0; i < count; i++) {
+  if (count > 1) {
+    // Swapchains and camera streams allocate several buffers of the same descriptor at once.
+    std::vector<buffer_handle_t> handles;
+    err = buf_mgr_->AllocateBuffers(desc, count, &handles);
+    for (auto handle : handles) {
+      buffers.emplace_back(hidl_handle(handle));
+    }
+  } else if (count == 1) {
     buffer_handle_t buffer;
     ALOGD_IF(DEBUG, "buffer: %p", &buffer);
     err = buf_mgr_->AllocateBuffer(desc, &buffer);
-    if (err != Error::NONE) {
-      break;
+    if (err == Error::NONE) {
+      buffers.emplace_back(hidl_handle(buffer));
     }
-    buffers.emplace_back(hidl_handle(buffer));
   }
 
   uint32_t stride = 0;
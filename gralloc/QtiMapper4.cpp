@@ -486,22 +486,20 @@ Return<void> QtiMapper::listSupportedMetadataTypes(listSupportedMetadataTypes_cb
 
 Return<void> QtiMapper::isSupported(const BufferDescriptorInfo_4_0 &descriptor_info,
                                     isSupported_cb hidl_cb) {
-  IMapperBufferDescriptor descriptor;
-  auto err = CreateDescriptor(descriptor_info, &descriptor);
-  if (err != Error::NONE) {
-    hidl_cb(err, false);
+  if (!ValidDescriptor(descriptor_info)) {
+    hidl_cb(Error::BAD_VALUE, false);
     return Void();
   }
 
+  // Same fields as a decoded descriptor, without the encode/decode round trip.
   gralloc::BufferDescriptor desc;
-  err = static_cast<Error>(Decode(descriptor, &desc));
-  if (err != Error::NONE) {
-    hidl_cb(err, false);
-    return Void();
-  }
+  desc.SetDimensions(INT(descriptor_info.width), INT(descriptor_info.height));
+  desc.SetLayerCount(descriptor_info.layerCount);
+  desc.SetColorFormat(static_cast<int>(descriptor_info.format));
+  desc.SetUsage(descriptor_info.usage);
+  desc.SetReservedSize(descriptor_info.reservedSize);
 
-  buffer_handle_t buffer;
-  err = static_cast<IMapper_4_0_Error>(buf_mgr_->AllocateBuffer(desc, &buffer, 0, true));
+  auto err = static_cast<IMapper_4_0_Error>(buf_mgr_->IsSupported(desc));
   if (err != Error::NONE) {
     hidl_cb(err, false);
   } else {
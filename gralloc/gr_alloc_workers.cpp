@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <sys/prctl.h>
+#include <algorithm>
+
+#include "gr_alloc_workers.h"
+
+namespace gralloc {
+
+AllocWorkers::~AllocWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    exit_ = true;
+    cv_.notify_all();
+  }
+
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void AllocWorkers::Run(uint32_t count, const Job &job) {
+  if (count <= 1 || !num_threads_) {
+    for (uint32_t i = 0; i < count; i++) {
+      job(i);
+    }
+    return;
+  }
+
+  Batch batch;
+  batch.job = &job;
+  batch.count = count;
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (workers_.empty()) {
+    for (uint32_t i = 0; i < num_threads_; i++) {
+      workers_.emplace_back(&AllocWorkers::WorkerThread, this);
+    }
+  }
+  batches_.push_back(&batch);
+  cv_.notify_all();
+
+  while (RunNext(&batch, &lock)) {
+  }
+  // The workers may still be running the last indices.
+  batch.done_cv.wait(lock, [&batch] { return batch.done == batch.count; });
+}
+
+bool AllocWorkers::RunNext(Batch *batch, std::unique_lock<std::mutex> *lock) {
+  if (batch->next == batch->count) {
+    return false;
+  }
+
+  uint32_t index = batch->next++;
+  if (batch->next == batch->count) {
+    batches_.erase(std::find(batches_.begin(), batches_.end(), batch));
+  }
+
+  lock->unlock();
+  (*batch->job)(index);
+  lock->lock();
+
+  // The caller returns once done is complete, the batch is not touched after the notify.
+  if (++batch->done == batch->count) {
+    batch->done_cv.notify_all();
+  }
+
+  return true;
+}
+
+void AllocWorkers::WorkerThread() {
+  prctl(PR_SET_NAME, "GrallocAllocWkr", 0, 0, 0);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    cv_.wait(lock, [this] { return exit_ || !batches_.empty(); });
+    if (exit_) {
+      break;
+    }
+
+    RunNext(batches_.front(), &lock);
+  }
+}
+
+}  // namespace gralloc
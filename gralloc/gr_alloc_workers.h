@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GR_ALLOC_WORKERS_H__
+#define __GR_ALLOC_WORKERS_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gralloc {
+
+// Threads that help the calling thread through the allocations of a batch. They are started on
+// the first batch, most processes only import buffers and never need them, and are kept for the
+// next batches. Batches of concurrent callers are served in turn, each caller works on its own
+// batch too, so that a batch always makes progress.
+class AllocWorkers {
+ public:
+  typedef std::function<void(uint32_t index)> Job;
+
+  explicit AllocWorkers(uint32_t num_threads) : num_threads_(num_threads) {}
+  ~AllocWorkers();
+
+  // Runs job for each index below count, returns once all of them ran.
+  void Run(uint32_t count, const Job &job);
+
+ private:
+  struct Batch {
+    const Job *job = nullptr;
+    uint32_t count = 0;
+    uint32_t next = 0;
+    uint32_t done = 0;
+    std::condition_variable done_cv;
+  };
+
+  // Runs the next index of the batch, returns false if none is left.
+  bool RunNext(Batch *batch, std::unique_lock<std::mutex> *lock);
+  void WorkerThread();
+
+  const uint32_t num_threads_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::deque<Batch *> batches_;
+  std::vector<std::thread> workers_;
+  bool exit_ = false;
+};
+
+}  // namespace gralloc
+
+#endif  // __GR_ALLOC_WORKERS_H__
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gr_alloc_workers.h"
+
+namespace gralloc {
+
+TEST(AllocWorkers, RunsEveryIndexOnce) {
+  AllocWorkers workers(3);
+  for (uint32_t count : {0u, 1u, 2u, 7u, 64u}) {
+    std::vector<std::atomic<int>> runs(count);
+    workers.Run(count, [&runs](uint32_t i) { runs[i]++; });
+    for (uint32_t i = 0; i < count; i++) {
+      EXPECT_EQ(1, runs[i]) << "count " << count << " index " << i;
+    }
+  }
+}
+
+// The threads are kept from one batch to the next.
+TEST(AllocWorkers, ReusesThreads) {
+  AllocWorkers workers(3);
+  std::mutex lock;
+  std::set<std::thread::id> threads;
+  for (int batch = 0; batch < 20; batch++) {
+    workers.Run(8, [&](uint32_t) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      std::lock_guard<std::mutex> guard(lock);
+      threads.insert(std::this_thread::get_id());
+    });
+  }
+  EXPECT_LE(threads.size(), 4u);
+  EXPECT_GT(threads.size(), 1u);
+}
+
+// Batches of concurrent callers all complete, each on at least its own thread.
+TEST(AllocWorkers, ConcurrentBatches) {
+  AllocWorkers workers(3);
+  std::vector<std::thread> callers;
+  std::atomic<uint32_t> total = 0;
+  for (int caller = 0; caller < 6; caller++) {
+    callers.emplace_back([&workers, &total] {
+      for (int batch = 0; batch < 50; batch++) {
+        std::vector<int> runs(5, 0);
+        workers.Run(5, [&runs](uint32_t i) { runs[i]++; });
+        for (int run : runs) {
+          ASSERT_EQ(1, run);
+        }
+        total += 5;
+      }
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(6u * 50u * 5u, total);
+}
+
+}  // namespace gralloc
@@ -56,9 +56,38 @@ static BufferInfo GetBufferInfo(const BufferDescriptor &descriptor) {
 
 void Allocator::SetProperties(gralloc::GrallocProperties props) {
   use_system_heap_for_sensors_ = props.use_system_heap_for_sensors;
+
+  if (props.buffer_pool_size && !buffer_pool_) {
+    AllocInterface *alloc_intf = AllocInterface::GetInstance();
+    if (alloc_intf) {
+      buffer_pool_ = std::make_unique<BufferPool>(alloc_intf);
+    }
+  }
+  if (buffer_pool_) {
+    BufferPoolConfig config;
+    config.max_bytes = props.buffer_pool_size;
+    config.usage_mask = props.buffer_pool_usage;
+    // Every pooled buffer needs a metadata buffer as well.
+    config.pool_metadata = props.buffer_pool_usage != 0;
+    buffer_pool_->Configure(config);
+  }
 }
 
-int Allocator::AllocateMem(AllocData *alloc_data, uint64_t usage, int format) {
+uint64_t Allocator::TrimBufferPool(uint64_t target_bytes) {
+  if (buffer_pool_) {
+    return buffer_pool_->Trim(target_bytes);
+  }
+
+  return 0;
+}
+
+void Allocator::Dump(std::ostringstream *os) {
+  if (buffer_pool_) {
+    buffer_pool_->Dump(os);
+  }
+}
+
+int Allocator::AllocateMem(AllocData *alloc_data, uint64_t usage, int format, bool metadata) {
   int ret;
   int err = 0;
   bool is_secure = false;
@@ -75,7 +104,11 @@ int Allocator::AllocateMem(AllocData *alloc_data, uint64_t usage, int format) {
                           &alloc_data->vm_names, &alloc_data->alloc_type, &alloc_data->flags,
                           &alloc_data->size);
 
-  ret = alloc_intf->AllocBuffer(alloc_data);
+  if (buffer_pool_) {
+    ret = buffer_pool_->Allocate(alloc_data, usage, metadata);
+  } else {
+    ret = alloc_intf->AllocBuffer(alloc_data);
+  }
   if (ret >= 0) {
     alloc_data->alloc_type |= private_handle_t::PRIV_FLAGS_USES_ION;
   } else {
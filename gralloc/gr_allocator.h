@@ -30,9 +30,12 @@
 #ifndef __GR_ALLOCATOR_H__
 #define __GR_ALLOCATOR_H__
 
+#include <memory>
+#include <sstream>
 #include <vector>
 
 #include "gr_buf_descriptor.h"
+#include "gr_buf_pool.h"
 #include "gr_utils.h"
 #include "gralloc_priv.h"
 #include "gr_alloc_interface.h"
@@ -46,13 +49,19 @@ class Allocator {
   int ImportBuffer(int fd);
   int FreeBuffer(void *base, unsigned int size, unsigned int offset, int fd, int handle);
   int CleanBuffer(void *base, unsigned int size, unsigned int offset, int handle, int op, int fd);
-  int AllocateMem(AllocData *data, uint64_t usage, int format);
+  // metadata marks the metadata buffer allocated along with each buffer.
+  int AllocateMem(AllocData *data, uint64_t usage, int format, bool metadata = false);
   // @return : index of the descriptor with maximum buffer size req
   bool CheckForBufferSharing(uint32_t num_descriptors,
                              const std::vector<std::shared_ptr<BufferDescriptor>> &descriptors,
                              ssize_t *max_index);
+  // Returns the number of bytes the pool released.
+  uint64_t TrimBufferPool(uint64_t target_bytes);
+  void Dump(std::ostringstream *os);
+
  private:
   bool use_system_heap_for_sensors_ = true;
+  std::unique_ptr<BufferPool> buffer_pool_;
 };
 
 }  // namespace gralloc
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <benchmark/benchmark.h>
+#include <cutils/native_handle.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gr_alloc_interface.h"
+#include "gr_alloc_workers.h"
+#include "gr_buf_mgr.h"
+#include "gr_utils.h"
+
+namespace gralloc {
+
+using aidl::android::hardware::graphics::common::StandardMetadataType;
+
+static const int kBenchFormats[] = {
+  HAL_PIXEL_FORMAT_RGBA_8888,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS_UBWC,
+  HAL_PIXEL_FORMAT_YCbCr_420_TP10_UBWC,
+};
+
+// Layout of a few formats as the mapper computes it on every lock, with and without the cache.
+static void BM_BufferLayout(benchmark::State &state) {
+  SetLayoutCacheEnabled(state.range(0) != 0);
+  uint64_t usage = BufferUsage::GPU_TEXTURE | BufferUsage::COMPOSER_OVERLAY;
+  for (auto _ : state) {
+    for (int format : kBenchFormats) {
+      BufferInfo info(1080, 2400, format, usage);
+      unsigned int size = 0, alignedw = 0, alignedh = 0;
+      GetBufferSizeAndDimensions(info, &size, &alignedw, &alignedh);
+      int plane_count = 0;
+      PlaneLayoutInfo plane_info[8];
+      if (IsYuvFormat(format)) {
+        GetYUVPlaneInfo(info, format, INT(alignedw), INT(alignedh), 0, &plane_count, plane_info);
+      }
+      benchmark::DoNotOptimize(size);
+      benchmark::DoNotOptimize(plane_count);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * INT(sizeof(kBenchFormats) / sizeof(int)));
+  SetLayoutCacheEnabled(true);
+}
+BENCHMARK(BM_BufferLayout)->ArgName("cached")->Arg(0)->Arg(1);
+
+static BufferDescriptor GetBenchDescriptor() {
+  BufferDescriptor descriptor;
+  descriptor.SetDimensions(1080, 2400);
+  descriptor.SetColorFormat(HAL_PIXEL_FORMAT_RGBA_8888);
+  descriptor.SetUsage(BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN |
+                      BufferUsage::GPU_TEXTURE);
+  descriptor.SetName("gr_benchmark");
+  return descriptor;
+}
+
+static void BM_AllocateRelease(benchmark::State &state) {
+  SetLayoutCacheEnabled(state.range(0) != 0);
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  BufferDescriptor descriptor = GetBenchDescriptor();
+  for (auto _ : state) {
+    buffer_handle_t handle = nullptr;
+    if (buf_mgr->AllocateBuffer(descriptor, &handle) != Error::NONE) {
+      state.SkipWithError("AllocateBuffer failed");
+      break;
+    }
+    buf_mgr->ReleaseBuffer(PRIV_HANDLE_CONST(handle));
+  }
+  state.SetItemsProcessed(state.iterations());
+  SetLayoutCacheEnabled(true);
+}
+BENCHMARK(BM_AllocateRelease)->ArgName("cached")->Arg(0)->Arg(1);
+
+static void BM_LockUnlock(benchmark::State &state) {
+  SetLayoutCacheEnabled(state.range(0) != 0);
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  buffer_handle_t handle = nullptr;
+  if (buf_mgr->AllocateBuffer(GetBenchDescriptor(), &handle) != Error::NONE) {
+    state.SkipWithError("AllocateBuffer failed");
+    return;
+  }
+
+  auto hnd = PRIV_HANDLE_CONST(handle);
+  for (auto _ : state) {
+    buf_mgr->LockBuffer(hnd, BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN);
+    buf_mgr->UnlockBuffer(hnd);
+  }
+  state.SetItemsProcessed(state.iterations());
+  buf_mgr->ReleaseBuffer(hnd);
+  SetLayoutCacheEnabled(true);
+}
+BENCHMARK(BM_LockUnlock)->ArgName("cached")->Arg(0)->Arg(1);
+
+// isSupported queries as codecs issue them during format negotiation. With memo set, the same
+// few descriptors are queried over and over, otherwise every query has a descriptor of its own.
+static void BM_IsSupported(benchmark::State &state) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  BufferDescriptor descriptor = GetBenchDescriptor();
+  int width = 1080;
+  for (auto _ : state) {
+    for (int format : kBenchFormats) {
+      descriptor.SetColorFormat(format);
+      benchmark::DoNotOptimize(buf_mgr->IsSupported(descriptor));
+    }
+    if (!state.range(0)) {
+      width = (width < 4096) ? (width + 1) : 1080;
+      descriptor.SetDimensions(width, 2400);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * INT(sizeof(kBenchFormats) / sizeof(int)));
+}
+BENCHMARK(BM_IsSupported)->ArgName("memo")->Arg(0)->Arg(1)->ThreadRange(1, 4);
+
+// Metadata queries of per-frame callers on one imported buffer. Width and plane layouts are
+// served from the blobs kept by the buffer, dataspace is encoded on every query.
+static void BM_GetMetadata(benchmark::State &state) {
+  static private_handle_t *hnd = nullptr;
+  static buffer_handle_t allocated = nullptr;
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  if (state.thread_index() == 0) {
+    native_handle_t *clone = nullptr;
+    if (buf_mgr->AllocateBuffer(GetBenchDescriptor(), &allocated) == Error::NONE) {
+      clone = native_handle_clone(allocated);
+    }
+    if (clone && buf_mgr->RetainBuffer(PRIV_HANDLE_CONST(clone)) == Error::NONE) {
+      hnd = const_cast<private_handle_t *>(PRIV_HANDLE_CONST(clone));
+    }
+  }
+
+  const int64_t types[] = {
+    static_cast<int64_t>(StandardMetadataType::WIDTH),
+    static_cast<int64_t>(StandardMetadataType::PLANE_LAYOUTS),
+    static_cast<int64_t>(StandardMetadataType::DATASPACE),
+  };
+  for (auto _ : state) {
+    if (!hnd) {
+      state.SkipWithError("Buffer import failed");
+      break;
+    }
+    hidl_vec<uint8_t> out;
+    buf_mgr->GetMetadata(hnd, types[state.range(0)], &out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    if (hnd) {
+      buf_mgr->ReleaseBuffer(hnd);
+      hnd = nullptr;
+    }
+    if (allocated) {
+      buf_mgr->ReleaseBuffer(PRIV_HANDLE_CONST(allocated));
+      allocated = nullptr;
+    }
+  }
+}
+BENCHMARK(BM_GetMetadata)->ArgName("type")->DenseRange(0, 2)->ThreadRange(1, 8);
+
+// Stands in for the heap. An allocation keeps the CPU busy for a while, as the kernel does when
+// it zeroes the pages.
+class FakeHeap : public AllocInterface {
+ public:
+  explicit FakeHeap(std::chrono::microseconds latency) : latency_(latency) {}
+  ~FakeHeap() {}
+
+  int AllocBuffer(AllocData *data) override {
+    auto end = std::chrono::steady_clock::now() + latency_;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+    data->fd = -1;
+    return 0;
+  }
+  int FreeBuffer(void *, unsigned int, unsigned int, int, int) override { return 0; }
+  int MapBuffer(void **, unsigned int, unsigned int, int) override { return 0; }
+  int CleanBuffer(void *, unsigned int, unsigned int, int, int, int) override { return 0; }
+  int ImportBuffer(int fd) override { return fd; }
+
+ private:
+  std::chrono::microseconds latency_;
+};
+
+enum AllocMode {
+  kAllocSerial,
+  kAllocThreadPerBatch,  // A thread per allocation worker on every batch.
+  kAllocWorkers,
+};
+
+// Batches of allocations on a fake heap, as camera and codecs request them. A latency of 0 leaves
+// the cost of handing out the allocations to threads.
+static void BM_AllocateBatch(benchmark::State &state) {
+  FakeHeap heap(std::chrono::microseconds(state.range(2)));
+  AllocWorkers workers(3);
+  uint32_t count = static_cast<uint32_t>(state.range(1));
+  std::vector<AllocData> data(count);
+  auto allocate = [&heap, &data](uint32_t i) { heap.AllocBuffer(&data[i]); };
+
+  for (auto _ : state) {
+    switch (state.range(0)) {
+      case kAllocSerial:
+        for (uint32_t i = 0; i < count; i++) {
+          allocate(i);
+        }
+        break;
+      case kAllocThreadPerBatch: {
+        std::atomic<uint32_t> next_index = 0;
+        auto run = [&]() {
+          for (uint32_t i = next_index++; i < count; i = next_index++) {
+            allocate(i);
+          }
+        };
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < std::min(count, 4u); i++) {
+          threads.emplace_back(run);
+        }
+        run();
+        for (auto &thread : threads) {
+          thread.join();
+        }
+        break;
+      }
+      default:
+        workers.Run(count, allocate);
+        break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AllocateBatch)->ArgNames({"mode", "count", "latency_us"})->UseRealTime()
+    ->Apply([](benchmark::internal::Benchmark *b) {
+      for (int mode : {kAllocSerial, kAllocThreadPerBatch, kAllocWorkers}) {
+        for (int count : {1, 4, 8}) {
+          for (int latency_us : {0, 200}) {
+            b->Args({mode, count, latency_us});
+          }
+        }
+      }
+    });
+
+}  // namespace gralloc
+
+BENCHMARK_MAIN();
@@ -314,6 +314,43 @@ BufferManager::~BufferManager() {
 void BufferManager::SetGrallocDebugProperties(gralloc::GrallocProperties props) {
   allocator_->SetProperties(props);
   AdrenoMemInfo::GetInstance()->AdrenoSetProperties(props);
+  // UBWC and Adreno properties feed into the layout computations.
+  SetLayoutCacheEnabled(!props.layout_cache_disable);
+  support_cache_.Clear();
+}
+
+Error BufferManager::IsSupported(const BufferDescriptor &descriptor) {
+  // Only the buffer layout is computed, which needs neither buffer_lock_ nor the allocator.
+  uint64_t usage = descriptor.GetUsage();
+  SupportKey key;
+  memset(&key, 0, sizeof(key));
+  key.width = descriptor.GetWidth();
+  key.height = descriptor.GetHeight();
+  key.format = GetImplDefinedFormat(usage, descriptor.GetFormat());
+  key.layer_count = descriptor.GetLayerCount();
+  key.usage = usage;
+
+  Error error = Error::NONE;
+  if (support_cache_.Find(key, &error)) {
+    return error;
+  }
+
+  BufferInfo info = GetBufferInfo(descriptor);
+  info.format = key.format;
+  info.layer_count = key.layer_count;
+
+  unsigned int size = 0;
+  unsigned int alignedw = 0, alignedh = 0;
+  GraphicsMetadata graphics_metadata = {};
+  int err = GetBufferSizeAndDimensions(info, &size, &alignedw, &alignedh, &graphics_metadata);
+  if (err < 0) {
+    error = Error::BAD_DESCRIPTOR;
+  } else if (size == 0) {
+    error = Error::NO_RESOURCES;
+  }
+  support_cache_.Insert(key, error);
+
+  return error;
 }
 
 Error BufferManager::FreeBuffer(std::shared_ptr<Buffer> buf) {
@@ -327,6 +364,10 @@ Error BufferManager::FreeBuffer(std::shared_ptr<Buffer> buf) {
 
   auto meta_size = GetMetaDataSize(hnd->reserved_size);
 
+  // Waits for cache maintenance in progress, which is not done under buffer_lock_.
+  std::lock_guard<std::mutex> cpu_access_lock(buf->cpu_access_lock);
+  buf->freed = true;
+
   if (allocator_->FreeBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset, hnd->fd,
                              buf->ion_handle_main) != 0) {
     return Error::BAD_BUFFER;
@@ -451,7 +492,7 @@ Error BufferManager::MapBuffer(private_handle_t const *handle) {
 }
 
 Error BufferManager::IsBufferImported(const private_handle_t *hnd) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
   auto buf = GetBufferFromHandleLocked(hnd);
   if (buf != nullptr) {
     return Error::NONE;
@@ -462,7 +503,7 @@ Error BufferManager::IsBufferImported(const private_handle_t *hnd) {
 Error BufferManager::RetainBuffer(private_handle_t const *hnd) {
   ALOGD_IF(DEBUG, "Retain buffer handle:%p id: %" PRIu64, hnd, hnd->id);
   auto err = Error::NONE;
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
   auto buf = GetBufferFromHandleLocked(hnd);
   if (buf != nullptr) {
     buf->IncRef();
@@ -475,7 +516,7 @@ Error BufferManager::RetainBuffer(private_handle_t const *hnd) {
 
 Error BufferManager::ReleaseBuffer(private_handle_t const *hnd) {
   ALOGD_IF(DEBUG, "Release buffer handle:%p", hnd);
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
   auto buf = GetBufferFromHandleLocked(hnd);
   if (buf == nullptr) {
     ALOGE("Could not find handle: %p", hnd);
@@ -493,8 +534,50 @@ Error BufferManager::ReleaseBuffer(private_handle_t const *hnd) {
   return Error::NONE;
 }
 
+std::shared_ptr<BufferManager::Buffer> BufferManager::GetMappedBuffer(
+    const private_handle_t *hnd, bool map, Error *err) {
+  {
+    std::shared_lock<std::shared_mutex> lock(buffer_lock_);
+    auto buf = GetBufferFromHandleLocked(hnd);
+    if (buf == nullptr || !map || hnd->base != 0) {
+      *err = buf ? Error::NONE : Error::BAD_BUFFER;
+      return buf;
+    }
+  }
+
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
+  auto buf = GetBufferFromHandleLocked(hnd);
+  if (buf == nullptr) {
+    *err = Error::BAD_BUFFER;
+    return nullptr;
+  }
+
+  *err = Error::NONE;
+  if (hnd->base == 0) {
+    // we need to map for real
+    *err = MapBuffer(hnd);
+  }
+
+  return buf;
+}
+
+Error BufferManager::SyncCache(const Buffer &buf, const CacheOps &cache_ops) {
+  auto hnd = buf.handle;
+  if (!cache_ops.count) {
+    cache_ops_skipped_++;
+  }
+  for (unsigned int i = 0; i < cache_ops.count; i++) {
+    cache_ops_++;
+    if (allocator_->CleanBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset,
+                                buf.ion_handle_main, cache_ops.ops[i], hnd->fd) != 0) {
+      return Error::BAD_BUFFER;
+    }
+  }
+
+  return Error::NONE;
+}
+
 Error BufferManager::LockBuffer(const private_handle_t *hnd, uint64_t usage) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
   auto err = Error::NONE;
   ALOGD_IF(DEBUG, "LockBuffer buffer handle:%p id: %" PRIu64, hnd, hnd->id);
 
@@ -503,29 +586,32 @@ Error BufferManager::LockBuffer(const private_handle_t *hnd, uint64_t usage) {
     return Error::BAD_VALUE;
   }
 
-  auto buf = GetBufferFromHandleLocked(hnd);
+  auto buf = GetMappedBuffer(hnd, true, &err);
   if (buf == nullptr) {
     return Error::BAD_BUFFER;
   }
 
-  if (hnd->base == 0) {
-    // we need to map for real
-    err = MapBuffer(hnd);
+  // Cache maintenance is done outside buffer_lock_, the handle stays valid until the buffer is
+  // freed, which waits for cpu_access_lock.
+  std::lock_guard<std::mutex> cpu_access_lock(buf->cpu_access_lock);
+  if (buf->freed) {
+    return Error::BAD_BUFFER;
   }
 
   // Invalidate if CPU reads in software and there are non-CPU
   // writers. No need to do this for the metadata buffer as it is
   // only read/written in software.
-
-  // todo use handle here
   if (err == Error::NONE && (hnd->flags & private_handle_t::PRIV_FLAGS_USES_ION) &&
       (hnd->flags & private_handle_t::PRIV_FLAGS_CACHED)) {
-    if (allocator_->CleanBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset,
-                                buf->ion_handle_main, CACHE_INVALIDATE, hnd->fd)) {
+    if (SyncCache(*buf, buf->cpu_access.GetLockOps()) != Error::NONE) {
       return Error::BAD_BUFFER;
     }
   }
 
+  if (err == Error::NONE) {
+    buf->cpu_access.Lock(CpuCanWrite(usage));
+  }
+
   // Mark the buffer to be flushed after CPU write.
   if (err == Error::NONE && CpuCanWrite(usage)) {
     private_handle_t *handle = const_cast<private_handle_t *>(hnd);
@@ -536,62 +622,63 @@ Error BufferManager::LockBuffer(const private_handle_t *hnd, uint64_t usage) {
 }
 
 Error BufferManager::FlushBuffer(const private_handle_t *handle) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
   auto status = Error::NONE;
 
   private_handle_t *hnd = const_cast<private_handle_t *>(handle);
-  auto buf = GetBufferFromHandleLocked(hnd);
+  auto buf = GetMappedBuffer(hnd, false, &status);
   if (buf == nullptr) {
     return Error::BAD_BUFFER;
   }
 
-  if (allocator_->CleanBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset,
-                              buf->ion_handle_main, CACHE_CLEAN, hnd->fd) != 0) {
-    status = Error::BAD_BUFFER;
+  std::lock_guard<std::mutex> cpu_access_lock(buf->cpu_access_lock);
+  if (buf->freed) {
+    return Error::BAD_BUFFER;
   }
 
-  return status;
+  // Nothing to clean if the CPU has not written the buffer since the last clean, and cannot while
+  // it is not locked for writing.
+  return SyncCache(*buf, buf->cpu_access.Flush());
 }
 
 Error BufferManager::RereadBuffer(const private_handle_t *handle) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
   auto status = Error::NONE;
 
   private_handle_t *hnd = const_cast<private_handle_t *>(handle);
-  auto buf = GetBufferFromHandleLocked(hnd);
+  auto buf = GetMappedBuffer(hnd, false, &status);
   if (buf == nullptr) {
     return Error::BAD_BUFFER;
   }
 
-  if (allocator_->CleanBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset,
-                              buf->ion_handle_main, CACHE_INVALIDATE, hnd->fd) != 0) {
-    status = Error::BAD_BUFFER;
+  // A device may have written the buffer while it is locked, always invalidate.
+  std::lock_guard<std::mutex> cpu_access_lock(buf->cpu_access_lock);
+  if (buf->freed) {
+    return Error::BAD_BUFFER;
   }
 
-  return status;
+  return SyncCache(*buf, buf->cpu_access.Reread());
 }
 
 Error BufferManager::UnlockBuffer(const private_handle_t *handle) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
   auto status = Error::NONE;
 
   private_handle_t *hnd = const_cast<private_handle_t *>(handle);
-  auto buf = GetBufferFromHandleLocked(hnd);
+  auto buf = GetMappedBuffer(hnd, false, &status);
   if (buf == nullptr) {
     return Error::BAD_BUFFER;
   }
 
-  if (hnd->flags & private_handle_t::PRIV_FLAGS_NEEDS_FLUSH) {
-    if (allocator_->CleanBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset,
-                                buf->ion_handle_main, CACHE_CLEAN, hnd->fd) != 0) {
-      status = Error::BAD_BUFFER;
-    }
+  std::lock_guard<std::mutex> cpu_access_lock(buf->cpu_access_lock);
+  if (buf->freed) {
+    return Error::BAD_BUFFER;
+  }
+
+  // Writes are cleaned by every unlock while a write lock may still be held, READ_DONE is left to
+  // the last unlock.
+  if (SyncCache(*buf, buf->cpu_access.Unlock()) != Error::NONE) {
+    status = Error::BAD_BUFFER;
+  }
+  if (!buf->cpu_access.IsDirty()) {
     hnd->flags &= ~private_handle_t::PRIV_FLAGS_NEEDS_FLUSH;
-  } else {
-    if (allocator_->CleanBuffer(reinterpret_cast<void *>(hnd->base), hnd->size, hnd->offset,
-                                buf->ion_handle_main, CACHE_READ_DONE, hnd->fd) != 0) {
-      status = Error::BAD_BUFFER;
-    }
   }
 
   return status;
@@ -625,44 +712,40 @@ static void InitializePrivateHandle(private_handle_t *hnd, int fd, int meta_fd,
   hnd->numFds = qtigralloc::private_handle_t::kNumFds;
 }
 
-Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_handle_t *handle,
-                                    unsigned int bufferSize, bool testAlloc) {
-  if (!handle)
-    return Error::BAD_BUFFER;
-  std::lock_guard<std::mutex> buffer_lock(buffer_lock_);
+Error BufferManager::GetBufferLayout(const BufferDescriptor &descriptor, unsigned int bufferSize,
+                                     BufferLayout *layout) {
+  layout->usage = descriptor.GetUsage();
+  layout->format = GetImplDefinedFormat(layout->usage, descriptor.GetFormat());
+  layout->layer_count = descriptor.GetLayerCount();
+  layout->buffer_type = GetBufferType(layout->format);
 
-  uint64_t usage = descriptor.GetUsage();
-  int format = GetImplDefinedFormat(usage, descriptor.GetFormat());
-  uint32_t layer_count = descriptor.GetLayerCount();
-
-  unsigned int size;
-  unsigned int alignedw, alignedh;
-  int err = 0;
-
-  int buffer_type = GetBufferType(format);
   BufferInfo info = GetBufferInfo(descriptor);
-  info.format = format;
-  info.layer_count = layer_count;
+  info.format = layout->format;
+  info.layer_count = layout->layer_count;
 
-  GraphicsMetadata graphics_metadata = {};
-  err = GetBufferSizeAndDimensions(info, &size, &alignedw, &alignedh, &graphics_metadata);
+  layout->graphics_metadata = {};
+  int err = GetBufferSizeAndDimensions(info, &layout->size, &layout->alignedw, &layout->alignedh,
+                                       &layout->graphics_metadata);
   if (err < 0) {
     return Error::BAD_DESCRIPTOR;
   }
 
-  if (testAlloc) {
-    if (size == 0) {
-       return Error::NO_RESOURCES;
-    }
-    return Error::NONE;
-  }
+  layout->size = (bufferSize >= layout->size) ? bufferSize : layout->size;
+
+  return Error::NONE;
+}
+
+Error BufferManager::AllocateHandle(const BufferDescriptor &descriptor, const BufferLayout &layout,
+                                    buffer_handle_t *handle, AllocatedHandle *out) {
+  uint64_t usage = layout.usage;
+  int format = layout.format;
+  int err = 0;
 
-  size = (bufferSize >= size) ? bufferSize : size;
   uint64_t flags = 0;
   auto page_size = UINT(getpagesize());
   AllocData data;
   data.align = GetDataAlignment(format, usage);
-  data.size = size;
+  data.size = layout.size;
   data.handle = (uintptr_t)handle;
   data.uncached = UseUncached(format, usage);
 
@@ -670,7 +753,7 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
   err = allocator_->AllocateMem(&data, usage, format);
   if (err) {
     ALOGE("gralloc failed to allocate err=%s format %d size %d WxH %dx%d usage %" PRIu64,
-          strerror(-err), format, size, alignedw, alignedh, usage);
+          strerror(-err), format, layout.size, layout.alignedw, layout.alignedh, usage);
     return Error::NO_RESOURCES;
   }
 
@@ -680,9 +763,10 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
   e_data.handle = data.handle;
   e_data.align = page_size;
 
-  err = allocator_->AllocateMem(&e_data, 0, 0);
+  err = allocator_->AllocateMem(&e_data, 0, 0, true);
   if (err) {
     ALOGE("gralloc failed to allocate metadata error=%s", strerror(-err));
+    allocator_->FreeBuffer(nullptr, data.size, 0, data.fd, data.ion_handle);
     return Error::NO_RESOURCES;
   }
 
@@ -697,21 +781,28 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
   private_handle_t *hnd = static_cast<private_handle_t *>(malloc(sizeof(private_handle_t)));
   if (hnd == nullptr) {
     ALOGE("gralloc failed to allocate private_handle_t");
+    allocator_->FreeBuffer(nullptr, data.size, 0, data.fd, data.ion_handle);
+    allocator_->FreeBuffer(nullptr, e_data.size, 0, e_data.fd, e_data.ion_handle);
     return Error::NO_RESOURCES;
   }
 
-  InitializePrivateHandle(hnd, data.fd, e_data.fd, INT(flags), INT(alignedw), INT(alignedh),
-                          descriptor.GetWidth(), descriptor.GetHeight(), format, buffer_type,
-                          data.size, usage);
+  InitializePrivateHandle(hnd, data.fd, e_data.fd, INT(flags), INT(layout.alignedw),
+                          INT(layout.alignedh), descriptor.GetWidth(), descriptor.GetHeight(),
+                          format, layout.buffer_type, data.size, usage);
 
   hnd->reserved_size = static_cast<unsigned int>(descriptor.GetReservedSize());
   hnd->id = ++next_id_;
   hnd->base = 0;
   hnd->base_metadata = 0;
-  hnd->layer_count = layer_count;
+  hnd->layer_count = layout.layer_count;
+
+  out->hnd = hnd;
+  out->ion_handle = data.ion_handle;
+  out->ion_handle_meta = e_data.ion_handle;
 
-  bool use_adreno_for_size = CanUseAdrenoForSize(buffer_type, usage);
+  bool use_adreno_for_size = CanUseAdrenoForSize(layout.buffer_type, usage);
   if (use_adreno_for_size) {
+    GraphicsMetadata graphics_metadata = layout.graphics_metadata;
     setMetaDataAndUnmap(hnd, SET_GRAPHICS_METADATA, reinterpret_cast<void *>(&graphics_metadata));
   }
 
@@ -744,7 +835,48 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
   UnmapAndReset(hnd, descriptor.GetReservedSize());
   *handle = hnd;
 
-  RegisterHandleLocked(hnd, data.ion_handle, e_data.ion_handle);
+  return Error::NONE;
+}
+
+void BufferManager::FreeAllocatedHandle(const AllocatedHandle &allocated) {
+  private_handle_t *hnd = allocated.hnd;
+  if (hnd == nullptr) {
+    return;
+  }
+
+  UnmapAndReset(hnd, hnd->reserved_size);
+  allocator_->FreeBuffer(nullptr, hnd->size, hnd->offset, hnd->fd, allocated.ion_handle);
+  allocator_->FreeBuffer(nullptr, static_cast<unsigned int>(GetMetaDataSize(hnd->reserved_size)),
+                         hnd->offset_metadata, hnd->fd_metadata, allocated.ion_handle_meta);
+  free(hnd);
+}
+
+Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_handle_t *handle,
+                                    unsigned int bufferSize, bool testAlloc) {
+  if (!handle)
+    return Error::BAD_BUFFER;
+
+  if (testAlloc) {
+    return IsSupported(descriptor);
+  }
+
+  BufferLayout layout;
+  auto err = GetBufferLayout(descriptor, bufferSize, &layout);
+  if (err != Error::NONE) {
+    return err;
+  }
+
+  // The buffer is not visible to other threads until it is registered, only that needs the lock.
+  AllocatedHandle allocated;
+  err = AllocateHandle(descriptor, layout, handle, &allocated);
+  if (err != Error::NONE) {
+    FreeAllocatedHandle(allocated);
+    return err;
+  }
+
+  private_handle_t *hnd = allocated.hnd;
+  std::lock_guard<std::shared_mutex> buffer_lock(buffer_lock_);
+  RegisterHandleLocked(hnd, allocated.ion_handle, allocated.ion_handle_meta);
   ALOGD_IF(DEBUG, "Allocated buffer handle: %p id: %" PRIu64, hnd, hnd->id);
   if (DEBUG) {
     private_handle_t::Dump(hnd);
@@ -752,6 +884,49 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
   return Error::NONE;
 }
 
+Error BufferManager::AllocateBuffers(const BufferDescriptor &descriptor, uint32_t count,
+                                     std::vector<buffer_handle_t> *handles) {
+  BufferLayout layout;
+  auto err = GetBufferLayout(descriptor, 0, &layout);
+  if (err != Error::NONE) {
+    return err;
+  }
+
+  // Buffers are allocated and initialized on the calling thread and the allocation workers, the
+  // heap takes concurrent allocations (the buffer pool refills concurrently too).
+  std::vector<buffer_handle_t> out(count, nullptr);
+  std::vector<AllocatedHandle> allocated(count);
+  std::vector<Error> errors(count, Error::NONE);
+  alloc_workers_.Run(count, [&](uint32_t i) {
+    errors[i] = AllocateHandle(descriptor, layout, &out[i], &allocated[i]);
+  });
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (errors[i] != Error::NONE) {
+      err = errors[i];
+      break;
+    }
+  }
+
+  if (err != Error::NONE) {
+    for (auto &handle : allocated) {
+      FreeAllocatedHandle(handle);
+    }
+    return err;
+  }
+
+  {
+    std::lock_guard<std::shared_mutex> buffer_lock(buffer_lock_);
+    for (auto &handle : allocated) {
+      RegisterHandleLocked(handle.hnd, handle.ion_handle, handle.ion_handle_meta);
+    }
+  }
+  ALOGD_IF(DEBUG, "Allocated %u buffers of size %u", count, layout.size);
+
+  *handles = std::move(out);
+  return Error::NONE;
+}
+
 void BufferManager:: BuffersDump() {
   char timeStamp[32];
   char hms[32];
@@ -793,7 +968,7 @@ void BufferManager:: BuffersDump() {
 }
 
 Error BufferManager::Dump(std::ostringstream *os) {
-  std::lock_guard<std::mutex> buffer_lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> buffer_lock(buffer_lock_);
   for (auto it : handles_map_) {
     auto buf = it.second;
     auto hnd = buf->handle;
@@ -814,12 +989,25 @@ Error BufferManager::Dump(std::ostringstream *os) {
         << "0x" << std::setw(8) << hnd->format;
     *os << std::dec << std::setfill(' ') << std::endl;
   }
+  LayoutCacheStats layout_cache_stats;
+  GetLayoutCacheStats(&layout_cache_stats);
+  *os << "layout cache hits: " << layout_cache_stats.hits;
+  *os << " misses: " << layout_cache_stats.misses;
+  *os << " evictions: " << layout_cache_stats.evictions << std::endl;
+  LayoutCacheStats support_cache_stats;
+  support_cache_.GetStats(&support_cache_stats);
+  *os << "support cache hits: " << support_cache_stats.hits;
+  *os << " misses: " << support_cache_stats.misses;
+  *os << " evictions: " << support_cache_stats.evictions << std::endl;
+  *os << "cache maintenance ops: " << cache_ops_;
+  *os << " skipped: " << cache_ops_skipped_ << std::endl;
+  allocator_->Dump(os);
   return Error::NONE;
 }
 
 // Get list of private handles in handles_map_
 Error BufferManager::GetAllHandles(std::vector<const private_handle_t *> *out_handle_list) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
   if (handles_map_.empty()) {
     return Error::NO_RESOURCES;
   }
@@ -832,7 +1020,7 @@ Error BufferManager::GetAllHandles(std::vector<const private_handle_t *> *out_ha
 
 Error BufferManager::GetReservedRegion(private_handle_t *handle, void **reserved_region,
                                        uint64_t *reserved_region_size) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
   if (!handle)
     return Error::BAD_BUFFER;
 
@@ -851,7 +1039,7 @@ Error BufferManager::GetReservedRegion(private_handle_t *handle, void **reserved
 
 Error BufferManager::GetMetadataValue(private_handle_t *handle, int64_t metadatatype_value,
                                       void *param) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::shared_lock<std::shared_mutex> lock(buffer_lock_);
   if (!handle)
     return Error::BAD_BUFFER;
   auto buf = GetBufferFromHandleLocked(handle);
@@ -866,9 +1054,32 @@ Error BufferManager::GetMetadataValue(private_handle_t *handle, int64_t metadata
   return GetMetaDataValue(handle, metadatatype_value, param);
 }
 
+// Metadata types that SetMetadata rejects and that only depend on the private handle or on
+// metadata written at allocation time.
+static bool IsImmutableMetadata(int64_t metadatatype_value) {
+  switch (metadatatype_value) {
+    case (int64_t)StandardMetadataType::BUFFER_ID:
+    case (int64_t)StandardMetadataType::NAME:
+    case (int64_t)StandardMetadataType::WIDTH:
+    case (int64_t)StandardMetadataType::HEIGHT:
+    case (int64_t)StandardMetadataType::LAYER_COUNT:
+    case (int64_t)StandardMetadataType::PIXEL_FORMAT_REQUESTED:
+    case (int64_t)StandardMetadataType::PIXEL_FORMAT_FOURCC:
+    case (int64_t)StandardMetadataType::PIXEL_FORMAT_MODIFIER:
+    case (int64_t)StandardMetadataType::USAGE:
+    case (int64_t)StandardMetadataType::ALLOCATION_SIZE:
+    case (int64_t)StandardMetadataType::PROTECTED_CONTENT:
+    case (int64_t)StandardMetadataType::COMPRESSION:
+    case (int64_t)StandardMetadataType::PLANE_LAYOUTS:
+      return true;
+    default:
+      return false;
+  }
+}
+
 Error BufferManager::GetMetadata(private_handle_t *handle, int64_t metadatatype_value,
                                  hidl_vec<uint8_t> *out) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::shared_lock<std::shared_mutex> lock(buffer_lock_);
   if (!handle)
     return Error::BAD_BUFFER;
   auto buf = GetBufferFromHandleLocked(handle);
@@ -879,6 +1090,16 @@ Error BufferManager::GetMetadata(private_handle_t *handle, int64_t metadatatype_
     return Error::BAD_BUFFER;
   }
 
+  bool immutable = IsImmutableMetadata(metadatatype_value);
+  if (immutable) {
+    std::lock_guard<std::mutex> encoded_lock(buf->encoded_metadata_lock);
+    auto it = buf->encoded_metadata.find(metadatatype_value);
+    if (it != buf->encoded_metadata.end()) {
+      *out = it->second;
+      return Error::NONE;
+    }
+  }
+
   auto metadata = reinterpret_cast<MetaData_t *>(handle->base_metadata);
 
   void *metadata_ptr = nullptr;
@@ -1332,12 +1553,17 @@ Error BufferManager::GetMetadata(private_handle_t *handle, int64_t metadatatype_
       error = Error::UNSUPPORTED;
   }
 
+  if (immutable && (error == Error::NONE)) {
+    std::lock_guard<std::mutex> encoded_lock(buf->encoded_metadata_lock);
+    buf->encoded_metadata[metadatatype_value] = *out;
+  }
+
   return error;
 }
 
 Error BufferManager::SetMetadata(private_handle_t *handle, int64_t metadatatype_value,
                                  hidl_vec<uint8_t> in) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::shared_mutex> lock(buffer_lock_);
   if (!handle)
     return Error::BAD_BUFFER;
 
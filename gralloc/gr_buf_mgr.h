@@ -29,13 +29,16 @@
 #include <pthread.h>
 
 #include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "gr_alloc_workers.h"
 #include "gr_allocator.h"
 #include "gr_buf_descriptor.h"
+#include "gr_cpu_access.h"
 #include "gr_utils.h"
 #include "gralloc_priv.h"
 
@@ -47,6 +50,13 @@ class BufferManager {
 
   Error AllocateBuffer(const BufferDescriptor &descriptor, buffer_handle_t *handle,
                        unsigned int bufferSize = 0, bool testAlloc = false);
+  // Allocates count buffers of the descriptor. The layout is computed once and the buffers are
+  // allocated in parallel without buffer_lock_, which is taken once to register them all. No
+  // buffer is allocated on failure.
+  Error AllocateBuffers(const BufferDescriptor &descriptor, uint32_t count,
+                        std::vector<buffer_handle_t> *handles);
+  // Tells whether a buffer can be allocated for the descriptor, without allocating it.
+  Error IsSupported(const BufferDescriptor &descriptor);
   Error RetainBuffer(private_handle_t const *hnd);
   Error ReleaseBuffer(private_handle_t const *hnd);
   Error LockBuffer(const private_handle_t *hnd, uint64_t usage);
@@ -98,16 +108,74 @@ class BufferManager {
     bool DecRef() { return --ref_count == 0; }
     uint64_t reserved_size = 0;
     void *reserved_region_ptr = nullptr;
+    // Encoded values of the metadata types that cannot change after allocation, filled on the
+    // first query of each type.
+    std::mutex encoded_metadata_lock;
+    std::unordered_map<int64_t, hidl_vec<uint8_t>> encoded_metadata;
+    // CPU access to the buffer in this process, to skip redundant cache maintenance. Guarded by
+    // cpu_access_lock, which cache maintenance is done under instead of buffer_lock_.
+    std::mutex cpu_access_lock;
+    CpuAccess cpu_access;
+    bool freed = false;
   };
 
   Error FreeBuffer(std::shared_ptr<Buffer> buf);
 
+  // Size and layout of the buffers of a descriptor, the same for all buffers of a request.
+  struct BufferLayout {
+    uint64_t usage = 0;
+    int format = 0;
+    uint32_t layer_count = 0;
+    int buffer_type = 0;
+    unsigned int size = 0;
+    unsigned int alignedw = 0;
+    unsigned int alignedh = 0;
+    GraphicsMetadata graphics_metadata = {};
+  };
+
+  // A buffer allocated but not registered yet.
+  struct AllocatedHandle {
+    private_handle_t *hnd = nullptr;
+    int ion_handle = -1;
+    int ion_handle_meta = -1;
+  };
+
+  // Along with the calling thread.
+  static constexpr uint32_t kAllocWorkers = 3;
+
+  Error GetBufferLayout(const BufferDescriptor &descriptor, unsigned int bufferSize,
+                        BufferLayout *layout);
+  // Allocates the memory and handle of a buffer and initializes its metadata. Does not need
+  // buffer_lock_. allocated is filled once the handle exists, to free it if a later step fails.
+  Error AllocateHandle(const BufferDescriptor &descriptor, const BufferLayout &layout,
+                       buffer_handle_t *handle, AllocatedHandle *allocated);
+  void FreeAllocatedHandle(const AllocatedHandle &allocated);
+  // Looks up the buffer of the handle, mapping it if map is set.
+  std::shared_ptr<Buffer> GetMappedBuffer(const private_handle_t *hnd, bool map, Error *err);
+  // Called with buf->cpu_access_lock held.
+  Error SyncCache(const Buffer &buf, const CacheOps &cache_ops);
+
+  // Normalized descriptor parameters that decide IsSupported. Zero-initialized before being
+  // filled, as LayoutCache compares keys bytewise.
+  struct SupportKey {
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    uint32_t layer_count;
+    uint64_t usage;
+  };
+
   // Get the wrapper Buffer object from the handle, returns nullptr if handle is not found
   std::shared_ptr<Buffer> GetBufferFromHandleLocked(const private_handle_t *hnd);
   Allocator *allocator_ = NULL;
-  std::mutex buffer_lock_;
+  // Metadata queries only read the buffer state and take it shared.
+  std::shared_mutex buffer_lock_;
   std::unordered_map<const private_handle_t *, std::shared_ptr<Buffer>> handles_map_ = {};
   std::atomic<uint64_t> next_id_;
+  std::atomic<uint64_t> cache_ops_ = 0;
+  std::atomic<uint64_t> cache_ops_skipped_ = 0;
+  LayoutCache<SupportKey, Error, 64> support_cache_;
+  AllocWorkers alloc_workers_{kAllocWorkers};
   uint64_t allocated_ = 0;
   uint64_t kAllocThreshold = (uint64_t)1*1024*1024*1024;
   uint64_t kMemoryOffset = 50*1024*1024;
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <cutils/native_handle.h>
+#include <gralloctypes/Gralloc4.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gr_buf_mgr.h"
+#include "gr_priv_handle.h"
+#include "gr_utils.h"
+
+namespace gralloc {
+
+using aidl::android::hardware::graphics::common::Dataspace;
+using aidl::android::hardware::graphics::common::StandardMetadataType;
+
+static const int kFormats[] = {
+  HAL_PIXEL_FORMAT_RGBA_8888,
+  HAL_PIXEL_FORMAT_RGB_565,
+  HAL_PIXEL_FORMAT_RGBA_1010102,
+  HAL_PIXEL_FORMAT_RGBA_FP16,
+  HAL_PIXEL_FORMAT_BLOB,
+  HAL_PIXEL_FORMAT_RAW10,
+  HAL_PIXEL_FORMAT_Y8,
+  HAL_PIXEL_FORMAT_YV12,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP,
+  HAL_PIXEL_FORMAT_YCbCr_420_888,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS_UBWC,
+  HAL_PIXEL_FORMAT_YCbCr_420_TP10_UBWC,
+  HAL_PIXEL_FORMAT_YCbCr_420_P010,
+  HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+  // Not a format gralloc knows.
+  0x7fff,
+};
+
+static const uint64_t kUsages[] = {
+  0,
+  BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN,
+  BufferUsage::GPU_TEXTURE | BufferUsage::GPU_RENDER_TARGET,
+  BufferUsage::COMPOSER_OVERLAY | BufferUsage::GPU_TEXTURE,
+  static_cast<uint64_t>(BufferUsage::VIDEO_ENCODER),
+  BufferUsage::VIDEO_DECODER | GRALLOC_USAGE_PRIVATE_ALLOC_UBWC,
+  BufferUsage::CAMERA_OUTPUT | BufferUsage::CAMERA_INPUT,
+  GRALLOC_USAGE_PRIVATE_10BIT | GRALLOC_USAGE_PRIVATE_ALLOC_UBWC,
+};
+
+static const struct {
+  int width;
+  int height;
+} kSizes[] = {
+  {0, 0}, {1, 1}, {17, 33}, {1080, 2400}, {3840, 2160},
+};
+
+static BufferDescriptor GetDescriptor(int width, int height, int format, uint64_t usage,
+                                      uint32_t layer_count) {
+  BufferDescriptor descriptor;
+  descriptor.SetDimensions(width, height);
+  descriptor.SetColorFormat(format);
+  descriptor.SetUsage(usage);
+  descriptor.SetLayerCount(layer_count);
+  descriptor.SetName("gr_buf_mgr_test");
+  return descriptor;
+}
+
+// The decision AllocateBuffer took in test mode before IsSupported was memoized.
+static Error GetReferenceDecision(const BufferDescriptor &descriptor) {
+  uint64_t usage = descriptor.GetUsage();
+  BufferInfo info(descriptor.GetWidth(), descriptor.GetHeight(), descriptor.GetFormat(), usage);
+  info.format = GetImplDefinedFormat(usage, descriptor.GetFormat());
+  info.layer_count = descriptor.GetLayerCount();
+
+  unsigned int size = 0;
+  unsigned int alignedw = 0, alignedh = 0;
+  GraphicsMetadata graphics_metadata = {};
+  if (GetBufferSizeAndDimensions(info, &size, &alignedw, &alignedh, &graphics_metadata) < 0) {
+    return Error::BAD_DESCRIPTOR;
+  }
+
+  return (size == 0) ? Error::NO_RESOURCES : Error::NONE;
+}
+
+static std::vector<BufferDescriptor> GetDescriptors() {
+  std::vector<BufferDescriptor> descriptors;
+  for (int format : kFormats) {
+    for (uint64_t usage : kUsages) {
+      for (auto &size : kSizes) {
+        for (uint32_t layer_count : {1u, 2u}) {
+          descriptors.push_back(GetDescriptor(size.width, size.height, format, usage,
+                                              layer_count));
+        }
+      }
+    }
+  }
+  return descriptors;
+}
+
+static std::string Describe(const BufferDescriptor &descriptor) {
+  std::ostringstream os;
+  os << "format " << descriptor.GetFormat() << " usage 0x" << std::hex << descriptor.GetUsage()
+     << std::dec << " " << descriptor.GetWidth() << "x" << descriptor.GetHeight() << " layers "
+     << descriptor.GetLayerCount();
+  return os.str();
+}
+
+// The memoized decision matches the one computed without the memo, on a miss and on a hit.
+TEST(BufferManagerIsSupported, MatchesReference) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  for (auto &descriptor : GetDescriptors()) {
+    SCOPED_TRACE(Describe(descriptor));
+    Error expected = GetReferenceDecision(descriptor);
+    EXPECT_EQ(expected, buf_mgr->IsSupported(descriptor));
+    EXPECT_EQ(expected, buf_mgr->IsSupported(descriptor));
+  }
+}
+
+// The whole set does not fit in the memo, later passes see evicted entries recomputed.
+TEST(BufferManagerIsSupported, MatchesReferenceUnderEviction) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  std::vector<BufferDescriptor> descriptors = GetDescriptors();
+  std::vector<Error> expected;
+  for (auto &descriptor : descriptors) {
+    expected.push_back(GetReferenceDecision(descriptor));
+  }
+
+  for (int pass = 0; pass < 3; pass++) {
+    for (size_t i = 0; i < descriptors.size(); i++) {
+      SCOPED_TRACE(Describe(descriptors[i]));
+      EXPECT_EQ(expected[i], buf_mgr->IsSupported(descriptors[i]));
+    }
+  }
+}
+
+// Test allocations answer from the same decision and never hand out a buffer.
+TEST(BufferManagerIsSupported, TestAllocationMatches) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  for (auto &descriptor : GetDescriptors()) {
+    SCOPED_TRACE(Describe(descriptor));
+    buffer_handle_t handle = nullptr;
+    EXPECT_EQ(GetReferenceDecision(descriptor),
+              buf_mgr->AllocateBuffer(descriptor, &handle, 0, true /* testAlloc */));
+    EXPECT_EQ(nullptr, handle);
+  }
+}
+
+// Readers race with writers that keep evicting the memo entries.
+TEST(BufferManagerIsSupported, ConcurrentQueries) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  std::vector<BufferDescriptor> descriptors = GetDescriptors();
+  std::vector<Error> expected;
+  for (auto &descriptor : descriptors) {
+    expected.push_back(GetReferenceDecision(descriptor));
+  }
+
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      for (int pass = 0; pass < 4; pass++) {
+        for (size_t i = t; i < descriptors.size(); i += (t + 1)) {
+          if (buf_mgr->IsSupported(descriptors[i]) != expected[i]) {
+            mismatches++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+}
+
+// Allocates a buffer and imports a clone of its handle, the way the allocator service and the
+// mapper of a client do.
+class ImportedBuffer {
+ public:
+  explicit ImportedBuffer(const BufferDescriptor &descriptor) {
+    BufferManager *buf_mgr = BufferManager::GetInstance();
+    if (buf_mgr->AllocateBuffer(descriptor, &allocated_) != Error::NONE) {
+      return;
+    }
+    native_handle_t *clone = native_handle_clone(allocated_);
+    if (clone == nullptr) {
+      return;
+    }
+    if (buf_mgr->RetainBuffer(PRIV_HANDLE_CONST(clone)) != Error::NONE) {
+      native_handle_close(clone);
+      native_handle_delete(clone);
+      return;
+    }
+    imported_ = const_cast<private_handle_t *>(PRIV_HANDLE_CONST(clone));
+  }
+
+  ~ImportedBuffer() {
+    BufferManager *buf_mgr = BufferManager::GetInstance();
+    if (imported_) {
+      buf_mgr->ReleaseBuffer(imported_);
+    }
+    if (allocated_) {
+      buf_mgr->ReleaseBuffer(PRIV_HANDLE_CONST(allocated_));
+    }
+  }
+
+  private_handle_t *get() const { return imported_; }
+
+ private:
+  buffer_handle_t allocated_ = nullptr;
+  private_handle_t *imported_ = nullptr;
+};
+
+static const StandardMetadataType kImmutableTypes[] = {
+  StandardMetadataType::BUFFER_ID,
+  StandardMetadataType::NAME,
+  StandardMetadataType::WIDTH,
+  StandardMetadataType::HEIGHT,
+  StandardMetadataType::LAYER_COUNT,
+  StandardMetadataType::PIXEL_FORMAT_REQUESTED,
+  StandardMetadataType::PIXEL_FORMAT_FOURCC,
+  StandardMetadataType::PIXEL_FORMAT_MODIFIER,
+  StandardMetadataType::USAGE,
+  StandardMetadataType::ALLOCATION_SIZE,
+  StandardMetadataType::PROTECTED_CONTENT,
+  StandardMetadataType::COMPRESSION,
+  StandardMetadataType::PLANE_LAYOUTS,
+};
+
+static hidl_vec<uint8_t> GetMetadata(private_handle_t *hnd, StandardMetadataType type,
+                                     Error *error) {
+  hidl_vec<uint8_t> out;
+  *error = BufferManager::GetInstance()->GetMetadata(hnd, static_cast<int64_t>(type), &out);
+  return out;
+}
+
+class BufferManagerMetadataTest : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    buffer_ = std::make_unique<ImportedBuffer>(GetDescriptor(
+        1080, 2400, GetParam(), BufferUsage::GPU_TEXTURE | BufferUsage::COMPOSER_OVERLAY, 1));
+    ASSERT_NE(nullptr, buffer_->get());
+  }
+
+  std::unique_ptr<ImportedBuffer> buffer_;
+};
+
+// The blob served for an immutable type is the encoding of the values in the handle, on the
+// first query that encodes it and on the later ones served from the buffer.
+TEST_P(BufferManagerMetadataTest, ImmutableBlobsMatchHandle) {
+  private_handle_t *hnd = buffer_->get();
+  for (auto type : kImmutableTypes) {
+    SCOPED_TRACE(::testing::Message() << "type " << static_cast<int64_t>(type));
+    Error error = Error::NONE;
+    hidl_vec<uint8_t> first = GetMetadata(hnd, type, &error);
+    ASSERT_EQ(Error::NONE, error);
+    hidl_vec<uint8_t> second = GetMetadata(hnd, type, &error);
+    ASSERT_EQ(Error::NONE, error);
+    EXPECT_EQ(first, second);
+  }
+
+  Error error = Error::NONE;
+  uint64_t id = 0;
+  ASSERT_EQ(0, android::gralloc4::decodeBufferId(
+                   GetMetadata(hnd, StandardMetadataType::BUFFER_ID, &error), &id));
+  EXPECT_EQ(hnd->id, id);
+  std::string name;
+  ASSERT_EQ(0, android::gralloc4::decodeName(
+                   GetMetadata(hnd, StandardMetadataType::NAME, &error), &name));
+  EXPECT_EQ("gr_buf_mgr_test", name);
+  uint64_t width = 0;
+  ASSERT_EQ(0, android::gralloc4::decodeWidth(
+                   GetMetadata(hnd, StandardMetadataType::WIDTH, &error), &width));
+  EXPECT_EQ(1080u, width);
+  uint64_t height = 0;
+  ASSERT_EQ(0, android::gralloc4::decodeHeight(
+                   GetMetadata(hnd, StandardMetadataType::HEIGHT, &error), &height));
+  EXPECT_EQ(2400u, height);
+  uint64_t usage = 0;
+  ASSERT_EQ(0, android::gralloc4::decodeUsage(
+                   GetMetadata(hnd, StandardMetadataType::USAGE, &error), &usage));
+  EXPECT_EQ(hnd->usage, usage);
+  uint64_t allocation_size = 0;
+  ASSERT_EQ(0, android::gralloc4::decodeAllocationSize(
+                   GetMetadata(hnd, StandardMetadataType::ALLOCATION_SIZE, &error),
+                   &allocation_size));
+  EXPECT_EQ(hnd->size, allocation_size);
+}
+
+// Immutable types cannot be written, so the blobs kept by the buffer never go stale.
+TEST_P(BufferManagerMetadataTest, ImmutableTypesRejectWrites) {
+  private_handle_t *hnd = buffer_->get();
+  Error error = Error::NONE;
+  hidl_vec<uint8_t> before = GetMetadata(hnd, StandardMetadataType::WIDTH, &error);
+  ASSERT_EQ(Error::NONE, error);
+
+  hidl_vec<uint8_t> in;
+  ASSERT_EQ(0, android::gralloc4::encodeWidth(16, &in));
+  EXPECT_NE(Error::NONE, BufferManager::GetInstance()->SetMetadata(
+                             hnd, static_cast<int64_t>(StandardMetadataType::WIDTH), in));
+  EXPECT_EQ(before, GetMetadata(hnd, StandardMetadataType::WIDTH, &error));
+}
+
+// Mutable types are encoded on every query and reflect the last write.
+TEST_P(BufferManagerMetadataTest, MutableTypesAreNotKept) {
+  private_handle_t *hnd = buffer_->get();
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  for (auto dataspace : {Dataspace::SRGB, Dataspace::DISPLAY_P3, Dataspace::BT2020_PQ}) {
+    hidl_vec<uint8_t> in;
+    ASSERT_EQ(0, android::gralloc4::encodeDataspace(dataspace, &in));
+    ASSERT_EQ(Error::NONE, buf_mgr->SetMetadata(
+                               hnd, static_cast<int64_t>(StandardMetadataType::DATASPACE), in));
+
+    Error error = Error::NONE;
+    Dataspace out = Dataspace::UNKNOWN;
+    ASSERT_EQ(0, android::gralloc4::decodeDataspace(
+                     GetMetadata(hnd, StandardMetadataType::DATASPACE, &error), &out));
+    EXPECT_EQ(dataspace, out);
+  }
+}
+
+// Readers of the shared lock run along writers of the same buffer and allocations of others.
+TEST_P(BufferManagerMetadataTest, ConcurrentReadersAndWriters) {
+  private_handle_t *hnd = buffer_->get();
+  std::vector<hidl_vec<uint8_t>> expected;
+  for (auto type : kImmutableTypes) {
+    Error error = Error::NONE;
+    expected.push_back(GetMetadata(hnd, type, &error));
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      while (!done) {
+        for (size_t i = 0; i < expected.size(); i++) {
+          Error error = Error::NONE;
+          if (GetMetadata(hnd, kImmutableTypes[i], &error) != expected[i] ||
+              error != Error::NONE) {
+            mismatches++;
+          }
+        }
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    BufferManager *buf_mgr = BufferManager::GetInstance();
+    hidl_vec<uint8_t> in;
+    android::gralloc4::encodeDataspace(Dataspace::SRGB, &in);
+    while (!done) {
+      buf_mgr->SetMetadata(hnd, static_cast<int64_t>(StandardMetadataType::DATASPACE), in);
+    }
+  });
+
+  for (int i = 0; i < 50; i++) {
+    ImportedBuffer other(GetDescriptor(256, 256, GetParam(), BufferUsage::GPU_TEXTURE, 1));
+    EXPECT_NE(nullptr, other.get());
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, BufferManagerMetadataTest,
+                         ::testing::Values(HAL_PIXEL_FORMAT_RGBA_8888,
+                                           HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS,
+                                           HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS_UBWC));
+
+}  // namespace gralloc
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define DEBUG 0
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
+#include <log/log.h>
+#include <utils/Trace.h>
+#include <vector>
+
+#include "gr_buf_pool.h"
+#include "gralloc_priv.h"
+
+namespace gralloc {
+
+BufferPool::BufferPool(AllocInterface *heap) : heap_(heap) {}
+
+BufferPool::~BufferPool() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    exit_ = true;
+  }
+  cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  TrimLocked(0);
+}
+
+void BufferPool::Configure(const BufferPoolConfig &config) {
+  std::lock_guard<std::mutex> lock(lock_);
+  config_ = config;
+  TrimLocked(config_.max_bytes);
+  if (config_.max_bytes && !worker_.joinable()) {
+    worker_ = std::thread(&BufferPool::WorkerThread, this);
+  }
+}
+
+bool BufferPool::IsEligible(const AllocData &data, uint64_t usage, bool metadata) const {
+  if (!config_.max_bytes || !data.vm_names.empty() ||
+      (data.alloc_type & private_handle_t::PRIV_FLAGS_SECURE_BUFFER) ||
+      (usage & GRALLOC_USAGE_PROTECTED)) {
+    return false;
+  }
+
+  return metadata ? config_.pool_metadata : (usage & config_.usage_mask) != 0;
+}
+
+bool BufferPool::IsHotLocked(ClassState *state, Clock::time_point now) {
+  while (!state->requests.empty() && (now - state->requests.front()) > config_.max_age) {
+    state->requests.pop_front();
+  }
+
+  return state->requests.size() >= config_.hot_threshold;
+}
+
+bool BufferPool::Acquire(AllocData *data, uint64_t usage, bool metadata) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!IsEligible(*data, usage, metadata)) {
+    return false;
+  }
+
+  SizeClass size_class = {data->heap_name, data->flags, data->size, data->align, data->uncached};
+  ClassState &state = classes_[size_class];
+  auto now = Clock::now();
+  state.requests.push_back(now);
+  if (state.requests.size() > config_.hot_threshold) {
+    state.requests.pop_front();
+  }
+
+  bool hit = !state.buffers.empty();
+  if (hit) {
+    PooledBuffer buffer = state.buffers.front();
+    state.buffers.pop_front();
+    data->fd = buffer.fd;
+    data->ion_handle = buffer.ion_handle;
+    stats_.bytes_held -= data->size;
+    stats_.buffers_held--;
+    stats_.hits++;
+  } else {
+    stats_.misses++;
+  }
+  ALOGD_IF(DEBUG, "%s: size %u heap %s %s", __FUNCTION__, data->size, data->heap_name.c_str(),
+           hit ? "hit" : "miss");
+
+  if (IsHotLocked(&state, now)) {
+    refill_pending_ = true;
+    cv_.notify_one();
+  }
+
+  return hit;
+}
+
+int BufferPool::Allocate(AllocData *data, uint64_t usage, bool metadata) {
+  if (Acquire(data, usage, metadata)) {
+    return 0;
+  }
+
+  int err = heap_->AllocBuffer(data);
+  if (err < 0 && Trim(0)) {
+    // The heap is short of memory, hand it what the pool holds and try once more.
+    ALOGW("%s: Allocation failed, trimmed buffer pool to retry", __FUNCTION__);
+    err = heap_->AllocBuffer(data);
+  }
+
+  return err;
+}
+
+void BufferPool::FreeLocked(const SizeClass &size_class, const PooledBuffer &buffer) {
+  heap_->FreeBuffer(nullptr, size_class.size, 0, buffer.fd, buffer.ion_handle);
+  stats_.bytes_held -= size_class.size;
+  stats_.buffers_held--;
+  stats_.trimmed_bytes += size_class.size;
+}
+
+uint64_t BufferPool::Trim(uint64_t target_bytes) {
+  std::lock_guard<std::mutex> lock(lock_);
+  uint64_t bytes_held = stats_.bytes_held;
+  TrimLocked(target_bytes);
+
+  return bytes_held - stats_.bytes_held;
+}
+
+void BufferPool::TrimLocked(uint64_t target_bytes) {
+  // Oldest buffers first within each class; classes are visited in key order.
+  for (auto &it : classes_) {
+    auto &buffers = it.second.buffers;
+    while (!buffers.empty() && stats_.bytes_held > target_bytes) {
+      FreeLocked(it.first, buffers.front());
+      buffers.pop_front();
+    }
+  }
+}
+
+void BufferPool::TrimAgedLocked(Clock::time_point now) {
+  for (auto it = classes_.begin(); it != classes_.end();) {
+    auto &state = it->second;
+    bool hot = IsHotLocked(&state, now);
+    while (!state.buffers.empty() &&
+           (!hot || (now - state.buffers.front().created) > config_.max_age)) {
+      FreeLocked(it->first, state.buffers.front());
+      state.buffers.pop_front();
+    }
+    if (state.buffers.empty() && state.requests.empty()) {
+      it = classes_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void BufferPool::Refill(std::unique_lock<std::mutex> *lock) {
+  auto now = Clock::now();
+  std::vector<SizeClass> pending;
+  for (auto &it : classes_) {
+    if (IsHotLocked(&it.second, now) && it.second.buffers.size() < config_.buffers_per_class) {
+      pending.push_back(it.first);
+    }
+  }
+
+  for (auto &size_class : pending) {
+    auto state = classes_.find(size_class);
+    while (!exit_ && state != classes_.end() &&
+           state->second.buffers.size() < config_.buffers_per_class &&
+           stats_.bytes_held + size_class.size <= config_.max_bytes) {
+      AllocData data;
+      data.heap_name = size_class.heap_name;
+      data.flags = size_class.flags;
+      data.size = size_class.size;
+      data.align = size_class.align;
+      data.uncached = size_class.uncached;
+
+      // Allocate outside the lock, the kernel zeroes the pages here.
+      lock->unlock();
+      ATRACE_BEGIN("BufferPool::Refill");
+      int err = heap_->AllocBuffer(&data);
+      ATRACE_END();
+      lock->lock();
+      if (err < 0) {
+        ALOGW("%s: Failed to allocate size %u heap %s err %d", __FUNCTION__, data.size,
+              data.heap_name.c_str(), err);
+        break;
+      }
+
+      // The class may have been trimmed or the pool shrunk while the lock was dropped.
+      state = classes_.find(size_class);
+      if (exit_ || state == classes_.end() ||
+          stats_.bytes_held + size_class.size > config_.max_bytes) {
+        heap_->FreeBuffer(nullptr, data.size, 0, data.fd, data.ion_handle);
+        break;
+      }
+      state->second.buffers.push_back({data.fd, data.ion_handle, Clock::now()});
+      stats_.bytes_held += size_class.size;
+      stats_.buffers_held++;
+    }
+  }
+}
+
+void BufferPool::WorkerThread() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!exit_) {
+    cv_.wait_for(lock, config_.max_age, [this] { return exit_ || refill_pending_; });
+    if (exit_) {
+      break;
+    }
+
+    if (refill_pending_) {
+      refill_pending_ = false;
+      Refill(&lock);
+    }
+    TrimAgedLocked(Clock::now());
+  }
+}
+
+void BufferPool::GetStats(BufferPoolStats *stats) {
+  std::lock_guard<std::mutex> lock(lock_);
+  *stats = stats_;
+}
+
+void BufferPool::Dump(std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(lock_);
+  *os << "buffer pool hits: " << stats_.hits << " misses: " << stats_.misses;
+  *os << " held: " << stats_.buffers_held << " (" << stats_.bytes_held / 1024 << " KiB)";
+  *os << " trimmed: " << stats_.trimmed_bytes / 1024 << " KiB" << std::endl;
+  for (auto &it : classes_) {
+    if (it.second.buffers.empty()) {
+      continue;
+    }
+    *os << "  heap: " << it.first.heap_name << " size: " << it.first.size;
+    *os << " buffers: " << it.second.buffers.size() << std::endl;
+  }
+}
+
+}  // namespace gralloc
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GR_BUF_POOL_H__
+#define __GR_BUF_POOL_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include "gr_alloc_interface.h"
+
+namespace gralloc {
+
+struct BufferPoolConfig {
+  // Upper bound of memory held by the pool. Zero disables the pool.
+  uint64_t max_bytes = 0;
+  // Usage bits that make a buffer eligible for pooling.
+  uint64_t usage_mask = 0;
+  // Whether the metadata buffers allocated along with each buffer are pooled.
+  bool pool_metadata = false;
+  // Number of buffers kept ready per size class.
+  uint32_t buffers_per_class = 2;
+  // A size class becomes hot once it is requested this many times within max_age.
+  uint32_t hot_threshold = 2;
+  // Idle buffers and size classes without demand are trimmed after this period.
+  std::chrono::milliseconds max_age = std::chrono::milliseconds(5000);
+};
+
+struct BufferPoolStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t bytes_held = 0;
+  uint32_t buffers_held = 0;
+  uint64_t trimmed_bytes = 0;
+};
+
+// Keeps freshly allocated, never shared, non-secure buffers ready for the size classes that
+// are requested repeatedly, so that the allocating thread does not pay for the heap allocation
+// and kernel zeroing of the pages.
+// Released buffers are never returned to the pool: once handed out, a dma-buf may still be
+// referenced by its importers after the allocator drops its own reference.
+// Refill and trimming run on a worker thread. The heap is accessed through AllocInterface so
+// that the pool can be exercised against a fake backend.
+class BufferPool {
+ public:
+  explicit BufferPool(AllocInterface *heap);
+  ~BufferPool();
+
+  void Configure(const BufferPoolConfig &config);
+
+  // Fills fd/ion_handle of data from a pooled buffer matching the requested heap, flags and size.
+  // metadata tells the metadata buffer of an allocation from the buffer itself. Returns false if
+  // no such buffer is available; the demand is recorded either way.
+  bool Acquire(AllocData *data, uint64_t usage, bool metadata);
+
+  // Takes data from the pool, or allocates it from the heap on a miss. A failed heap allocation
+  // releases every pooled buffer and is retried once. Returns 0 or the heap error.
+  int Allocate(AllocData *data, uint64_t usage, bool metadata);
+
+  // Releases pooled buffers until at most target_bytes are held. Meant to be called on memory
+  // pressure. Returns the number of bytes released.
+  uint64_t Trim(uint64_t target_bytes);
+
+  void GetStats(BufferPoolStats *stats);
+  void Dump(std::ostringstream *os);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct SizeClass {
+    std::string heap_name;
+    unsigned int flags;
+    unsigned int size;
+    unsigned int align;
+    bool uncached;
+
+    bool operator<(const SizeClass &rhs) const {
+      return std::tie(heap_name, flags, size, align, uncached) <
+             std::tie(rhs.heap_name, rhs.flags, rhs.size, rhs.align, rhs.uncached);
+    }
+  };
+
+  struct PooledBuffer {
+    int fd;
+    int ion_handle;
+    Clock::time_point created;
+  };
+
+  struct ClassState {
+    std::deque<PooledBuffer> buffers;
+    std::deque<Clock::time_point> requests;
+  };
+
+  bool IsEligible(const AllocData &data, uint64_t usage, bool metadata) const;
+  bool IsHotLocked(ClassState *state, Clock::time_point now);
+  void FreeLocked(const SizeClass &size_class, const PooledBuffer &buffer);
+  void TrimLocked(uint64_t target_bytes);
+  void TrimAgedLocked(Clock::time_point now);
+  void Refill(std::unique_lock<std::mutex> *lock);
+  void WorkerThread();
+
+  AllocInterface *heap_ = nullptr;
+  BufferPoolConfig config_;
+  std::map<SizeClass, ClassState> classes_;
+  BufferPoolStats stats_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool refill_pending_ = false;
+  bool exit_ = false;
+  std::thread worker_;
+};
+
+}  // namespace gralloc
+
+#endif  // __GR_BUF_POOL_H__
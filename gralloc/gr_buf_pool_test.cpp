@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "gr_buf_pool.h"
+#include "gralloc_priv.h"
+
+namespace gralloc {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const unsigned int kSize = 64 * 1024;
+const uint64_t kPooledUsage = 0x100;
+const uint64_t kOtherUsage = 0x200;
+
+// A heap of capacity bytes handing out fake fds.
+class FakeHeap : public AllocInterface {
+ public:
+  explicit FakeHeap(uint64_t capacity = UINT64_MAX) : capacity_(capacity) {}
+
+  int AllocBuffer(AllocData *data) override {
+    std::lock_guard<std::mutex> lock(lock_);
+    allocs_++;
+    if (live_bytes_ + data->size > capacity_) {
+      return -ENOMEM;
+    }
+    live_bytes_ += data->size;
+    data->fd = next_fd_++;
+    data->ion_handle = data->fd;
+    return 0;
+  }
+
+  int FreeBuffer(void *, unsigned int size, unsigned int, int, int) override {
+    std::lock_guard<std::mutex> lock(lock_);
+    live_bytes_ -= size;
+    return 0;
+  }
+
+  int MapBuffer(void **, unsigned int, unsigned int, int) override { return 0; }
+  int CleanBuffer(void *, unsigned int, unsigned int, int, int, int) override { return 0; }
+  int ImportBuffer(int) override { return 0; }
+
+  uint64_t live_bytes() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return live_bytes_;
+  }
+
+  uint32_t allocs() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return allocs_;
+  }
+
+ private:
+  std::mutex lock_;
+  uint64_t capacity_;
+  uint64_t live_bytes_ = 0;
+  uint32_t allocs_ = 0;
+  int next_fd_ = 100;
+};
+
+AllocData GetAllocData(unsigned int size = kSize) {
+  AllocData data;
+  data.heap_name = "qcom,system";
+  data.size = size;
+  data.align = 4096;
+  return data;
+}
+
+BufferPoolConfig GetConfig(uint64_t max_bytes = 16 * kSize) {
+  BufferPoolConfig config;
+  config.max_bytes = max_bytes;
+  config.usage_mask = kPooledUsage;
+  config.pool_metadata = true;
+  return config;
+}
+
+BufferPoolStats GetStats(BufferPool *pool) {
+  BufferPoolStats stats;
+  pool->GetStats(&stats);
+  return stats;
+}
+
+// Polls the pool until done holds or a second has passed.
+bool WaitFor(BufferPool *pool, std::function<bool(const BufferPoolStats &)> done) {
+  for (int i = 0; i < 1000; i++) {
+    if (done(GetStats(pool))) {
+      return true;
+    }
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  return false;
+}
+
+// Requests a size class often enough to make it hot, and waits for its refill.
+void Warm(BufferPool *pool, unsigned int size, uint32_t buffers) {
+  for (int i = 0; i < 2; i++) {
+    AllocData data = GetAllocData(size);
+    ASSERT_FALSE(pool->Acquire(&data, kPooledUsage, false));
+  }
+  ASSERT_TRUE(WaitFor(pool, [buffers](auto &stats) { return stats.buffers_held == buffers; }));
+}
+
+}  // namespace
+
+TEST(BufferPool, HitAfterRefill) {
+  FakeHeap heap;
+  {
+    BufferPool pool(&heap);
+    pool.Configure(GetConfig());
+    Warm(&pool, kSize, 2);
+
+    AllocData data = GetAllocData();
+    ASSERT_TRUE(pool.Acquire(&data, kPooledUsage, false));
+    EXPECT_GE(data.fd, 100);
+    BufferPoolStats stats = GetStats(&pool);
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+
+    // Another size is a class of its own.
+    AllocData other = GetAllocData(2 * kSize);
+    EXPECT_FALSE(pool.Acquire(&other, kPooledUsage, false));
+    EXPECT_EQ(3u, GetStats(&pool).misses);
+
+    // The buffer handed out is the caller's, the pool frees what it still holds.
+    heap.FreeBuffer(nullptr, data.size, 0, data.fd, data.ion_handle);
+  }
+  EXPECT_EQ(0u, heap.live_bytes());
+}
+
+TEST(BufferPool, Eligibility) {
+  FakeHeap heap;
+  BufferPool pool(&heap);
+  AllocData data = GetAllocData();
+  // Not configured.
+  EXPECT_FALSE(pool.Acquire(&data, kPooledUsage, false));
+  EXPECT_EQ(0u, GetStats(&pool).misses);
+
+  pool.Configure(GetConfig());
+  EXPECT_FALSE(pool.Acquire(&data, kOtherUsage, false));
+  EXPECT_EQ(0u, GetStats(&pool).misses);
+
+  // Zero usage is only pooled for metadata buffers.
+  EXPECT_FALSE(pool.Acquire(&data, 0, false));
+  EXPECT_EQ(0u, GetStats(&pool).misses);
+  EXPECT_FALSE(pool.Acquire(&data, 0, true));
+  EXPECT_EQ(1u, GetStats(&pool).misses);
+
+  BufferPoolConfig config = GetConfig();
+  config.pool_metadata = false;
+  pool.Configure(config);
+  EXPECT_FALSE(pool.Acquire(&data, 0, true));
+  EXPECT_EQ(1u, GetStats(&pool).misses);
+
+  AllocData secure = GetAllocData();
+  secure.alloc_type = private_handle_t::PRIV_FLAGS_SECURE_BUFFER;
+  EXPECT_FALSE(pool.Acquire(&secure, kPooledUsage, false));
+  AllocData shared = GetAllocData();
+  shared.vm_names.push_back("qcom,cp_pixel");
+  EXPECT_FALSE(pool.Acquire(&shared, kPooledUsage, false));
+  EXPECT_FALSE(pool.Acquire(&data, kPooledUsage | GRALLOC_USAGE_PROTECTED, false));
+  EXPECT_EQ(1u, GetStats(&pool).misses);
+}
+
+TEST(BufferPool, MemoryCap) {
+  FakeHeap heap;
+  BufferPool pool(&heap);
+  BufferPoolConfig config = GetConfig(3 * kSize);
+  config.buffers_per_class = 8;
+  pool.Configure(config);
+  Warm(&pool, kSize, 3);
+
+  // The refill stopped at the cap rather than at the class size.
+  std::this_thread::sleep_for(milliseconds(20));
+  BufferPoolStats stats = GetStats(&pool);
+  EXPECT_EQ(3u, stats.buffers_held);
+  EXPECT_EQ(3u * kSize, stats.bytes_held);
+  EXPECT_EQ(3u * kSize, heap.live_bytes());
+
+  // Lowering the cap trims right away.
+  pool.Configure(GetConfig(kSize));
+  EXPECT_EQ(kSize, GetStats(&pool).bytes_held);
+  EXPECT_EQ(kSize, heap.live_bytes());
+}
+
+TEST(BufferPool, Trim) {
+  FakeHeap heap;
+  BufferPool pool(&heap);
+  pool.Configure(GetConfig());
+  Warm(&pool, kSize, 2);
+
+  EXPECT_EQ(kSize, pool.Trim(kSize));
+  EXPECT_EQ(0u, pool.Trim(kSize));
+  EXPECT_EQ(kSize, pool.Trim(0));
+  BufferPoolStats stats = GetStats(&pool);
+  EXPECT_EQ(0u, stats.buffers_held);
+  EXPECT_EQ(2u * kSize, stats.trimmed_bytes);
+  EXPECT_EQ(0u, heap.live_bytes());
+}
+
+// Buffers of a class no longer requested are released after max_age.
+TEST(BufferPool, AgeTrim) {
+  FakeHeap heap;
+  BufferPool pool(&heap);
+  BufferPoolConfig config = GetConfig();
+  config.max_age = milliseconds(50);
+  pool.Configure(config);
+  Warm(&pool, kSize, 2);
+
+  EXPECT_TRUE(WaitFor(&pool, [](auto &stats) { return stats.buffers_held == 0; }));
+  EXPECT_EQ(2u * kSize, GetStats(&pool).trimmed_bytes);
+  EXPECT_EQ(0u, heap.live_bytes());
+}
+
+// A heap allocation failing for want of memory gets back what the pool holds.
+TEST(BufferPool, TrimOnAllocationFailure) {
+  FakeHeap heap(3 * kSize);
+  BufferPool pool(&heap);
+  pool.Configure(GetConfig());
+  Warm(&pool, kSize, 2);
+
+  AllocData data = GetAllocData(2 * kSize);
+  uint32_t allocs = heap.allocs();
+  EXPECT_EQ(0, pool.Allocate(&data, kOtherUsage, false));
+  EXPECT_EQ(allocs + 2, heap.allocs());
+  EXPECT_EQ(0u, GetStats(&pool).buffers_held);
+  EXPECT_EQ(2u * kSize, heap.live_bytes());
+
+  // With nothing left to trim, the failure is returned without a retry.
+  AllocData more = GetAllocData(2 * kSize);
+  allocs = heap.allocs();
+  EXPECT_EQ(-ENOMEM, pool.Allocate(&more, kOtherUsage, false));
+  EXPECT_EQ(allocs + 1, heap.allocs());
+  heap.FreeBuffer(nullptr, data.size, 0, data.fd, data.ion_handle);
+}
+
+TEST(BufferPool, AllocateTakesPooledBuffer) {
+  FakeHeap heap;
+  BufferPool pool(&heap);
+  pool.Configure(GetConfig());
+  Warm(&pool, kSize, 2);
+
+  AllocData data = GetAllocData();
+  EXPECT_EQ(0, pool.Allocate(&data, kPooledUsage, false));
+  EXPECT_EQ(1u, GetStats(&pool).hits);
+  EXPECT_EQ(2u, GetStats(&pool).misses);
+  heap.FreeBuffer(nullptr, data.size, 0, data.fd, data.ion_handle);
+}
+
+}  // namespace gralloc
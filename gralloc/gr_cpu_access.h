@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GR_CPU_ACCESS_H__
+#define __GR_CPU_ACCESS_H__
+
+#include <algorithm>
+
+#include "gr_alloc_interface.h"
+
+namespace gralloc {
+
+// Cache operations of one CPU access, to be issued in order.
+struct CacheOps {
+  int ops[2] = {};
+  unsigned int count = 0;
+
+  void Add(int op) { ops[count++] = op; }
+};
+
+// CPU access to a buffer in this process, deciding the cache maintenance of its locks, unlocks,
+// flushes and rereads. Not thread safe, callers serialize the accesses of a buffer.
+// - A device may write the buffer while a lock is held elsewhere in the process, every lock
+//   invalidates. CPU writes not cleaned yet are cleaned first, the invalidate would drop them.
+// - Unlock does not tell which lock it ends. A write lock is taken to last as long as there are
+//   as many locks held, and CPU writes are cleaned on every unlock until then, which includes
+//   the unlock that ends the write.
+// - Only the last unlock of a buffer the CPU did not write hands it back with READ_DONE.
+class CpuAccess {
+ public:
+  // The operations to issue before the lock, which is recorded with Lock once they succeeded.
+  CacheOps GetLockOps() const {
+    CacheOps cache_ops;
+    if (dirty_) {
+      cache_ops.Add(CACHE_CLEAN);
+    }
+    cache_ops.Add(CACHE_INVALIDATE);
+    return cache_ops;
+  }
+
+  void Lock(bool write) {
+    locks_++;
+    write_locks_ += write ? 1 : 0;
+    // Pending writes were cleaned by the lock operations.
+    dirty_ = (write_locks_ != 0);
+  }
+
+  CacheOps Unlock() {
+    CacheOps cache_ops;
+    locks_ -= (locks_ != 0) ? 1 : 0;
+    write_locks_ = std::min(write_locks_, locks_);
+    if (dirty_) {
+      cache_ops.Add(CACHE_CLEAN);
+      dirty_ = (write_locks_ != 0);
+    } else if (!locks_) {
+      cache_ops.Add(CACHE_READ_DONE);
+    }
+    return cache_ops;
+  }
+
+  CacheOps Flush() {
+    CacheOps cache_ops;
+    if (dirty_) {
+      cache_ops.Add(CACHE_CLEAN);
+      dirty_ = (write_locks_ != 0);
+    }
+    return cache_ops;
+  }
+
+  CacheOps Reread() {
+    CacheOps cache_ops = GetLockOps();
+    dirty_ = (write_locks_ != 0);
+    return cache_ops;
+  }
+
+  bool IsDirty() const { return dirty_; }
+
+ private:
+  unsigned int locks_ = 0;
+  unsigned int write_locks_ = 0;
+  bool dirty_ = false;  // Written by the CPU since the last clean.
+};
+
+}  // namespace gralloc
+
+#endif  // __GR_CPU_ACCESS_H__
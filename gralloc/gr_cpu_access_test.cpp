@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "gr_cpu_access.h"
+
+namespace gralloc {
+
+namespace {
+
+// Stands in for the allocator, with the buffer as one cache line over its memory. The cache
+// operations do what the dma-buf sync does on a non-coherent CPU: a start of CPU access and an end
+// of a read only access invalidate, dropping what was not cleaned, an end of a read write access
+// cleans.
+class FakeAllocator {
+ public:
+  int CleanBuffer(void *base, unsigned int size, unsigned int offset, int handle, int op, int fd) {
+    switch (op) {
+      case CACHE_CLEAN:
+        if (line_ == kDirty) {
+          memory_ = cache_;
+          line_ = kClean;
+        }
+        break;
+      case CACHE_INVALIDATE:
+      case CACHE_READ_DONE:
+        line_ = kInvalid;
+        break;
+      default:
+        return -EINVAL;
+    }
+    ops_.push_back(op);
+    return 0;
+  }
+
+  void CpuWrite(int value) {
+    cache_ = value;
+    line_ = kDirty;
+  }
+
+  int CpuRead() {
+    if (line_ == kInvalid) {
+      cache_ = memory_;
+      line_ = kClean;
+    }
+    return cache_;
+  }
+
+  void DeviceWrite(int value) { memory_ = value; }
+  int DeviceRead() { return memory_; }
+
+  std::vector<int> TakeOps() {
+    std::vector<int> ops;
+    ops.swap(ops_);
+    return ops;
+  }
+
+ private:
+  enum LineState { kInvalid, kClean, kDirty };
+
+  int memory_ = 0;
+  int cache_ = 0;
+  LineState line_ = kInvalid;
+  std::vector<int> ops_;
+};
+
+// Does what BufferManager does for a cached buffer.
+class CpuAccessTest : public ::testing::Test {
+ protected:
+  void Lock(bool write) {
+    Issue(access_.GetLockOps());
+    access_.Lock(write);
+  }
+  void Unlock() { Issue(access_.Unlock()); }
+  void Flush() { Issue(access_.Flush()); }
+  void Reread() { Issue(access_.Reread()); }
+
+  void Issue(const CacheOps &cache_ops) {
+    for (unsigned int i = 0; i < cache_ops.count; i++) {
+      ASSERT_EQ(0, allocator_.CleanBuffer(nullptr, 0, 0, -1, cache_ops.ops[i], -1));
+    }
+  }
+
+  CpuAccess access_;
+  FakeAllocator allocator_;
+};
+
+}  // namespace
+
+TEST_F(CpuAccessTest, SingleLock) {
+  Lock(false);
+  Unlock();
+  EXPECT_EQ(std::vector<int>({CACHE_INVALIDATE, CACHE_READ_DONE}), allocator_.TakeOps());
+
+  Lock(true);
+  allocator_.CpuWrite(1);
+  Unlock();
+  EXPECT_EQ(std::vector<int>({CACHE_INVALIDATE, CACHE_CLEAN}), allocator_.TakeOps());
+  EXPECT_EQ(1, allocator_.DeviceRead());
+}
+
+// The unlock that ends a write cleans it even though another lock is held, whichever lock it ends.
+TEST_F(CpuAccessTest, WriteUnderNestedLockReachesDevice) {
+  Lock(false);
+  Lock(true);
+  allocator_.CpuWrite(1);
+  Unlock();
+  EXPECT_EQ(1, allocator_.DeviceRead());
+
+  Lock(true);
+  Lock(false);
+  allocator_.CpuWrite(2);
+  Unlock();
+  EXPECT_EQ(2, allocator_.DeviceRead());
+  Unlock();
+  Unlock();
+}
+
+TEST_F(CpuAccessTest, NestedLockSeesDeviceWrite) {
+  Lock(false);
+  EXPECT_EQ(0, allocator_.CpuRead());
+  allocator_.DeviceWrite(1);
+  Lock(false);
+  EXPECT_EQ(1, allocator_.CpuRead());
+  Unlock();
+  Unlock();
+}
+
+// A lock or reread while a write is pending does not drop it.
+TEST_F(CpuAccessTest, InvalidateKeepsPendingWrites) {
+  Lock(true);
+  allocator_.CpuWrite(1);
+  Lock(false);
+  EXPECT_EQ(1, allocator_.CpuRead());
+  allocator_.CpuWrite(2);
+  Reread();
+  EXPECT_EQ(2, allocator_.CpuRead());
+  EXPECT_EQ(2, allocator_.DeviceRead());
+  Unlock();
+  Unlock();
+}
+
+TEST_F(CpuAccessTest, SkipsRedundantOperations) {
+  Lock(false);
+  Lock(false);
+  allocator_.TakeOps();
+  Flush();
+  Unlock();
+  EXPECT_TRUE(allocator_.TakeOps().empty());
+  Unlock();
+  EXPECT_EQ(std::vector<int>({CACHE_READ_DONE}), allocator_.TakeOps());
+
+  Lock(true);
+  allocator_.CpuWrite(1);
+  Flush();
+  EXPECT_EQ(1, allocator_.DeviceRead());
+  Unlock();
+  allocator_.TakeOps();
+  Flush();
+  EXPECT_TRUE(allocator_.TakeOps().empty());
+}
+
+// Random nesting of locks from several clients of the process, with device writes in between:
+// the CPU reads what was last written by anyone, and the device does once the buffer is unlocked.
+TEST_F(CpuAccessTest, RandomNesting) {
+  std::mt19937 random(7);
+  int value = 0;
+  int written = 0;
+  std::vector<bool> locks;
+  for (int step = 0; step < 100000; step++) {
+    switch (random() % 6) {
+      case 0:
+      case 1: {
+        bool write = random() % 2;
+        Lock(write);
+        locks.push_back(write);
+        ASSERT_EQ(written, allocator_.CpuRead()) << "step " << step;
+        break;
+      }
+      case 2:
+        if (!locks.empty()) {
+          locks.erase(locks.begin() + random() % locks.size());
+          Unlock();
+        }
+        break;
+      case 3:
+        for (size_t i = 0; i < locks.size(); i++) {
+          if (locks[i]) {
+            written = ++value;
+            allocator_.CpuWrite(written);
+            break;
+          }
+        }
+        break;
+      case 4:
+        if (locks.empty()) {
+          ASSERT_EQ(written, allocator_.DeviceRead()) << "step " << step;
+          written = ++value;
+          allocator_.DeviceWrite(written);
+        }
+        break;
+      default:
+        if (!locks.empty()) {
+          Reread();
+          ASSERT_EQ(written, allocator_.CpuRead()) << "step " << step;
+        }
+        break;
+    }
+  }
+}
+
+}  // namespace gralloc
@@ -97,13 +97,10 @@
 
 namespace gralloc {
 
-DmaLegacyManager *DmaLegacyManager::dma_legacy_manager_ = NULL;
-
 DmaLegacyManager *DmaLegacyManager::GetInstance() {
-  if (!dma_legacy_manager_) {
-    dma_legacy_manager_ = new DmaLegacyManager();
-  }
-  return dma_legacy_manager_;
+  // Allocations of a batch run concurrently and may be the first use.
+  static DmaLegacyManager *instance = new DmaLegacyManager();
+  return instance;
 }
 
 void DmaLegacyManager::Deinit() {
@@ -125,17 +122,18 @@ int DmaLegacyManager::AllocBuffer(AllocData *data) {
     tag_name = "libdmalegacy alloc size: " + std::to_string(data->size);
   }
 
+  // AllocBuffer can be called concurrently from the buffer pool, do not go through members.
   ATRACE_BEGIN("GrallocAllocation");
-  dma_legacy_dev_fd_ = buffer_allocator_.Alloc(data->heap_name, data->size, flags, data->align);
+  int fd = buffer_allocator_.Alloc(data->heap_name, data->size, flags, data->align);
   ATRACE_END();
-  if (dma_legacy_dev_fd_ < 0) {
+  if (fd < 0) {
     ALOGE("libdmalegacy alloc failed ion_fd %d size %d align %d heap_name %s flags %x",
-          dma_legacy_dev_fd_, data->size, data->align, data->heap_name.c_str(), flags);
-    return dma_legacy_dev_fd_;
+          fd, data->size, data->align, data->heap_name.c_str(), flags);
+    return fd;
   }
 
-  data->fd = dma_legacy_dev_fd_;
-  data->ion_handle = dma_legacy_dev_fd_;
+  data->fd = fd;
+  data->ion_handle = fd;
   ALOGD_IF(DEBUG, "libdmalegacy: Allocated buffer size:%u fd:%d", data->size, data->fd);
 
   return 0;
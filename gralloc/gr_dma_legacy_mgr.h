@@ -64,7 +64,6 @@ class DmaLegacyManager : public AllocInterface {
 
   int dma_legacy_dev_fd_ = FD_INIT;
   BufferAllocator buffer_allocator_;
-  static DmaLegacyManager *dma_legacy_manager_;
 };
 
 }  // namespace gralloc
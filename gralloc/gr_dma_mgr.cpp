@@ -55,13 +55,10 @@
 
 namespace gralloc {
 
-DmaManager *DmaManager::dma_manager_ = NULL;
-
 DmaManager *DmaManager::GetInstance() {
-  if (!dma_manager_) {
-    dma_manager_ = new DmaManager();
-  }
-  return dma_manager_;
+  // Allocations of a batch run concurrently and may be the first use.
+  static DmaManager *instance = new DmaManager();
+  return instance;
 }
 
 void DmaManager::Deinit() {
@@ -81,17 +78,18 @@ int DmaManager::AllocBuffer(AllocData *data) {
     tag_name = "libdma alloc size: " + std::to_string(data->size);
   }
 
+  // AllocBuffer can be called concurrently from the buffer pool, do not go through members.
   ATRACE_BEGIN("GrallocAllocation");
-  dma_dev_fd_ = buffer_allocator_.Alloc(data->heap_name, data->size, flags, data->align);
+  int fd = buffer_allocator_.Alloc(data->heap_name, data->size, flags, data->align);
   ATRACE_END();
-  if (dma_dev_fd_ < 0) {
-    ALOGE("libdma alloc failed ion_fd %d size %d align %d heap_name %s flags %x", dma_dev_fd_,
+  if (fd < 0) {
+    ALOGE("libdma alloc failed ion_fd %d size %d align %d heap_name %s flags %x", fd,
           data->size, data->align, data->heap_name.c_str(), flags);
-    return dma_dev_fd_;
+    return fd;
   }
 
-  data->fd = dma_dev_fd_;
-  data->ion_handle = dma_dev_fd_;
+  data->fd = fd;
+  data->ion_handle = fd;
   ALOGD_IF(DEBUG, "libdma: Allocated buffer size:%u fd:%d", data->size, data->fd);
 
   return 0;
@@ -64,7 +64,6 @@ class DmaManager : public AllocInterface {
 
   int dma_dev_fd_ = FD_INIT;
   BufferAllocator buffer_allocator_;
-  static DmaManager *dma_manager_;
 };
 
 }  // namespace gralloc
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GR_LAYOUT_CACHE_H__
+#define __GR_LAYOUT_CACHE_H__
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace gralloc {
+
+struct LayoutCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+};
+
+// Bounded, 4-way set associative cache of buffer layout computations.
+// Each slot is guarded by a sequence counter: readers never block and simply retry (or report a
+// miss) when they race with a writer. Writers are serialized on a mutex. A full set replaces
+// its entries round robin, which bounds the memory footprint to kSlots entries.
+// Key and Value must be trivially copyable; keys are compared bytewise, so callers must
+// zero-initialize them to avoid comparing padding.
+template <typename Key, typename Value, size_t kSlots>
+class LayoutCache {
+  static_assert(std::is_trivially_copyable<Key>::value, "Key must be trivially copyable");
+  static_assert(std::is_trivially_copyable<Value>::value, "Value must be trivially copyable");
+  static_assert(kSlots && !(kSlots & (kSlots - 1)), "kSlots must be a power of two");
+  static_assert(kSlots >= 4, "kSlots must hold at least one set");
+
+ public:
+  bool Find(const Key &key, Value *value) {
+    const Slot *set = &slots_[SetIndex(key)];
+    for (size_t way = 0; way < kWays; way++) {
+      if (Read(set[way], key, value)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  void Insert(const Key &key, const Value &value) {
+    std::lock_guard<std::mutex> lock(write_lock_);
+    size_t set_index = SetIndex(key);
+    Slot *set = &slots_[set_index];
+    Slot *slot = nullptr;
+    for (size_t way = 0; way < kWays && !slot; way++) {
+      if (set[way].valid && !std::memcmp(&set[way].key, &key, sizeof(Key))) {
+        slot = &set[way];
+      }
+    }
+    for (size_t way = 0; way < kWays && !slot; way++) {
+      if (!set[way].valid) {
+        slot = &set[way];
+      }
+    }
+    if (!slot) {
+      // Round robin replacement within the set.
+      slot = &set[victim_[set_index / kWays]++ % kWays];
+      evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    BeginWrite(slot);
+    std::memcpy(&slot->key, &key, sizeof(Key));
+    std::memcpy(&slot->value, &value, sizeof(Value));
+    slot->valid = true;
+    EndWrite(slot);
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(write_lock_);
+    for (auto &slot : slots_) {
+      BeginWrite(&slot);
+      slot.valid = false;
+      EndWrite(&slot);
+    }
+  }
+
+  void GetStats(LayoutCacheStats *stats) const {
+    stats->hits += hits_.load(std::memory_order_relaxed);
+    stats->misses += misses_.load(std::memory_order_relaxed);
+    stats->evictions += evictions_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr int kMaxReadRetries = 4;
+  static constexpr size_t kWays = 4;
+
+  struct Slot {
+    std::atomic<uint32_t> sequence{0};
+    bool valid = false;
+    Key key = {};
+    Value value = {};
+  };
+
+  // Returns the first slot of the set the key maps to.
+  static size_t SetIndex(const Key &key) {
+    // FNV-1a over the key bytes.
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&key);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(Key); i++) {
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    // FNV-1a mixes poorly into the low bits, finalize before masking.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (static_cast<size_t>(hash) & (kSlots / kWays - 1)) * kWays;
+  }
+
+  static bool Read(const Slot &slot, const Key &key, Value *value) {
+    for (int retry = 0; retry < kMaxReadRetries; retry++) {
+      uint32_t begin = slot.sequence.load(std::memory_order_acquire);
+      if (begin & 1) {
+        continue;  // Writer in progress.
+      }
+      bool valid = slot.valid;
+      Key slot_key;
+      Value slot_value;
+      std::memcpy(&slot_key, &slot.key, sizeof(Key));
+      std::memcpy(&slot_value, &slot.value, sizeof(Value));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != begin) {
+        continue;
+      }
+      if (!valid || std::memcmp(&slot_key, &key, sizeof(Key))) {
+        return false;
+      }
+      *value = slot_value;
+      return true;
+    }
+    return false;
+  }
+
+  static void BeginWrite(Slot *slot) {
+    slot->sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  static void EndWrite(Slot *slot) { slot->sequence.fetch_add(1, std::memory_order_release); }
+
+  Slot slots_[kSlots];
+  uint8_t victim_[kSlots / kWays] = {};
+  std::mutex write_lock_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+};
+
+}  // namespace gralloc
+
+#endif  // __GR_LAYOUT_CACHE_H__
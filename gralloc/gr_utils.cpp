@@ -84,6 +84,85 @@ static inline unsigned int MMM_COLOR_FMT_RGB_STRIDE_IN_PIXELS(unsigned int color
 }
 #endif
 
+// Layout computations only depend on the buffer parameters and on properties that are fixed
+// once the allocator/mapper is up, so results are memoized. Keys are zero-initialized before
+// being filled, as LayoutCache compares them bytewise.
+struct BufferInfoKey {
+  int32_t width;
+  int32_t height;
+  int32_t format;
+  int32_t layer_count;
+  uint64_t usage;
+};
+
+struct PlaneInfoKey {
+  BufferInfoKey info;
+  int32_t format;
+  int32_t width;
+  int32_t height;
+  int32_t flags;
+};
+
+struct AlignedDimensions {
+  unsigned int alignedw;
+  unsigned int alignedh;
+};
+
+struct SizeAndDimensions {
+  unsigned int size;
+  unsigned int alignedw;
+  unsigned int alignedh;
+  GraphicsMetadata graphics_metadata;
+};
+
+struct PlaneInfo {
+  int plane_count;
+  PlaneLayoutInfo plane_info[8];
+};
+
+static LayoutCache<BufferInfoKey, AlignedDimensions, 64> aligned_dims_cache_;
+static LayoutCache<BufferInfoKey, SizeAndDimensions, 64> size_cache_;
+static LayoutCache<PlaneInfoKey, PlaneInfo, 64> plane_info_cache_;
+static std::atomic<bool> layout_cache_enabled_{true};
+
+static BufferInfoKey GetBufferInfoKey(const BufferInfo &info) {
+  BufferInfoKey key;
+  memset(&key, 0, sizeof(key));
+  key.width = info.width;
+  key.height = info.height;
+  key.format = info.format;
+  key.layer_count = info.layer_count;
+  key.usage = info.usage;
+  return key;
+}
+
+void SetLayoutCacheEnabled(bool enable) {
+  layout_cache_enabled_.store(enable, std::memory_order_relaxed);
+  InvalidateLayoutCache();
+}
+
+void InvalidateLayoutCache() {
+  aligned_dims_cache_.Clear();
+  size_cache_.Clear();
+  plane_info_cache_.Clear();
+}
+
+void GetLayoutCacheStats(LayoutCacheStats *stats) {
+  *stats = {};
+  aligned_dims_cache_.GetStats(stats);
+  size_cache_.GetStats(stats);
+  plane_info_cache_.GetStats(stats);
+}
+
+static int ComputeAlignedWidthAndHeight(const BufferInfo &info, unsigned int *alignedw,
+                                        unsigned int *alignedh);
+static int ComputeBufferSizeAndDimensions(const BufferInfo &info, unsigned int *size,
+                                          unsigned int *alignedw, unsigned int *alignedh,
+                                          GraphicsMetadata *graphics_metadata);
+static int ComputeYUVPlaneInfo(const BufferInfo &info, int32_t format, int32_t width,
+                               int32_t height, int32_t flags, int *plane_count,
+                               PlaneLayoutInfo *plane_info);
+
 bool IsYuvFormat(int format) {
   switch (format) {
     case HAL_PIXEL_FORMAT_YCbCr_420_SP:
@@ -560,6 +639,34 @@ int GetBufferSizeAndDimensions(const BufferInfo &info, unsigned int *size, unsig
 
 int GetBufferSizeAndDimensions(const BufferInfo &info, unsigned int *size, unsigned int *alignedw,
                                unsigned int *alignedh, GraphicsMetadata *graphics_metadata) {
+  if (!layout_cache_enabled_.load(std::memory_order_relaxed)) {
+    return ComputeBufferSizeAndDimensions(info, size, alignedw, alignedh, graphics_metadata);
+  }
+
+  BufferInfoKey key = GetBufferInfoKey(info);
+  SizeAndDimensions entry;
+  if (size_cache_.Find(key, &entry)) {
+    *size = entry.size;
+    *alignedw = entry.alignedw;
+    *alignedh = entry.alignedh;
+    *graphics_metadata = entry.graphics_metadata;
+    return 0;
+  }
+
+  int err = ComputeBufferSizeAndDimensions(info, size, alignedw, alignedh, graphics_metadata);
+  if (!err) {
+    entry.size = *size;
+    entry.alignedw = *alignedw;
+    entry.alignedh = *alignedh;
+    entry.graphics_metadata = *graphics_metadata;
+    size_cache_.Insert(key, entry);
+  }
+  return err;
+}
+
+static int ComputeBufferSizeAndDimensions(const BufferInfo &info, unsigned int *size,
+                                          unsigned int *alignedw, unsigned int *alignedh,
+                                          GraphicsMetadata *graphics_metadata) {
   int buffer_type = GetBufferType(info.format);
   if (CanUseAdrenoForSize(buffer_type, info.usage)) {
     return GetGpuResourceSizeAndDimensions(info, size, alignedw, alignedh, graphics_metadata);
@@ -1207,6 +1314,29 @@ void GetColorSpaceFromMetadata(private_handle_t *hnd, int *color_space) {
 
 int GetAlignedWidthAndHeight(const BufferInfo &info, unsigned int *alignedw,
                               unsigned int *alignedh) {
+  if (!layout_cache_enabled_.load(std::memory_order_relaxed)) {
+    return ComputeAlignedWidthAndHeight(info, alignedw, alignedh);
+  }
+
+  BufferInfoKey key = GetBufferInfoKey(info);
+  AlignedDimensions entry;
+  if (aligned_dims_cache_.Find(key, &entry)) {
+    *alignedw = entry.alignedw;
+    *alignedh = entry.alignedh;
+    return 0;
+  }
+
+  int err = ComputeAlignedWidthAndHeight(info, alignedw, alignedh);
+  if (!err) {
+    entry.alignedw = *alignedw;
+    entry.alignedh = *alignedh;
+    aligned_dims_cache_.Insert(key, entry);
+  }
+  return err;
+}
+
+static int ComputeAlignedWidthAndHeight(const BufferInfo &info, unsigned int *alignedw,
+                                        unsigned int *alignedh) {
   int width = info.width;
   int height = info.height;
   int format = info.format;
@@ -1711,6 +1841,37 @@ int GetBufferType(int inputFormat) {
 // Here width and height are aligned width and aligned height.
 int GetYUVPlaneInfo(const BufferInfo &info, int32_t format, int32_t width, int32_t height,
                     int32_t flags, int *plane_count, PlaneLayoutInfo *plane_info) {
+  if (!layout_cache_enabled_.load(std::memory_order_relaxed)) {
+    return ComputeYUVPlaneInfo(info, format, width, height, flags, plane_count, plane_info);
+  }
+
+  PlaneInfoKey key;
+  memset(&key, 0, sizeof(key));
+  key.info = GetBufferInfoKey(info);
+  key.format = format;
+  key.width = width;
+  key.height = height;
+  key.flags = flags;
+
+  PlaneInfo entry;
+  if (plane_info_cache_.Find(key, &entry)) {
+    *plane_count = entry.plane_count;
+    std::copy(entry.plane_info, entry.plane_info + entry.plane_count, plane_info);
+    return 0;
+  }
+
+  int err = ComputeYUVPlaneInfo(info, format, width, height, flags, plane_count, plane_info);
+  if (!err && *plane_count > 0 && *plane_count <= 8) {
+    entry.plane_count = *plane_count;
+    std::copy(plane_info, plane_info + *plane_count, entry.plane_info);
+    plane_info_cache_.Insert(key, entry);
+  }
+  return err;
+}
+
+static int ComputeYUVPlaneInfo(const BufferInfo &info, int32_t format, int32_t width,
+                               int32_t height, int32_t flags, int *plane_count,
+                               PlaneLayoutInfo *plane_info) {
   int err = 0;
   unsigned int y_stride, c_stride, y_height, c_height, y_size, c_size, mmm_color_format;
   uint64_t yOffset, cOffset, crOffset, cbOffset;
@@ -2209,18 +2370,14 @@ void GetDRMFormat(uint32_t format, uint32_t flags, uint32_t *drm_format,
 }
 
 bool CanAllocateZSLForSecureCamera() {
-  static bool inited = false;
-  static bool can_allocate = true;
-  if (inited) {
-    return can_allocate;
-  }
-  char property[PROPERTY_VALUE_MAX];
-  property_get("vendor.gralloc.secure_preview_buffer_format", property, "0");
-  if (!(strncmp(property, "420_sp", PROPERTY_VALUE_MAX))) {
-    can_allocate = false;
-  }
-  inited = true;
-  ALOGI("CanAllocateZSLForSecureCamera: %d", can_allocate);
+  // Layouts are computed concurrently, the property is read once on first use.
+  static const bool can_allocate = [] {
+    char property[PROPERTY_VALUE_MAX];
+    property_get("vendor.gralloc.secure_preview_buffer_format", property, "0");
+    bool allowed = strncmp(property, "420_sp", PROPERTY_VALUE_MAX) != 0;
+    ALOGI("CanAllocateZSLForSecureCamera: %d", allowed);
+    return allowed;
+  }();
 
   return can_allocate;
 }
@@ -72,6 +72,7 @@
 #include <vector>
 
 #include "QtiGrallocPriv.h"
+#include "gr_layout_cache.h"
 #include "gralloc_priv.h"
 #include "qdMetaData.h"
 
@@ -110,6 +111,9 @@ struct GrallocProperties {
   bool use_system_heap_for_sensors = true;
   bool ubwc_disable = false;
   bool ahardware_buffer_disable = false;
+  bool layout_cache_disable = false;
+  uint64_t buffer_pool_size = 0;
+  uint64_t buffer_pool_usage = 0;
 };
 
 template <class Type1, class Type2>
@@ -284,6 +288,9 @@ Error ColorMetadataToDataspace(ColorMetaData color_metadata,
                                aidl::android::hardware::graphics::common::Dataspace *dataspace);
 Error GetPlaneLayout(private_handle_t *handle,
                      std::vector<aidl::android::hardware::graphics::common::PlaneLayout> *out);
+void SetLayoutCacheEnabled(bool enable);
+void InvalidateLayoutCache();
+void GetLayoutCacheStats(LayoutCacheStats *stats);
 }  // namespace gralloc
 
 #endif  // __GR_UTILS_H__
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "gr_utils.h"
+
+namespace gralloc {
+
+static const int kFormats[] = {
+  HAL_PIXEL_FORMAT_RGBA_8888,
+  HAL_PIXEL_FORMAT_RGBX_8888,
+  HAL_PIXEL_FORMAT_BGRA_8888,
+  HAL_PIXEL_FORMAT_RGB_888,
+  HAL_PIXEL_FORMAT_RGB_565,
+  HAL_PIXEL_FORMAT_RGBA_1010102,
+  HAL_PIXEL_FORMAT_RGBA_FP16,
+  HAL_PIXEL_FORMAT_R_8,
+  HAL_PIXEL_FORMAT_RG_88,
+  HAL_PIXEL_FORMAT_BLOB,
+  HAL_PIXEL_FORMAT_RAW16,
+  HAL_PIXEL_FORMAT_RAW10,
+  HAL_PIXEL_FORMAT_RAW_OPAQUE,
+  HAL_PIXEL_FORMAT_Y8,
+  HAL_PIXEL_FORMAT_Y16,
+  HAL_PIXEL_FORMAT_YV12,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP,
+  HAL_PIXEL_FORMAT_YCrCb_420_SP,
+  HAL_PIXEL_FORMAT_YCbCr_420_888,
+  HAL_PIXEL_FORMAT_YCbCr_422_SP,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS,
+  HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS_UBWC,
+  HAL_PIXEL_FORMAT_YCbCr_420_TP10_UBWC,
+  HAL_PIXEL_FORMAT_YCbCr_420_P010,
+  HAL_PIXEL_FORMAT_YCbCr_420_P010_UBWC,
+  HAL_PIXEL_FORMAT_YCbCr_420_P010_VENUS,
+  HAL_PIXEL_FORMAT_NV12_ENCODEABLE,
+  HAL_PIXEL_FORMAT_NV21_ZSL,
+  HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+};
+
+static const uint64_t kUsages[] = {
+  0,
+  BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN,
+  static_cast<uint64_t>(BufferUsage::GPU_TEXTURE),
+  BufferUsage::GPU_TEXTURE | BufferUsage::GPU_RENDER_TARGET,
+  BufferUsage::COMPOSER_OVERLAY | BufferUsage::GPU_TEXTURE,
+  static_cast<uint64_t>(BufferUsage::VIDEO_ENCODER),
+  BufferUsage::VIDEO_DECODER | GRALLOC_USAGE_PRIVATE_ALLOC_UBWC,
+  BufferUsage::CAMERA_OUTPUT | BufferUsage::CAMERA_INPUT,
+  GRALLOC_USAGE_PRIVATE_ALLOC_UBWC | BufferUsage::GPU_TEXTURE,
+  GRALLOC_USAGE_PRIVATE_10BIT | GRALLOC_USAGE_PRIVATE_ALLOC_UBWC,
+  GRALLOC_USAGE_PROTECTED | GRALLOC_USAGE_HW_COMPOSER,
+};
+
+static const struct {
+  int width;
+  int height;
+} kSizes[] = {
+  {1, 1}, {17, 33}, {720, 1280}, {1080, 2400}, {1920, 1080}, {3840, 2160},
+};
+
+// Everything the layout functions report for one set of buffer parameters.
+struct Layout {
+  int size_err = 0;
+  unsigned int size = 0;
+  unsigned int alignedw = 0;
+  unsigned int alignedh = 0;
+  GraphicsMetadata graphics_metadata;
+  int aligned_err = 0;
+  unsigned int aligned_only_w = 0;
+  unsigned int aligned_only_h = 0;
+  int plane_err = 0;
+  int plane_count = 0;
+  PlaneLayoutInfo plane_info[8];
+
+  Layout() {
+    memset(&graphics_metadata, 0, sizeof(graphics_metadata));
+    memset(plane_info, 0, sizeof(plane_info));
+  }
+};
+
+static Layout GetLayout(const BufferInfo &info) {
+  Layout layout;
+  layout.size_err = GetBufferSizeAndDimensions(info, &layout.size, &layout.alignedw,
+                                               &layout.alignedh, &layout.graphics_metadata);
+  layout.aligned_err = GetAlignedWidthAndHeight(info, &layout.aligned_only_w,
+                                                &layout.aligned_only_h);
+  if (!layout.size_err && IsYuvFormat(info.format)) {
+    layout.plane_err = GetYUVPlaneInfo(info, info.format, INT(layout.alignedw),
+                                       INT(layout.alignedh), 0, &layout.plane_count,
+                                       layout.plane_info);
+  }
+
+  return layout;
+}
+
+static void ExpectSameLayout(const Layout &expected, const Layout &actual,
+                             const BufferInfo &info) {
+  SCOPED_TRACE(::testing::Message() << "format " << info.format << " usage 0x" << std::hex
+                                    << info.usage << std::dec << " " << info.width << "x"
+                                    << info.height << " layers " << info.layer_count);
+  EXPECT_EQ(expected.size_err, actual.size_err);
+  EXPECT_EQ(expected.size, actual.size);
+  EXPECT_EQ(expected.alignedw, actual.alignedw);
+  EXPECT_EQ(expected.alignedh, actual.alignedh);
+  EXPECT_EQ(0, memcmp(&expected.graphics_metadata, &actual.graphics_metadata,
+                      sizeof(GraphicsMetadata)));
+  EXPECT_EQ(expected.aligned_err, actual.aligned_err);
+  EXPECT_EQ(expected.aligned_only_w, actual.aligned_only_w);
+  EXPECT_EQ(expected.aligned_only_h, actual.aligned_only_h);
+  EXPECT_EQ(expected.plane_err, actual.plane_err);
+  ASSERT_EQ(expected.plane_count, actual.plane_count);
+  EXPECT_EQ(0, memcmp(expected.plane_info, actual.plane_info,
+                      sizeof(PlaneLayoutInfo) * static_cast<size_t>(expected.plane_count)));
+}
+
+class LayoutCacheTest : public ::testing::Test {
+ protected:
+  void TearDown() override { SetLayoutCacheEnabled(true); }
+};
+
+// The cached path reports exactly what the uncached one computes, on a miss and on a hit.
+TEST_F(LayoutCacheTest, MatchesUncachedPath) {
+  for (int format : kFormats) {
+    for (uint64_t usage : kUsages) {
+      for (auto &size : kSizes) {
+        for (int layer_count : {1, 2}) {
+          BufferInfo info(size.width, size.height, format, usage);
+          info.layer_count = layer_count;
+
+          SetLayoutCacheEnabled(false);
+          Layout expected = GetLayout(info);
+          SetLayoutCacheEnabled(true);
+          Layout miss = GetLayout(info);
+          Layout hit = GetLayout(info);
+
+          ExpectSameLayout(expected, miss, info);
+          ExpectSameLayout(expected, hit, info);
+        }
+      }
+    }
+  }
+}
+
+// Entries evicted from a full set are recomputed, not served stale.
+TEST_F(LayoutCacheTest, MatchesUncachedPathUnderEviction) {
+  std::vector<BufferInfo> infos;
+  for (int width = 64; width < 64 + 512; width++) {
+    infos.push_back(BufferInfo(width, 480, HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS));
+  }
+
+  SetLayoutCacheEnabled(false);
+  std::vector<Layout> expected;
+  for (auto &info : infos) {
+    expected.push_back(GetLayout(info));
+  }
+
+  SetLayoutCacheEnabled(true);
+  for (int pass = 0; pass < 2; pass++) {
+    for (size_t i = 0; i < infos.size(); i++) {
+      ExpectSameLayout(expected[i], GetLayout(infos[i]), infos[i]);
+    }
+  }
+
+  LayoutCacheStats stats;
+  GetLayoutCacheStats(&stats);
+  EXPECT_GT(stats.evictions, 0u);
+}
+
+struct TestKey {
+  int32_t a;
+  int32_t b;
+};
+
+TEST(LayoutCache, FindInsertClear) {
+  LayoutCache<TestKey, int, 8> cache;
+  TestKey key = {1, 2};
+  int value = 0;
+
+  EXPECT_FALSE(cache.Find(key, &value));
+  cache.Insert(key, 42);
+  ASSERT_TRUE(cache.Find(key, &value));
+  EXPECT_EQ(42, value);
+
+  cache.Insert(key, 43);
+  ASSERT_TRUE(cache.Find(key, &value));
+  EXPECT_EQ(43, value);
+
+  cache.Clear();
+  EXPECT_FALSE(cache.Find(key, &value));
+
+  LayoutCacheStats stats;
+  cache.GetStats(&stats);
+  EXPECT_EQ(2u, stats.hits);
+  EXPECT_EQ(2u, stats.misses);
+}
+
+TEST(LayoutCache, BoundedBySlots) {
+  LayoutCache<TestKey, int, 8> cache;
+  for (int i = 0; i < 100; i++) {
+    cache.Insert({i, 0}, i);
+  }
+
+  int found = 0;
+  for (int i = 0; i < 100; i++) {
+    int value = -1;
+    if (cache.Find({i, 0}, &value)) {
+      EXPECT_EQ(i, value);
+      found++;
+    }
+  }
+  EXPECT_LE(found, 8);
+  EXPECT_GT(found, 0);
+}
+
+}  // namespace gralloc
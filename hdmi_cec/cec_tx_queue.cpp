@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define DEBUG 0
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+#include <log/log.h>
+#include <hardware/hdmi_cec.h>
+#include <utils/Trace.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <utility>
+#include "cec_tx_queue.h"
+
+namespace qhdmicec {
+
+CECTxQueue::CECTxQueue(const char *wr_msg_path, bool connected,
+        const Writer &writer)
+    : mPath(wr_msg_path), mWriter(writer), mConnected(connected)
+{
+    if (!mWriter) {
+        mWriter = [](int fd, const void *buf, size_t count, off_t offset) {
+            return pwrite(fd, buf, count, offset);
+        };
+    }
+    mThread = std::thread(&CECTxQueue::run, this);
+}
+
+CECTxQueue::~CECTxQueue()
+{
+    std::deque<Request> failed;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStop = true;
+        mCond.notify_all();
+    }
+    mThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        failPendingLocked(&failed);
+    }
+    for (auto &request : failed) {
+        complete(request, HDMI_RESULT_FAIL);
+    }
+
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+void CECTxQueue::enqueue(const char *frame, size_t len, int poll_key,
+        const ResultCallback &callback)
+{
+    int result = HDMI_RESULT_SUCCESS;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mStop || !mConnected) {
+            mStats.failed++;
+            result = HDMI_RESULT_FAIL;
+        } else if (poll_key >= 0) {
+            // A poll only reports whether the destination acks, a poll that
+            // is still queued answers for this one too.
+            auto it = std::find_if(mPending.begin(), mPending.end(),
+                    [poll_key](const Request &request) {
+                        return request.poll_key == poll_key;
+                    });
+            if (it != mPending.end()) {
+                it->callbacks.push_back(callback);
+                mStats.coalesced_polls++;
+                return;
+            }
+        }
+
+        if (result == HDMI_RESULT_SUCCESS) {
+            if (mPending.size() >= MAX_PENDING) {
+                ALOGE("%s: Too many pending CEC messages", __FUNCTION__);
+                mStats.failed++;
+                result = HDMI_RESULT_BUSY;
+            } else {
+                Request request;
+                request.frame.assign(frame, frame + len);
+                request.poll_key = poll_key;
+                request.callbacks.push_back(callback);
+                mPending.push_back(std::move(request));
+                mCond.notify_all();
+                return;
+            }
+        }
+    }
+
+    callback(result);
+}
+
+int CECTxQueue::send(const char *frame, size_t len, int poll_key)
+{
+    auto result = std::make_shared<std::promise<int>>();
+    std::future<int> future = result->get_future();
+    enqueue(frame, len, poll_key, [result](int value) { result->set_value(value); });
+
+    return future.get();
+}
+
+void CECTxQueue::setConnected(bool connected)
+{
+    std::deque<Request> failed;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mConnected = connected;
+        if (!connected) {
+            failPendingLocked(&failed);
+            // Wakes up the transmit thread if it is backing off.
+            mCond.notify_all();
+        }
+    }
+
+    for (auto &request : failed) {
+        complete(request, HDMI_RESULT_FAIL);
+    }
+}
+
+bool CECTxQueue::isConnected()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mConnected;
+}
+
+CECTxQueue::Stats CECTxQueue::getStats()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mStats;
+}
+
+void CECTxQueue::run()
+{
+    prctl(PR_SET_NAME, "CEC_TxQueue", 0, 0, 0);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mCond.wait(lock, [this] { return mStop || !mPending.empty(); });
+        if (mStop) {
+            break;
+        }
+
+        Request request = std::move(mPending.front());
+        mPending.pop_front();
+        int result = transmit(request.frame, &lock);
+
+        lock.unlock();
+        complete(request, result);
+        lock.lock();
+    }
+}
+
+int CECTxQueue::transmit(const std::vector<char> &frame,
+        std::unique_lock<std::mutex> *lock)
+{
+    ATRACE_CALL();
+    int backoff_ms = INITIAL_BACKOFF_MS;
+    //HAL spec requires us to retry at least once.
+    for (int retry_count = 0; ; retry_count++) {
+        if (mStop || !mConnected) {
+            mStats.failed++;
+            return HDMI_RESULT_FAIL;
+        }
+
+        lock->unlock();
+        ssize_t err = writeFrame(frame);
+        lock->lock();
+
+        if (err >= 0) {
+            ALOGD_IF(DEBUG, "%s: Sent CEC message - %zd bytes written",
+                    __FUNCTION__, err);
+            mStats.sent++;
+            return HDMI_RESULT_SUCCESS;
+        }
+
+        if (err == -EAGAIN && retry_count < MAX_RETRIES) {
+            ALOGD_IF(DEBUG, "%s: CEC line busy, retrying in %d ms",
+                    __FUNCTION__, backoff_ms);
+            mStats.retries++;
+            mCond.wait_for(*lock, std::chrono::milliseconds(backoff_ms),
+                    [this] { return mStop || !mConnected; });
+            backoff_ms = std::min(backoff_ms * 2, int(MAX_BACKOFF_MS));
+            continue;
+        }
+
+        mStats.failed++;
+        if (err == -ENXIO) {
+            ALOGI("%s: No device exists with the destination address",
+                    __FUNCTION__);
+            return HDMI_RESULT_NACK;
+        } else if (err == -EAGAIN) {
+            ALOGE("%s: CEC line is busy, max retry count exceeded",
+                    __FUNCTION__);
+            return HDMI_RESULT_BUSY;
+        }
+
+        ALOGE("%s: Failed to send CEC message err: %zd - %s",
+                __FUNCTION__, err, strerror(int(-err)));
+        return HDMI_RESULT_FAIL;
+    }
+}
+
+ssize_t CECTxQueue::writeFrame(const std::vector<char> &frame)
+{
+    // Only the transmit thread touches mFd.
+    if (mFd < 0) {
+        mFd = open(mPath.c_str(), O_WRONLY | O_CLOEXEC);
+        if (mFd < 0) {
+            int err = errno;
+            ALOGE("%s: Failed to open path: %s error: %s",
+                    __FUNCTION__, mPath.c_str(), strerror(err));
+            return -err;
+        }
+        std::lock_guard<std::mutex> lock(mLock);
+        mStats.reopens++;
+    }
+
+    ssize_t err = mWriter(mFd, frame.data(), frame.size(), 0);
+    if (err < 0) {
+        err = -errno;
+        // Busy line and missing destination are results of the transmission,
+        // anything else reopens the node for the next frame.
+        if (err != -EAGAIN && err != -ENXIO) {
+            close(mFd);
+            mFd = -1;
+        }
+    }
+
+    return err;
+}
+
+void CECTxQueue::failPendingLocked(std::deque<Request> *failed)
+{
+    mStats.failed += mPending.size();
+    failed->swap(mPending);
+    mPending.clear();
+}
+
+void CECTxQueue::complete(const Request &request, int result)
+{
+    for (auto &callback : request.callbacks) {
+        callback(result);
+    }
+}
+
+}; //namespace qhdmicec
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef CEC_TX_QUEUE_H
+#define CEC_TX_QUEUE_H
+
+#include <sys/types.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qhdmicec {
+
+// Transmits CEC frames to the driver in order on a thread of its own, so that
+// callers do not block on the CEC line. The message node is kept open, busy
+// lines are retried with a bounded exponential backoff, and polls that are
+// already queued for the same destination are not transmitted again.
+// Connection state is tracked from hotplug events, frames are failed without
+// being written while disconnected.
+class CECTxQueue {
+public:
+    // Called on the transmit thread with a HDMI_RESULT_* value.
+    typedef std::function<void(int result)> ResultCallback;
+    // Writes a frame to the open node, as pwrite does.
+    typedef std::function<ssize_t(int fd, const void *buf, size_t count,
+            off_t offset)> Writer;
+
+    struct Stats {
+        uint64_t sent;
+        uint64_t failed;
+        uint64_t retries;
+        uint64_t reopens;
+        uint64_t coalesced_polls;
+    };
+
+    // wr_msg_path is the driver message node, any writable file for testing.
+    // A test writer can stand in for the driver to fail writes.
+    CECTxQueue(const char *wr_msg_path, bool connected,
+            const Writer &writer = nullptr);
+    ~CECTxQueue();
+
+    // Queues a frame in the driver format. poll_key is the initiator and
+    // destination of a polling message, -1 for any other message.
+    void enqueue(const char *frame, size_t len, int poll_key,
+            const ResultCallback &callback);
+    // Queues the frame and waits for its HDMI_RESULT_*, as the HAL expects.
+    int send(const char *frame, size_t len, int poll_key);
+    void setConnected(bool connected);
+    bool isConnected();
+    Stats getStats();
+
+private:
+    static const int MAX_RETRIES = 3;
+    static const int INITIAL_BACKOFF_MS = 8;
+    static const int MAX_BACKOFF_MS = 32;
+    static const size_t MAX_PENDING = 32;
+
+    struct Request {
+        std::vector<char> frame;
+        int poll_key;
+        std::vector<ResultCallback> callbacks;
+    };
+
+    void run();
+    int transmit(const std::vector<char> &frame, std::unique_lock<std::mutex> *lock);
+    ssize_t writeFrame(const std::vector<char> &frame);
+    void failPendingLocked(std::deque<Request> *failed);
+    static void complete(const Request &request, int result);
+
+    std::string mPath;
+    Writer mWriter;
+    int mFd = -1;
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<Request> mPending;
+    bool mConnected = false;
+    bool mStop = false;
+    Stats mStats = {};
+    std::thread mThread;
+};
+
+}; //namespace qhdmicec
+#endif /* end of include guard: CEC_TX_QUEUE_H */
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <hardware/hdmi_cec.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cec_tx_queue.h"
+
+namespace qhdmicec {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const milliseconds TIMEOUT(2000);
+
+// A fake cec/wr_msg: a temporary file the frames are written to, with
+// scripted errors for the writes the driver would fail.
+class FakeNode {
+public:
+    FakeNode()
+    {
+        char path[] = "/tmp/cec_wr_msg_XXXXXX";
+        int fd = mkstemp(path);
+        close(fd);
+        mPath = path;
+    }
+
+    ~FakeNode() { unlink(mPath.c_str()); }
+
+    const char *path() { return mPath.c_str(); }
+
+    CECTxQueue::Writer writer()
+    {
+        return [this](int fd, const void *buf, size_t count, off_t offset) {
+            std::unique_lock<std::mutex> lock(mLock);
+            mCond.wait(lock, [this] { return !mBlocked; });
+            mAttempts.push_back(std::chrono::steady_clock::now());
+            if (!mErrors.empty()) {
+                errno = mErrors.front();
+                mErrors.pop_front();
+                return ssize_t(-1);
+            }
+            const char *frame = static_cast<const char *>(buf);
+            mFrames.emplace_back(frame, frame + count);
+            return pwrite(fd, buf, count, offset);
+        };
+    }
+
+    void failNext(int error, int count = 1)
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mErrors.insert(mErrors.end(), count, error);
+    }
+
+    void block()
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mBlocked = true;
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mBlocked = false;
+        mCond.notify_all();
+    }
+
+    std::vector<std::string> frames()
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mFrames;
+    }
+
+    std::vector<std::chrono::steady_clock::time_point> attempts()
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mAttempts;
+    }
+
+    // The frame last written, as the driver would read it.
+    std::string contents()
+    {
+        char buf[64] = {};
+        int fd = open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+        ssize_t len = read(fd, buf, sizeof(buf));
+        close(fd);
+        return std::string(buf, size_t(std::max(len, ssize_t(0))));
+    }
+
+private:
+    std::string mPath;
+    std::mutex mLock;
+    std::condition_variable mCond;
+    bool mBlocked = false;
+    std::deque<int> mErrors;
+    std::vector<std::string> mFrames;
+    std::vector<std::chrono::steady_clock::time_point> mAttempts;
+};
+
+// Collects the results of enqueued frames.
+class Results {
+public:
+    CECTxQueue::ResultCallback callback()
+    {
+        return [this](int result) {
+            std::lock_guard<std::mutex> lock(mLock);
+            mResults.push_back(result);
+            mCond.notify_all();
+        };
+    }
+
+    std::vector<int> wait(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCond.wait_for(lock, TIMEOUT,
+                [this, count] { return mResults.size() >= count; });
+        return mResults;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::vector<int> mResults;
+};
+
+// Waits for the transmit thread to open the node for the first frame.
+bool waitForAttempt(FakeNode *node, CECTxQueue *queue)
+{
+    for (int i = 0; i < 200; i++) {
+        if (!node->attempts().empty() || queue->getStats().reopens) {
+            return true;
+        }
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(CECTxQueue, SendsInOrderOnOneOpen)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40\x04", 2, -1));
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x4f\x82\x10\x00", 4, -1));
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40\x36", 2, -1));
+
+    std::string routing("\x4f\x82\x10\x00", 4);
+    EXPECT_EQ(std::vector<std::string>({"\x40\x04", routing, "\x40\x36"}),
+            node.frames());
+    // Every frame is written at the start of the node.
+    EXPECT_EQ(std::string("\x40\x36\x10\x00", 4), node.contents());
+    CECTxQueue::Stats stats = queue.getStats();
+    EXPECT_EQ(3u, stats.sent);
+    EXPECT_EQ(1u, stats.reopens);
+}
+
+TEST(CECTxQueue, RetriesBusyLineWithBackoff)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    node.failNext(EAGAIN, 2);
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40\x04", 2, -1));
+
+    auto attempts = node.attempts();
+    ASSERT_EQ(3u, attempts.size());
+    EXPECT_GE(attempts[1] - attempts[0], milliseconds(8));
+    EXPECT_GE(attempts[2] - attempts[1], milliseconds(16));
+    EXPECT_EQ(2u, queue.getStats().retries);
+    // A busy line does not reopen the node.
+    EXPECT_EQ(1u, queue.getStats().reopens);
+}
+
+TEST(CECTxQueue, BusyAfterMaxRetries)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    node.failNext(EAGAIN, 4);
+    EXPECT_EQ(HDMI_RESULT_BUSY, queue.send("\x40\x04", 2, -1));
+
+    auto attempts = node.attempts();
+    ASSERT_EQ(4u, attempts.size());
+    EXPECT_GE(attempts[3] - attempts[2], milliseconds(32));
+    CECTxQueue::Stats stats = queue.getStats();
+    EXPECT_EQ(3u, stats.retries);
+    EXPECT_EQ(1u, stats.failed);
+    // The next frame goes out.
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40\x04", 2, -1));
+}
+
+TEST(CECTxQueue, NackIsNotRetried)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    node.failNext(ENXIO);
+    EXPECT_EQ(HDMI_RESULT_NACK, queue.send("\x40", 1, 0x40));
+    EXPECT_EQ(1u, node.attempts().size());
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40", 1, 0x40));
+    EXPECT_EQ(1u, queue.getStats().reopens);
+}
+
+TEST(CECTxQueue, ReopensAfterError)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    node.failNext(EIO);
+    EXPECT_EQ(HDMI_RESULT_FAIL, queue.send("\x40\x04", 2, -1));
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40\x04", 2, -1));
+    EXPECT_EQ(2u, queue.getStats().reopens);
+}
+
+TEST(CECTxQueue, MissingNode)
+{
+    CECTxQueue queue("/nonexistent/cec/wr_msg", true);
+    EXPECT_EQ(HDMI_RESULT_FAIL, queue.send("\x40\x04", 2, -1));
+    EXPECT_EQ(0u, queue.getStats().sent);
+}
+
+// A poll for a destination that is already queued is answered by the queued one.
+TEST(CECTxQueue, CoalescesQueuedPolls)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    Results results;
+    node.block();
+    queue.enqueue("\x40\x04", 2, -1, results.callback());
+    ASSERT_TRUE(waitForAttempt(&node, &queue));
+    queue.enqueue("\x44", 1, 0x44, results.callback());
+    queue.enqueue("\x45", 1, 0x45, results.callback());
+    queue.enqueue("\x44", 1, 0x44, results.callback());
+    node.release();
+
+    EXPECT_EQ(std::vector<int>(4, HDMI_RESULT_SUCCESS), results.wait(4));
+    EXPECT_EQ(std::vector<std::string>({"\x40\x04", "\x44", "\x45"}),
+            node.frames());
+    EXPECT_EQ(1u, queue.getStats().coalesced_polls);
+}
+
+TEST(CECTxQueue, DisconnectFailsQueuedFrames)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    Results results;
+    node.block();
+    queue.enqueue("\x40\x04", 2, -1, results.callback());
+    ASSERT_TRUE(waitForAttempt(&node, &queue));
+    queue.enqueue("\x40\x36", 2, -1, results.callback());
+    queue.enqueue("\x40", 1, 0x40, results.callback());
+
+    queue.setConnected(false);
+    EXPECT_FALSE(queue.isConnected());
+    EXPECT_EQ(std::vector<int>(2, HDMI_RESULT_FAIL), results.wait(2));
+    EXPECT_EQ(HDMI_RESULT_FAIL, queue.send("\x40\x04", 2, -1));
+    node.release();
+    // The frame in flight went out before the disconnect was seen.
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, results.wait(3)[2]);
+
+    queue.setConnected(true);
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, queue.send("\x40\x04", 2, -1));
+}
+
+// A disconnect ends the backoff of a busy line.
+TEST(CECTxQueue, DisconnectStopsRetries)
+{
+    FakeNode node;
+    CECTxQueue queue(node.path(), true, node.writer());
+    Results results;
+    node.failNext(EAGAIN, 4);
+    queue.enqueue("\x40\x04", 2, -1, results.callback());
+    ASSERT_TRUE(waitForAttempt(&node, &queue));
+    queue.setConnected(false);
+    EXPECT_EQ(std::vector<int>({HDMI_RESULT_FAIL}), results.wait(1));
+    EXPECT_LT(node.attempts().size(), 4u);
+}
+
+TEST(CECTxQueue, FullQueueIsBusy)
+{
+    FakeNode node;
+    Results results;
+    std::thread releaser;
+    {
+        CECTxQueue queue(node.path(), true, node.writer());
+        node.block();
+        queue.enqueue("\x40\x04", 2, -1, results.callback());
+        ASSERT_TRUE(waitForAttempt(&node, &queue));
+        for (int i = 0; i < 32; i++) {
+            queue.enqueue("\x40\x04", 2, -1, results.callback());
+        }
+        EXPECT_EQ(HDMI_RESULT_BUSY, queue.send("\x40\x04", 2, -1));
+        releaser = std::thread([&node] {
+            std::this_thread::sleep_for(milliseconds(20));
+            node.release();
+        });
+        // Destroying the queue fails the frames still queued.
+    }
+    releaser.join();
+    std::vector<int> all = results.wait(33);
+    ASSERT_EQ(33u, all.size());
+    EXPECT_EQ(HDMI_RESULT_SUCCESS, all[0]);
+    for (size_t i = 1; i < all.size(); i++) {
+        EXPECT_EQ(HDMI_RESULT_FAIL, all[i]);
+    }
+}
+
+}; //namespace qhdmicec
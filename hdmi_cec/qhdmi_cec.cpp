@@ -37,13 +37,13 @@
 #include <utils/Trace.h>
 #include "qhdmi_cec.h"
 #include "QHDMIClient.h"
+#include "cec_tx_queue.h"
 
 namespace qhdmicec {
 
 const int NUM_HDMI_PORTS = 1;
 const int MAX_SYSFS_DATA = 128;
 const int MAX_CEC_FRAME_SIZE = 20;
-const int MAX_SEND_MESSAGE_RETRIES = 1;
 
 enum {
     LOGICAL_ADDRESS_SET   =  1,
@@ -63,9 +63,10 @@ enum {
 };
 
 //Forward declarations
-static void cec_close_context(cec_context_t* ctx __unused);
+static void cec_close_context(cec_context_t* ctx);
 static int cec_enable(cec_context_t *ctx, int enable);
 static int cec_is_connected(const struct hdmi_cec_device* dev, int port_id);
+static int cec_read_connected(cec_context_t *ctx);
 
 static ssize_t read_node(const char *path, char *data)
 {
@@ -207,22 +208,21 @@ static int cec_send_message(const struct hdmi_cec_device* dev,
         const cec_message_t* msg)
 {
     ATRACE_CALL();
-    if(cec_is_connected(dev, 0) <= 0)
+    cec_context_t* ctx = (cec_context_t*)(dev);
+    if(!ctx->tx_queue->isConnected())
         return HDMI_RESULT_FAIL;
 
-    cec_context_t* ctx = (cec_context_t*)(dev);
     ALOGD_IF(DEBUG, "%s: initiator: %d destination: %d length: %u",
             __FUNCTION__, msg->initiator, msg->destination,
             (uint32_t) msg->length);
 
     // Dump message received from framework
     char dump[128];
-    if(msg->length > 0) {
+    if(DEBUG && msg->length > 0) {
         hex_to_string((char*)msg->body, msg->length, dump);
-        ALOGD_IF(DEBUG, "%s: message from framework: %s", __FUNCTION__, dump);
+        ALOGD("%s: message from framework: %s", __FUNCTION__, dump);
     }
 
-    char write_msg_path[MAX_PATH_LENGTH];
     char write_msg[MAX_CEC_FRAME_SIZE];
     memset(write_msg, 0, sizeof(write_msg));
     // See definition of struct hdmi_cec_msg in driver code
@@ -239,42 +239,17 @@ static int cec_send_message(const struct hdmi_cec_device* dev,
     }
     //msg length + initiator + destination
     write_msg[CEC_OFFSET_FRAME_LENGTH] = (unsigned char) (msg->length + 1);
-    hex_to_string(write_msg, sizeof(write_msg), dump);
-    ALOGD_IF(DEBUG, "%s: message to driver: %s", __FUNCTION__, dump);
-    snprintf(write_msg_path, sizeof(write_msg_path), "%s/cec/wr_msg",
-            ctx->fb_sysfs_path);
-    int retry_count = 0;
-    ssize_t err = 0;
-    //HAL spec requires us to retry at least once.
-    while (true) {
-        err = write_node(write_msg_path, write_msg, sizeof(write_msg));
-        retry_count++;
-        if (err == -EAGAIN && retry_count <= MAX_SEND_MESSAGE_RETRIES) {
-            ALOGE("%s: CEC line busy, retrying", __FUNCTION__);
-        } else {
-            break;
-        }
+    if(DEBUG) {
+        hex_to_string(write_msg, sizeof(write_msg), dump);
+        ALOGD("%s: message to driver: %s", __FUNCTION__, dump);
     }
 
-    if (err < 0) {
-       if (err == -ENXIO) {
-           ALOGI("%s: No device exists with the destination address",
-                   __FUNCTION__);
-           return HDMI_RESULT_NACK;
-       } else if (err == -EAGAIN) {
-            ALOGE("%s: CEC line is busy, max retry count exceeded",
-                    __FUNCTION__);
-            return HDMI_RESULT_BUSY;
-        } else {
-            return HDMI_RESULT_FAIL;
-            ALOGE("%s: Failed to send CEC message err: %zd - %s",
-                    __FUNCTION__, err, strerror(int(-err)));
-        }
-    } else {
-        ALOGD_IF(DEBUG, "%s: Sent CEC message - %zd bytes written",
-                __FUNCTION__, err);
-        return HDMI_RESULT_SUCCESS;
-    }
+    // Messages without a body poll the destination for its presence
+    int poll_key = -1;
+    if(msg->length == 0)
+        poll_key = (msg->initiator << 4) | msg->destination;
+
+    return ctx->tx_queue->send(write_msg, sizeof(write_msg), poll_key);
 }
 
 void cec_receive_message(cec_context_t *ctx, char *msg, ssize_t len)
@@ -283,9 +258,9 @@ void cec_receive_message(cec_context_t *ctx, char *msg, ssize_t len)
         return;
 
     char dump[128];
-    if(len > 0) {
+    if(DEBUG && len > 0) {
         hex_to_string(msg, len, dump);
-        ALOGD_IF(DEBUG, "%s: Message from driver: %s", __FUNCTION__, dump);
+        ALOGD("%s: Message from driver: %s", __FUNCTION__, dump);
     }
 
     hdmi_event_t event;
@@ -299,13 +274,17 @@ void cec_receive_message(cec_context_t *ctx, char *msg, ssize_t len)
     size_t copy_size = event.cec.length > sizeof(event.cec.body) ?
                        sizeof(event.cec.body) : event.cec.length;
     memcpy(event.cec.body, &msg[CEC_OFFSET_OPCODE],copy_size);
-    hex_to_string((char *) event.cec.body, copy_size, dump);
-    ALOGD_IF(DEBUG, "%s: Message to framework: %s", __FUNCTION__, dump);
+    if(DEBUG) {
+        hex_to_string((char *) event.cec.body, copy_size, dump);
+        ALOGD("%s: Message to framework: %s", __FUNCTION__, dump);
+    }
     ctx->callback.callback_func(&event, ctx->callback.callback_arg);
 }
 
 void cec_hdmi_hotplug(cec_context_t *ctx, int connected)
 {
+    //Connection state is tracked here instead of reading it from sysfs
+    ctx->tx_queue->setConnected(connected != 0);
     //Ignore unplug events when system control is disabled
     if(!ctx->system_control && connected == 0)
         return;
@@ -381,8 +360,16 @@ static void cec_set_audio_return_channel(const struct hdmi_cec_device* dev,
 static int cec_is_connected(const struct hdmi_cec_device* dev, int port_id)
 {
     // Ignore port_id since we have only one port
-    int connected = 0;
     cec_context_t* ctx = (cec_context_t*)(dev);
+    bool connected = ctx->tx_queue->isConnected();
+    ALOGD_IF(DEBUG, "%s: HDMI at port %d is - %s", __FUNCTION__, port_id,
+            connected ? "connected":"disconnected");
+    return connected ? 1 : 0;
+}
+
+static int cec_read_connected(cec_context_t *ctx)
+{
+    int connected = 0;
     char connected_path[MAX_PATH_LENGTH];
     char connected_data[MAX_SYSFS_DATA];
     snprintf (connected_path, sizeof(connected_path),"%s/connected",
@@ -390,7 +377,7 @@ static int cec_is_connected(const struct hdmi_cec_device* dev, int port_id)
     ssize_t err = read_node(connected_path, connected_data);
     connected = atoi(connected_data);
 
-    ALOGD_IF(DEBUG, "%s: HDMI at port %d is - %s", __FUNCTION__, port_id,
+    ALOGD_IF(DEBUG, "%s: HDMI is - %s", __FUNCTION__,
             connected ? "connected":"disconnected");
     if (err < 0)
         return (int) err;
@@ -445,6 +432,12 @@ static void cec_init_context(cec_context_t *ctx)
     ctx->vendor_id = 0xA47733;
     cec_clear_logical_address((hdmi_cec_device_t*)ctx);
 
+    //Initial connection state, hotplug events keep it up to date
+    char write_msg_path[MAX_PATH_LENGTH];
+    snprintf(write_msg_path, sizeof(write_msg_path), "%s/cec/wr_msg",
+            ctx->fb_sysfs_path);
+    ctx->tx_queue = new CECTxQueue(write_msg_path, cec_read_connected(ctx) > 0);
+
     //Set up listener for HDMI events
     ctx->disp_client = new qClient::QHDMIClient();
     ctx->disp_client->setCECContext(ctx);
@@ -456,9 +449,11 @@ static void cec_init_context(cec_context_t *ctx)
     ALOGD("%s: CEC enabled", __FUNCTION__);
 }
 
-static void cec_close_context(cec_context_t* ctx __unused)
+static void cec_close_context(cec_context_t* ctx)
 {
     ALOGD("%s: Closing context", __FUNCTION__);
+    delete ctx->tx_queue;
+    ctx->tx_queue = NULL;
 }
 
 static int cec_device_open(const struct hw_module_t* module,
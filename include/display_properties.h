@@ -121,6 +121,7 @@
 #define ENABLE_FORCE_SPLIT                   DISPLAY_PROP("enable_force_split")
 #define DISABLE_GPU_COLOR_CONVERT            DISPLAY_PROP("disable_gpu_color_convert")
 #define ENABLE_ASYNC_VDS_CREATION            DISPLAY_PROP("enable_async_vds_creation")
+#define VDS_GPU_FRAMES_IN_FLIGHT             DISPLAY_PROP("vds_gpu_frames_in_flight")
 #define MAX_PRIMARY_LAYERS                   DISPLAY_PROP("max_primary_layers")
 #define ENABLE_HISTOGRAM_INTR                DISPLAY_PROP("enable_hist_intr")
 #define DISABLE_MMRM_PROP                    DISPLAY_PROP("disable_mmrm_prop")
@@ -157,6 +158,8 @@
 
 // PERF hint properties
 #define ENABLE_PERF_HINT_LARGE_COMP_CYCLE    DISPLAY_PROP("enable_perf_hint_large_comp_cycle")
+#define ENABLE_PERF_HINT_PREDICTION          DISPLAY_PROP("enable_perf_hint_prediction")
+#define PERF_HINT_SLACK_THRESHOLD            DISPLAY_PROP("perf_hint_slack_threshold")
 #define DISABLE_DYNAMIC_FPS                  DISPLAY_PROP("disable_dynamic_fps")
 #define ENABLE_QSYNC_IDLE                    DISPLAY_PROP("enable_qsync_idle")
 #define ENHANCE_IDLE_TIME                    DISPLAY_PROP("enhance_idle_time")
@@ -201,6 +204,17 @@
 #define TRACK_INPUT_FENCES                   DISPLAY_PROP("track_input_fences")
 #define ENABLE_ROTATOR_CONCURRENCY           DISPLAY_PROP("enable_rotator_concurrency")
 #define FORCE_GPU_COMPOSITION                DISPLAY_PROP("force_gpu_composition")
+#define EGL_IMAGE_CACHE_SIZE                 DISPLAY_PROP("egl_image_cache_size")
+#define DISABLE_GL_PROGRAM_WARMUP            DISPLAY_PROP("disable_gl_program_warmup")
+#define BRIGHTNESS_FRAME_HOLD_MS             DISPLAY_PROP("brightness_frame_hold_ms")
+#define ENABLE_SW_VSYNC                      DISPLAY_PROP("enable_sw_vsync")
+#define SW_VSYNC_ERROR_THRESHOLD_US          DISPLAY_PROP("sw_vsync_error_threshold_us")
+#define SW_VSYNC_RESYNC_MS                   DISPLAY_PROP("sw_vsync_resync_ms")
+#define ENABLE_INPUT_FENCE_MONITOR           DISPLAY_PROP("enable_input_fence_monitor")
+#define MIXER_RECONFIG_STABLE_FRAMES         DISPLAY_PROP("mixer_reconfig_stable_frames")
+#define MIXER_RECONFIG_STABLE_MS             DISPLAY_PROP("mixer_reconfig_stable_ms")
+#define MIXER_RECONFIG_MIN_INTERVAL_MS       DISPLAY_PROP("mixer_reconfig_min_interval_ms")
+#define ENABLE_POWER_ON_WITH_FRAME           DISPLAY_PROP("enable_power_on_with_frame")
 
 // Add all other.properties above
 // End of property
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "yv12_converter.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define COPYBIT_NEON
+#elif defined(__SSE2__)
+// Part of the x86-64 baseline, no runtime detection needed
+#include <emmintrin.h>
+#define COPYBIT_SSE2
+#endif
+
+// Frames smaller than this are converted on the calling thread
+#define PARALLEL_MIN_LUMA_SIZE (1920 * 1080)
+#define MAX_CONVERT_THREADS 4
+
+/* Interleaves count bytes of each chroma plane into dst, p1 first */
+static void interleave_chroma(unsigned char *dst, const unsigned char *p1,
+                              const unsigned char *p2, unsigned int count)
+{
+    unsigned int i = 0;
+#if defined(COPYBIT_NEON)
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t c;
+        c.val[0] = vld1q_u8(p1 + i);
+        c.val[1] = vld1q_u8(p2 + i);
+        vst2q_u8(dst + i*2, c);
+    }
+#elif defined(COPYBIT_SSE2)
+    for (; i + 16 <= count; i += 16) {
+        __m128i c1 = _mm_loadu_si128((const __m128i *)(p1 + i));
+        __m128i c2 = _mm_loadu_si128((const __m128i *)(p2 + i));
+        _mm_storeu_si128((__m128i *)(dst + i*2), _mm_unpacklo_epi8(c1, c2));
+        _mm_storeu_si128((__m128i *)(dst + i*2 + 16), _mm_unpackhi_epi8(c1, c2));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i*2]   = p1[i];
+        dst[i*2+1] = p2[i];
+    }
+}
+
+struct yv12Info {
+    unsigned char *dst;
+    const unsigned char *src;
+    unsigned int y_size;
+    unsigned int width;
+    unsigned int height;
+    unsigned int c_width;
+    unsigned int c_size;
+    unsigned int chromaPadding;
+};
+
+/*
+ * Converts band index of num_bands of the frame. Luma and chroma are split
+ * evenly, so that bands can be converted concurrently
+ */
+static void convertYV12Band(const yv12Info &info, unsigned int index,
+                            unsigned int num_bands)
+{
+    unsigned int y_start = (unsigned int)((uint64_t)info.y_size * index / num_bands);
+    unsigned int y_end = (unsigned int)((uint64_t)info.y_size * (index + 1) / num_bands);
+    memcpy(info.dst + y_start, info.src + y_start, y_end - y_start);
+
+    unsigned char* newChroma = info.dst + info.y_size;
+    const unsigned char* oldChroma = info.src + info.y_size;
+    if(!info.chromaPadding) {
+        // Both planes are contiguous, interleave them as a whole
+        unsigned int start = (unsigned int)((uint64_t)info.c_size * index / num_bands);
+        unsigned int end = (unsigned int)((uint64_t)info.c_size * (index + 1) / num_bands);
+        interleave_chroma(newChroma + start*2, oldChroma + start,
+                          oldChroma + info.c_size + start, end - start);
+        return;
+    }
+
+    // Skip the padding at the end of each source chroma row, the rows of the
+    // destination are width bytes
+    unsigned int rows = info.height/2;
+    unsigned int start = rows * index / num_bands;
+    unsigned int end = rows * (index + 1) / num_bands;
+    for(unsigned int r = start; r < end; r++) {
+        interleave_chroma(newChroma + r*info.width, oldChroma + r*info.c_width,
+                          oldChroma + r*info.c_width + info.c_size, info.width/2);
+    }
+}
+
+/*
+ * With an odd width, chroma pairs straddle the rows of the destination.
+ * r1 tracks the row of the source buffer
+ * r2 tracks the row of the destination buffer
+ * The width/2 checks are to avoid copying
+ * from the padding
+ */
+static void convertYV12OddWidth(const yv12Info &info)
+{
+    unsigned char* newChroma = info.dst + info.y_size;
+    const unsigned char* oldChroma = info.src + info.y_size;
+    unsigned int width = info.width;
+    unsigned int c_width = info.c_width;
+    unsigned int c_size = info.c_size;
+    unsigned int r1 = 0, r2 = 0, i = 0, j = 0;
+    while(r1 < info.height/2) {
+        if(j == width) {
+            j = 0;
+            r2++;
+            continue;
+        }
+        if (j+1 == width) {
+            newChroma[r2*width + j] = oldChroma[r1*c_width+i];
+            r2++;
+            newChroma[r2*width] = oldChroma[r1*c_width+i+c_size];
+            j = 1;
+        } else {
+            newChroma[r2*width + j] = oldChroma[r1*c_width+i];
+            newChroma[r2*width + j + 1] = oldChroma[r1*c_width+i+c_size];
+            j+=2;
+        }
+        i++;
+        if (i == width/2 ) {
+            i = 0;
+            r1++;
+        }
+    }
+}
+
+unsigned int yv12ConvertBands(unsigned int y_size)
+{
+    if(y_size < PARALLEL_MIN_LUMA_SIZE) {
+        return 1;
+    }
+
+    return std::min(std::max(std::thread::hardware_concurrency(), 1u),
+                    (unsigned int)MAX_CONVERT_THREADS);
+}
+
+void convertYV12Frame(unsigned char *dst, const unsigned char *src,
+                      unsigned int stride, unsigned int width,
+                      unsigned int height, unsigned int num_bands)
+{
+    // Please refer to the description of YV12 in hardware.h
+    // for the formulae used to calculate buffer sizes and offsets
+    yv12Info info;
+    info.dst = dst;
+    info.src = src;
+    info.y_size = stride * height;
+    info.width = width;
+    info.height = height;
+    info.c_width = ((stride/2) + 15) & ~15u;
+    info.c_size = info.c_width * height/2;
+    info.chromaPadding = info.c_width - width/2;
+
+    if(info.chromaPadding && (width & 1)) {
+        memcpy(dst, src, info.y_size);
+        convertYV12OddWidth(info);
+        return;
+    }
+
+    num_bands = std::max(num_bands, 1u);
+    std::vector<std::thread> workers;
+    for(unsigned int i = 1; i < num_bands; i++) {
+        workers.emplace_back(convertYV12Band, std::cref(info), i, num_bands);
+    }
+    convertYV12Band(info, 0, num_bands);
+    for(auto &worker : workers) {
+        worker.join();
+    }
+}
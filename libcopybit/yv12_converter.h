@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __YV12_CONVERTER_H__
+#define __YV12_CONVERTER_H__
+
+/*
+ * Number of bands a frame with y_size bytes of luma is converted in, one
+ * thread per band. Small frames are converted on the calling thread
+ */
+unsigned int yv12ConvertBands(unsigned int y_size);
+
+/*
+ * Converts a YV12 frame at src to YCrCb_420_SP at dst, in num_bands bands.
+ * stride is the luma stride of src, width the visible width. The luma of dst
+ * has the same stride as src, its chroma rows are width bytes
+ */
+void convertYV12Frame(unsigned char *dst, const unsigned char *src,
+                      unsigned int stride, unsigned int width,
+                      unsigned int height, unsigned int num_bands);
+
+#endif  // __YV12_CONVERTER_H__
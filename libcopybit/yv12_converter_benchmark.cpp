@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "yv12_converter.h"
+
+namespace {
+
+// Args: stride, width, height, bands. Bands 0 uses the count the copybit HAL would.
+void BM_ConvertYV12(benchmark::State &state) {
+  unsigned int stride = static_cast<unsigned int>(state.range(0));
+  unsigned int width = static_cast<unsigned int>(state.range(1));
+  unsigned int height = static_cast<unsigned int>(state.range(2));
+  unsigned int bands = static_cast<unsigned int>(state.range(3));
+  if (!bands) {
+    bands = yv12ConvertBands(stride * height);
+  }
+
+  unsigned int c_width = ((stride / 2) + 15) & ~15u;
+  std::vector<unsigned char> src(size_t(stride) * height + size_t(c_width) * height, 0x80);
+  std::vector<unsigned char> dst(size_t(stride) * height + size_t(width) * (height / 2 + 1));
+  for (auto _ : state) {
+    convertYV12Frame(dst.data(), src.data(), stride, width, height, bands);
+    benchmark::DoNotOptimize(dst.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+  state.counters["bands"] = bands;
+}
+
+void Sizes(benchmark::internal::Benchmark *b) {
+  for (long bands : {1, 2, 4, 0}) {
+    b->Args({1280, 1280, 720, bands});       // Unpadded chroma
+    b->Args({2000, 2000, 1088, bands});      // Padded chroma
+    b->Args({3840, 3840, 2160, bands});      // Unpadded chroma
+    b->Args({1920, 1917, 1080, bands});      // Odd width, single threaded C routine
+  }
+}
+
+BENCHMARK(BM_ConvertYV12)->Apply(Sizes)->ArgNames({"stride", "w", "h", "bands"})->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
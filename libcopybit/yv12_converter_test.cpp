@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "yv12_converter.h"
+
+namespace {
+
+struct Frame {
+  unsigned int stride;
+  unsigned int width;
+  unsigned int height;
+
+  unsigned int CWidth() const { return ((stride / 2) + 15) & ~15u; }
+  size_t SrcSize() const { return size_t(stride) * height + size_t(CWidth()) * height; }
+  // The odd width routine writes one byte past the chroma of height/2 rows of width bytes.
+  size_t DstSize() const { return size_t(stride) * height + size_t(width) * (height / 2 + 1); }
+};
+
+std::string Name(const Frame &frame) {
+  return std::to_string(frame.stride) + "/" + std::to_string(frame.width) + "x" +
+         std::to_string(frame.height);
+}
+
+// The conversion as it was before it was split in bands, byte by byte.
+void Reference(const Frame &frame, const unsigned char *src, unsigned char *dst) {
+  unsigned int y_size = frame.stride * frame.height;
+  unsigned int c_width = frame.CWidth();
+  unsigned int c_size = c_width * frame.height / 2;
+  unsigned int width = frame.width;
+  for (unsigned int i = 0; i < y_size; i++) {
+    dst[i] = src[i];
+  }
+
+  const unsigned char *old_chroma = src + y_size;
+  unsigned char *new_chroma = dst + y_size;
+  if (c_width == width / 2) {
+    for (unsigned int i = 0; i < c_size; i++) {
+      new_chroma[i * 2] = old_chroma[i];
+      new_chroma[i * 2 + 1] = old_chroma[i + c_size];
+    }
+    return;
+  }
+
+  unsigned int r1 = 0, r2 = 0, i = 0, j = 0;
+  while (r1 < frame.height / 2) {
+    if (j == width) {
+      j = 0;
+      r2++;
+      continue;
+    }
+    if (j + 1 == width) {
+      new_chroma[r2 * width + j] = old_chroma[r1 * c_width + i];
+      r2++;
+      new_chroma[r2 * width] = old_chroma[r1 * c_width + i + c_size];
+      j = 1;
+    } else {
+      new_chroma[r2 * width + j] = old_chroma[r1 * c_width + i];
+      new_chroma[r2 * width + j + 1] = old_chroma[r1 * c_width + i + c_size];
+      j += 2;
+    }
+    i++;
+    if (i == width / 2) {
+      i = 0;
+      r1++;
+    }
+  }
+}
+
+std::vector<unsigned char> Pattern(size_t size) {
+  std::vector<unsigned char> buffer(size);
+  uint32_t seed = 0x12345678;
+  for (auto &byte : buffer) {
+    seed = seed * 1103515245 + 12345;
+    byte = static_cast<unsigned char>(seed >> 16);
+  }
+  return buffer;
+}
+
+void ExpectConverts(const Frame &frame, unsigned int num_bands) {
+  std::vector<unsigned char> src = Pattern(frame.SrcSize());
+  // Bytes the conversion does not write keep their fill value in both.
+  std::vector<unsigned char> expected(frame.DstSize(), 0xa5);
+  std::vector<unsigned char> actual(frame.DstSize(), 0xa5);
+
+  Reference(frame, src.data(), expected.data());
+  convertYV12Frame(actual.data(), src.data(), frame.stride, frame.width, frame.height,
+                   num_bands);
+  EXPECT_TRUE(expected == actual) << Name(frame) << " in " << num_bands << " bands";
+}
+
+}  // namespace
+
+TEST(YV12Converter, Unpadded) {
+  for (const Frame &frame : {Frame{32, 32, 2}, Frame{64, 64, 48}, Frame{96, 96, 10},
+                             Frame{1920, 1920, 1080}}) {
+    for (unsigned int bands : {1u, 2u, 3u, 4u}) {
+      ExpectConverts(frame, bands);
+    }
+  }
+}
+
+// Chroma rows of the source are padded to 16 bytes, those of the destination are not.
+TEST(YV12Converter, PaddedChroma) {
+  for (const Frame &frame : {Frame{48, 48, 16}, Frame{40, 36, 8}, Frame{176, 176, 144},
+                             Frame{720, 720, 480}, Frame{1920, 1918, 1088},
+                             Frame{2000, 2000, 1100}}) {
+    for (unsigned int bands : {1u, 2u, 3u, 4u}) {
+      ExpectConverts(frame, bands);
+    }
+  }
+}
+
+// Widths that are not a multiple of the vector size leave a scalar tail per row.
+TEST(YV12Converter, VectorTails) {
+  for (unsigned int width = 2; width <= 96; width += 2) {
+    ExpectConverts(Frame{width, width, 6}, 1);
+    ExpectConverts(Frame{width, width, 6}, 3);
+  }
+}
+
+TEST(YV12Converter, OddWidth) {
+  for (const Frame &frame : {Frame{48, 47, 16}, Frame{40, 33, 8}, Frame{1920, 1917, 1080}}) {
+    ExpectConverts(frame, 1);
+    ExpectConverts(frame, 4);
+  }
+}
+
+TEST(YV12Converter, OddHeight) {
+  for (const Frame &frame : {Frame{64, 64, 31}, Frame{48, 46, 15}, Frame{48, 47, 9}}) {
+    ExpectConverts(frame, 1);
+    ExpectConverts(frame, 2);
+  }
+}
+
+// More bands than chroma rows leaves some bands without chroma.
+TEST(YV12Converter, MoreBandsThanRows) {
+  ExpectConverts(Frame{64, 64, 2}, 4);
+  ExpectConverts(Frame{48, 46, 2}, 4);
+  ExpectConverts(Frame{48, 46, 4}, 0);
+}
+
+TEST(YV12Converter, Bands) {
+  EXPECT_EQ(1u, yv12ConvertBands(1280 * 720));
+  EXPECT_EQ(1u, yv12ConvertBands(1920 * 1080 - 1));
+  EXPECT_GE(yv12ConvertBands(1920 * 1080), 1u);
+  EXPECT_LE(yv12ConvertBands(3840 * 2160), 4u);
+}
@@ -1173,6 +1173,12 @@ class DRMManagerInterface {
    */
   virtual int GetConnectorsInfo(DRMConnectorsInfo *info) = 0;
 
+  /*
+   * Pluggable connectors are probed again on their next info query, which may read the EDID.
+   * Meant to be called on hotplug, the info is served from the last probe otherwise.
+   */
+  virtual void InvalidateConnectorsInfo() = 0;
+
   /*
    * Provides information on a selected encoder.
    * [output]: DRMEncoderInfo: Resource info for the given encoder id.
@@ -79,6 +79,7 @@
 #include <iterator>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include "drm_master.h"
 
@@ -90,6 +91,7 @@ using std::begin;
 using std::copy;
 using std::end;
 using std::fill;
+using std::vector;
 
 namespace drm_utils {
 
@@ -190,6 +192,23 @@ int DRMMaster::RemoveFbId(uint32_t fb_id) {
   return ret;
 }
 
+int DRMMaster::RemoveFbIds(const vector<uint32_t> &fb_ids) {
+  lock_guard<mutex> obj(s_lock);
+  int ret = 0;
+#ifdef DRM_IOCTL_MSM_RMFB2
+  for (auto fb_id : fb_ids) {
+    uint32_t id = fb_id;
+    if (drmIoctl(dev_fd_, DRM_IOCTL_MSM_RMFB2, &id)) {
+      DRM_LOGW("drmIoctl::DRM_IOCTL_MSM_RMFB2 failed for fb_id %d with error %d", fb_id, errno);
+      ret = -errno;
+    }
+  }
+#else
+  DRM_LOGW("drmModeRmFB is no longer used. DRM_IOCTL_MSM_RMFB2 not found");
+#endif
+  return ret;
+}
+
 bool DRMMaster::IsRmFbRefCounted() {
 #ifdef DRM_IOCTL_MSM_RMFB2
   return true;
@@ -31,6 +31,7 @@
 #define __DRM_MASTER_H__
 
 #include <mutex>
+#include <vector>
 
 #include "drm_logger.h"
 
@@ -68,6 +69,13 @@ class DRMMaster {
    *   ioctl error code
    */
   int RemoveFbId(uint32_t fb_id);
+  /* Removes a batch of fb_ids from DRM, taking the master lock once
+   * Input:
+   *   fb_ids: DRM FBs to be removed
+   * Returns:
+   *   error code of the last failed ioctl, 0 if all succeeded
+   */
+  int RemoveFbIds(const std::vector<uint32_t> &fb_ids);
   /* Poplulates master DRM fd
    * Input:
    *   fd: Pointer to store master fd into
@@ -362,7 +362,6 @@ void DRMConnectorManager::Update() {
     drmModeConnector *libdrm_conn = drmModeGetConnector(fd_, drmconn.first);
     if (libdrm_conn) {
       conn->InitAndParse(libdrm_conn);
-      conn->SetSkipConnectorReload(true);
       connector_pool_[drmconn.first] = std::move(conn);
     } else {
       DRM_LOGW("Critical error: drmModeGetConnector() failed for connector %u.", drmconn.first);
@@ -372,6 +371,13 @@ void DRMConnectorManager::Update() {
   drmModeFreeResources(resource);
 }
 
+void DRMConnectorManager::InvalidateInfo() {
+  lock_guard<mutex> lock(lock_);
+  for (auto &conn : connector_pool_) {
+    conn.second->InvalidateInfo();
+  }
+}
+
 void DRMConnectorManager::DumpByID(uint32_t id) {
   lock_guard<mutex> lock(lock_);
   connector_pool_[id]->Dump();
@@ -941,10 +947,14 @@ void DRMConnector::ParseCapabilities(uint64_t blob_id, uint64_t *panel_id) {
 
 int DRMConnector::GetInfo(DRMConnectorInfo *info) {
   uint32_t conn_id = drm_connector_->connector_id;
-  if (!skip_connector_reload_ && (IsTVConnector(drm_connector_->connector_type)
-      || (DRM_MODE_CONNECTOR_VIRTUAL == drm_connector_->connector_type))) {
-    // Reload since for some connectors like Virtual and DP, modes may change.
-    drmModeConnectorPtr drm_connector = drmModeGetConnector(fd_, conn_id);
+  bool is_virtual = (DRM_MODE_CONNECTOR_VIRTUAL == drm_connector_->connector_type);
+  if (IsTVConnector(drm_connector_->connector_type) || is_virtual) {
+    // Reload since for some connectors like Virtual and DP, modes may change. A full probe may
+    // read the EDID again, so DP only gets one after a hotplug and otherwise reads the current
+    // state. Virtual connector modes follow the WB configuration and always need a probe.
+    bool probe = is_virtual || probe_pending_;
+    drmModeConnectorPtr drm_connector = probe ? drmModeGetConnector(fd_, conn_id) :
+                                                drmModeGetConnectorCurrent(fd_, conn_id);
     if (!drm_connector) {
       // Connector resource not found. This could happen if a connector is removed before a commit
       // was done on it. Mark the connector as disconnected for graceful teardown. Update 'info'
@@ -958,29 +968,17 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
     }
     drmModeFreeConnector(drm_connector_);
     drm_connector_ = drm_connector;
+    probe_pending_ = false;
   }
 
-  SetSkipConnectorReload(false);  // Reset skip_connector_reload_ setting.
-  info->modes.clear();
   if (!drm_connector_->count_modes) {
     DRM_LOGW("Zero modes on connector %u.", conn_id);
+  } else if (!drm_connector_->modes) {
+    DLOGW("Connector %u not found.", conn_id);
+    info->modes.clear();
+    return 0;
   }
 
-  for (auto i = 0; i < drm_connector_->count_modes; i++) {
-    DRMModeInfo modes_item {};
-    if (!drm_connector_->modes) {
-      DLOGW("Connector %u not found.", conn_id);
-      return 0;
-    }
-    modes_item.mode = drm_connector_->modes[i];
-    info->modes.push_back(modes_item);
-  }
-  info->mmWidth = drm_connector_->mmWidth;
-  info->mmHeight = drm_connector_->mmHeight;
-  info->type = drm_connector_->connector_type;
-  info->type_id = drm_connector_->connector_type_id;
-  info->is_connected = IsConnected();
-
   drmModeObjectProperties *props =
       drmModeObjectGetProperties(fd_, drm_connector_->connector_id, DRM_MODE_OBJECT_CONNECTOR);
   if (!props || !props->props || !props->prop_values) {
@@ -988,65 +986,44 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
     return -ENODEV;
   }
 
-  uint32_t index = UINT32_MAX;
-
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::HDR_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::HDR_PROPERTIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], &info->panel_hdr_prop);
-  }
-
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::CAPABILITIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::CAPABILITIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], info);
-  }
-
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::MODE_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::MODE_PROPERTIES)));
-    if (index < props->count_props)
-      ParseModeProperties(props->prop_values[index], info);
-  }
-
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::EXT_HDR_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::EXT_HDR_PROPERTIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], &info->ext_hdr_prop);
-  }
-
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::TOPOLOGY_CONTROL)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::TOPOLOGY_CONTROL)));
-    info->topology_control = props->prop_values[index];
-  }
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::EDID)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::EDID)));
-    ParseCapabilities(props->prop_values[index], &info->edid);
-  }
+  auto get_value = [this, props](DRMProperty prop_enum, uint64_t *value) {
+    if (!prop_mgr_.IsPropertyAvailable(prop_enum)) {
+      return false;
+    }
+    uint32_t index = std::distance(props->props,
+                                   std::find(props->props, props->props + props->count_props,
+                                             prop_mgr_.GetPropertyId(prop_enum)));
+    if (index >= props->count_props) {
+      return false;
+    }
+    *value = props->prop_values[index];
+    return true;
+  };
+
+  DRMConnectorBlobs blobs;
+  get_value(DRMProperty::CAPABILITIES, &blobs.capabilities);
+  get_value(DRMProperty::HDR_PROPERTIES, &blobs.hdr);
+  get_value(DRMProperty::MODE_PROPERTIES, &blobs.mode_properties);
+  get_value(DRMProperty::EXT_HDR_PROPERTIES, &blobs.ext_hdr);
+  get_value(DRMProperty::EDID, &blobs.edid);
+  get_value(DRMProperty::DEMURA_PANEL_ID, &blobs.panel_id);
+  info_cache_.Update(blobs, drm_connector_->modes, drm_connector_->count_modes,
+                     drm_connector_->connector_type_id, this);
+
+  *info = info_cache_.GetInfo();
+  info->mmWidth = drm_connector_->mmWidth;
+  info->mmHeight = drm_connector_->mmHeight;
+  info->type = drm_connector_->connector_type;
+  info->type_id = drm_connector_->connector_type_id;
+  info->is_connected = IsConnected();
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::SUPPORTED_COLORSPACES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::SUPPORTED_COLORSPACES)));
-    info->supported_colorspaces = props->prop_values[index];
+  uint64_t value = 0;
+  if (get_value(DRMProperty::TOPOLOGY_CONTROL, &value)) {
+    info->topology_control = static_cast<uint32_t>(value);
   }
-
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::DEMURA_PANEL_ID)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::DEMURA_PANEL_ID)));
-    ParseCapabilities(props->prop_values[index], &info->panel_id);
+  value = 0;
+  if (get_value(DRMProperty::SUPPORTED_COLORSPACES, &value)) {
+    info->supported_colorspaces = static_cast<uint32_t>(value);
   }
 
   drmModeFreeObjectProperties(props);
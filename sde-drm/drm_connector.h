@@ -36,10 +36,12 @@
 #include <map>
 #include <memory>
 #include <memory>
+#include <vector>
 #include <drm/msm_drm.h>
 #include <display/drm/sde_drm.h>
 #include <mutex>
 #include <set>
+#include "drm_connector_info_cache.h"
 #include "drm_pp_manager.h"
 
 #include "drm_utils.h"
@@ -47,7 +49,7 @@
 
 namespace sde_drm {
 
-class DRMConnector {
+class DRMConnector : public DRMConnectorBlobParser {
  public:
   explicit DRMConnector(int fd) : fd_(fd) {}
   ~DRMConnector();
@@ -61,24 +63,27 @@ class DRMConnector {
   void Perform(DRMOps code, drmModeAtomicReq *req, va_list args);
   int IsConnected() { return (DRM_MODE_CONNECTED == drm_connector_->connection); }
   int GetPossibleEncoders(std::set<uint32_t> *possible_encoders);
-  void SetSkipConnectorReload(bool skip_reload) { skip_connector_reload_ = skip_reload; };
+  // Makes the next GetInfo probe pluggable connectors again, meant to be called on hotplug.
+  void InvalidateInfo() { probe_pending_ = true; }
   void Dump();
 
  private:
   void ParseProperties();
-  void ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info);
-  void ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties *hdr_info);
-  void ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info);
-  void ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_properties *hdr_info);
-  void ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edid);
-  void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id);
+  // DRMConnectorBlobParser methods.
+  void ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info) override;
+  void ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties *hdr_info) override;
+  void ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info) override;
+  void ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_properties *hdr_info) override;
+  void ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edid) override;
+  void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id) override;
   void SetROI(drmModeAtomicReq *req, uint32_t obj_id, uint32_t num_roi,
               DRMRect *conn_rois);
 
   int fd_ = -1;
   drmModeConnector *drm_connector_ = {};
   DRMPropertyManager prop_mgr_ {};
-  bool skip_connector_reload_ = false; //  Usually set to true for new TV/pluggable displays.
+  bool probe_pending_ = false;  // Set on hotplug for TV/pluggable displays.
+  DRMConnectorInfoCache info_cache_ {};
   DRMStatus status_ = DRMStatus::FREE;
   std::unique_ptr<DRMPPManager> pp_mgr_{};
 #ifdef SDE_MAX_ROI_V1
@@ -91,6 +96,8 @@ class DRMConnectorManager {
   explicit DRMConnectorManager(int fd) : fd_(fd) {}
   void Init(drmModeRes *res);
   void Update();
+  // Has pluggable connectors probed again on their next GetConnectorInfo.
+  void InvalidateInfo();
   void DeInit() {}
   void DumpAll();
   void DumpByID(uint32_t id);
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string.h>
+
+#include "drm_connector_info_cache.h"
+
+namespace sde_drm {
+
+bool DRMConnectorInfoCache::HasSameModes(const drmModeModeInfo *modes, int count_modes) const {
+  return (drm_modes_.size() == static_cast<size_t>(count_modes)) &&
+         (drm_modes_.empty() || !memcmp(drm_modes_.data(), modes,
+                                        drm_modes_.size() * sizeof(drmModeModeInfo)));
+}
+
+void DRMConnectorInfoCache::Update(const DRMConnectorBlobs &blobs, const drmModeModeInfo *modes,
+                                   int count_modes, uint32_t type_id,
+                                   DRMConnectorBlobParser *parser) {
+  // Capabilities are spread over the whole info, start over when they change.
+  if (!valid_ || blobs_.capabilities != blobs.capabilities) {
+    *this = {};
+    if (blobs.capabilities) {
+      parser->ParseCapabilities(blobs.capabilities, &info_);
+    }
+  }
+
+  if (!valid_ || blobs_.hdr != blobs.hdr) {
+    info_.panel_hdr_prop = {};
+    if (blobs.hdr) {
+      parser->ParseCapabilities(blobs.hdr, &info_.panel_hdr_prop);
+    }
+  }
+
+  if (!valid_ || blobs_.mode_properties != blobs.mode_properties ||
+      !HasSameModes(modes, count_modes)) {
+    info_.type_id = type_id;
+    info_.modes.clear();
+    for (auto i = 0; i < count_modes; i++) {
+      DRMModeInfo modes_item {};
+      modes_item.mode = modes[i];
+      info_.modes.push_back(modes_item);
+    }
+    if (blobs.mode_properties) {
+      parser->ParseModeProperties(blobs.mode_properties, &info_);
+    }
+    drm_modes_.assign(modes, modes + count_modes);
+  }
+
+  if (!valid_ || blobs_.ext_hdr != blobs.ext_hdr) {
+    info_.ext_hdr_prop = {};
+    if (blobs.ext_hdr) {
+      parser->ParseCapabilities(blobs.ext_hdr, &info_.ext_hdr_prop);
+    }
+  }
+
+  if (!valid_ || blobs_.edid != blobs.edid) {
+    info_.edid.clear();
+    if (blobs.edid) {
+      parser->ParseCapabilities(blobs.edid, &info_.edid);
+    }
+  }
+
+  if (!valid_ || blobs_.panel_id != blobs.panel_id) {
+    info_.panel_id = 0;
+    if (blobs.panel_id) {
+      parser->ParseCapabilities(blobs.panel_id, &info_.panel_id);
+    }
+  }
+
+  blobs_ = blobs;
+  valid_ = true;
+}
+
+}  // namespace sde_drm
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DRM_CONNECTOR_INFO_CACHE_H__
+#define __DRM_CONNECTOR_INFO_CACHE_H__
+
+#include <drm_interface.h>
+#include <xf86drmMode.h>
+#include <vector>
+
+namespace sde_drm {
+
+// Ids of the blobs the connector info is parsed from, 0 for a blob the connector does not have.
+struct DRMConnectorBlobs {
+  uint64_t capabilities = 0;
+  uint64_t hdr = 0;
+  uint64_t mode_properties = 0;
+  uint64_t ext_hdr = 0;
+  uint64_t edid = 0;
+  uint64_t panel_id = 0;
+};
+
+// Parses the content of the connector blobs, read from the driver by DRMConnector.
+class DRMConnectorBlobParser {
+ public:
+  virtual void ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info) = 0;
+  virtual void ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties *hdr_info) = 0;
+  virtual void ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info) = 0;
+  virtual void ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_properties *hdr_info) = 0;
+  virtual void ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edid) = 0;
+  virtual void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id) = 0;
+
+ protected:
+  virtual ~DRMConnectorBlobParser() {}
+};
+
+// Info parsed from the connector blobs. Each part is parsed again only when the id of the blob
+// it comes from changes; the driver replaces a blob instead of updating it in place.
+class DRMConnectorInfoCache {
+ public:
+  // Brings the info up to date with the blobs and modes of the connector as last read.
+  void Update(const DRMConnectorBlobs &blobs, const drmModeModeInfo *modes, int count_modes,
+              uint32_t type_id, DRMConnectorBlobParser *parser);
+  const DRMConnectorInfo &GetInfo() const { return info_; }
+
+ private:
+  bool HasSameModes(const drmModeModeInfo *modes, int count_modes) const;
+
+  bool valid_ = false;
+  DRMConnectorBlobs blobs_ = {};
+  std::vector<drmModeModeInfo> drm_modes_;
+  DRMConnectorInfo info_ = {};
+};
+
+}  // namespace sde_drm
+
+#endif  // __DRM_CONNECTOR_INFO_CACHE_H__
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "drm_connector_info_cache.h"
+
+namespace sde_drm {
+
+namespace {
+
+const uint32_t kModeCount = 24;
+
+// Parses text blobs shaped like the ones of a DP connector, with a line of properties per mode.
+class TextBlobParser : public DRMConnectorBlobParser {
+ public:
+  TextBlobParser() {
+    for (uint32_t i = 0; i < kModeCount; i++) {
+      mode_properties_ += "mode_name=" + std::to_string(i) + "\ndsc_enabled=0\nbit_clk_rate=" +
+                          std::to_string(540000000 + i) + "\ntopology=2\n";
+    }
+    capabilities_ = "display type=secondary\nmax_linewidth=4096\nqsync_support=true\n";
+  }
+
+  void ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info) override {
+    info->max_linewidth = static_cast<uint32_t>(Parse(capabilities_));
+  }
+
+  void ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties *hdr_info) override {}
+
+  void ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info) override {
+    size_t lines = Parse(mode_properties_);
+    for (auto &mode : info->modes) {
+      mode.curr_compression_mode = static_cast<uint32_t>(lines);
+    }
+  }
+
+  void ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_properties *hdr_info) override {}
+
+  void ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edid) override {
+    edid->assign(256, static_cast<uint8_t>(blob_id));
+  }
+
+  void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id) override { *panel_id = blob_id; }
+
+ private:
+  static size_t Parse(const std::string &blob) {
+    std::stringstream stream(blob);
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(stream, line)) {
+      lines += (line.find('=') != std::string::npos);
+    }
+    return lines;
+  }
+
+  std::string capabilities_;
+  std::string mode_properties_;
+};
+
+}  // namespace
+
+// GetInfo on each event of a hotplug storm. changed is what the driver replaced between two
+// events: 0 nothing, 1 the EDID blob, 2 the capabilities blob, which is parsed as if uncached.
+static void BM_HotplugStorm(benchmark::State &state) {
+  TextBlobParser parser;
+  DRMConnectorInfoCache cache;
+  std::vector<drmModeModeInfo> modes(kModeCount);
+  for (uint32_t i = 0; i < kModeCount; i++) {
+    modes[i].hdisplay = static_cast<uint16_t>(3840 - i);
+    modes[i].vdisplay = 2160;
+  }
+
+  DRMConnectorBlobs blobs;
+  blobs.capabilities = 1;
+  blobs.mode_properties = 2;
+  blobs.edid = 3;
+  for (auto _ : state) {
+    if (state.range(0) == 1) {
+      blobs.edid++;
+    } else if (state.range(0) == 2) {
+      blobs.capabilities++;
+    }
+    cache.Update(blobs, modes.data(), kModeCount, 1, &parser);
+    benchmark::DoNotOptimize(cache.GetInfo());
+  }
+}
+BENCHMARK(BM_HotplugStorm)->ArgName("changed")->Arg(0)->Arg(1)->Arg(2);
+
+}  // namespace sde_drm
+
+BENCHMARK_MAIN();
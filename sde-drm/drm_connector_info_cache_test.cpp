@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "drm_connector_info_cache.h"
+
+namespace sde_drm {
+
+namespace {
+
+// Stands in for the driver: the content parsed from a blob is derived from its id, and the
+// parses of each kind of blob are counted.
+class FakeBlobParser : public DRMConnectorBlobParser {
+ public:
+  void ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info) override {
+    capabilities_++;
+    info->max_linewidth = static_cast<uint32_t>(blob_id);
+  }
+
+  void ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties *hdr_info) override {
+    hdr_++;
+  }
+
+  void ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info) override {
+    mode_properties_++;
+    for (auto &mode : info->modes) {
+      mode.curr_compression_mode = static_cast<uint32_t>(blob_id);
+    }
+  }
+
+  void ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_properties *hdr_info) override {
+    ext_hdr_++;
+  }
+
+  void ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edid) override {
+    edid_++;
+    edid->assign(128, static_cast<uint8_t>(blob_id));
+  }
+
+  void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id) override {
+    panel_id_++;
+    *panel_id = blob_id;
+  }
+
+  uint32_t total() {
+    return capabilities_ + hdr_ + mode_properties_ + ext_hdr_ + edid_ + panel_id_;
+  }
+
+  uint32_t capabilities_ = 0;
+  uint32_t hdr_ = 0;
+  uint32_t mode_properties_ = 0;
+  uint32_t ext_hdr_ = 0;
+  uint32_t edid_ = 0;
+  uint32_t panel_id_ = 0;
+};
+
+// A pluggable connector with all its blobs.
+DRMConnectorBlobs GetBlobs() {
+  DRMConnectorBlobs blobs;
+  blobs.capabilities = 10;
+  blobs.hdr = 11;
+  blobs.mode_properties = 12;
+  blobs.ext_hdr = 13;
+  blobs.edid = 14;
+  blobs.panel_id = 15;
+  return blobs;
+}
+
+std::vector<drmModeModeInfo> GetModes(uint32_t count) {
+  std::vector<drmModeModeInfo> modes(count);
+  for (uint32_t i = 0; i < count; i++) {
+    modes[i].hdisplay = static_cast<uint16_t>(1920 - i);
+    modes[i].vdisplay = 1080;
+    modes[i].vrefresh = 60;
+  }
+  return modes;
+}
+
+class DRMConnectorInfoCacheTest : public ::testing::Test {
+ protected:
+  void Update(const DRMConnectorBlobs &blobs) {
+    cache_.Update(blobs, modes_.data(), static_cast<int>(modes_.size()), 1, &parser_);
+  }
+
+  FakeBlobParser parser_;
+  DRMConnectorInfoCache cache_;
+  std::vector<drmModeModeInfo> modes_ = GetModes(3);
+};
+
+}  // namespace
+
+TEST_F(DRMConnectorInfoCacheTest, FirstUpdateParsesAll) {
+  Update(GetBlobs());
+  EXPECT_EQ(6u, parser_.total());
+
+  const DRMConnectorInfo &info = cache_.GetInfo();
+  EXPECT_EQ(10u, info.max_linewidth);
+  ASSERT_EQ(3u, info.modes.size());
+  EXPECT_EQ(1919, info.modes[1].mode.hdisplay);
+  EXPECT_EQ(12u, info.modes[1].curr_compression_mode);
+  EXPECT_EQ(std::vector<uint8_t>(128, 14), info.edid);
+  EXPECT_EQ(15u, info.panel_id);
+  EXPECT_EQ(1u, info.type_id);
+}
+
+// Repeated queries, as on a storm of hotplug events that changed nothing, parse no blob.
+TEST_F(DRMConnectorInfoCacheTest, UnchangedBlobsAreNotParsed) {
+  Update(GetBlobs());
+  for (int i = 0; i < 100; i++) {
+    Update(GetBlobs());
+  }
+  EXPECT_EQ(6u, parser_.total());
+  EXPECT_EQ(std::vector<uint8_t>(128, 14), cache_.GetInfo().edid);
+}
+
+// A new sink brings a new EDID blob, only the EDID is parsed again.
+TEST_F(DRMConnectorInfoCacheTest, ChangedBlobIsParsedAlone) {
+  Update(GetBlobs());
+  DRMConnectorBlobs blobs = GetBlobs();
+  blobs.edid = 24;
+  Update(blobs);
+
+  EXPECT_EQ(2u, parser_.edid_);
+  EXPECT_EQ(7u, parser_.total());
+  EXPECT_EQ(std::vector<uint8_t>(128, 24), cache_.GetInfo().edid);
+  EXPECT_EQ(15u, cache_.GetInfo().panel_id);
+}
+
+TEST_F(DRMConnectorInfoCacheTest, CapabilitiesChangeParsesAll) {
+  Update(GetBlobs());
+  DRMConnectorBlobs blobs = GetBlobs();
+  blobs.capabilities = 20;
+  Update(blobs);
+
+  EXPECT_EQ(12u, parser_.total());
+  EXPECT_EQ(20u, cache_.GetInfo().max_linewidth);
+}
+
+// The mode properties are parsed against the modes, new modes need them parsed again.
+TEST_F(DRMConnectorInfoCacheTest, ModesChangeParsesModeProperties) {
+  Update(GetBlobs());
+  modes_ = GetModes(5);
+  Update(GetBlobs());
+
+  EXPECT_EQ(2u, parser_.mode_properties_);
+  EXPECT_EQ(7u, parser_.total());
+  ASSERT_EQ(5u, cache_.GetInfo().modes.size());
+  EXPECT_EQ(12u, cache_.GetInfo().modes[4].curr_compression_mode);
+
+  modes_[2].vrefresh = 30;
+  Update(GetBlobs());
+  EXPECT_EQ(3u, parser_.mode_properties_);
+  EXPECT_EQ(30u, cache_.GetInfo().modes[2].mode.vrefresh);
+}
+
+// A blob gone with the sink leaves its part of the info empty.
+TEST_F(DRMConnectorInfoCacheTest, RemovedBlobClearsInfo) {
+  Update(GetBlobs());
+  DRMConnectorBlobs blobs = GetBlobs();
+  blobs.edid = 0;
+  blobs.panel_id = 0;
+  Update(blobs);
+
+  EXPECT_EQ(6u, parser_.total());
+  EXPECT_TRUE(cache_.GetInfo().edid.empty());
+  EXPECT_EQ(0u, cache_.GetInfo().panel_id);
+}
+
+TEST_F(DRMConnectorInfoCacheTest, NoModes) {
+  modes_.clear();
+  cache_.Update(GetBlobs(), nullptr, 0, 1, &parser_);
+  EXPECT_TRUE(cache_.GetInfo().modes.empty());
+  cache_.Update(GetBlobs(), nullptr, 0, 1, &parser_);
+  EXPECT_EQ(1u, parser_.mode_properties_);
+}
+
+}  // namespace sde_drm
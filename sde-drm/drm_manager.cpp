@@ -171,6 +171,10 @@ int DRMManager::GetConnectorsInfo(DRMConnectorsInfo *infos) {
   return ret;
 }
 
+void DRMManager::InvalidateConnectorsInfo() {
+  conn_mgr_->InvalidateInfo();
+}
+
 int DRMManager::GetEncoderInfo(uint32_t encoder_id, DRMEncoderInfo *info) {
   *info = {};
   return encoder_mgr_->GetEncoderInfo(encoder_id, info);
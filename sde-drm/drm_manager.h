@@ -56,6 +56,7 @@ class DRMManager : public DRMManagerInterface {
   virtual int GetCrtcInfo(uint32_t crtc_id, DRMCrtcInfo *info);
   virtual int GetConnectorInfo(uint32_t conn_id, DRMConnectorInfo *info);
   virtual int GetConnectorsInfo(DRMConnectorsInfo *infos);
+  virtual void InvalidateConnectorsInfo();
   virtual int GetEncoderInfo(uint32_t encoder_id, DRMEncoderInfo *info);
   virtual int GetEncodersInfo(DRMEncodersInfo *infos);
   virtual void GetCrtcPPInfo(uint32_t crtc_id, DRMPPFeatureInfo *info);
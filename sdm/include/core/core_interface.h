@@ -289,6 +289,15 @@ class CoreInterface {
   */
   virtual DisplayError GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) = 0;
 
+  /*! @brief Method to notify a hot-plug event.
+
+    @details Client shall call this method when it is told of a hot-plug event, before calling
+    GetDisplaysStatus. Pluggable displays are probed again on the next query of their status,
+    which is otherwise served from the last probe. Does nothing by default, so that existing
+    implementations of this interface keep building.
+  */
+  virtual void NotifyHotplug() { }
+
   /*! @brief Method to get the maximum supported number of concurrent displays of a particular type.
 
     @details Client shall use this method to get the maximum number of DisplayInterface instances
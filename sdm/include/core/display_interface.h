@@ -201,6 +201,8 @@ enum DisplayEvent {
   kPostIdleTimeout,         // Event triggered after entering idle.
   kVmReleaseDone,           // Event triggered after releasing the mdp hw to secondary vm.
   kDumpStacktrace,          // Event triggered by commit thread to dump stack trace.
+  kResourcesReleased,       // Event triggered after a commit released the resources that a
+                            // display was waiting for.
 };
 
 /*! @brief This enum represents the secure events received by Display HAL. */
@@ -1309,6 +1311,17 @@ class DisplayInterface {
   */
   virtual DisplayError PostHandleSecureEvent(SecureEvent secure_event) = 0;
 
+  /*! @brief Method to prepare the framebuffer object of a buffer ahead of its first commit.
+
+    @details This is a hint, the framebuffer object is created on a worker thread and is picked up
+    by the commit that the buffer is first used in. It does not block on the display lock.
+
+    @param[in] buffer \link LayerBuffer \endlink
+
+    @return \link DisplayError \endlink
+  */
+  virtual DisplayError PrefetchBuffer(const LayerBuffer &buffer) = 0;
+
   virtual void Abort() = 0;
 
  protected:
@@ -807,6 +807,13 @@ enum UpdateType {
   kUpdateMax,
 };
 
+struct HWFbIdStats {
+  uint64_t prefetched = 0;  // fb_ids created ahead of the commit.
+  uint64_t hits = 0;        // Commits that found the fb_id prefetched.
+  uint64_t misses = 0;      // Commits that had to create the fb_id.
+  uint64_t removed = 0;     // fb_ids removed by the worker, for all displays.
+};
+
 struct HWLayersInfo {
   uint32_t app_layer_count = 0;      // Total number of app layers. Must not be 0.
   int32_t gpu_target_index = -1;     // GPU target layer index. -1 if not present.
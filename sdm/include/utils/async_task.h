@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __ASYNC_TASK_H__
+#define __ASYNC_TASK_H__
+
+#include <algorithm>
+#include <condition_variable>   // NOLINT
+#include <deque>
+#include <future>   // NOLINT
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sdm {
+
+// Companion of SyncTask for work the caller does not need to wait for. Tasks are queued to a
+// worker thread and run in order. PostTask returns as soon as the task is queued, or blocks while
+// max_pending tasks are already queued. Completion of each task is reported through the returned
+// future. The handler can hand out a Fence through its task context for GPU work that is still
+// in flight once OnTask returns.
+template <class TaskCode>
+class AsyncTask {
+ public:
+  // This class need to be overridden by caller to pass on a task context.
+  class TaskContext {
+   public:
+    virtual ~TaskContext() { }
+  };
+
+  // Methods to callback into caller for command codes executions in worker thread.
+  class TaskHandler {
+   public:
+    virtual ~TaskHandler() { }
+    virtual void OnTask(const TaskCode &task_code, TaskContext *task_context) = 0;
+    // Called for consecutive queued tasks with the same code when batching is enabled, so that
+    // the handler can submit them at once. By default the tasks are run one by one.
+    virtual void OnTaskBatch(const TaskCode &task_code,
+                             const std::vector<TaskContext *> &task_contexts) {
+      for (auto task_context : task_contexts) {
+        OnTask(task_code, task_context);
+      }
+    }
+  };
+
+  AsyncTask(TaskHandler &task_handler, uint32_t max_pending, bool batching = false)
+    : task_handler_(task_handler), max_pending_(std::max(max_pending, 1U)), batching_(batching) {
+    std::thread worker_thread(AsyncTaskThread, this);
+    worker_thread_.swap(worker_thread);
+  }
+
+  // Tasks that have not started yet are cancelled, the running one is waited for. Callers blocked
+  // in PostTask or Flush are released, and waited for until they have left.
+  ~AsyncTask() {
+    std::deque<Task> cancelled;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      exit_ = true;
+      cancelled.swap(queue_);
+      worker_cv_.notify_one();
+      caller_cv_.notify_all();
+    }
+    Cancel(&cancelled);
+    worker_thread_.join();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    caller_cv_.wait(lock, [this] { return !waiters_; });
+  }
+
+  // Ownership of the task context is shared with the queue until the task has run. The future
+  // becomes true once the task has run, or false if it was cancelled. Once the destructor has
+  // started, tasks are not queued anymore and the future is false right away.
+  std::future<bool> PostTask(const TaskCode &task_code,
+                             const std::shared_ptr<TaskContext> &task_context) {
+    Task task;
+    task.task_code = task_code;
+    task.task_context = task_context;
+    std::future<bool> done = task.done.get_future();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Wait(&lock, [this] { return queue_.size() < max_pending_; });
+    if (exit_) {
+      task.done.set_value(false);
+      return done;
+    }
+
+    queue_.push_back(std::move(task));
+    worker_cv_.notify_one();
+
+    return done;
+  }
+
+  // Blocks until all tasks queued so far have run, or were cancelled by the destructor.
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Wait(&lock, [this] { return queue_.empty() && !running_; });
+  }
+
+  // Drops the tasks that have not started yet and returns how many were dropped.
+  size_t CancelPending() {
+    std::deque<Task> cancelled;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cancelled.swap(queue_);
+      caller_cv_.notify_all();
+    }
+    size_t count = cancelled.size();
+    Cancel(&cancelled);
+
+    return count;
+  }
+
+  size_t GetPendingCount() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return queue_.size() + (running_ ? 1 : 0);
+  }
+
+ private:
+  struct Task {
+    TaskCode task_code;
+    std::shared_ptr<TaskContext> task_context;
+    std::promise<bool> done;
+  };
+
+  static void AsyncTaskThread(AsyncTask *async_task) {
+    if (async_task) {
+      async_task->OnThreadCallback();
+    }
+  }
+
+  // Waits on caller_cv_ until ready returns true or the destructor has started, accounted in
+  // waiters_ so that the destructor does not return while a caller is still inside.
+  template <class Predicate>
+  void Wait(std::unique_lock<std::mutex> *lock, Predicate ready) {
+    waiters_++;
+    caller_cv_.wait(*lock, [this, &ready] { return exit_ || ready(); });
+    waiters_--;
+    if (exit_) {
+      caller_cv_.notify_all();
+    }
+  }
+
+  // Contexts of cancelled tasks are released outside the lock, their destructors are caller code.
+  static void Cancel(std::deque<Task> *tasks) {
+    for (auto &task : *tasks) {
+      task.done.set_value(false);
+    }
+    tasks->clear();
+  }
+
+  void OnThreadCallback() {
+    std::vector<Task> batch;
+    std::vector<TaskContext *> task_contexts;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      worker_cv_.wait(lock, [this] { return exit_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        break;
+      }
+
+      // Take the next task, along with the ones following it for the same code when batching.
+      do {
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      } while (batching_ && !queue_.empty() && (queue_.front().task_code == batch[0].task_code));
+      running_ = true;
+      lock.unlock();
+      caller_cv_.notify_all();
+
+      // Call task handler which is implemented by the caller.
+      if (batch.size() == 1) {
+        task_handler_.OnTask(batch[0].task_code, batch[0].task_context.get());
+      } else {
+        for (auto &task : batch) {
+          task_contexts.push_back(task.task_context.get());
+        }
+        task_handler_.OnTaskBatch(batch[0].task_code, task_contexts);
+        task_contexts.clear();
+      }
+
+      for (auto &task : batch) {
+        task.done.set_value(true);
+      }
+      batch.clear();
+
+      lock.lock();
+      running_ = false;
+      caller_cv_.notify_all();
+    }
+  }
+
+  TaskHandler &task_handler_;
+  const size_t max_pending_;
+  const bool batching_;
+  std::thread worker_thread_;
+  std::mutex mutex_;
+  std::condition_variable caller_cv_;
+  std::condition_variable worker_cv_;
+  std::deque<Task> queue_;
+  uint32_t waiters_ = 0;
+  bool running_ = false;
+  bool exit_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __ASYNC_TASK_H__
@@ -58,7 +58,7 @@ class SyncTask {
     std::unique_lock<std::mutex> caller_lock(caller_mutex_);
     std::thread worker_thread(SyncTaskThread, this);
     worker_thread_.swap(worker_thread);
-    caller_cv_.wait(caller_lock);
+    caller_cv_.wait(caller_lock, [this] { return worker_ready_; });
   }
 
   ~SyncTask() {
@@ -83,11 +83,12 @@ class SyncTask {
       task_context_ = task_context;
       worker_thread_exit_ = terminate;
       pending_code_ = true;
+      task_done_ = false;
       worker_cv_.notify_one();
     }
 
     // Wait for worker thread to finish and signal.
-    caller_cv_.wait(caller_lock);
+    caller_cv_.wait(caller_lock, [this] { return task_done_; });
   }
 
   static void SyncTaskThread(SyncTask *sync_task) {
@@ -106,6 +107,7 @@ class SyncTask {
     {
       // Signal caller thread that worker thread is ready to listen to events.
       std::unique_lock<std::mutex> caller_lock(caller_mutex_);
+      worker_ready_ = true;
       caller_cv_.notify_one();
     }
 
@@ -122,6 +124,7 @@ class SyncTask {
       pending_code_ = false;
       // Notify completion of current task to the caller thread which is blocked.
       std::unique_lock<std::mutex> caller_lock(caller_mutex_);
+      task_done_ = true;
       caller_cv_.notify_one();
     }
   }
@@ -136,6 +139,9 @@ class SyncTask {
   std::condition_variable worker_cv_;
   bool worker_thread_exit_ = false;
   bool pending_code_ = false;
+  // Guarded by caller_mutex_, so that a spurious wakeup of the caller is told apart from a signal.
+  bool worker_ready_ = false;
+  bool task_done_ = false;
 };
 
 }  // namespace sdm
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __VSYNC_MODEL_H__
+#define __VSYNC_MODEL_H__
+
+#include <stdint.h>
+#include <vector>
+
+namespace sdm {
+
+// Estimates vsync period and phase from hardware vsync timestamps, so that vsync can be predicted
+// while hardware vsync is off. Timestamps need not be consecutive vsyncs, missed vsyncs are
+// accounted for by rounding to the nearest multiple of the period.
+// Not thread safe.
+class VSyncModel {
+ public:
+  static constexpr uint32_t kDefaultHistory = 12;
+  static constexpr uint32_t kMinSamples = 6;
+
+  explicit VSyncModel(int64_t error_threshold_ns, uint32_t history = kDefaultHistory);
+
+  // Drops the samples. The nominal period is the starting point of the estimate, and samples
+  // further than error_threshold_ns from it are rejected.
+  void Reset(int64_t nominal_period_ns);
+  // Returns false if the sample deviates from the prediction by more than the error threshold.
+  // The model is then restarted from this sample.
+  bool AddSample(int64_t timestamp_ns);
+  // Enough samples fit the model within the error threshold for it to be used for prediction.
+  bool IsLocked() const { return locked_; }
+  int64_t GetPeriod() const { return period_ns_; }
+  // Returns the first predicted vsync after time_ns.
+  int64_t GetNextVSync(int64_t time_ns) const;
+  // Returns the deviation of timestamp_ns from the closest predicted vsync.
+  int64_t GetError(int64_t timestamp_ns) const;
+  // Returns how far ahead of the latest sample predictions are expected to stay within half the
+  // error threshold, given the uncertainty of the fitted period. 0 while the model is not locked.
+  int64_t GetPredictionHorizon() const;
+
+ private:
+  void Fit();
+
+  const int64_t error_threshold_ns_;
+  const uint32_t history_;
+  int64_t nominal_period_ns_ = 0;
+  int64_t period_ns_ = 0;
+  int64_t phase_ns_ = 0;  // Timestamp of a predicted vsync.
+  double period_error_ns_ = 0.0;  // Standard error of the fitted period.
+  std::vector<int64_t> samples_;
+  uint32_t next_sample_ = 0;
+  bool locked_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __VSYNC_MODEL_H__
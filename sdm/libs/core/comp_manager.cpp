@@ -224,6 +224,7 @@ DisplayError CompManager::UnregisterDisplay(Handle display_ctx) {
 
   registered_displays_.erase(display_comp_ctx->display_id);
   powered_on_displays_.erase(display_comp_ctx->display_id);
+  resource_waiters_.erase(display_comp_ctx);
 
   DLOGV_IF(kTagCompManager, "Registered displays [%s], display %d-%d",
            StringDisplayList(registered_displays_).c_str(), display_comp_ctx->display_id,
@@ -470,7 +471,8 @@ DisplayError CompManager::Commit(Handle display_ctx, DispLayerStack *disp_layer_
   return kErrorNone;
 }
 
-DisplayError CompManager::PostCommit(Handle display_ctx, DispLayerStack *disp_layer_stack) {
+DisplayError CompManager::PostCommit(Handle display_ctx, DispLayerStack *disp_layer_stack,
+                                     bool *resources_released) {
   std::lock_guard<std::recursive_mutex> obj(comp_mgr_mutex_);
 
   DisplayError error = kErrorNone;
@@ -482,6 +484,26 @@ DisplayError CompManager::PostCommit(Handle display_ctx, DispLayerStack *disp_la
     return error;
   }
 
+  // Resources are handed over once the commit that stops using them is done, check whether this
+  // was the one the waiting displays need.
+  *resources_released = false;
+  for (auto it = resource_waiters_.begin(); it != resource_waiters_.end();) {
+    bool res_exhausted = false;
+    bool res_wait_needed = false;
+    resource_intf_->Perform(ResourceInterface::kCmdGetResourceStatus,
+                            it->first->display_resource_ctx, &res_exhausted, &it->second,
+                            &res_wait_needed);
+    if (res_exhausted || res_wait_needed) {
+      it++;
+      continue;
+    }
+
+    DLOGI("Resources released for display %d-%d by display %d-%d", it->first->display_id,
+          it->first->display_type, display_comp_ctx->display_id, display_comp_ctx->display_type);
+    *resources_released = true;
+    it = resource_waiters_.erase(it);
+  }
+
   display_comp_ctx->idle_fallback = false;
   display_comp_ctx->first_cycle_ = false;
   display_comp_ctx->constraints.idle_timeout = false;
@@ -770,6 +792,12 @@ bool CompManager::CheckResourceState(Handle display_ctx, bool *res_exhausted,
   resource_intf_->Perform(ResourceInterface::kCmdGetResourceStatus,
                           display_comp_ctx->display_resource_ctx, res_exhausted, &attr,
                           &res_wait_needed);
+  if (res_wait_needed || *res_exhausted) {
+    resource_waiters_[display_comp_ctx] = attr;
+  } else {
+    resource_waiters_.erase(display_comp_ctx);
+  }
+
   return res_wait_needed;
 }
 
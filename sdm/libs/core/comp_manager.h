@@ -69,7 +69,8 @@ class CompManager {
   DisplayError Prepare(Handle display_ctx, DispLayerStack *disp_layer_stack);
   DisplayError Commit(Handle display_ctx, DispLayerStack *disp_layer_stack);
   DisplayError PostPrepare(Handle display_ctx, DispLayerStack *disp_layer_stack);
-  DisplayError PostCommit(Handle display_ctx, DispLayerStack *disp_layer_stack);
+  DisplayError PostCommit(Handle display_ctx, DispLayerStack *disp_layer_stack,
+                          bool *resources_released);
   void Purge(Handle display_ctx);
   DisplayError SetIdleTimeoutMs(Handle display_ctx, uint32_t active_ms, uint32_t inactive_ms);
   void ProcessIdleTimeout(Handle display_ctx);
@@ -150,6 +151,8 @@ class CompManager {
   std::set<int32_t> registered_displays_;  // List of registered displays
   std::set<int32_t> configured_displays_;  // List of sucessfully configured displays
   std::set<int32_t> powered_on_displays_;  // List of powered on displays.
+  // Displays found waiting for resources by CheckResourceState, with the attributes to check with.
+  std::map<DisplayCompositionContext *, HWDisplayAttributes> resource_waiters_;
   bool safe_mode_ = false;              // Flag to notify all displays to be in resource crunch
                                         // mode, where strategy manager chooses the best strategy
                                         // that uses optimal number of pipes for each display
@@ -402,6 +402,11 @@ DisplayError CoreImpl::GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) {
   return error;
 }
 
+void CoreImpl::NotifyHotplug() {
+  SCOPE_LOCK(locker_);
+  hw_info_intf_->NotifyHotplug();
+}
+
 DisplayError CoreImpl::GetMaxDisplaysSupported(DisplayType type, int32_t *max_displays) {
   SCOPE_LOCK(locker_);
   return hw_info_intf_->GetMaxDisplaysSupported(type, max_displays);
@@ -64,7 +64,9 @@
  */
 
 #include <stdio.h>
+#include <inttypes.h>
 #include <malloc.h>
+#include <time.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <utils/formats.h>
@@ -81,6 +83,7 @@
 
 #include "display_base.h"
 #include "hw_info_interface.h"
+#include "input_fence_monitor.h"
 
 #define __CLASS__ "DisplayBase"
 
@@ -258,6 +261,24 @@ DisplayError DisplayBase::Init() {
   track_input_fences_ = (prop == 1);
   DLOGI("track_input_fences_:%d %d-%d", track_input_fences_, display_id_, display_type_);
 
+  // Lateness stats cost a poll and a dup per layer and commit, only on request. Stuck fence stack
+  // dumps need the monitor too.
+  prop = 0;
+  Debug::GetProperty(ENABLE_INPUT_FENCE_MONITOR, &prop);
+  monitor_input_fences_ = (prop == 1) || track_input_fences_;
+
+  MixerResolutionController::Config mixer_config;
+  if (Debug::GetProperty(MIXER_RECONFIG_STABLE_FRAMES, &prop) == kErrorNone) {
+    mixer_config.stable_frames = UINT32(prop);
+  }
+  if (Debug::GetProperty(MIXER_RECONFIG_STABLE_MS, &prop) == kErrorNone) {
+    mixer_config.stable_ms = UINT32(prop);
+  }
+  if (Debug::GetProperty(MIXER_RECONFIG_MIN_INTERVAL_MS, &prop) == kErrorNone) {
+    mixer_config.min_interval_ms = UINT32(prop);
+  }
+  mixer_controller_.SetConfig(mixer_config);
+
   return kErrorNone;
 
 CleanupOnError:
@@ -360,6 +381,10 @@ void DisplayBase::GenerateBorderLayers(const std::vector<LayerRect> &border_rect
 }
 
 DisplayError DisplayBase::Deinit() {
+  if (monitor_input_fences_ && InputFenceMonitor::GetInstance()) {
+    InputFenceMonitor::GetInstance()->RemoveDisplay(display_id_);
+  }
+
   {  // Scope for lock
     ClientLock lock(disp_mutex_);
     ClearColorInfo();
@@ -1602,11 +1627,17 @@ DisplayError DisplayBase::PostCommit(HWLayersInfo *hw_layers_info) {
     comp_manager_->ControlPartialUpdate(display_comp_ctx_, true /* enable */);
   }
 
-  DisplayError error = comp_manager_->PostCommit(display_comp_ctx_, &disp_layer_stack_);
+  bool resources_released = false;
+  DisplayError error = comp_manager_->PostCommit(display_comp_ctx_, &disp_layer_stack_,
+                                                 &resources_released);
   if (error != kErrorNone) {
     return error;
   }
 
+  if (resources_released) {
+    event_handler_->HandleEvent(kResourcesReleased);
+  }
+
   // Stop dropping vsync when first commit is received after idle fallback.
   drop_hw_vsync_ = false;
 
@@ -1616,6 +1647,8 @@ DisplayError DisplayBase::PostCommit(HWLayersInfo *hw_layers_info) {
     return error;
   }
 
+  UpdatePowerOnLatency();
+
   // Handle pending vsync enable if any after the commit
   error = HandlePendingVSyncEnable(retire_fence_);
   if (error != kErrorNone) {
@@ -1828,6 +1861,7 @@ DisplayError DisplayBase::SetDisplayState(DisplayState state, bool teardown,
     if (pending_power_state_ != kPowerStateNone) {
       hw_intf_->CancelDeferredPowerMode();
       pending_power_state_ = kPowerStateNone;
+      power_on_start_us_ = 0;
     }
     DLOGI("Same state transition is requested.");
     return kErrorNone;
@@ -1860,6 +1894,7 @@ DisplayError DisplayBase::SetDisplayState(DisplayState state, bool teardown,
     }
     cached_qos_data_ = {};
     cached_qos_data_.clock_hz = default_clock_hz_;
+    power_on_start_us_ = 0;
     break;
 
   case kStateOn:
@@ -1867,12 +1902,15 @@ DisplayError DisplayBase::SetDisplayState(DisplayState state, bool teardown,
       hw_events_intf_->SetEventState(HWEvent::POWER_EVENT, true);
     }
 
+    power_on_start_us_ = GetTimeUs();
     error = hw_intf_->PowerOn(cached_qos_data_, &sync_points);
     if (error != kErrorNone) {
       if (error == kErrorDeferred) {
         pending_power_state_ = kPowerStateOn;
         error = kErrorNone;
       } else {
+        // Otherwise the next commit, whatever state it is in, would be taken for the first frame.
+        power_on_start_us_ = 0;
         return error;
       }
     } else {
@@ -1883,6 +1921,7 @@ DisplayError DisplayBase::SetDisplayState(DisplayState state, bool teardown,
                                               hw_panel_info_, mixer_attributes_, fb_config_,
                                               &cached_qos_data_);
     if (error != kErrorNone) {
+      power_on_start_us_ = 0;
       return error;
     }
     default_clock_hz_ = cached_qos_data_.clock_hz;
@@ -2096,6 +2135,16 @@ std::string DisplayBase::Dump() {
   os << " clk: " << display_attributes_.clock_khz;
   os << " Topology: " << display_attributes_.topology;
   os << std::noboolalpha;
+  HWFbIdStats fb_id_stats = {};
+  hw_intf_->GetFbIdStats(&fb_id_stats);
+  os << "\n FbId prefetched: " << fb_id_stats.prefetched << " hits: " << fb_id_stats.hits
+     << " misses: " << fb_id_stats.misses << " removed: " << fb_id_stats.removed;
+  if (monitor_input_fences_ && InputFenceMonitor::GetInstance()) {
+    InputFenceMonitor::GetInstance()->Dump(display_id_, &os);
+  }
+  mixer_controller_.Dump(&os);
+  os << "\nPower on to first frame: " << power_on_latency_us_ << " us max "
+     << max_power_on_latency_us_ << " us";
 
   os << "\nCurrent Color Mode: " << current_color_mode_.c_str();
   os << "\nAvailable Color Modes:\n";
@@ -2925,7 +2974,7 @@ bool DisplayBase::NeedsDownScale(const LayerRect &src_rect, const LayerRect &dst
 }
 
 bool DisplayBase::NeedsMixerReconfiguration(LayerStack *layer_stack, uint32_t *new_mixer_width,
-                                            uint32_t *new_mixer_height) {
+                                            uint32_t *new_mixer_height, bool commit) {
   ClientLock lock(disp_mutex_);
   uint32_t mixer_width = mixer_attributes_.width;
   uint32_t mixer_height = mixer_attributes_.height;
@@ -3019,17 +3068,43 @@ bool DisplayBase::NeedsMixerReconfiguration(LayerStack *layer_stack, uint32_t *n
     LayerRect dst_domain = {0.0f, 0.0f, FLOAT(*new_mixer_width), FLOAT(*new_mixer_height)};
 
     MapRect(fb_rect, dst_domain, layer->dst_rect, &layer_dst_rect);
+    // Falling back to the display size avoids downscaling at the mixer or a mixer larger than the
+    // display, it cannot wait for the content to settle.
+    bool display_size = false;
     if (NeedsDownScale(layer->src_rect, layer_dst_rect, needs_rotation)) {
       *new_mixer_width = display_width;
       *new_mixer_height = display_height;
+      display_size = true;
     }
     if (*new_mixer_width > display_width || *new_mixer_height > display_height) {
       *new_mixer_width = display_width;
       *new_mixer_height = display_height;
+      display_size = true;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t now_ms = (int64_t(now.tv_sec) * 1000) + (now.tv_nsec / 1000000);
+    if (display_size) {
+      bool changed = ((*new_mixer_width != mixer_width) || (*new_mixer_height != mixer_height));
+      if (commit) {
+        mixer_controller_.ApplyForced(changed, now_ms);
+      }
+      return changed;
     }
+
+    // The content may alternate between layers asking for different resolutions, only follow it
+    // when it is worth a reconfiguration.
+    mixer_controller_.Update(mixer_width, mixer_height, *new_mixer_width, *new_mixer_height,
+                             display_width, display_height, now_ms, commit, new_mixer_width,
+                             new_mixer_height);
     return ((*new_mixer_width != mixer_width) || (*new_mixer_height != mixer_height));
   }
 
+  if (commit) {
+    mixer_controller_.ResetPending();
+  }
+
   return false;
 }
 
@@ -3665,6 +3740,27 @@ DisplayError DisplayBase::ResetPendingPowerState(const shared_ptr<Fence> &retire
   return kErrorNone;
 }
 
+void DisplayBase::UpdatePowerOnLatency() {
+  if (!power_on_start_us_) {
+    return;
+  }
+
+  // From power on until the first frame after it is committed, which includes the wait for the
+  // power on when it went with that frame.
+  power_on_latency_us_ = GetTimeUs() - power_on_start_us_;
+  max_power_on_latency_us_ = std::max(max_power_on_latency_us_, power_on_latency_us_);
+  power_on_start_us_ = 0;
+  DLOGI("Power on to first frame took %" PRId64 " us for display %d-%d", power_on_latency_us_,
+        display_id_, display_type_);
+}
+
+int64_t DisplayBase::GetTimeUs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (int64_t(now.tv_sec) * 1000000) + (now.tv_nsec / 1000);
+}
+
 bool DisplayBase::CheckResourceState(bool *res_exhausted) {
   return comp_manager_->CheckResourceState(display_comp_ctx_, res_exhausted, display_attributes_);
 }
@@ -3986,6 +4082,15 @@ void DisplayBase::Abort() {
   }
 }
 
+DisplayError DisplayBase::PrefetchBuffer(const LayerBuffer &buffer) {
+  // Not under disp_mutex_, the client calls this while the display may be busy in a commit.
+  if (!hw_intf_) {
+    return kErrorNotSupported;
+  }
+
+  return hw_intf_->PrefetchFbId(buffer);
+}
+
 void DisplayBase::CacheRetireFence() {
   if (draw_method_ == kDrawDefault) {
     retire_fence_ = disp_layer_stack_.info.retire_fence;
@@ -4244,41 +4349,35 @@ DisplayError DisplayBase::ConfigureCwbForIdleFallback(LayerStack *layer_stack) {
 }
 
 void DisplayBase::TrackInputFences() {
-  if (!track_input_fences_) {
+  if (!monitor_input_fences_) {
     return;
   }
-  // Check if async task is in progress.
-  // Wait until it finishes.
-  if (fence_wait_future_.valid()) {
-    fence_wait_future_.get();
+
+  InputFenceMonitor *input_fence_monitor = InputFenceMonitor::GetInstance();
+  if (!input_fence_monitor) {
+    return;
   }
 
-  lock_guard<mutex> scope_lock(fence_track_mutex_);
-  // Copy & Wait on all fences.
-  acquire_fences_ = {};
+  std::vector<InputFenceMonitor::LayerFence> fences;
+  fences.reserve(disp_layer_stack_.info.hw_layers.size());
   for (auto &hw_layer : disp_layer_stack_.info.hw_layers) {
-    acquire_fences_.push_back(hw_layer.input_buffer.acquire_fence);
+    InputFenceMonitor::LayerFence layer_fence;
+    layer_fence.layer_name = hw_layer.layer_name;
+    layer_fence.fence = hw_layer.input_buffer.acquire_fence;
+    fences.push_back(layer_fence);
   }
-  // Start async task to wait on fences.
-  fence_wait_future_ = std::async(std::launch::async, [&](){
-                                  WaitOnFences();
-                                  });
-}
 
-void DisplayBase::WaitOnFences() {
-  lock_guard<mutex> scope_lock(fence_track_mutex_);
-  const int kFenceWaitTimeoutMs = 500;
-  for (auto &acquire_fence : acquire_fences_) {
-    if (Fence::Wait(acquire_fence, kFenceWaitTimeoutMs) == kErrorNone) {
-      continue;
-    }
-    // Fence did not signal in 500 ms.
-    DLOGI("Dumping stack trace for %d-%d", display_id_, display_type_);
-    event_handler_->HandleEvent(kDumpStacktrace);
-    usleep(kFenceWaitTimeoutMs * 1000);
-    DLOGI("Dumping stack trace after 500 ms sleep %d-%d", display_id_, display_type_);
-    event_handler_->HandleEvent(kDumpStacktrace);
+  // Fence that has not signaled in a while, see what its producer is up to.
+  InputFenceMonitor::StuckHandler stuck_handler = nullptr;
+  if (track_input_fences_) {
+    stuck_handler = [this]() {
+      DLOGI("Dumping stack trace for %d-%d", display_id_, display_type_);
+      event_handler_->HandleEvent(kDumpStacktrace);
+    };
   }
+
+  input_fence_monitor->Track(display_id_, display_attributes_.vsync_period_ns, fences,
+                             stuck_handler);
 }
 
 }  // namespace sdm
@@ -77,12 +77,12 @@
 #include <condition_variable>  // NOLINT
 #include <string>
 #include <vector>
-#include <future>
 
 #include "hw_interface.h"
 #include "comp_manager.h"
 #include "color_manager.h"
 #include "hw_events_interface.h"
+#include "mixer_resolution_controller.h"
 
 #define GET_PANEL_FEATURE_FACTORY "GetPanelFeatureFactoryIntf"
 
@@ -199,6 +199,7 @@ class DisplayBase : public DisplayInterface {
   virtual DisplayError PostHandleSecureEvent(SecureEvent secure_event) {
     return kErrorNotSupported;
   }
+  virtual DisplayError PrefetchBuffer(const LayerBuffer &buffer);
   virtual DisplayError SetDisplayDppsAdROI(void *payload) {
     return kErrorNotSupported;
   }
@@ -307,8 +308,9 @@ class DisplayBase : public DisplayInterface {
   void HwRecovery(const HWRecoveryEvent sdm_event_code);
 
   const char *GetName(const LayerComposition &composition);
+  // With commit false the mixer resolution controller does not record the frame.
   bool NeedsMixerReconfiguration(LayerStack *layer_stack, uint32_t *new_mixer_width,
-                                 uint32_t *new_mixer_height);
+                                 uint32_t *new_mixer_height, bool commit = true);
   DisplayError ReconfigureMixer(uint32_t width, uint32_t height);
   bool NeedsDownScale(const LayerRect &src_rect, const LayerRect &dst_rect, bool needs_rotation);
   void DeInitializeColorModes();
@@ -330,6 +332,8 @@ class DisplayBase : public DisplayInterface {
   DisplayError InitRC();
   DisplayError HandlePendingVSyncEnable(const shared_ptr<Fence> &retire_fence);
   DisplayError ResetPendingPowerState(const shared_ptr<Fence> &retire_fence);
+  void UpdatePowerOnLatency();
+  static int64_t GetTimeUs();
   DisplayError GetPendingDisplayState(DisplayState *disp_state);
   void SetPendingPowerState(DisplayState state);
   DisplayError SetupPanelFeatureFactory();
@@ -405,6 +409,10 @@ class DisplayBase : public DisplayInterface {
   uint32_t current_refresh_rate_ = 0;
   bool drop_skewed_vsync_ = false;
   bool custom_mixer_resolution_ = false;
+  MixerResolutionController mixer_controller_;
+  int64_t power_on_start_us_ = 0;  // Set from power on until the first frame after it commits.
+  int64_t power_on_latency_us_ = 0;
+  int64_t max_power_on_latency_us_ = 0;
   bool vsync_enable_pending_ = false;
   HWPowerState pending_power_state_ = kPowerStateNone;
   QSyncMode qsync_mode_ = kQSyncModeNone;
@@ -461,7 +469,6 @@ class DisplayBase : public DisplayInterface {
   DisplayError InitBorderLayers();
   std::vector<LayerRect> GetBorderRects();
   void GenerateBorderLayers(const std::vector<LayerRect> &border_rects);
-  void WaitOnFences();
   unsigned int rc_cached_res_width_ = 0;
   unsigned int rc_cached_res_height_ = 0;
   unsigned int rc_cached_mixer_width_ = 0;
@@ -488,10 +495,8 @@ class DisplayBase : public DisplayInterface {
   bool windowed_display_ = false;
   LayerRect window_rect_ = {};
   bool enable_win_rect_mask_ = false;
-  std::future<void> fence_wait_future_;
   bool track_input_fences_ = false;
-  std::vector<shared_ptr<Fence>> acquire_fences_;
-  std::mutex fence_track_mutex_;
+  bool monitor_input_fences_ = false;
 };
 
 }  // namespace sdm
@@ -78,6 +78,7 @@
 #include "drm_master.h"
 #include "hw_info_interface.h"
 #include "hw_interface.h"
+#include "input_fence_monitor.h"
 
 #define __CLASS__ "DisplayBuiltIn"
 
@@ -238,11 +239,17 @@ DisplayError DisplayBuiltIn::Init() {
 
   NoiseInit();
   InitCWBBuffer();
+  InitVSyncSynthesizer();
 
   return error;
 }
 
 DisplayError DisplayBuiltIn::Deinit() {
+  // Synthesized vsync is delivered without the display lock, stop it first.
+  if (vsync_synthesizer_) {
+    vsync_synthesizer_->Deinit();
+  }
+
   {
     ClientLock lock(disp_mutex_);
 
@@ -712,7 +719,7 @@ void DisplayBuiltIn::PreCommit(LayerStack *layer_stack) {
     }
   }
 
-  if (vsync_enable_) {
+  if (vsync_enable_ && !(vsync_synthesizer_ && vsync_synthesizer_->IsSynthesizing())) {
     DTRACE_BEGIN("RegisterVsync");
     // wait for previous frame's retire fence to signal.
     Fence::Wait(retire_fence_);
@@ -750,8 +757,10 @@ DisplayError DisplayBuiltIn::PostCommit(HWLayersInfo *hw_layers_info) {
     lock_guard<recursive_mutex> obj(brightness_lock_);
     if (pending_brightness_) {
       Fence::Wait(retire_fence_);
-      SetPanelBrightness(cached_brightness_);
-      pending_brightness_ = false;
+      // Kept pending on failure, to be applied along with the next commit.
+      if (SetPanelBrightness(cached_brightness_) == kErrorNone) {
+        pending_brightness_ = false;
+      }
     }
   }
 
@@ -792,6 +801,7 @@ DisplayError DisplayBuiltIn::PostCommit(HWLayersInfo *hw_layers_info) {
   dpps_info_.Init(this, hw_panel_info_.panel_name, this);
 
   HandleQsyncPostCommit();
+  UpdateVSyncSynthesizer(false /* force_reset */);
 
   handle_idle_timeout_ = false;
 
@@ -868,9 +878,12 @@ DisplayError DisplayBuiltIn::SetDisplayState(DisplayState state, bool teardown,
     return error;
   }
 
+  UpdateVSyncSynthesizer(true /* force_reset */);
+
   if (secure_event_ == kTUITransitionEnd && state == kStateOff) {
-    SetPanelBrightness(cached_brightness_);
-    pending_brightness_ = false;
+    if (SetPanelBrightness(cached_brightness_) == kErrorNone) {
+      pending_brightness_ = false;
+    }
   }
 
   if (hw_panel_info_.mode != panel_mode) {
@@ -985,6 +998,8 @@ DisplayError DisplayBuiltIn::SetPanelBrightness(float brightness) {
     level_remainder = t - level;
   }
 
+  // The remainder and the pending state are only updated once the level got applied, or
+  // deferred. On failure, GetPanelBrightness keeps reporting the level last applied.
   DisplayError err = hw_intf_->SetPanelBrightness(level);
   if (err == kErrorNone) {
     level_remainder_ = level_remainder;
@@ -1094,6 +1109,17 @@ DisplayError DisplayBuiltIn::VSync(int64_t timestamp) {
     return kErrorNone;
   }
 
+  if (vsync_synthesizer_) {
+    bool hw_vsync_needed = true;
+    propagate_vsync = vsync_synthesizer_->OnHWVSync(timestamp, &hw_vsync_needed);
+    if (!hw_vsync_needed) {
+      hw_events_intf_->SetEventState(HWEvent::VSYNC, false);
+    }
+    if (!propagate_vsync) {
+      return kErrorNone;
+    }
+  }
+
   DisplayEventVSync vsync;
   vsync.timestamp = timestamp;
   event_handler_->VSync(vsync);
@@ -1101,10 +1127,77 @@ DisplayError DisplayBuiltIn::VSync(int64_t timestamp) {
   return kErrorNone;
 }
 
+bool DisplayBuiltIn::OnSynthesizedVSync(int64_t timestamp) {
+  DTRACE_SCOPED();
+  // Same conditions as hardware vsync, which is disabled while vsync is synthesized.
+  bool qsync_enabled = enable_qsync_idle_ && (active_qsync_mode_ != kQSyncModeNone);
+  if (!vsync_enable_ || drop_hw_vsync_ || qsync_enabled) {
+    return false;
+  }
+
+  DisplayEventVSync vsync;
+  vsync.timestamp = timestamp;
+  event_handler_->VSync(vsync);
+
+  return true;
+}
+
+void DisplayBuiltIn::EnableHWVSync() {
+  hw_events_intf_->SetEventState(HWEvent::VSYNC, vsync_enable_);
+}
+
+void DisplayBuiltIn::InitVSyncSynthesizer() {
+  int value = 0;
+  DebugHandler::Get()->GetProperty(ENABLE_SW_VSYNC, &value);
+  if (value != 1) {
+    return;
+  }
+
+  int error_threshold_us = 500;
+  DebugHandler::Get()->GetProperty(SW_VSYNC_ERROR_THRESHOLD_US, &error_threshold_us);
+  int resync_ms = 1000;
+  DebugHandler::Get()->GetProperty(SW_VSYNC_RESYNC_MS, &resync_ms);
+  if (error_threshold_us <= 0 || resync_ms <= 0) {
+    DLOGW("Invalid sw vsync error threshold %d us or resync interval %d ms", error_threshold_us,
+          resync_ms);
+    return;
+  }
+
+  int64_t error_threshold_ns = static_cast<int64_t>(error_threshold_us) * 1000;
+  vsync_synthesizer_.reset(new VSyncSynthesizer(this, error_threshold_ns, UINT32(resync_ms)));
+  std::string thread_name = "SDM_SWVSync_" + std::to_string(display_id_);
+  if (vsync_synthesizer_->Init(thread_name) != kErrorNone) {
+    vsync_synthesizer_ = nullptr;
+    return;
+  }
+  UpdateVSyncSynthesizer(true /* force_reset */);
+  DLOGI("Synthesized vsync enabled, error threshold %d us, resync every %d ms",
+        error_threshold_us, resync_ms);
+}
+
+void DisplayBuiltIn::UpdateVSyncSynthesizer(bool force_reset) {
+  if (!vsync_synthesizer_ || !current_refresh_rate_) {
+    return;
+  }
+
+  // Vsync period changes along with the refresh rate and panel mode, learn it again.
+  if (force_reset || (vsync_synthesizer_fps_ != current_refresh_rate_) ||
+      (vsync_synthesizer_mode_ != hw_panel_info_.mode)) {
+    vsync_synthesizer_fps_ = current_refresh_rate_;
+    vsync_synthesizer_mode_ = hw_panel_info_.mode;
+    if (vsync_synthesizer_->Reset(1000000000LL / current_refresh_rate_)) {
+      EnableHWVSync();
+    }
+  }
+}
+
 void DisplayBuiltIn::SetVsyncStatus(bool enable) {
   string trace_name = enable ? "enable" : "disable";
   DTRACE_BEGIN(trace_name.c_str());
-  if (enable) {
+  if (enable && vsync_synthesizer_ && vsync_synthesizer_->IsSynthesizing()) {
+    // Vsync is being synthesized, hardware vsync is not needed.
+    pending_vsync_enable_ = false;
+  } else if (enable) {
     // Enable if vsync is still enabled.
     hw_events_intf_->SetEventState(HWEvent::VSYNC, vsync_enable_);
     pending_vsync_enable_ = false;
@@ -1541,6 +1634,22 @@ std::string DisplayBuiltIn::Dump() {
   os << " Topology: " << display_attributes_.topology;
   os << " Qsync mode: " << active_qsync_mode_;
   os << std::noboolalpha;
+  if (vsync_synthesizer_) {
+    VSyncSynthesizer::Stats stats = vsync_synthesizer_->GetStats();
+    os << "\n SW vsync: synthesized " << stats.synthesized << " hw " << stats.hw_vsyncs
+       << " resyncs " << stats.resyncs << " misses " << stats.misses
+       << " max error " << stats.max_error_ns << "ns";
+  }
+  HWFbIdStats fb_id_stats = {};
+  hw_intf_->GetFbIdStats(&fb_id_stats);
+  os << "\n FbId prefetched: " << fb_id_stats.prefetched << " hits: " << fb_id_stats.hits
+     << " misses: " << fb_id_stats.misses << " removed: " << fb_id_stats.removed;
+  if (monitor_input_fences_ && InputFenceMonitor::GetInstance()) {
+    InputFenceMonitor::GetInstance()->Dump(display_id_, &os);
+  }
+  mixer_controller_.Dump(&os);
+  os << "\nPower on to first frame: " << power_on_latency_us_ << " us max "
+     << max_power_on_latency_us_ << " us";
 
   DynamicRangeType curr_dynamic_range = kSdrType;
   if (std::find(current_color_mode_.hw_assets.begin(), current_color_mode_.hw_assets.end(),
@@ -2595,7 +2704,8 @@ void DisplayBuiltIn::AppendCWBLayer(LayerStack *layer_stack) {
 
   uint32_t new_mixer_width = fb_config_.x_pixels;
   uint32_t new_mixer_height = fb_config_.y_pixels;
-  NeedsMixerReconfiguration(layer_stack, &new_mixer_width, &new_mixer_height);
+  // Peeks at the mixer resolution of this frame, which is decided later in Prepare.
+  NeedsMixerReconfiguration(layer_stack, &new_mixer_width, &new_mixer_height, false);
   // Set cwb src_rect same as mixer resolution since LM tappoint
   // and dest_rect equal to fb resolution as strategy scales HWLayer dest rect based on fb
   cwb_layer_.src_rect = {0, 0, FLOAT(new_mixer_width), FLOAT(new_mixer_height)};
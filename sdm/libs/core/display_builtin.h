@@ -47,6 +47,7 @@
 #include "display_base.h"
 #include "drm_interface.h"
 #include "hw_events_interface.h"
+#include "vsync_synthesizer.h"
 
 namespace sdm {
 
@@ -132,7 +133,8 @@ class DisplayIPCVmCallbackImpl : public IPCVmCallbackIntf {
   recursive_mutex cb_mutex_;
 };
 
-class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
+class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf,
+                       VSyncSynthesizer::EventHandler {
  public:
   DisplayBuiltIn(DisplayEventHandler *event_handler, HWInfoInterface *hw_info_intf,
                  BufferAllocator *buffer_allocator, CompManager *comp_manager,
@@ -206,6 +208,10 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   void HandlePowerEvent() override;
   void HandleVmReleaseEvent() override;
 
+  // Implement the VSyncSynthesizer::EventHandler
+  bool OnSynthesizedVSync(int64_t timestamp) override;
+  void EnableHWVSync() override;
+
   // Implement the DppsPropIntf
   DisplayError DppsProcessOps(enum DppsOps op, void *payload, size_t size) override;
   DisplayError SetActiveConfig(uint32_t index) override;
@@ -244,6 +250,8 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   DisplayError HandleDemuraLayer(LayerStack *layer_stack);
   void NotifyDppsHdrPresent(LayerStack *layer_stack);
   bool IdleFallbackLowerFps(bool idle_screen);
+  void InitVSyncSynthesizer();
+  void UpdateVSyncSynthesizer(bool force_reset);
 
   const uint32_t kPuTimeOutMs = 1000;
   std::vector<HWEvent> event_list_;
@@ -299,6 +307,9 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   Layer cwb_layer_ = {};
   bool lower_fps_ = false;
   bool cwb_buffer_inited_ = false;
+  std::unique_ptr<VSyncSynthesizer> vsync_synthesizer_ = nullptr;
+  uint32_t vsync_synthesizer_fps_ = 0;
+  HWDisplayMode vsync_synthesizer_mode_ = kModeDefault;
 };
 
 }  // namespace sdm
@@ -154,6 +154,7 @@ class DisplayNull : public DisplayInterface {
   MAKE_NO_OP(DestroyLayer())
   MAKE_NO_OP(SetAlternateDisplayConfig(uint32_t *))
   MAKE_NO_OP(ForceToneMapUpdate(LayerStack *layer_stack));
+  MAKE_NO_OP(PrefetchBuffer(const LayerBuffer &))
 
  protected:
   DisplayConfigVariableInfo default_variable_config_ = {};
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/sys.h>
+#include <chrono>
+
+#include "hw_brightness_writer.h"
+
+#define __CLASS__ "HWBrightnessWriter"
+
+namespace sdm {
+
+HWBrightnessWriter::HWBrightnessWriter(const std::string &thread_name)
+  : thread_name_(thread_name) {}
+
+HWBrightnessWriter::~HWBrightnessWriter() {
+  Deinit();
+}
+
+DisplayError HWBrightnessWriter::Init(uint32_t hold_ms) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (thread_.joinable()) {
+    return kErrorNone;
+  }
+
+  hold_ms_ = hold_ms;
+  exit_ = false;
+  thread_ = std::thread(&HWBrightnessWriter::Run, this);
+
+  return kErrorNone;
+}
+
+void HWBrightnessWriter::Deinit() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!thread_.joinable()) {
+      return;
+    }
+    exit_ = true;
+  }
+  level_cv_.notify_one();
+  thread_.join();
+
+  DLOGI("%s: requested %" PRIu64 ", written %" PRIu64 ", coalesced %" PRIu64 ", skipped %" PRIu64
+        ", retried %" PRIu64 ", failed %" PRIu64, thread_name_.c_str(), stats_.requested,
+        stats_.written, stats_.coalesced, stats_.skipped, stats_.retried, stats_.failed);
+}
+
+DisplayError HWBrightnessWriter::SetLevel(int fd, int level) {
+  std::unique_lock<std::mutex> lock(lock_);
+  stats_.requested++;
+
+  if (!thread_.joinable() || exit_ || (write_failed_ && !pending_ && !writing_)) {
+    // Worker is not running, or the node failed the last level it was given. Write in place, so
+    // that the caller knows whether the level got applied.
+    lock.unlock();
+    bool written = Write(fd, level);
+    lock.lock();
+    if (written) {
+      stats_.written++;
+      last_written_level_ = level;
+      write_failed_ = false;
+      return kErrorNone;
+    }
+    stats_.failed++;
+    last_written_level_ = -1;
+    return kErrorHardware;
+  }
+
+  if (pending_) {
+    stats_.coalesced++;
+  } else if (level == last_written_level_ && !writing_) {
+    stats_.skipped++;
+    return kErrorNone;
+  } else {
+    frame_committed_ = false;
+  }
+
+  fd_ = fd;
+  level_ = level;
+  pending_ = true;
+  level_cv_.notify_one();
+
+  return kErrorNone;
+}
+
+bool HWBrightnessWriter::GetPendingLevel(int *level) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!pending_) {
+    return false;
+  }
+
+  *level = level_;
+  return true;
+}
+
+void HWBrightnessWriter::OnFrameCommitted() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (pending_) {
+    frame_committed_ = true;
+    level_cv_.notify_one();
+  }
+}
+
+void HWBrightnessWriter::Flush() {
+  std::unique_lock<std::mutex> lock(lock_);
+  frame_committed_ = true;
+  level_cv_.notify_one();
+  idle_cv_.wait(lock, [this] { return !pending_ && !writing_; });
+}
+
+void HWBrightnessWriter::Invalidate() {
+  std::lock_guard<std::mutex> lock(lock_);
+  last_written_level_ = -1;
+}
+
+HWBrightnessWriter::Stats HWBrightnessWriter::GetStats() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return stats_;
+}
+
+void HWBrightnessWriter::Run() {
+  prctl(PR_SET_NAME, thread_name_.c_str(), 0, 0, 0);
+  setpriority(PRIO_PROCESS, 0, kThreadPriorityUrgent);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  uint32_t retries = 0;
+  while (true) {
+    level_cv_.wait(lock, [this] { return exit_ || pending_; });
+    if (!pending_) {
+      break;
+    }
+
+    if (hold_ms_ && !exit_) {
+      level_cv_.wait_for(lock, std::chrono::milliseconds(hold_ms_),
+                         [this] { return exit_ || frame_committed_; });
+    }
+
+    // Requests that came in while waiting have replaced level_.
+    int fd = fd_;
+    int level = level_;
+    pending_ = false;
+    frame_committed_ = false;
+    if (level == last_written_level_) {
+      stats_.skipped++;
+      idle_cv_.notify_all();
+      continue;
+    }
+
+    writing_ = true;
+    lock.unlock();
+    bool written = Write(fd, level);
+    lock.lock();
+
+    last_written_level_ = written ? level : -1;
+    if (written) {
+      stats_.written++;
+      write_failed_ = false;
+      retries = 0;
+    } else if (pending_) {
+      // A newer level replaced the one that failed, it gets retries of its own.
+      retries = 0;
+    } else if (!exit_ && (retries < kMaxWriteRetries)) {
+      // Still writing as far as Flush and SetLevel are concerned.
+      retries++;
+      stats_.retried++;
+      level_cv_.wait_for(lock, std::chrono::milliseconds(kWriteRetryDelayMs),
+                         [this] { return exit_ || pending_; });
+      if (!pending_) {
+        fd_ = fd;
+        level_ = level;
+        pending_ = true;
+        frame_committed_ = true;
+      } else {
+        retries = 0;
+      }
+    } else {
+      stats_.failed++;
+      write_failed_ = true;
+      retries = 0;
+    }
+    writing_ = false;
+    idle_cv_.notify_all();
+  }
+
+  idle_cv_.notify_all();
+}
+
+bool HWBrightnessWriter::Write(int fd, int level) {
+  DTRACE_SCOPED();
+  char buffer[kMaxCommandLength] = {0};
+
+  int32_t bytes = snprintf(buffer, kMaxCommandLength, "%d\n", level);
+  ssize_t ret = Sys::pwrite_(fd, buffer, static_cast<size_t>(bytes), 0);
+  if (ret <= 0) {
+    DLOGE("Failed to write level %d to brightness node, error = %s", level, strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace sdm
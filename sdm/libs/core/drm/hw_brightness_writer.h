@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_BRIGHTNESS_WRITER_H__
+#define __HW_BRIGHTNESS_WRITER_H__
+
+#include <core/sdm_types.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sdm {
+
+// Writes panel brightness levels to the backlight node from a worker thread. Only the latest
+// requested level is kept, so a burst of requests during a brightness animation results in a
+// single write, and a level equal to the one last written is not written again.
+// With a non-zero hold time, a level is held until the next frame is committed, or at most
+// hold_ms, so that the backlight changes along with the frame content.
+// A failed write is retried a few times unless a newer level replaces it. Once the retries are
+// exhausted, levels are written in place until a write succeeds, so that callers get the result.
+class HWBrightnessWriter {
+ public:
+  struct Stats {
+    uint64_t requested = 0;
+    uint64_t coalesced = 0;  // Replaced by a later request before being written.
+    uint64_t skipped = 0;    // Same as the level last written.
+    uint64_t written = 0;
+    uint64_t retried = 0;
+    uint64_t failed = 0;  // Not written after all retries, or written in place and failed.
+  };
+
+  explicit HWBrightnessWriter(const std::string &thread_name);
+  ~HWBrightnessWriter();
+
+  DisplayError Init(uint32_t hold_ms);
+  // Writes pending level, if any, and stops the worker. Must be called before fd is closed.
+  void Deinit();
+  // Returns an error if the level was written in place and the write failed.
+  DisplayError SetLevel(int fd, int level);
+  // Gets the level that is yet to be written. Returns false if there is none.
+  bool GetPendingLevel(int *level);
+  void OnFrameCommitted();
+  // Blocks until the pending level, if any, has been written.
+  void Flush();
+  // The panel may lose its backlight level across power state changes, write next level anyway.
+  void Invalidate();
+  Stats GetStats();
+
+ private:
+  static const int kMaxCommandLength = 12;
+  static constexpr uint32_t kMaxWriteRetries = 3;
+  static constexpr uint32_t kWriteRetryDelayMs = 5;
+
+  void Run();
+  bool Write(int fd, int level);
+
+  std::string thread_name_;
+  uint32_t hold_ms_ = 0;
+  std::thread thread_;
+  std::mutex lock_;
+  std::condition_variable level_cv_;
+  std::condition_variable idle_cv_;
+  int fd_ = -1;
+  int level_ = 0;
+  int last_written_level_ = -1;
+  bool pending_ = false;
+  bool writing_ = false;
+  bool frame_committed_ = false;
+  // Set once a level could not be written after all retries, until a write succeeds.
+  bool write_failed_ = false;
+  bool exit_ = false;
+  Stats stats_ = {};
+};
+
+}  // namespace sdm
+
+#endif  // __HW_BRIGHTNESS_WRITER_H__
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <utils/sys.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hw_brightness_writer.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const int kNodeFd = 1000;
+
+// Backlight node behind Sys::pwrite_. Levels listed in fail_levels, or all levels while
+// fail_all is set, are rejected with EIO.
+struct FakeNode {
+  std::mutex lock;
+  std::vector<int> writes;
+  std::vector<int> fail_levels;
+  int fail_count = 0;
+  bool fail_all = false;
+  int level = -1;
+};
+
+FakeNode *g_node = nullptr;
+
+ssize_t FakePwrite(int fd, const void *buf, size_t count, off_t offset) {
+  if (fd != kNodeFd || offset != 0) {
+    errno = EBADF;
+    return -1;
+  }
+  int level = atoi(static_cast<const char *>(buf));
+  std::lock_guard<std::mutex> lock(g_node->lock);
+  bool fail = g_node->fail_all || (g_node->fail_count > 0);
+  for (int fail_level : g_node->fail_levels) {
+    fail |= (fail_level == level);
+  }
+  if (fail) {
+    g_node->fail_count -= (g_node->fail_count > 0);
+    errno = EIO;
+    return -1;
+  }
+  g_node->writes.push_back(level);
+  g_node->level = level;
+  return static_cast<ssize_t>(count);
+}
+
+class HWBrightnessWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_node = &node_;
+    pwrite_ = Sys::pwrite_;
+    Sys::pwrite_ = FakePwrite;
+  }
+
+  void TearDown() override {
+    writer_.Deinit();
+    Sys::pwrite_ = pwrite_;
+    g_node = nullptr;
+  }
+
+  std::vector<int> writes() {
+    std::lock_guard<std::mutex> lock(node_.lock);
+    return node_.writes;
+  }
+
+  int level() {
+    std::lock_guard<std::mutex> lock(node_.lock);
+    return node_.level;
+  }
+
+  void SetFailAll(bool fail_all) {
+    std::lock_guard<std::mutex> lock(node_.lock);
+    node_.fail_all = fail_all;
+  }
+
+  FakeNode node_;
+  HWBrightnessWriter writer_{"brightness_test"};
+  Sys::pwrite pwrite_ = nullptr;
+};
+
+}  // namespace
+
+// A burst held for the next frame ends up in a single write of its last level.
+TEST_F(HWBrightnessWriterTest, CoalescesBurst) {
+  ASSERT_EQ(kErrorNone, writer_.Init(500));
+  for (int level = 100; level <= 110; level++) {
+    EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, level));
+  }
+  int pending = 0;
+  ASSERT_TRUE(writer_.GetPendingLevel(&pending));
+  EXPECT_EQ(110, pending);
+
+  writer_.OnFrameCommitted();
+  writer_.Flush();
+  EXPECT_EQ(std::vector<int>({110}), writes());
+  EXPECT_FALSE(writer_.GetPendingLevel(&pending));
+
+  auto stats = writer_.GetStats();
+  EXPECT_EQ(11u, stats.requested);
+  EXPECT_EQ(10u, stats.coalesced);
+  EXPECT_EQ(1u, stats.written);
+}
+
+TEST_F(HWBrightnessWriterTest, SkipsLevelLastWritten) {
+  ASSERT_EQ(kErrorNone, writer_.Init(0));
+  writer_.SetLevel(kNodeFd, 100);
+  writer_.Flush();
+  writer_.SetLevel(kNodeFd, 100);
+  writer_.Flush();
+  EXPECT_EQ(std::vector<int>({100}), writes());
+
+  // Unless the panel may have lost it.
+  writer_.Invalidate();
+  writer_.SetLevel(kNodeFd, 100);
+  writer_.Flush();
+  EXPECT_EQ(std::vector<int>({100, 100}), writes());
+}
+
+// A transient failure is retried, Flush waits for the retries.
+TEST_F(HWBrightnessWriterTest, RetriesFailedWrite) {
+  node_.fail_count = 2;
+  ASSERT_EQ(kErrorNone, writer_.Init(0));
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 100));
+  writer_.Flush();
+  EXPECT_EQ(100, level());
+
+  auto stats = writer_.GetStats();
+  EXPECT_EQ(2u, stats.retried);
+  EXPECT_EQ(0u, stats.failed);
+  EXPECT_EQ(1u, stats.written);
+}
+
+// A newer level replaces a failing one instead of waiting for its retries.
+TEST_F(HWBrightnessWriterTest, NewerLevelReplacesFailedOne) {
+  node_.fail_levels = {100};
+  ASSERT_EQ(kErrorNone, writer_.Init(0));
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 100));
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 110));
+  writer_.Flush();
+  EXPECT_EQ(110, level());
+  EXPECT_EQ(0u, writer_.GetStats().failed);
+
+  // The writer did not fall back to writing in place.
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 100));
+  writer_.Flush();
+  EXPECT_EQ(1u, writer_.GetStats().failed);
+}
+
+// Once retries are exhausted, levels are written in place and failures reported, until the
+// node accepts a level again.
+TEST_F(HWBrightnessWriterTest, ReportsPersistentFailure) {
+  SetFailAll(true);
+  ASSERT_EQ(kErrorNone, writer_.Init(0));
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 100));
+  writer_.Flush();
+  auto stats = writer_.GetStats();
+  EXPECT_EQ(3u, stats.retried);
+  EXPECT_EQ(1u, stats.failed);
+  int pending = 0;
+  EXPECT_FALSE(writer_.GetPendingLevel(&pending));
+
+  EXPECT_EQ(kErrorHardware, writer_.SetLevel(kNodeFd, 120));
+  EXPECT_EQ(2u, writer_.GetStats().failed);
+
+  SetFailAll(false);
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 130));
+  EXPECT_EQ(130, level());
+
+  // Back to the worker.
+  writer_.OnFrameCommitted();
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 140));
+  writer_.Flush();
+  EXPECT_EQ(std::vector<int>({130, 140}), writes());
+}
+
+TEST_F(HWBrightnessWriterTest, WritesInPlaceWithoutWorker) {
+  EXPECT_EQ(kErrorNone, writer_.SetLevel(kNodeFd, 100));
+  EXPECT_EQ(100, level());
+  EXPECT_EQ(kErrorHardware, writer_.SetLevel(kNodeFd + 1, 110));
+  EXPECT_EQ(100, level());
+}
+
+// A level held for a frame that never comes is still written on Deinit.
+TEST_F(HWBrightnessWriterTest, DeinitWritesPendingLevel) {
+  ASSERT_EQ(kErrorNone, writer_.Init(5000));
+  writer_.SetLevel(kNodeFd, 100);
+  writer_.Deinit();
+  EXPECT_EQ(std::vector<int>({100}), writes());
+}
+
+// Levels requested from several threads end with the last one written.
+TEST_F(HWBrightnessWriterTest, ConcurrentRequests) {
+  ASSERT_EQ(kErrorNone, writer_.Init(0));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([this, t] {
+      for (int i = 0; i < 100; i++) {
+        writer_.SetLevel(kNodeFd, t * 100 + i);
+        writer_.OnFrameCommitted();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  writer_.SetLevel(kNodeFd, 1000);
+  writer_.Flush();
+  EXPECT_EQ(1000, level());
+  auto stats = writer_.GetStats();
+  EXPECT_EQ(401u, stats.requested);
+  EXPECT_EQ(stats.requested, stats.written + stats.coalesced + stats.skipped);
+}
+
+}  // namespace sdm
@@ -104,6 +104,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <limits>
 
 #include "hw_device_drm.h"
+#include "hw_fb_id_worker.h"
 #include "hw_info_interface.h"
 
 #define __CLASS__ "HWDeviceDRM"
@@ -315,20 +316,33 @@ static void GetDRMFormat(LayerBufferFormat format, uint32_t *drm_format,
   }
 }
 
+static HWFbIdWorker *GetFbIdWorker() {
+  // Lives as long as the process, framebuffer objects may be released from any thread until then.
+  static HWFbIdWorker *worker = new HWFbIdWorker([](const std::vector<uint32_t> &fb_ids) {
+    DTRACE_SCOPED();
+    DRMMaster *master = nullptr;
+    DRMMaster::GetInstance(&master);
+    if (!master) {
+      DLOGE("Failed to acquire DRM Master instance");
+      return;
+    }
+
+    master->RemoveFbIds(fb_ids);
+  });
+
+  return worker;
+}
+
 class FrameBufferObject : public LayerBufferObject {
  public:
-  explicit FrameBufferObject(uint32_t fb_id, LayerBufferFormat format,
+  explicit FrameBufferObject(int32_t display_id, uint32_t fb_id, LayerBufferFormat format,
                              uint32_t width, uint32_t height)
-    :fb_id_(fb_id), format_(format), width_(width), height_(height) {
+    :display_id_(display_id), fb_id_(fb_id), format_(format), width_(width), height_(height) {
   }
 
   ~FrameBufferObject() {
-    DRMMaster *master;
-    DRMMaster::GetInstance(&master);
-    int ret = master->RemoveFbId(fb_id_);
-    if (ret < 0) {
-      DLOGE("Removing fb_id %d failed with error %d", fb_id_, errno);
-    }
+    // The last reference may be dropped on any thread, remove it along with others off this one.
+    GetFbIdWorker()->RemoveFbId(display_id_, fb_id_);
   }
   uint32_t GetFbId() { return fb_id_; }
   bool IsEqual(LayerBufferFormat format, uint32_t width, uint32_t height) {
@@ -336,12 +350,42 @@ class FrameBufferObject : public LayerBufferObject {
   }
 
  private:
+  int32_t display_id_;
   uint32_t fb_id_;
   LayerBufferFormat format_;
   uint32_t width_;
   uint32_t height_;
 };
 
+static int CreateFbId(BufferAllocator *buffer_allocator, const LayerBuffer &buffer,
+                      uint32_t *fb_id) {
+  DRMMaster *master = nullptr;
+  DRMMaster::GetInstance(&master);
+  int ret = -1;
+
+  if (!master) {
+    DLOGE("Failed to acquire DRM Master instance");
+    return ret;
+  }
+
+  DRMBuffer layout{};
+  AllocatedBufferInfo buf_info{};
+  buf_info.fd = layout.fd = buffer.planes[0].fd;
+  buf_info.aligned_width = layout.width = buffer.width;
+  buf_info.aligned_height = layout.height = buffer.height;
+  buf_info.format = buffer.format;
+  buf_info.usage = buffer.usage;
+  GetDRMFormat(buf_info.format, &layout.drm_format, &layout.drm_format_modifier);
+  buffer_allocator->GetBufferLayout(buf_info, layout.stride, layout.offset, &layout.num_planes);
+  ret = master->CreateFbId(layout, fb_id);
+  if (ret < 0) {
+    DLOGE("CreateFbId failed. width %d, height %d, format: %s, stride %u, error %d",
+        layout.width, layout.height, GetFormatString(buf_info.format), layout.stride[0], errno);
+  }
+
+  return ret;
+}
+
 HWDeviceDRM::Registry::Registry(BufferAllocator *buffer_allocator) :
   buffer_allocator_(buffer_allocator) {
   int value = 0;
@@ -374,31 +418,124 @@ void HWDeviceDRM::Registry::Register(HWLayersInfo *hw_layers_info) {
 }
 
 int HWDeviceDRM::Registry::CreateFbId(const LayerBuffer &buffer, uint32_t *fb_id) {
-  DRMMaster *master = nullptr;
-  DRMMaster::GetInstance(&master);
-  int ret = -1;
+  return sdm::CreateFbId(buffer_allocator_, buffer, fb_id);
+}
 
-  if (!master) {
-    DLOGE("Failed to acquire DRM Master instance");
-    return ret;
+void HWDeviceDRM::Registry::Prefetch(const LayerBuffer &buffer) {
+  uint64_t handle_id = buffer.handle_id;
+  if (!handle_id || disable_fbid_cache_ || buffer.planes[0].fd < 0) {
+    return;
   }
 
-  DRMBuffer layout{};
-  AllocatedBufferInfo buf_info{};
-  buf_info.fd = layout.fd = buffer.planes[0].fd;
-  buf_info.aligned_width = layout.width = buffer.width;
-  buf_info.aligned_height = layout.height = buffer.height;
-  buf_info.format = buffer.format;
-  buf_info.usage = buffer.usage;
-  GetDRMFormat(buf_info.format, &layout.drm_format, &layout.drm_format_modifier);
-  buffer_allocator_->GetBufferLayout(buf_info, layout.stride, layout.offset, &layout.num_planes);
-  ret = master->CreateFbId(layout, fb_id);
-  if (ret < 0) {
-    DLOGE("CreateFbId failed. width %d, height %d, format: %s, stride %u, error %d",
-        layout.width, layout.height, GetFormatString(buf_info.format), layout.stride[0], errno);
+  // Only what CreateFbId needs. The fd is owned by the client and may be closed before the job
+  // runs, the job works on a dup.
+  LayerBuffer prefetch_buffer;
+  prefetch_buffer.format = buffer.format;
+  prefetch_buffer.width = buffer.width;
+  prefetch_buffer.height = buffer.height;
+  prefetch_buffer.usage = buffer.usage;
+  prefetch_buffer.handle_id = handle_id;
+  if (buffer.flags.interlace) {
+    prefetch_buffer.width *= 2;
+    prefetch_buffer.height /= 2;
   }
 
-  return ret;
+  {
+    std::lock_guard<std::mutex> lock(prefetch_cache_->lock);
+    if (prefetch_cache_->buffers.find(handle_id) != prefetch_cache_->buffers.end()) {
+      return;
+    }
+
+    prefetch_buffer.planes[0].fd = Sys::dup_(buffer.planes[0].fd);
+    if (prefetch_buffer.planes[0].fd < 0) {
+      return;
+    }
+
+    if (prefetch_cache_->buffers.size() >= kMaxPrefetchedBuffers) {
+      // Not committed by now, it is probably composed by GPU.
+      prefetch_cache_->buffers.erase(prefetch_cache_->order.front());
+      prefetch_cache_->order.pop_front();
+    }
+    prefetch_cache_->buffers[handle_id] = nullptr;
+    prefetch_cache_->order.push_back(handle_id);
+  }
+
+  std::weak_ptr<PrefetchCache> weak_cache = prefetch_cache_;
+  BufferAllocator *buffer_allocator = buffer_allocator_;
+  int32_t display_id = display_id_;
+  auto job = [weak_cache, buffer_allocator, display_id, prefetch_buffer]() {
+    DTRACE_SCOPED();
+    std::shared_ptr<LayerBufferObject> fb_obj = nullptr;
+    uint32_t fb_id = 0;
+    if (sdm::CreateFbId(buffer_allocator, prefetch_buffer, &fb_id) >= 0) {
+      fb_obj = std::make_shared<FrameBufferObject>(display_id, fb_id, prefetch_buffer.format,
+                                                   prefetch_buffer.width, prefetch_buffer.height);
+    }
+    Sys::close_(prefetch_buffer.planes[0].fd);
+
+    std::shared_ptr<PrefetchCache> cache = weak_cache.lock();
+    if (!cache) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(cache->lock);
+    auto it = cache->buffers.find(prefetch_buffer.handle_id);
+    if (it == cache->buffers.end() || it->second) {
+      // Evicted or taken while being created.
+      return;
+    }
+    if (fb_obj) {
+      it->second = fb_obj;
+      cache->prefetched++;
+    } else {
+      cache->order.erase(std::find(cache->order.begin(), cache->order.end(), it->first));
+      cache->buffers.erase(it);
+    }
+  };
+
+  if (!GetFbIdWorker()->Post(display_id_, job)) {
+    Sys::close_(prefetch_buffer.planes[0].fd);
+    std::lock_guard<std::mutex> lock(prefetch_cache_->lock);
+    // May have been taken or evicted in the meantime.
+    auto it = std::find(prefetch_cache_->order.begin(), prefetch_cache_->order.end(), handle_id);
+    if (it != prefetch_cache_->order.end()) {
+      prefetch_cache_->order.erase(it);
+      prefetch_cache_->buffers.erase(handle_id);
+    }
+  }
+}
+
+std::shared_ptr<LayerBufferObject> HWDeviceDRM::Registry::TakePrefetched(
+    const LayerBuffer &buffer) {
+  std::lock_guard<std::mutex> lock(prefetch_cache_->lock);
+  std::shared_ptr<LayerBufferObject> fb_obj = nullptr;
+
+  auto it = prefetch_cache_->buffers.find(buffer.handle_id);
+  if (it != prefetch_cache_->buffers.end()) {
+    // A pending one is dropped, the caller creates it now rather than wait for it.
+    FrameBufferObject *prefetched = static_cast<FrameBufferObject*>(it->second.get());
+    if (prefetched && prefetched->IsEqual(buffer.format, buffer.width, buffer.height)) {
+      fb_obj = it->second;
+    }
+    prefetch_cache_->order.erase(std::find(prefetch_cache_->order.begin(),
+                                           prefetch_cache_->order.end(), it->first));
+    prefetch_cache_->buffers.erase(it);
+  }
+
+  if (fb_obj) {
+    prefetch_cache_->hits++;
+  } else {
+    prefetch_cache_->misses++;
+  }
+
+  return fb_obj;
+}
+
+void HWDeviceDRM::Registry::GetStats(HWFbIdStats *stats) {
+  std::lock_guard<std::mutex> lock(prefetch_cache_->lock);
+  stats->prefetched = prefetch_cache_->prefetched;
+  stats->hits = prefetch_cache_->hits;
+  stats->misses = prefetch_cache_->misses;
 }
 
 void HWDeviceDRM::Registry::MapBufferToFbId(Layer* layer, const LayerBuffer &buffer) {
@@ -427,13 +564,19 @@ void HWDeviceDRM::Registry::MapBufferToFbId(Layer* layer, const LayerBuffer &buf
       // Clear fb_id map, if the size reaches cache limit.
       layer->buffer_map->buffer_map.clear();
     }
+
+    std::shared_ptr<LayerBufferObject> fb_obj = TakePrefetched(buffer);
+    if (fb_obj) {
+      layer->buffer_map->buffer_map[handle_id] = fb_obj;
+      return;
+    }
   }
 
   uint32_t fb_id = 0;
   if (CreateFbId(buffer, &fb_id) >= 0) {
     // Create and cache the fb_id in map
-    layer->buffer_map->buffer_map[handle_id] = std::make_shared<FrameBufferObject>(fb_id,
-        buffer.format, buffer.width, buffer.height);
+    layer->buffer_map->buffer_map[handle_id] = std::make_shared<FrameBufferObject>(display_id_,
+        fb_id, buffer.format, buffer.width, buffer.height);
   }
 }
 
@@ -461,17 +604,27 @@ void HWDeviceDRM::Registry::MapOutputBufferToFbId(LayerBuffer *output_buffer) {
       // Clear output buffer map, if the size reaches cache limit.
       output_buffer_map_.clear();
     }
+
+    std::shared_ptr<LayerBufferObject> fb_obj = TakePrefetched(*output_buffer);
+    if (fb_obj) {
+      output_buffer_map_[handle_id] = fb_obj;
+      return;
+    }
   }
 
   uint32_t fb_id = 0;
   if (CreateFbId(*output_buffer, &fb_id) >= 0) {
-    output_buffer_map_[handle_id] = std::make_shared<FrameBufferObject>(fb_id,
+    output_buffer_map_[handle_id] = std::make_shared<FrameBufferObject>(display_id_, fb_id,
         output_buffer->format, output_buffer->width, output_buffer->height);
   }
 }
 
 void HWDeviceDRM::Registry::Clear() {
   output_buffer_map_.clear();
+
+  std::lock_guard<std::mutex> lock(prefetch_cache_->lock);
+  prefetch_cache_->buffers.clear();
+  prefetch_cache_->order.clear();
 }
 
 uint32_t HWDeviceDRM::Registry::GetFbId(Layer *layer, uint64_t handle_id) {
@@ -494,6 +647,16 @@ uint32_t HWDeviceDRM::Registry::GetOutputFbId(uint64_t handle_id) {
   return 0;
 }
 
+DisplayError HWDeviceDRM::PrefetchFbId(const LayerBuffer &buffer) {
+  registry_.Prefetch(buffer);
+  return kErrorNone;
+}
+
+void HWDeviceDRM::GetFbIdStats(HWFbIdStats *stats) {
+  registry_.GetStats(stats);
+  stats->removed = GetFbIdWorker()->GetStats().removed;
+}
+
 HWDeviceDRM::HWDeviceDRM(BufferAllocator *buffer_allocator, HWInfoInterface *hw_info_intf)
     : hw_info_intf_(hw_info_intf), registry_(buffer_allocator) {
   hw_info_intf_ = hw_info_intf;
@@ -530,6 +693,7 @@ DisplayError HWDeviceDRM::Init() {
   }
 
   display_id_ = static_cast<int32_t>(token_.conn_id);
+  registry_.SetDisplayId(display_id_);
 
   ret = drm_mgr_intf_->CreateAtomicReq(token_, &drm_atomic_intf_);
   if (ret) {
@@ -1650,6 +1814,28 @@ void HWDeviceDRM::SetupAtomic(Fence::ScopedRef &scoped_ref, HWLayersInfo *hw_lay
     drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_DYN_BIT_CLK, token_.conn_id, bit_clk_rate_);
   }
 
+  SetupPowerState(validate);
+
+  // Set CRTC mode, only if display config changes
+  if (first_cycle_ || vrefresh_ || update_mode_) {
+    drm_atomic_intf_->Perform(DRMOps::CRTC_SET_MODE, token_.crtc_id, &current_mode.mode);
+    drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_DSC_MODE, token_.conn_id,
+                              current_mode.curr_compression_mode);
+  }
+
+  if (!validate && (hw_layers_info->set_idle_time_ms >= 0)) {
+    DLOGI_IF(kTagDriverConfig, "Setting idle timeout to = %d ms",
+             hw_layers_info->set_idle_time_ms);
+    drm_atomic_intf_->Perform(DRMOps::CRTC_SET_IDLE_TIMEOUT, token_.crtc_id,
+                              hw_layers_info->set_idle_time_ms);
+  }
+
+  if (hw_panel_info_.mode == kModeCommand) {
+    drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_AUTOREFRESH, token_.conn_id, autorefresh_);
+  }
+}
+
+void HWDeviceDRM::SetupPowerState(bool validate) {
   if (first_cycle_) {
     drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_TOPOLOGY_CONTROL, token_.conn_id,
                               topology_control_);
@@ -1669,24 +1855,6 @@ void HWDeviceDRM::SetupAtomic(Fence::ScopedRef &scoped_ref, HWLayersInfo *hw_lay
       last_power_mode_ = power_mode;
     }
   }
-
-  // Set CRTC mode, only if display config changes
-  if (first_cycle_ || vrefresh_ || update_mode_) {
-    drm_atomic_intf_->Perform(DRMOps::CRTC_SET_MODE, token_.crtc_id, &current_mode.mode);
-    drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_DSC_MODE, token_.conn_id,
-                              current_mode.curr_compression_mode);
-  }
-
-  if (!validate && (hw_layers_info->set_idle_time_ms >= 0)) {
-    DLOGI_IF(kTagDriverConfig, "Setting idle timeout to = %d ms",
-             hw_layers_info->set_idle_time_ms);
-    drm_atomic_intf_->Perform(DRMOps::CRTC_SET_IDLE_TIMEOUT, token_.crtc_id,
-                              hw_layers_info->set_idle_time_ms);
-  }
-
-  if (hw_panel_info_.mode == kModeCommand) {
-    drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_AUTOREFRESH, token_.conn_id, autorefresh_);
-  }
 }
 
 void HWDeviceDRM::SetNoiseLayerConfig(const NoiseLayerConfig &noise_config) {
@@ -1881,6 +2049,9 @@ DisplayError HWDeviceDRM::AtomicCommit(HWLayersInfo *hw_layers_info) {
 
   hw_layers_info->retire_fence = retire_fence;
 
+  // fb_ids dropped while this frame was prepared are off the display once it retires.
+  GetFbIdWorker()->ReleaseFbIds(display_id_, retire_fence);
+
   for (uint32_t i = 0; i < hw_layers_info->hw_layers.size(); i++) {
     Layer &layer = hw_layers_info->hw_layers.at(i);
     HWRotatorSession *hw_rotator_session = &hw_layers_info->config[i].hw_rotator_session;
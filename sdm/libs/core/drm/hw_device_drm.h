@@ -68,6 +68,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <pthread.h>
 #include <xf86drmMode.h>
 #include <atomic>
+#include <deque>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -200,6 +201,8 @@ class HWDeviceDRM : public HWInterface {
     return kErrorNotSupported;
   }
   virtual DisplayError CancelDeferredPowerMode();
+  virtual DisplayError PrefetchFbId(const LayerBuffer &buffer);
+  virtual void GetFbIdStats(HWFbIdStats *stats);
 
   enum {
     kHWEventVSync,
@@ -240,6 +243,9 @@ class HWDeviceDRM : public HWInterface {
   DisplayError AtomicCommit(HWLayersInfo *hw_layers_info);
   void SetupAtomic(Fence::ScopedRef &scoped_ref, HWLayersInfo *hw_layers_info, bool validate,
                    int64_t *release_fence_fd, int64_t *retire_fence_fd);
+  // Activates the CRTC and sets the power mode on the first frame, or on the frame a power state
+  // change was deferred to.
+  void SetupPowerState(bool validate);
   void SetSecureConfig(const LayerBuffer &input_buffer, sde_drm::DRMSecureMode *fb_secure_mode,
                        sde_drm::DRMSecurityLevel *security_level);
   bool IsResolutionSwitchEnabled() const { return resolution_switch_enabled_; }
@@ -285,12 +291,35 @@ class HWDeviceDRM : public HWInterface {
     uint32_t GetFbId(Layer *layer, uint64_t handle_id);
     // Find fb_id for given handle_id in output buffer map.
     uint32_t GetOutputFbId(uint64_t handle_id);
+    // Create the fb_id of a buffer ahead of its first commit on the fb_id worker thread.
+    void Prefetch(const LayerBuffer &buffer);
+    void GetStats(HWFbIdStats *stats);
+    // Framebuffer objects of the registry are created and removed on the queues of this display.
+    void SetDisplayId(int32_t display_id) { display_id_ = display_id; }
 
    private:
+    static const uint32_t kMaxPrefetchedBuffers = 16;
+
+    // Shared with the prefetch jobs, which may outlive the registry.
+    struct PrefetchCache {
+      std::mutex lock;
+      // Holds nullptr while the fb_id is being created.
+      std::unordered_map<uint64_t, std::shared_ptr<LayerBufferObject>> buffers;
+      std::deque<uint64_t> order;
+      uint64_t prefetched = 0;
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+    };
+
+    // Returns the prefetched fb of the buffer and drops it from the prefetch cache, if any.
+    std::shared_ptr<LayerBufferObject> TakePrefetched(const LayerBuffer &buffer);
+
     bool disable_fbid_cache_ = false;
     std::unordered_map<uint64_t, std::shared_ptr<LayerBufferObject>> output_buffer_map_ {};
     BufferAllocator *buffer_allocator_ = {};
     uint8_t fbid_cache_limit_ = UI_FBID_LIMIT;
+    int32_t display_id_ = -1;
+    std::shared_ptr<PrefetchCache> prefetch_cache_ = std::make_shared<PrefetchCache>();
   };
 
  protected:
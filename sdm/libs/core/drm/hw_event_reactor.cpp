@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/sys.h>
+
+#include "hw_event_reactor.h"
+
+#define __CLASS__ "HWEventReactor"
+
+namespace sdm {
+
+HWEventReactor *HWEventReactor::GetInstance() {
+  static std::mutex instance_lock;
+  static HWEventReactor *instance = nullptr;
+
+  std::lock_guard<std::mutex> lock(instance_lock);
+  if (!instance) {
+    // Lives as long as the process, displays come and go with hotplug.
+    HWEventReactor *reactor = new HWEventReactor("SDM_EventThread");
+    if (reactor->Init() != kErrorNone) {
+      delete reactor;
+      return nullptr;
+    }
+    instance = reactor;
+  }
+
+  return instance;
+}
+
+HWEventReactor::HWEventReactor(const std::string &thread_name) : thread_name_(thread_name) {}
+
+HWEventReactor::~HWEventReactor() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      exit_ = true;
+    }
+    uint64_t exit_value = 1;
+    Sys::write_(wake_fd_, &exit_value, sizeof(uint64_t));
+    thread_.join();
+  }
+
+  if (wake_fd_ >= 0) {
+    Sys::close_(wake_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    Sys::close_(epoll_fd_);
+  }
+}
+
+DisplayError HWEventReactor::Init() {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    DLOGE("epoll_create1 failed. error = %s", strerror(errno));
+    return kErrorResources;
+  }
+
+  wake_fd_ = Sys::eventfd_(0, EFD_CLOEXEC);
+  if (wake_fd_ < 0) {
+    DLOGE("eventfd failed. error = %s", strerror(errno));
+    return kErrorResources;
+  }
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = UINT32(wake_fd_);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event)) {
+    DLOGE("Failed to add wake fd. error = %s", strerror(errno));
+    return kErrorResources;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  thread_ = std::thread(&HWEventReactor::Run, this);
+  thread_id_ = thread_.get_id();
+
+  return kErrorNone;
+}
+
+DisplayError HWEventReactor::AddSource(int fd, uint32_t events, const Handler &handler) {
+  if (fd < 0 || !handler) {
+    return kErrorParameters;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  if (sources_.find(fd) != sources_.end()) {
+    DLOGE("fd %d is already registered", fd);
+    return kErrorParameters;
+  }
+
+  // The id tells apart a stale event of a removed source from one of a new source on the same fd.
+  Source source;
+  source.id = next_id_++;
+  source.handler = std::make_shared<Handler>(handler);
+
+  struct epoll_event event = {};
+  event.events = events;
+  event.data.u64 = (UINT64(source.id) << 32) | UINT32(fd);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event)) {
+    DLOGE("Failed to add fd %d. error = %s", fd, strerror(errno));
+    return kErrorResources;
+  }
+  sources_[fd] = source;
+
+  return kErrorNone;
+}
+
+void HWEventReactor::RemoveSource(int fd) {
+  std::unique_lock<std::mutex> lock(lock_);
+  auto it = sources_.find(fd);
+  if (it == sources_.end()) {
+    return;
+  }
+
+  uint32_t id = it->second.id;
+  sources_.erase(it);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+
+  if (std::this_thread::get_id() != thread_id_) {
+    dispatch_done_.wait(lock, [this, id] { return dispatching_ != id; });
+  }
+}
+
+void HWEventReactor::Run() {
+  prctl(PR_SET_NAME, thread_name_.c_str(), 0, 0, 0);
+  setpriority(PRIO_PROCESS, 0, kThreadPriorityUrgent);
+
+  // Real Time task with lowest priority.
+  struct sched_param param = {0};
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  sched_setscheduler(0, SCHED_FIFO, &param);
+
+  struct epoll_event events[kMaxEvents];
+  while (true) {
+    int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (count < 0) {
+      if (errno != EINTR) {
+        DLOGW("epoll_wait failed. error = %s", strerror(errno));
+      }
+      continue;
+    }
+
+    for (int i = 0; i < count; i++) {
+      int fd = INT(events[i].data.u64 & UINT32_MAX);
+      uint32_t id = UINT32(events[i].data.u64 >> 32);
+
+      std::shared_ptr<Handler> handler;
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (exit_) {
+          DLOGI("Exiting the thread");
+          return;
+        }
+
+        auto it = sources_.find(fd);
+        if (fd == wake_fd_ || it == sources_.end() || it->second.id != id) {
+          continue;
+        }
+        handler = it->second.handler;
+        dispatching_ = id;
+      }
+
+      (*handler)(events[i].events);
+
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        dispatching_ = 0;
+      }
+      dispatch_done_.notify_all();
+    }
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_EVENT_REACTOR_H__
+#define __HW_EVENT_REACTOR_H__
+
+#include <core/sdm_types.h>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sdm {
+
+// Waits on the event sources of all displays with a single epoll instance and thread, and calls
+// the handler registered for each source that becomes ready.
+// Handlers run on the reactor thread one at a time and must not block.
+class HWEventReactor {
+ public:
+  typedef std::function<void(uint32_t /* epoll events */)> Handler;
+
+  static HWEventReactor *GetInstance();
+
+  explicit HWEventReactor(const std::string &thread_name);
+  ~HWEventReactor();
+
+  DisplayError Init();
+  DisplayError AddSource(int fd, uint32_t events, const Handler &handler);
+  // Once this returns, the handler of fd is neither running nor called anymore. When called from
+  // a handler, the handler being run may be the one removed; it is not waited for.
+  void RemoveSource(int fd);
+
+ private:
+  static const int kMaxEvents = 16;
+
+  struct Source {
+    uint32_t id = 0;
+    std::shared_ptr<Handler> handler;
+  };
+
+  void Run();
+
+  std::string thread_name_;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::thread thread_;
+  std::thread::id thread_id_;
+  std::mutex lock_;
+  std::condition_variable dispatch_done_;
+  std::map<int, Source> sources_;
+  uint32_t next_id_ = 1;
+  uint32_t dispatching_ = 0;
+  bool exit_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __HW_EVENT_REACTOR_H__
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utils/constants.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hw_event_reactor.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const milliseconds kTimeout(2000);
+
+// An eventfd source that counts the events handled for it.
+class TestSource {
+ public:
+  TestSource() : fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) { }
+  ~TestSource() { close(fd_); }
+
+  int fd() const { return fd_; }
+
+  void Signal() {
+    uint64_t value = 1;
+    ASSERT_EQ(ssize_t(sizeof(value)), write(fd_, &value, sizeof(value)));
+  }
+
+  void Handle(uint32_t /* events */) {
+    uint64_t value = 0;
+    if (read(fd_, &value, sizeof(value)) != sizeof(value)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    count_ += value;
+    cv_.notify_all();
+  }
+
+  bool WaitForCount(uint64_t count) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cv_.wait_for(lock, kTimeout, [this, count] { return count_ >= count; });
+  }
+
+  uint64_t count() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return count_;
+  }
+
+ private:
+  int fd_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  uint64_t count_ = 0;
+};
+
+class HWEventReactorTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_EQ(kErrorNone, reactor_.Init()); }
+
+  DisplayError Add(TestSource *source) {
+    return reactor_.AddSource(source->fd(), EPOLLIN,
+                              [source](uint32_t events) { source->Handle(events); });
+  }
+
+  HWEventReactor reactor_{"reactor_test"};
+};
+
+}  // namespace
+
+TEST_F(HWEventReactorTest, DeliversEvents) {
+  TestSource source;
+  ASSERT_EQ(kErrorNone, Add(&source));
+
+  source.Signal();
+  EXPECT_TRUE(source.WaitForCount(1));
+  source.Signal();
+  EXPECT_TRUE(source.WaitForCount(2));
+  reactor_.RemoveSource(source.fd());
+}
+
+TEST_F(HWEventReactorTest, RoutesEventsPerSource) {
+  TestSource sources[4];
+  for (auto &source : sources) {
+    ASSERT_EQ(kErrorNone, Add(&source));
+  }
+
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j <= i; j++) {
+      sources[i].Signal();
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(sources[i].WaitForCount(UINT64(i + 1)));
+  }
+  for (int i = 0; i < 4; i++) {
+    reactor_.RemoveSource(sources[i].fd());
+    EXPECT_EQ(UINT64(i + 1), sources[i].count());
+  }
+}
+
+TEST_F(HWEventReactorTest, RejectsInvalidSources) {
+  TestSource source;
+  EXPECT_EQ(kErrorParameters, reactor_.AddSource(-1, EPOLLIN, [](uint32_t) { }));
+  EXPECT_EQ(kErrorParameters, reactor_.AddSource(source.fd(), EPOLLIN, nullptr));
+
+  ASSERT_EQ(kErrorNone, Add(&source));
+  EXPECT_EQ(kErrorParameters, Add(&source));
+  reactor_.RemoveSource(source.fd());
+  // Removing twice, or a source never added, is harmless.
+  reactor_.RemoveSource(source.fd());
+  reactor_.RemoveSource(12345);
+}
+
+TEST_F(HWEventReactorTest, NoEventsAfterRemove) {
+  TestSource source;
+  ASSERT_EQ(kErrorNone, Add(&source));
+  source.Signal();
+  ASSERT_TRUE(source.WaitForCount(1));
+
+  reactor_.RemoveSource(source.fd());
+  source.Signal();
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(1u, source.count());
+}
+
+// RemoveSource waits for the handler of the source while it runs.
+TEST_F(HWEventReactorTest, RemoveWaitsForHandler) {
+  int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  ASSERT_GE(fd, 0);
+  std::atomic<bool> entered(false);
+  std::atomic<bool> finished(false);
+  ASSERT_EQ(kErrorNone, reactor_.AddSource(fd, EPOLLIN, [&](uint32_t) {
+    uint64_t value = 0;
+    read(fd, &value, sizeof(value));
+    entered = true;
+    std::this_thread::sleep_for(milliseconds(100));
+    finished = true;
+  }));
+
+  uint64_t value = 1;
+  write(fd, &value, sizeof(value));
+  while (!entered) {
+    std::this_thread::yield();
+  }
+  reactor_.RemoveSource(fd);
+  EXPECT_TRUE(finished);
+  close(fd);
+}
+
+// A handler may remove its own source, and other sources, without deadlocking.
+TEST_F(HWEventReactorTest, RemoveFromHandler) {
+  TestSource other;
+  ASSERT_EQ(kErrorNone, Add(&other));
+
+  int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  ASSERT_GE(fd, 0);
+  std::mutex lock;
+  std::condition_variable cv;
+  bool removed = false;
+  ASSERT_EQ(kErrorNone, reactor_.AddSource(fd, EPOLLIN, [&](uint32_t) {
+    reactor_.RemoveSource(fd);
+    reactor_.RemoveSource(other.fd());
+    std::lock_guard<std::mutex> guard(lock);
+    removed = true;
+    cv.notify_all();
+  }));
+
+  uint64_t value = 1;
+  write(fd, &value, sizeof(value));
+  std::unique_lock<std::mutex> guard(lock);
+  EXPECT_TRUE(cv.wait_for(guard, kTimeout, [&] { return removed; }));
+  guard.unlock();
+
+  other.Signal();
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(0u, other.count());
+  close(fd);
+}
+
+// A source added again on the same fd gets the events, the removed one does not.
+TEST_F(HWEventReactorTest, ReAddOnSameFd) {
+  TestSource source;
+  std::atomic<int> old_calls(0);
+  ASSERT_EQ(kErrorNone, reactor_.AddSource(source.fd(), EPOLLIN,
+                                           [&](uint32_t) { old_calls++; }));
+  reactor_.RemoveSource(source.fd());
+  ASSERT_EQ(kErrorNone, Add(&source));
+
+  source.Signal();
+  EXPECT_TRUE(source.WaitForCount(1));
+  EXPECT_EQ(0, old_calls);
+  reactor_.RemoveSource(source.fd());
+}
+
+// Sources come and go from several threads while events are being delivered.
+TEST_F(HWEventReactorTest, ConcurrentAddRemove) {
+  const int kThreads = 4;
+  const int kIterations = 200;
+  std::vector<std::thread> threads;
+  std::atomic<int> failures(0);
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kIterations; i++) {
+        TestSource source;
+        if (Add(&source) != kErrorNone) {
+          failures++;
+          continue;
+        }
+        source.Signal();
+        if (i % 2) {
+          source.WaitForCount(1);
+        }
+        reactor_.RemoveSource(source.fd());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, failures);
+}
+
+TEST(HWEventReactor, DestroyStopsThread) {
+  TestSource source;
+  {
+    HWEventReactor reactor("reactor_test");
+    ASSERT_EQ(kErrorNone, reactor.Init());
+    ASSERT_EQ(kErrorNone, reactor.AddSource(source.fd(), EPOLLIN,
+                                            [&](uint32_t events) { source.Handle(events); }));
+    source.Signal();
+    EXPECT_TRUE(source.WaitForCount(1));
+  }
+  source.Signal();
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(1u, source.count());
+}
+
+}  // namespace sdm
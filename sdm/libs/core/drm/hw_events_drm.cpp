@@ -27,15 +27,13 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <drm_master.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/prctl.h>
-#include <sys/resource.h>
+#include <sys/epoll.h>
 #include <sys/types.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
@@ -51,6 +49,7 @@
 #include <vector>
 #include <string>
 
+#include "hw_event_reactor.h"
 #include "hw_events_drm.h"
 
 #ifndef DRM_EVENT_MMRM_CB
@@ -76,187 +75,207 @@
 
 namespace sdm {
 
-using drm_utils::DRMMaster;
-
-DisplayError HWEventsDRM::InitializePollFd() {
-  for (uint32_t i = 0; i < event_data_list_.size(); i++) {
-    char data[kMaxStringLength]{};
-    HWEventData &event_data = event_data_list_[i];
-    poll_fds_[i] = {};
-    poll_fds_[i].fd = -1;
-
-    switch (event_data.event_type) {
-      case HWEvent::VSYNC: {
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        if (is_primary_) {
-          DRMMaster *master = nullptr;
-          int ret = DRMMaster::GetInstance(&master);
-          if (ret < 0) {
-            DLOGE("Failed to acquire DRMMaster instance");
-            return kErrorNotSupported;
-          }
-          master->GetHandle(&poll_fds_[i].fd);
-        } else {
-          poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        }
-        vsync_index_ = i;
-      } break;
-      case HWEvent::EXIT: {
-        // Create an eventfd to be used to unblock the poll system call when
-        // a thread is exiting.
-        poll_fds_[i].fd = Sys::eventfd_(0, 0);
-        poll_fds_[i].events |= POLLIN;
-        // Clear any existing data
-        Sys::pread_(poll_fds_[i].fd, data, kMaxStringLength, 0);
-      } break;
-      case HWEvent::IDLE_POWER_COLLAPSE: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        idle_pc_index_ = i;
-      } break;
-      case HWEvent::PANEL_DEAD: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        panel_dead_index_ = i;
-      } break;
-      case HWEvent::HW_RECOVERY: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        hw_recovery_index_ = i;
-      } break;
-      case HWEvent::HISTOGRAM: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        histogram_index_ = i;
-      } break;
-      case HWEvent::BACKLIGHT_EVENT: {
-        std::lock_guard<std::mutex> lock(backlight_mutex_);
-        int inotify_fd = Sys::inotify_init_();
-        if (inotify_fd < 0) {
-          DLOGE("inotify init failed");
-          return kErrorResources;
-        }
-        poll_fds_[i].fd = inotify_fd;
-        poll_fds_[i].events = POLLIN;
-        backlight_event_index_ = i;
-        DLOGI("%s backlight_event_index_ %d", brightness_node_.c_str(), backlight_event_index_);
-      } break;
-      case HWEvent::MMRM: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        mmrm_index_ = i;
-      } break;
-      case HWEvent::POWER_EVENT: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        power_event_index_ = i;
-      } break;
-      case HWEvent::VM_RELEASE_EVENT: {
-        poll_fds_[i].fd = drmOpen("msm_drm", nullptr);
-        if (poll_fds_[i].fd < 0) {
-          DLOGE("drmOpen failed with error %d", poll_fds_[i].fd);
-          return kErrorResources;
-        }
-        poll_fds_[i].events = POLLIN | POLLPRI | POLLERR;
-        vm_release_event_index_ = i;
-      } break;
-      case HWEvent::CEC_READ_MESSAGE:
-      case HWEvent::SHOW_BLANK_EVENT:
-      case HWEvent::THERMAL_LEVEL:
-      case HWEvent::PINGPONG_TIMEOUT:
-        break;
+DRMEventDispatcher *DRMEventDispatcher::GetInstance() {
+  static std::mutex instance_lock;
+  static DRMEventDispatcher *instance = nullptr;
+
+  std::lock_guard<std::mutex> lock(instance_lock);
+  if (!instance) {
+    DRMEventDispatcher *dispatcher = new DRMEventDispatcher();
+    if (dispatcher->Init() != kErrorNone) {
+      delete dispatcher;
+      return nullptr;
     }
+    instance = dispatcher;
+  }
+
+  return instance;
+}
+
+DisplayError DRMEventDispatcher::Init() {
+  HWEventReactor *reactor = HWEventReactor::GetInstance();
+  if (!reactor) {
+    return kErrorResources;
   }
 
+  fd_ = drmOpen("msm_drm", nullptr);
+  if (fd_ < 0) {
+    DLOGE("drmOpen failed with error %d", fd_);
+    return kErrorResources;
+  }
+
+  DisplayError error = reactor->AddSource(fd_, EPOLLIN | EPOLLPRI | EPOLLERR,
+                                          [this](uint32_t events) { HandleEvents(events); });
+  if (error != kErrorNone) {
+    drmClose(fd_);
+    fd_ = -1;
+  }
+
+  return error;
+}
+
+DisplayError DRMEventDispatcher::Register(HWEventsDRM *events,
+                                          const sde_drm::DRMDisplayToken &token, int *fd) {
+  std::lock_guard<std::mutex> lock(lock_);
+  displays_[events] = token;
+  *fd = fd_;
+
+  DLOGI("Registered CRTC %d, Connector %d, %zu displays", token.crtc_id, token.conn_id,
+        displays_.size());
   return kErrorNone;
 }
 
-DisplayError HWEventsDRM::SetEventParser() {
-  DisplayError error = kErrorNone;
+void DRMEventDispatcher::Unregister(HWEventsDRM *events) {
+  std::unique_lock<std::mutex> lock(lock_);
+  displays_.erase(events);
+
+  if (std::this_thread::get_id() != delivery_thread_) {
+    delivery_done_.wait(lock, [this, events] { return delivering_ != events; });
+  }
+}
 
-  for (auto &event_data : event_data_list_) {
-    switch (event_data.event_type) {
-      case HWEvent::VSYNC:
-        event_data.event_parser = &HWEventsDRM::HandleVSync;
-        break;
-      case HWEvent::CEC_READ_MESSAGE:
-        event_data.event_parser = &HWEventsDRM::HandleCECMessage;
-        break;
-      case HWEvent::EXIT:
-        event_data.event_parser = &HWEventsDRM::HandleThreadExit;
-        break;
-      case HWEvent::SHOW_BLANK_EVENT:
-        event_data.event_parser = &HWEventsDRM::HandleBlank;
-        break;
-      case HWEvent::THERMAL_LEVEL:
-        event_data.event_parser = &HWEventsDRM::HandleThermal;
-        break;
-      case HWEvent::IDLE_POWER_COLLAPSE:
-        event_data.event_parser = &HWEventsDRM::HandleIdlePowerCollapse;
-        break;
-      case HWEvent::PANEL_DEAD:
-        event_data.event_parser = &HWEventsDRM::HandlePanelDead;
-        break;
-      case HWEvent::HW_RECOVERY:
-        event_data.event_parser = &HWEventsDRM::HandleHwRecovery;
-        break;
-      case HWEvent::HISTOGRAM:
-        event_data.event_parser = &HWEventsDRM::HandleHistogram;
-        break;
-      case HWEvent::BACKLIGHT_EVENT:
-        event_data.event_parser = &HWEventsDRM::HandleBacklightEvent;
-        break;
-      case HWEvent::MMRM:
-        event_data.event_parser = &HWEventsDRM::HandleMMRM;
-        break;
-      case HWEvent::POWER_EVENT:
-        event_data.event_parser = &HWEventsDRM::HandlePowerEvent;
-        break;
-      case HWEvent::VM_RELEASE_EVENT:
-        event_data.event_parser = &HWEventsDRM::HandleVmReleaseEvent;
-        break;
-      default:
-        error = kErrorParameters;
-        break;
+void DRMEventDispatcher::Deliver(const Delivery &delivery) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    // An earlier handler may have unregistered the display.
+    if (displays_.find(delivery.display) == displays_.end()) {
+      return;
     }
+    delivering_ = delivery.display;
   }
 
-  return error;
+  if (delivery.event_resp) {
+    delivery.display->QueueDRMEvent(delivery.event_resp);
+  } else {
+    delivery.display->HandleVSync(delivery.vsyncs);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    delivering_ = nullptr;
+  }
+  delivery_done_.notify_all();
+}
+
+HWEventsDRM *DRMEventDispatcher::FindDisplay(uint32_t object_type, uint32_t object_id) {
+  for (auto &it : displays_) {
+    if ((object_type == DRM_MODE_OBJECT_CRTC && it.second.crtc_id == object_id) ||
+        (object_type == DRM_MODE_OBJECT_CONNECTOR && it.second.conn_id == object_id)) {
+      return it.first;
+    }
+  }
+
+  return nullptr;
+}
+
+void DRMEventDispatcher::HandleEvents(uint32_t /*epoll_events*/) {
+  alignas(uint64_t) char buffer[kMaxEventBufferLength];
+  ssize_t size = Sys::read_(fd_, buffer, sizeof(buffer));
+  if (size <= 0) {
+    DLOGW("read failed. error = %s", strerror(errno));
+    return;
+  }
+
+  // Route the events under the lock and deliver them after, vsync first since it is the most
+  // latency sensitive. The other events are only queued here, their handlers run on the worker
+  // of each display.
+  std::unique_lock<std::mutex> lock(lock_);
+  delivery_thread_ = std::this_thread::get_id();
+  std::map<HWEventsDRM *, vector<int64_t>> vsyncs;
+  vector<Delivery> deliveries;
+  ssize_t valid_size = 0;
+  while (valid_size + ssize_t(sizeof(struct drm_event)) <= size) {
+    auto event = reinterpret_cast<struct drm_event *>(&buffer[valid_size]);
+    if (event->length < sizeof(struct drm_event) || valid_size + event->length > size) {
+      DLOGE("Invalid event length %d at %zd of %zd", event->length, valid_size, size);
+      break;
+    }
+    if (event->type == DRM_EVENT_VBLANK && event->length >= sizeof(struct drm_event_vblank)) {
+      // The display was passed in as user data when the vblank was requested.
+      auto vblank = reinterpret_cast<struct drm_event_vblank *>(event);
+      auto display = reinterpret_cast<HWEventsDRM *>(vblank->user_data);
+      if (displays_.find(display) != displays_.end()) {
+        int64_t timestamp = (int64_t)(vblank->tv_sec)*1000000000 + (int64_t)(vblank->tv_usec)*1000;
+        vsyncs[display].push_back(timestamp);
+      }
+    }
+    valid_size += event->length;
+  }
+
+  for (auto &it : vsyncs) {
+    Delivery delivery;
+    delivery.display = it.first;
+    delivery.vsyncs = std::move(it.second);
+    deliveries.push_back(std::move(delivery));
+  }
+
+  for (ssize_t i = 0; i < valid_size;) {
+    auto event = reinterpret_cast<struct drm_event *>(&buffer[i]);
+    i += event->length;
+    if (event->type == DRM_EVENT_VBLANK) {
+      continue;
+    }
+    if (event->length < sizeof(struct drm_msm_event_resp)) {
+      DLOGE("Invalid event %x size %d", event->type, event->length);
+      continue;
+    }
+
+    auto event_resp = reinterpret_cast<struct drm_msm_event_resp *>(event);
+    Delivery delivery;
+    delivery.display = FindDisplay(event_resp->info.object_type, event_resp->info.object_id);
+    if (!delivery.display) {
+      DLOGW("Dropping event %x for object %d", event->type, event_resp->info.object_id);
+      continue;
+    }
+    delivery.event_resp = event_resp;
+    deliveries.push_back(std::move(delivery));
+  }
+  lock.unlock();
+
+  for (auto &delivery : deliveries) {
+    Deliver(delivery);
+  }
 }
 
-void HWEventsDRM::PopulateHWEventData(const vector<HWEvent> &event_list) {
-  for (auto &event : event_list) {
-    HWEventData event_data;
-    event_data.event_type = event;
-    event_data_list_.push_back(std::move(event_data));
+bool HWEventsDRM::IsEventSupported(HWEvent event) const {
+  return std::find(event_list_.begin(), event_list_.end(), event) != event_list_.end();
+}
+
+DisplayError HWEventsDRM::InitBacklightEvent() {
+  std::lock_guard<std::mutex> lock(backlight_mutex_);
+  int inotify_fd = Sys::inotify_init_();
+  if (inotify_fd < 0) {
+    DLOGE("inotify init failed");
+    return kErrorResources;
   }
 
-  SetEventParser();
-  InitializePollFd();
+  DisplayError error = HWEventReactor::GetInstance()->AddSource(
+      inotify_fd, EPOLLIN, [this](uint32_t events) { HandleBacklightEvent(events); });
+  if (error != kErrorNone) {
+    Sys::close_(inotify_fd);
+    return error;
+  }
+
+  backlight_fd_ = inotify_fd;
+  DLOGI("%s backlight_fd_ %d", brightness_node_.c_str(), backlight_fd_);
+  return kErrorNone;
+}
+
+void HWEventsDRM::DeinitBacklightEvent() {
+  if (backlight_fd_ < 0) {
+    return;
+  }
+
+  // Not under backlight_mutex_, the handler may be waiting on it.
+  HWEventReactor::GetInstance()->RemoveSource(backlight_fd_);
+
+  std::lock_guard<std::mutex> lock(backlight_mutex_);
+  if (backlight_wd_ >= 0) {
+    Sys::inotify_rm_watch_(backlight_fd_, backlight_wd_);
+    backlight_wd_ = -1;
+  }
+  Sys::close_(backlight_fd_);
+  backlight_fd_ = -1;
 }
 
 DisplayError HWEventsDRM::Init(int display_id, DisplayType display_type,
@@ -266,7 +285,6 @@ DisplayError HWEventsDRM::Init(int display_id, DisplayType display_type,
     return kErrorParameters;
 
   static_cast<const HWDeviceDRM *>(hw_intf)->GetDRMDisplayToken(&token_);
-  is_primary_ = static_cast<const HWDeviceDRM *>(hw_intf)->IsPrimaryDisplay();
   std::string backlight_path;
   static_cast<const HWDeviceDRM *>(hw_intf)->GetPanelBrightnessBasePath(&backlight_path);
   brightness_node_ = backlight_path + "brightness";
@@ -275,18 +293,21 @@ DisplayError HWEventsDRM::Init(int display_id, DisplayType display_type,
         token_.crtc_id, token_.conn_id);
 
   event_handler_ = event_handler;
-  poll_fds_.resize(event_list.size());
-
-  DLOGI("poll_fd size %d", (int)poll_fds_.size());
+  event_list_ = event_list;
   event_thread_name_ += " - " + std::to_string(display_id) + "-" + std::to_string(display_type);
 
-  PopulateHWEventData(event_list);
-
-  if (pthread_create(&event_thread_, NULL, &DisplayEventThread, this) < 0) {
-    DLOGE("Failed to start %s, error = %s", event_thread_name_.c_str(), strerror(errno));
+  DRMEventDispatcher *dispatcher = DRMEventDispatcher::GetInstance();
+  if (!dispatcher) {
+    DLOGE("Failed to set up events for %s", event_thread_name_.c_str());
     return kErrorResources;
   }
 
+  if (IsEventSupported(HWEvent::BACKLIGHT_EVENT)) {
+    InitBacklightEvent();
+  }
+
+  dispatcher->Register(this, token_, &drm_fd_);
+
   int value = 0;
   if (Debug::Get()->GetProperty(DISABLE_HW_RECOVERY_PROP, &value) == kErrorNone) {
     disable_hw_recovery_ = (value == 1);
@@ -316,7 +337,10 @@ DisplayError HWEventsDRM::Init(int display_id, DisplayType display_type,
 }
 
 DisplayError HWEventsDRM::Deinit() {
-  exit_threads_ = true;
+  {
+    std::lock_guard<std::mutex> lock(vsync_mutex_);
+    vsync_enabled_ = false;
+  }
 
   SetEventState(HWEvent::PANEL_DEAD, false);
   SetEventState(HWEvent::IDLE_POWER_COLLAPSE, false);
@@ -326,10 +350,13 @@ DisplayError HWEventsDRM::Deinit() {
   SetEventState(HWEvent::POWER_EVENT, false);
   SetEventState(HWEvent::VM_RELEASE_EVENT, false);
 
-  Sys::pthread_cancel_(event_thread_);
-  WakeUpEventThread();
-  pthread_join(event_thread_, NULL);
-  CloseFds();
+  // Waits for the events being delivered to this display, if any.
+  DRMEventDispatcher::GetInstance()->Unregister(this);
+  DeinitBacklightEvent();
+  // Nothing is queued anymore, drop what the worker has not started and wait for the rest.
+  event_task_.CancelPending();
+  event_task_.Flush();
+  drm_fd_ = -1;
 
   return kErrorNone;
 }
@@ -352,17 +379,16 @@ DisplayError HWEventsDRM::SetEventState(HWEvent event, bool enable, void *arg) {
     } break;
     case HWEvent::BACKLIGHT_EVENT: {
       std::lock_guard<std::mutex> lock(backlight_mutex_);
-      if (backlight_event_index_ == UINT32_MAX) {
+      if (backlight_fd_ < 0) {
         return kErrorResources;
       }
-      int inotify_fd = poll_fds_[backlight_event_index_].fd;
       if (!enable) {
         if (backlight_wd_ > 0) {
-          Sys::inotify_rm_watch_(inotify_fd, backlight_wd_);
+          Sys::inotify_rm_watch_(backlight_fd_, backlight_wd_);
         }
         backlight_wd_ = -1;
       } else if (enable && backlight_wd_ < 0) {
-        backlight_wd_ = Sys::inotify_add_watch_(inotify_fd, brightness_node_.c_str(), IN_MODIFY);
+        backlight_wd_ = Sys::inotify_add_watch_(backlight_fd_, brightness_node_.c_str(), IN_MODIFY);
         if (backlight_wd_ < 0) {
           DLOGE("inotify_add_watch failed %d", backlight_wd_);
           return kErrorResources;
@@ -404,152 +430,12 @@ DisplayError HWEventsDRM::SetEventState(HWEvent event, bool enable, void *arg) {
   return kErrorNone;
 }
 
-void HWEventsDRM::WakeUpEventThread() {
-  for (uint32_t i = 0; i < event_data_list_.size(); i++) {
-    if (event_data_list_[i].event_type == HWEvent::EXIT && poll_fds_[i].fd >= 0) {
-      uint64_t exit_value = 1;
-      ssize_t write_size = Sys::write_(poll_fds_[i].fd, &exit_value, sizeof(uint64_t));
-      if (write_size != sizeof(uint64_t)) {
-        DLOGW("Error triggering exit fd (%d). write size = %zu, error = %s", poll_fds_[i].fd,
-              static_cast<size_t>(write_size), strerror(errno));
-      }
-      break;
-    }
-  }
-}
-
-void HWEventsDRM::CloseFds() {
-  for (uint32_t i = 0; i < event_data_list_.size(); i++) {
-    switch (event_data_list_[i].event_type) {
-      case HWEvent::VSYNC:
-        if (!is_primary_) {
-          drmClose(poll_fds_[i].fd);
-        }
-        poll_fds_[i].fd = -1;
-        break;
-      case HWEvent::EXIT:
-        Sys::close_(poll_fds_[i].fd);
-        poll_fds_[i].fd = -1;
-        break;
-      case HWEvent::BACKLIGHT_EVENT: {
-        std::lock_guard<std::mutex> lock(backlight_mutex_);
-        Sys::inotify_rm_watch_(poll_fds_[i].fd, backlight_wd_);
-        Sys::close_(poll_fds_[i].fd);
-        poll_fds_[i].fd = -1;
-      } break;
-      case HWEvent::MMRM:
-      case HWEvent::IDLE_POWER_COLLAPSE:
-      case HWEvent::PANEL_DEAD:
-      case HWEvent::HW_RECOVERY:
-      case HWEvent::HISTOGRAM:
-      case HWEvent::POWER_EVENT:
-      case HWEvent::VM_RELEASE_EVENT:
-        drmClose(poll_fds_[i].fd);
-        poll_fds_[i].fd = -1;
-        break;
-      case HWEvent::CEC_READ_MESSAGE:
-      case HWEvent::SHOW_BLANK_EVENT:
-      case HWEvent::THERMAL_LEVEL:
-      case HWEvent::PINGPONG_TIMEOUT:
-        break;
-      default:
-        break;
-    }
-  }
-}
-
-void *HWEventsDRM::DisplayEventThread(void *context) {
-  if (context) {
-    return reinterpret_cast<HWEventsDRM *>(context)->DisplayEventHandler();
-  }
-
-  return NULL;
-}
-
-void *HWEventsDRM::DisplayEventHandler() {
-  char data[kMaxStringLength]{};
-
-  prctl(PR_SET_NAME, event_thread_name_.c_str(), 0, 0, 0);
-  setpriority(PRIO_PROCESS, 0, kThreadPriorityUrgent);
-
-  // Real Time task with lowest priority.
-  struct sched_param param = {0};
-  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
-  sched_setscheduler(0, SCHED_FIFO, &param);
-
-  while (!exit_threads_) {
-    int error = Sys::poll_(poll_fds_.data(), UINT32(poll_fds_.size()), -1);
-    if (error <= 0) {
-      DLOGW("poll failed. error = %s", strerror(errno));
-      continue;
-    }
-
-    for (uint32_t i = 0; i < event_data_list_.size(); i++) {
-      pollfd &poll_fd = poll_fds_[i];
-      if (poll_fd.fd < 0) {
-        continue;
-      }
-
-      switch (event_data_list_[i].event_type) {
-        case HWEvent::VSYNC:
-        case HWEvent::PANEL_DEAD:
-        case HWEvent::IDLE_POWER_COLLAPSE:
-        case HWEvent::HW_RECOVERY:
-        case HWEvent::HISTOGRAM:
-        case HWEvent::MMRM:
-        case HWEvent::POWER_EVENT:
-        case HWEvent::VM_RELEASE_EVENT:
-          if (poll_fd.revents & (POLLIN | POLLPRI | POLLERR)) {
-            (this->*(event_data_list_[i]).event_parser)(nullptr);
-          }
-          break;
-        case HWEvent::EXIT:
-          if ((poll_fd.revents & POLLIN) &&
-              (Sys::read_(poll_fd.fd, data, kMaxStringLength) > 0)) {
-            (this->*(event_data_list_[i]).event_parser)(data);
-          }
-          break;
-        case HWEvent::BACKLIGHT_EVENT:
-          if ((poll_fd.revents & POLLIN)) {
-            char buffer[kMaxEventBufferLength] = {};
-            int len = 0;
-            int length = Sys::read_(poll_fd.fd, buffer, kMaxEventBufferLength);
-            while (len < length) {
-              struct inotify_event *event = (struct inotify_event *) &buffer[len];
-              DLOGI("event masks %x in_modify %x", event->mask, IN_MODIFY);
-              if (event->mask & IN_MODIFY) {
-                int brightness_fd = Sys::open_(brightness_node_.c_str(), O_RDONLY);
-                if (brightness_fd > 0) {
-                  if (Sys::read_(brightness_fd, data, kMaxStringLength) > 0) {
-                      (this->*(event_data_list_[i]).event_parser)(data);
-                  }
-                  Sys::close_(brightness_fd);
-                }
-              }
-              len += sizeof(struct inotify_event) + event->len;
-            }
-          }  break;
-        case HWEvent::CEC_READ_MESSAGE:
-        case HWEvent::SHOW_BLANK_EVENT:
-        case HWEvent::THERMAL_LEVEL:
-        case HWEvent::PINGPONG_TIMEOUT:
-          if ((poll_fd.revents & POLLPRI) &&
-              (Sys::pread_(poll_fd.fd, data, kMaxStringLength, 0) > 0)) {
-            (this->*(event_data_list_[i]).event_parser)(data);
-          }
-          break;
-      }
-    }
-  }
-
-  DLOGI("Exiting the thread");
-  pthread_exit(0);
-
-  return nullptr;
-}
-
 DisplayError HWEventsDRM::RegisterVSync() {
   DTRACE_SCOPED();
+  if (!IsEventSupported(HWEvent::VSYNC)) {
+    return kErrorNotSupported;
+  }
+
   drmVBlank vblank {};
   uint32_t high_crtc = token_.crtc_index << DRM_VBLANK_HIGH_CRTC_SHIFT;
   vblank.request.type = (drmVBlankSeqType)(DRM_VBLANK_RELATIVE | DRM_VBLANK_EVENT |
@@ -558,7 +444,7 @@ DisplayError HWEventsDRM::RegisterVSync() {
   // DRM hack to pass in context to unused field signal. Driver will write this to the node being
   // polled on, and will be read as part of drm event handling and sent to handler
   vblank.request.signal = reinterpret_cast<unsigned long>(this);  // NOLINT
-  int error = drmWaitVBlank(poll_fds_[vsync_index_].fd, &vblank);
+  int error = drmWaitVBlank(drm_fd_, &vblank);
   if (error < 0) {
     DLOGE("drmWaitVBlank failed with err %d", errno);
     return kErrorResources;
@@ -567,24 +453,25 @@ DisplayError HWEventsDRM::RegisterVSync() {
   return kErrorNone;
 }
 
+int HWEventsDRM::RegisterEvent(uint32_t object_type, uint32_t object_id, uint32_t drm_event,
+                               bool enable) {
+  struct drm_msm_event_req req = {};
+  req.object_id = object_id;
+  req.object_type = object_type;
+  req.event = drm_event;
+
+  int ret = drmIoctl(drm_fd_, enable ? DRM_IOCTL_MSM_REGISTER_EVENT :
+                     DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
+  return ret ? -errno : 0;
+}
+
 DisplayError HWEventsDRM::RegisterPanelDead(bool enable) {
-  if (panel_dead_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::PANEL_DEAD)) {
     DLOGI("panel dead is not supported event");
     return kErrorNone;
   }
 
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.conn_id;
-  req.object_type = DRM_MODE_OBJECT_CONNECTOR;
-  req.event = DRM_EVENT_PANEL_DEAD;
-  if (enable) {
-    ret = drmIoctl(poll_fds_[panel_dead_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[panel_dead_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
-
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CONNECTOR, token_.conn_id, DRM_EVENT_PANEL_DEAD, enable);
   if (ret) {
     DLOGE("register panel dead enable:%d failed", enable);
     return kErrorResources;
@@ -594,25 +481,13 @@ DisplayError HWEventsDRM::RegisterPanelDead(bool enable) {
 }
 
 DisplayError HWEventsDRM::RegisterPowerEvents(bool enable) {
-  if (power_event_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::POWER_EVENT)) {
     DLOGI("power event is not supported");
     return kErrorNone;
   }
 
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.crtc_id;
-  req.object_type = DRM_MODE_OBJECT_CRTC;
-  req.event = DRM_EVENT_CRTC_POWER;
-
-  if (enable) {
-    ret = drmIoctl(poll_fds_[power_event_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[power_event_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CRTC, token_.crtc_id, DRM_EVENT_CRTC_POWER, enable);
   if (ret) {
-    ret = -errno;
     if (ret == -ENOENT || ret == -ENODEV || ret == -EACCES) {
       DLOGW("%s event failed as the device has disconnected. Event_thread_name : %s Ret=%d",
             (enable) ? "Register" : "DeRegister", event_thread_name_.c_str(), ret);
@@ -626,22 +501,12 @@ DisplayError HWEventsDRM::RegisterPowerEvents(bool enable) {
 }
 
 DisplayError HWEventsDRM::RegisterHistogram(bool enable) {
-  if (histogram_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::HISTOGRAM)) {
     DLOGI("histogram is not supported event");
     return kErrorNone;
   }
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.crtc_id;
-  req.object_type = DRM_MODE_OBJECT_CRTC;
-  req.event = DRM_EVENT_HISTOGRAM;
-  if (enable) {
-    ret = drmIoctl(poll_fds_[histogram_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[histogram_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
 
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CRTC, token_.crtc_id, DRM_EVENT_HISTOGRAM, enable);
   if (ret) {
     DLOGE("register histogram enable:%d failed", enable);
     return kErrorResources;
@@ -651,23 +516,12 @@ DisplayError HWEventsDRM::RegisterHistogram(bool enable) {
 }
 
 DisplayError HWEventsDRM::RegisterIdlePowerCollapse(bool enable) {
-  if (idle_pc_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::IDLE_POWER_COLLAPSE)) {
     DLOGI("idle power collapse is not supported event");
     return kErrorNone;
   }
 
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.crtc_id;
-  req.object_type = DRM_MODE_OBJECT_CRTC;
-  req.event = DRM_EVENT_SDE_POWER;
-  if (enable) {
-    ret = drmIoctl(poll_fds_[idle_pc_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[idle_pc_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
-
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CRTC, token_.crtc_id, DRM_EVENT_SDE_POWER, enable);
   if (ret) {
     DLOGE("register idle power collapse enable:%d failed", enable);
     return kErrorResources;
@@ -677,22 +531,13 @@ DisplayError HWEventsDRM::RegisterIdlePowerCollapse(bool enable) {
 }
 
 DisplayError HWEventsDRM::RegisterHwRecovery(bool enable) {
-  if (hw_recovery_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::HW_RECOVERY)) {
     DLOGI("Hardware recovery is not supported");
     return kErrorNone;
   }
 
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.conn_id;
-  req.object_type = DRM_MODE_OBJECT_CONNECTOR;
-  req.event = DRM_EVENT_SDE_HW_RECOVERY;
-  if (enable) {
-    ret = drmIoctl(poll_fds_[hw_recovery_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[hw_recovery_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CONNECTOR, token_.conn_id, DRM_EVENT_SDE_HW_RECOVERY,
+                          enable);
   if (ret) {
     DLOGE("Register hardware recovery enable:%d failed", enable);
     return kErrorResources;
@@ -703,22 +548,12 @@ DisplayError HWEventsDRM::RegisterHwRecovery(bool enable) {
 }
 
 DisplayError HWEventsDRM::RegisterMMRM(bool enable) {
-  if (mmrm_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::MMRM)) {
     DLOGI("MMRM is not supported");
     return kErrorNone;
   }
 
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.crtc_id;
-  req.object_type = DRM_MODE_OBJECT_CRTC;
-  req.event = DRM_EVENT_MMRM_CB;
-  if (enable) {
-    ret = drmIoctl(poll_fds_[mmrm_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[mmrm_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CRTC, token_.crtc_id, DRM_EVENT_MMRM_CB, enable);
   if (ret) {
     DLOGE("Register MMRM enable:%d failed", enable);
     return kErrorResources;
@@ -728,22 +563,12 @@ DisplayError HWEventsDRM::RegisterMMRM(bool enable) {
 }
 
 DisplayError HWEventsDRM::RegisterVmReleaseEvents(bool enable) {
-  if (vm_release_event_index_ == UINT32_MAX) {
+  if (!IsEventSupported(HWEvent::VM_RELEASE_EVENT)) {
     DLOGI("Vm Release is not supported event");
     return kErrorNone;
   }
-  struct drm_msm_event_req req = {};
-  int ret = 0;
-
-  req.object_id = token_.crtc_id;
-  req.object_type = DRM_MODE_OBJECT_CRTC;
-  req.event = DRM_EVENT_VM_RELEASE;
-  if (enable) {
-    ret = drmIoctl(poll_fds_[vm_release_event_index_].fd, DRM_IOCTL_MSM_REGISTER_EVENT, &req);
-  } else {
-    ret = drmIoctl(poll_fds_[vm_release_event_index_].fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &req);
-  }
 
+  int ret = RegisterEvent(DRM_MODE_OBJECT_CRTC, token_.crtc_id, DRM_EVENT_VM_RELEASE, enable);
   if (ret) {
     DLOGE("register vm release event %s failed with ret %d", enable ? "enable" : "disable", ret);
     return kErrorResources;
@@ -753,9 +578,9 @@ DisplayError HWEventsDRM::RegisterVmReleaseEvents(bool enable) {
   return kErrorNone;
 }
 
-void HWEventsDRM::HandleVSync(char *data) {
+void HWEventsDRM::HandleVSync(const vector<int64_t> &timestamps) {
+  DTRACE_SCOPED();
   DisplayError ret = kErrorNone;
-  vsync_handler_count_ = 0;  //  reset vsync handler count. lock not needed
   {
     std::lock_guard<std::mutex> lock(vsync_mutex_);
     vsync_registered_ = false;
@@ -765,15 +590,11 @@ void HWEventsDRM::HandleVSync(char *data) {
     }
   }
 
-  drmEventContext event = {};
-  event.version = DRM_EVENT_CONTEXT_VERSION;
-  event.vblank_handler = &HWEventsDRM::VSyncHandlerCallback;
-  int error = drmHandleEvent(poll_fds_[vsync_index_].fd, &event);
-  if (error != 0) {
-    DLOGE("drmHandleEvent failed: %i", error);
+  for (auto timestamp : timestamps) {
+    event_handler_->VSync(timestamp);
   }
 
-  if (vsync_handler_count_ > 1) {
+  if (timestamps.size() > 1) {
     //  probable thread preemption caused > 1 vsync handling. Re-enable vsync before polling
     std::lock_guard<std::mutex> lock(vsync_mutex_);
     vsync_registered_ = false;
@@ -784,242 +605,183 @@ void HWEventsDRM::HandleVSync(char *data) {
   }
 }
 
-void HWEventsDRM::HandlePanelDead(char *data) {
-  char event_data[kMaxStringLength] = {0};
-  int32_t size;
-  struct drm_msm_event_resp *event_resp = NULL;
-
-  size = (int32_t)Sys::pread_(poll_fds_[panel_dead_index_].fd, event_data, kMaxStringLength, 0);
-  if (size <= 0) {
-    return;
-  }
-
-  if (size > kMaxStringLength) {
-    DLOGE("event size %d is greater than event buffer size %d\n", size, kMaxStringLength);
-    return;
+void HWEventsDRM::QueueDRMEvent(const struct drm_msm_event_resp *event_resp) {
+  auto context = std::make_shared<DRMEventContext>();
+  auto begin = reinterpret_cast<const uint8_t *>(event_resp);
+  context->event.assign(begin, begin + event_resp->base.length);
+  if (!QueueTask(DRMEventTaskCode::kCodeDRMEvent, context)) {
+    DLOGW("%s: worker is stuck, dropping event %x", event_thread_name_.c_str(),
+          event_resp->base.type);
   }
+}
 
-  if (size < (int32_t)sizeof(*event_resp)) {
-    DLOGE("Invalid event size %d expected %zd\n", size, sizeof(*event_resp));
-    return;
+bool HWEventsDRM::QueueTask(DRMEventTaskCode task_code,
+                            const std::shared_ptr<DRMEventContext> &context) {
+  // Only the reactor thread queues, the count cannot grow behind its back.
+  if (event_task_.GetPendingCount() >= kMaxPendingEvents) {
+    return false;
   }
 
-  int32_t i = 0;
-  while (i < size) {
-    event_resp = (struct drm_msm_event_resp *)&event_data[i];
-    switch (event_resp->base.type) {
-      case DRM_EVENT_PANEL_DEAD:
-      {
-        DLOGI("Received panel dead event");
-        event_handler_->PanelDead();
-        break;
-      }
-      default: {
-        DLOGE("invalid event %d", event_resp->base.type);
-        break;
-      }
-    }
-    i += event_resp->base.length;
-  }
-
-  return;
+  event_task_.PostTask(task_code, context);
+  return true;
 }
 
-void HWEventsDRM::VSyncHandlerCallback(int fd, unsigned int sequence, unsigned int tv_sec,
-                                       unsigned int tv_usec, void *data) {
-  HWEventsDRM *ev_data = reinterpret_cast<HWEventsDRM *>(data);
-  ev_data->vsync_handler_count_++;
-  int64_t timestamp = (int64_t)(tv_sec)*1000000000 + (int64_t)(tv_usec)*1000;
-  DTRACE_SCOPED();
-  ev_data->event_handler_->VSync(timestamp);
+void HWEventsDRM::OnTask(const DRMEventTaskCode &task_code,
+                         AsyncTask<DRMEventTaskCode>::TaskContext *task_context) {
+  switch (task_code) {
+    case DRMEventTaskCode::kCodeDRMEvent: {
+      auto context = static_cast<DRMEventContext *>(task_context);
+      HandleDRMEvent(reinterpret_cast<const struct drm_msm_event_resp *>(context->event.data()));
+    } break;
+    case DRMEventTaskCode::kCodeBacklight:
+      ReadBacklight();
+      break;
+  }
 }
 
-void HWEventsDRM::HandleCECMessage(char *data) {
-  event_handler_->CECMessage(data);
+void HWEventsDRM::HandleDRMEvent(const struct drm_msm_event_resp *event_resp) {
+  switch (event_resp->base.type) {
+    case DRM_EVENT_PANEL_DEAD:
+      HandlePanelDead(event_resp);
+      break;
+    case DRM_EVENT_SDE_POWER:
+      HandleIdlePowerCollapse(event_resp);
+      break;
+    case DRM_EVENT_SDE_HW_RECOVERY:
+      HandleHwRecovery(event_resp);
+      break;
+    case DRM_EVENT_HISTOGRAM:
+      HandleHistogram(event_resp);
+      break;
+    case DRM_EVENT_MMRM_CB:
+      HandleMMRM(event_resp);
+      break;
+    case DRM_EVENT_CRTC_POWER:
+      HandlePowerEvent(event_resp);
+      break;
+    case DRM_EVENT_VM_RELEASE:
+      HandleVmReleaseEvent(event_resp);
+      break;
+    default:
+      DLOGE("invalid event %d", event_resp->base.type);
+      break;
+  }
 }
 
-void HWEventsDRM::HandleIdlePowerCollapse(char *data) {
-  char event_data[kMaxStringLength];
-  int32_t size;
-  struct drm_msm_event_resp *event_resp = NULL;
-
-  size = (int32_t)Sys::pread_(poll_fds_[idle_pc_index_].fd, event_data, kMaxStringLength, 0);
-  if (size < 0) {
-    return;
+// Returns the 32 bit payload of an event, or nullptr if the event does not carry one.
+static const uint32_t *GetEventPayload(const struct drm_msm_event_resp *event_resp) {
+  if (event_resp->base.length < sizeof(*event_resp) + sizeof(uint32_t)) {
+    DLOGE("event %x size %d is unexpected", event_resp->base.type, event_resp->base.length);
+    return nullptr;
   }
 
-  if (size > kMaxStringLength) {
-    DLOGE("event size %d is greater than event buffer size %d\n", size, kMaxStringLength);
-    return;
-  }
+  return reinterpret_cast<const uint32_t *>(event_resp->data);
+}
 
-  if (size < (int32_t)sizeof(*event_resp)) {
-    DLOGE("size %d exp %zd\n", size, sizeof(*event_resp));
-    return;
-  }
+void HWEventsDRM::HandlePanelDead(const struct drm_msm_event_resp * /*event_resp*/) {
+  DLOGI("Received panel dead event");
+  event_handler_->PanelDead();
+}
 
-  int32_t i = 0;
-
-  while (i < size) {
-    event_resp = (struct drm_msm_event_resp *)&event_data[i];
-    switch (event_resp->base.type) {
-      case DRM_EVENT_SDE_POWER:
-      {
-        uint32_t* event_payload = reinterpret_cast<uint32_t *>(event_resp->data);
-        if (*event_payload == 0) {
-          DLOGV("Received Idle power collapse event");
-          event_handler_->IdlePowerCollapse();
-        }
-        break;
-      }
-      default: {
-        DLOGE("invalid event %d", event_resp->base.type);
-        break;
-      }
-    }
-    i += event_resp->base.length;
+void HWEventsDRM::HandleIdlePowerCollapse(const struct drm_msm_event_resp *event_resp) {
+  const uint32_t *event_payload = GetEventPayload(event_resp);
+  if (event_payload && *event_payload == 0) {
+    DLOGV("Received Idle power collapse event");
+    event_handler_->IdlePowerCollapse();
   }
-
-  return;
 }
 
-void HWEventsDRM::HandleHwRecovery(char *data) {
-  char event_data[kMaxStringLength] = {0};
-  int32_t size;
-  struct drm_msm_event_resp *event_resp = NULL;
-
-  size = (int32_t)Sys::pread_(poll_fds_[hw_recovery_index_].fd, event_data, kMaxStringLength, 0);
-  if (size < 0) {
+void HWEventsDRM::HandleHwRecovery(const struct drm_msm_event_resp *event_resp) {
+  std::size_t size_of_data = (std::size_t)event_resp->base.length -
+                             (sizeof(event_resp->base) + sizeof(event_resp->info));
+  // expect up to uint32_t from driver
+  if (size_of_data > sizeof(uint32_t)) {
+    DLOGE("Size of hardware recovery event data: %zu exceeds %zu", size_of_data,
+          sizeof(uint32_t));
     return;
   }
 
-  if (size > kMaxStringLength) {
-    DLOGE("Hardware recovery event size %d is greater than event buffer size %d\n", size,
-          kMaxStringLength);
-    return;
-  }
+  uint32_t hw_event_code = 0;
+  memcpy(&hw_event_code, event_resp->data, size_of_data);
 
-  if (size < (int32_t)sizeof(*event_resp)) {
-    DLOGE("Hardware recovery event size is %d, expected %zd\n", size, sizeof(*event_resp));
+  HWRecoveryEvent sdm_event_code;
+  if (SetHwRecoveryEvent(hw_event_code, &sdm_event_code)) {
     return;
   }
-
-  int32_t i = 0;
-
-  while (i < size) {
-    event_resp = (struct drm_msm_event_resp *)&event_data[i];
-    switch (event_resp->base.type) {
-      case DRM_EVENT_SDE_HW_RECOVERY: {
-        std::size_t size_of_data = (std::size_t)event_resp->base.length -
-                                   (sizeof(event_resp->base) + sizeof(event_resp->info));
-        // expect up to uint32_t from driver
-        if (size_of_data > sizeof(uint32_t)) {
-          DLOGE("Size of hardware recovery event data: %zu exceeds %zu", size_of_data,
-                sizeof(uint32_t));
-          return;
-        }
-
-        uint32_t hw_event_code = 0;
-        memcpy(&hw_event_code, event_resp->data, size_of_data);
-
-        HWRecoveryEvent sdm_event_code;
-        if (SetHwRecoveryEvent(hw_event_code, &sdm_event_code)) {
-          return;
-        }
-        event_handler_->HwRecovery(sdm_event_code);
-        break;
-      }
-      default: {
-        DLOGE("Invalid event type %d", event_resp->base.type);
-        break;
-      }
-    }
-    i += event_resp->base.length;
-  }
-
-  return;
+  event_handler_->HwRecovery(sdm_event_code);
 }
 
-void HWEventsDRM::HandlePowerEvent(char * /*data*/) {
+void HWEventsDRM::HandlePowerEvent(const struct drm_msm_event_resp *event_resp) {
   DTRACE_SCOPED();
-  auto constexpr expected_size = sizeof(drm_msm_event_resp) + sizeof(uint32_t);
-  std::array<char, expected_size> event_data{'\0'};
-  auto size = Sys::pread_(poll_fds_[power_event_index_].fd, event_data.data(),
-                          event_data.size(), 0);
-  if (size != expected_size) {
-    DLOGE("event size %d is unexpected. skipping this power event", UINT32(size));
+  const uint32_t *event_payload = GetEventPayload(event_resp);
+  if (!event_payload) {
     return;
   }
 
-  auto msm_event = reinterpret_cast<struct drm_msm_event_resp *>(event_data.data());
-  DLOGI("poweron %d", *(reinterpret_cast<uint32_t *>(msm_event->data)));
-
+  DLOGI("poweron %d", *event_payload);
   event_handler_->HandlePowerEvent();
 }
 
-void HWEventsDRM::HandleHistogram(char * /*data*/) {
-  auto constexpr expected_size = sizeof(drm_msm_event_resp) + sizeof(uint32_t);
-  std::array<char, expected_size> event_data{'\0'};
-  auto size = Sys::pread_(poll_fds_[histogram_index_].fd, event_data.data(), event_data.size(), 0);
-  if (size != expected_size) {
-    DLOGE("event size %d is unexpected. skipping this histogram event", UINT32(size));
+void HWEventsDRM::HandleHistogram(const struct drm_msm_event_resp *event_resp) {
+  const uint32_t *blob_id = GetEventPayload(event_resp);
+  if (!blob_id) {
     return;
   }
 
-  auto msm_event = reinterpret_cast<struct drm_msm_event_resp *>(event_data.data());
-  auto blob_id = reinterpret_cast<uint32_t *>(msm_event->data);
-  event_handler_->Histogram(poll_fds_[histogram_index_].fd, *blob_id);
+  event_handler_->Histogram(drm_fd_, *blob_id);
 }
 
-void HWEventsDRM::HandleBacklightEvent(char *data) {
-  event_handler_->HandleBacklightEvent(atof(data));
-}
-
-void HWEventsDRM::HandleMMRM(char *data) {
-  DTRACE_SCOPED();
-  char event_data[kMaxStringLength];
-  int32_t size;
-  struct drm_msm_event_resp *event_resp = NULL;
-
-  size = (int32_t)Sys::pread_(poll_fds_[mmrm_index_].fd, event_data, kMaxStringLength, 0);
-  if (size < 0) {
-    DLOGW("Size is invalid!");
+void HWEventsDRM::HandleBacklightEvent(uint32_t epoll_events) {
+  if (!(epoll_events & EPOLLIN)) {
     return;
   }
 
-  if (size > kMaxStringLength) {
-    DLOGE("event size %d is greater than event buffer size %d\n", size, kMaxStringLength);
-    return;
+  // The inotify events are drained here, the brightness node is read on the worker. Several
+  // modifications in a row need a single read of the latest level.
+  char buffer[kMaxEventBufferLength] = {};
+  bool modified = false;
+  int len = 0;
+  int length = Sys::read_(backlight_fd_, buffer, kMaxEventBufferLength);
+  while (len < length) {
+    struct inotify_event *event = (struct inotify_event *) &buffer[len];
+    DLOGI("event masks %x in_modify %x", event->mask, IN_MODIFY);
+    modified |= (event->mask & IN_MODIFY) != 0;
+    len += sizeof(struct inotify_event) + event->len;
   }
 
-  if (size < (int32_t)sizeof(*event_resp)) {
-    DLOGE("size %d exp %zd\n", size, sizeof(*event_resp));
-    return;
+  if (modified && !QueueTask(DRMEventTaskCode::kCodeBacklight, nullptr)) {
+    DLOGW("%s: worker is stuck, dropping backlight event", event_thread_name_.c_str());
   }
+}
 
-  int32_t i = 0;
-
-  while (i < size) {
-    event_resp = (struct drm_msm_event_resp *)&event_data[i];
-    switch (event_resp->base.type) {
-      case DRM_EVENT_MMRM_CB:
-      {
-        uint32_t* event_payload = reinterpret_cast<uint32_t *>(event_resp->data);
-        if (event_payload) {
-          DLOGV("Received MMRM event");
-          event_handler_->MMRMEvent(*event_payload);
-        }
-        break;
-      }
-      default: {
-        DLOGE("invalid event %d", event_resp->base.type);
-        break;
-      }
+void HWEventsDRM::ReadBacklight() {
+  char data[kMaxStringLength]{};
+  int brightness_fd = Sys::open_(brightness_node_.c_str(), O_RDONLY);
+  if (brightness_fd > 0) {
+    if (Sys::read_(brightness_fd, data, kMaxStringLength) > 0) {
+      event_handler_->HandleBacklightEvent(atof(data));
     }
-    i += event_resp->base.length;
+    Sys::close_(brightness_fd);
   }
+}
 
-  return;
+void HWEventsDRM::HandleMMRM(const struct drm_msm_event_resp *event_resp) {
+  DTRACE_SCOPED();
+  const uint32_t *event_payload = GetEventPayload(event_resp);
+  if (event_payload) {
+    DLOGV("Received MMRM event");
+    event_handler_->MMRMEvent(*event_payload);
+  }
+}
+
+void HWEventsDRM::HandleVmReleaseEvent(const struct drm_msm_event_resp *event_resp) {
+  const uint32_t *event_payload = GetEventPayload(event_resp);
+  if (!event_payload) {
+    return;
+  }
+
+  DLOGI("vm release event data %d", *event_payload);
+  event_handler_->HandleVmReleaseEvent();
 }
 
 int HWEventsDRM::SetHwRecoveryEvent(const uint32_t hw_event_code, HWRecoveryEvent *sdm_event_code) {
@@ -1041,19 +803,4 @@ int HWEventsDRM::SetHwRecoveryEvent(const uint32_t hw_event_code, HWRecoveryEven
   return 0;
 }
 
-void HWEventsDRM::HandleVmReleaseEvent(char * /*data*/) {
-  auto constexpr expected_size = sizeof(drm_msm_event_resp) + sizeof(uint32_t);
-  std::array<char, expected_size> event_data{'\0'};
-  auto size = Sys::pread_(poll_fds_[vm_release_event_index_].fd, event_data.data(),
-                          event_data.size(), 0);
-  if (size != expected_size) {
-    DLOGE("event size %d is unexpected. skipping this vm release event", UINT32(size));
-    return;
-  }
-
-  auto msm_event = reinterpret_cast<struct drm_msm_event_resp *>(event_data.data());
-  DLOGI("vm release event data %d", *(reinterpret_cast<uint32_t *>(msm_event->data)));
-  event_handler_->HandleVmReleaseEvent();
-}
-
 }  // namespace sdm
@@ -31,11 +31,15 @@
 #define __HW_EVENTS_DRM_H__
 
 #include <drm_interface.h>
-#include <sys/poll.h>
+#include <drm/msm_drm.h>
 #include <sys/inotify.h>
+#include <utils/async_task.h>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <climits>
@@ -48,48 +52,105 @@ namespace sdm {
 
 using std::vector;
 
-class HWEventsDRM : public HWEventsInterface {
+class HWEventsDRM;
+
+enum class DRMEventTaskCode : int32_t {
+  kCodeDRMEvent,
+  kCodeBacklight,
+};
+
+struct DRMEventContext : public AsyncTask<DRMEventTaskCode>::TaskContext {
+  // Copy of the drm_msm_event_resp, the buffer it was read into is reused for the next events.
+  vector<uint8_t> event;
+};
+
+// Owns the DRM fd that carries the vblank and driver events of all displays. The fd is read on
+// the event reactor thread, and each event is routed to the display whose CRTC or connector it
+// was raised for. Vsync is handled right there, the other events are queued to the worker of
+// the display, so that a slow handler does not delay the vsync of any display.
+class DRMEventDispatcher {
+ public:
+  static DRMEventDispatcher *GetInstance();
+
+  // Returns the shared fd, to request events on.
+  DisplayError Register(HWEventsDRM *events, const sde_drm::DRMDisplayToken &token, int *fd);
+  // Once this returns, no event is delivered to events anymore. When called from an event
+  // handler, the handler being run may be the one of events; it is not waited for.
+  void Unregister(HWEventsDRM *events);
+
+ protected:
+  // Reads the pending events of fd_ and delivers them.
+  void HandleEvents(uint32_t epoll_events);
+
+  int fd_ = -1;
+
+ private:
+  static const int kMaxEventBufferLength = 4096;
+
+  struct Delivery {
+    HWEventsDRM *display = nullptr;
+    vector<int64_t> vsyncs;
+    const struct drm_msm_event_resp *event_resp = nullptr;
+  };
+
+  DisplayError Init();
+  HWEventsDRM *FindDisplay(uint32_t object_type, uint32_t object_id);
+  void Deliver(const Delivery &delivery);
+
+  // Not held while events are delivered, so that a display blocked in its handler does not hold
+  // up the registration of the others.
+  std::mutex lock_;
+  std::condition_variable delivery_done_;
+  std::map<HWEventsDRM *, sde_drm::DRMDisplayToken> displays_;
+  HWEventsDRM *delivering_ = nullptr;  // Display whose handler is running.
+  std::thread::id delivery_thread_;
+};
+
+class HWEventsDRM : public HWEventsInterface, public AsyncTask<DRMEventTaskCode>::TaskHandler {
  public:
   virtual DisplayError Init(int display_id, DisplayType display_type, HWEventHandler *event_handler,
                             const vector<HWEvent> &event_list, const HWInterface *hw_intf);
   virtual DisplayError Deinit();
   virtual DisplayError SetEventState(HWEvent event, bool enable, void *aux = nullptr);
 
+ protected:
+  friend class DRMEventDispatcher;
+
+  // Called by the dispatcher on the reactor thread.
+  virtual void HandleVSync(const vector<int64_t> &timestamps);
+  virtual void QueueDRMEvent(const struct drm_msm_event_resp *event_resp);
+
+  HWEventHandler *event_handler_{};
+  sde_drm::DRMDisplayToken token_ = {};
+
  private:
   static const int kMaxStringLength = 1024;
   static const int kMaxEventBufferLength = (kMaxStringLength * (sizeof(struct inotify_event) + 16));
+  // Events queued to the worker. It is stuck if it falls this far behind, further events are
+  // dropped rather than blocking the reactor thread.
+  static constexpr uint32_t kMaxPendingEvents = 32;
 
-  typedef void (HWEventsDRM::*EventParser)(char *);
-
-  struct HWEventData {
-    HWEvent event_type {};
-    EventParser event_parser {};
-  };
+  // AsyncTask methods.
+  void OnTask(const DRMEventTaskCode &task_code,
+              AsyncTask<DRMEventTaskCode>::TaskContext *task_context);
 
-  static void *DisplayEventThread(void *context);
-  static void VSyncHandlerCallback(int fd, unsigned int sequence, unsigned int tv_sec,
-                                   unsigned int tv_usec, void *data);
-
-  void *DisplayEventHandler();
-  void HandleVSync(char *data);
-  void HandleCECMessage(char *data);
-  void HandleThreadExit(char *data) {}
-  void HandleThermal(char *data) {}
-  void HandleBlank(char *data) {}
-  void HandleIdlePowerCollapse(char *data);
-  void HandlePanelDead(char *data);
-  void HandleHwRecovery(char *data);
-  void HandleHistogram(char *data);
-  void HandleBacklightEvent(char *data);
-  void HandleMMRM(char *data);
-  void HandlePowerEvent(char * /*data*/);
-  void HandleVmReleaseEvent(char * /*data*/);
+  bool IsEventSupported(HWEvent event) const;
+  // Returns false if the worker has too many events pending to take it.
+  bool QueueTask(DRMEventTaskCode task_code, const std::shared_ptr<DRMEventContext> &context);
+  void HandleDRMEvent(const struct drm_msm_event_resp *event_resp);
+  void HandleIdlePowerCollapse(const struct drm_msm_event_resp *event_resp);
+  void HandlePanelDead(const struct drm_msm_event_resp *event_resp);
+  void HandleHwRecovery(const struct drm_msm_event_resp *event_resp);
+  void HandleHistogram(const struct drm_msm_event_resp *event_resp);
+  void HandleBacklightEvent(uint32_t epoll_events);
+  void ReadBacklight();
+  void HandleMMRM(const struct drm_msm_event_resp *event_resp);
+  void HandlePowerEvent(const struct drm_msm_event_resp *event_resp);
+  void HandleVmReleaseEvent(const struct drm_msm_event_resp *event_resp);
   int SetHwRecoveryEvent(const uint32_t hw_event_code, HWRecoveryEvent *sdm_event_code);
-  void PopulateHWEventData(const vector<HWEvent> &event_list);
-  void WakeUpEventThread();
-  DisplayError SetEventParser();
-  DisplayError InitializePollFd();
-  void CloseFds();
+  DisplayError InitBacklightEvent();
+  void DeinitBacklightEvent();
+  int RegisterEvent(uint32_t object_type, uint32_t object_id, uint32_t drm_event, bool enable);
   DisplayError RegisterVSync();
   DisplayError RegisterPanelDead(bool enable);
   DisplayError RegisterIdlePowerCollapse(bool enable);
@@ -99,33 +160,22 @@ class HWEventsDRM : public HWEventsInterface {
   DisplayError RegisterPowerEvents(bool enable);
   DisplayError RegisterVmReleaseEvents(bool enable);
 
-  HWEventHandler *event_handler_{};
-  vector<HWEventData> event_data_list_{};
-  vector<pollfd> poll_fds_{};
-  pthread_t event_thread_{};
+  vector<HWEvent> event_list_{};
   std::string event_thread_name_ = "SDM_EventThread";
-  bool exit_threads_ = false;
-  uint32_t vsync_index_ = UINT32_MAX;
-  uint32_t histogram_index_ = UINT32_MAX;
+  int drm_fd_ = -1;  // Shared by all displays, owned by DRMEventDispatcher.
   bool vsync_enabled_ = false;
   bool vsync_registered_ = false;
-  uint32_t vsync_handler_count_ = 0;
   std::mutex vsync_mutex_;  // To protect vsync_enabled_ and vsync_registered_
-  sde_drm::DRMDisplayToken token_ = {};
-  bool is_primary_ = false;
-  uint32_t panel_dead_index_ = UINT32_MAX;
-  uint32_t idle_pc_index_ = UINT32_MAX;
   bool disable_hw_recovery_ = false;
   bool enable_hist_interrupt_ = false;
-  uint32_t hw_recovery_index_ = UINT32_MAX;
   std::mutex backlight_mutex_;
-  uint32_t backlight_event_index_ = UINT32_MAX;
+  int backlight_fd_ = -1;
   std::string brightness_node_ = {};
   int backlight_wd_ = -1;
   bool disable_mmrm_ = false;
-  uint32_t mmrm_index_ = UINT32_MAX;
-  uint32_t power_event_index_ = UINT32_MAX;
-  uint32_t vm_release_event_index_ = UINT32_MAX;
+  // Runs the handlers of the events other than vsync. Declared last, so that it is stopped
+  // before the state they use goes away.
+  AsyncTask<DRMEventTaskCode> event_task_{*this, kMaxPendingEvents};
 };
 
 }  // namespace sdm
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <xf86drmMode.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hw_event_reactor.h"
+#include "hw_events_drm.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::steady_clock;
+
+// Reads the events from a pipe, on the reactor thread.
+class PipeDispatcher : public DRMEventDispatcher {
+ public:
+  explicit PipeDispatcher(HWEventReactor *reactor) : reactor_(reactor) {
+    pipe2(pipe_, O_CLOEXEC);
+    fd_ = pipe_[0];
+    reactor_->AddSource(fd_, EPOLLIN, [this](uint32_t events) { HandleEvents(events); });
+  }
+
+  ~PipeDispatcher() {
+    reactor_->RemoveSource(fd_);
+    close(pipe_[0]);
+    close(pipe_[1]);
+  }
+
+  void Write(const void *event, size_t size) { write(pipe_[1], event, size); }
+
+ private:
+  HWEventReactor *reactor_;
+  int pipe_[2] = {-1, -1};
+};
+
+// Signals once an event is handled, and takes duration to handle a panel dead event.
+class Handler : public HWEventHandler {
+ public:
+  explicit Handler(std::chrono::microseconds duration = {}) : duration_(duration) {}
+
+  DisplayError VSync(int64_t timestamp) override {
+    Signal();
+    return kErrorNone;
+  }
+  void PanelDead() override {
+    Signal();
+    std::this_thread::sleep_for(duration_);
+  }
+  DisplayError Blank(bool blank) override { return kErrorNone; }
+  void CECMessage(char *message) override {}
+  void IdlePowerCollapse() override {}
+  void PingPongTimeout() override {}
+  void HwRecovery(const HWRecoveryEvent sdm_event_code) override {}
+  void Histogram(int histogram_fd, uint32_t blob_id) override {}
+  void HandleBacklightEvent(float brightness_level) override {}
+  void MMRMEvent(uint32_t clk) override {}
+  void HandlePowerEvent() override {}
+  void HandleVmReleaseEvent() override {}
+
+  // Waits for the count-th event since the start, and returns when it was signaled.
+  steady_clock::time_point Wait(uint64_t count) {
+    std::unique_lock<std::mutex> lock(lock_);
+    cv_.wait(lock, [this, count] { return count_ >= count; });
+    return signaled_;
+  }
+
+ private:
+  void Signal() {
+    std::lock_guard<std::mutex> lock(lock_);
+    signaled_ = steady_clock::now();
+    count_++;
+    cv_.notify_all();
+  }
+
+  std::chrono::microseconds duration_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  uint64_t count_ = 0;
+  steady_clock::time_point signaled_;
+};
+
+class Display : public HWEventsDRM {
+ public:
+  Display(HWEventHandler *handler, uint32_t crtc_id, uint32_t conn_id) {
+    event_handler_ = handler;
+    token_.crtc_id = crtc_id;
+    token_.conn_id = conn_id;
+  }
+
+  const sde_drm::DRMDisplayToken &token() { return token_; }
+};
+
+}  // namespace
+
+// The vsync of one display, raised while the panel dead handler of another display is running
+// for handler_us. Reports the time from the vblank being readable to the vsync handler.
+static void BM_VSyncDispatchLatency(benchmark::State &state) {
+  HWEventReactor reactor("BM_EventThread");
+  reactor.Init();
+  PipeDispatcher dispatcher(&reactor);
+  Handler vsync_handler;
+  Handler slow_handler(std::chrono::microseconds(state.range(0)));
+  Display vsync_display(&vsync_handler, 10, 20);
+  Display slow_display(&slow_handler, 11, 21);
+  int fd = -1;
+  dispatcher.Register(&vsync_display, vsync_display.token(), &fd);
+  dispatcher.Register(&slow_display, slow_display.token(), &fd);
+
+  struct drm_event_vblank vblank = {};
+  vblank.base.type = DRM_EVENT_VBLANK;
+  vblank.base.length = sizeof(vblank);
+  vblank.user_data = reinterpret_cast<uint64_t>(&vsync_display);
+  std::vector<uint8_t> panel_dead(sizeof(struct drm_msm_event_resp) + sizeof(uint64_t));
+  auto event_resp = reinterpret_cast<struct drm_msm_event_resp *>(panel_dead.data());
+  event_resp->base.type = DRM_EVENT_PANEL_DEAD;
+  event_resp->base.length = UINT32(panel_dead.size());
+  event_resp->info.object_type = DRM_MODE_OBJECT_CONNECTOR;
+  event_resp->info.object_id = 21;
+
+  uint64_t count = 0;
+  for (auto _ : state) {
+    count++;
+    if (state.range(0)) {
+      dispatcher.Write(panel_dead.data(), panel_dead.size());
+      slow_handler.Wait(count);
+    }
+    auto start = steady_clock::now();
+    dispatcher.Write(&vblank, sizeof(vblank));
+    auto end = vsync_handler.Wait(count);
+    state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+  }
+
+  dispatcher.Unregister(&vsync_display);
+  dispatcher.Unregister(&slow_display);
+}
+BENCHMARK(BM_VSyncDispatchLatency)->ArgName("handler_us")->Arg(0)->Arg(1000)->Arg(8000)
+    ->UseManualTime()->Iterations(100);
+
+}  // namespace sdm
+
+BENCHMARK_MAIN();
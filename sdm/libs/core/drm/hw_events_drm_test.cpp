@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <xf86drmMode.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hw_events_drm.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const milliseconds kTimeout(2000);
+
+// Appends the vblank the driver raises for a vsync requested by display.
+void AddVBlank(vector<uint8_t> *buffer, HWEventsDRM *display, uint32_t usec) {
+  struct drm_event_vblank vblank = {};
+  vblank.base.type = DRM_EVENT_VBLANK;
+  vblank.base.length = sizeof(vblank);
+  vblank.user_data = reinterpret_cast<uint64_t>(display);
+  vblank.tv_usec = usec;
+  auto begin = reinterpret_cast<uint8_t *>(&vblank);
+  buffer->insert(buffer->end(), begin, begin + sizeof(vblank));
+}
+
+// Appends a driver event raised for a CRTC or connector, with a payload padded to keep the
+// events that follow aligned.
+void AddEvent(vector<uint8_t> *buffer, uint32_t type, uint32_t object_type, uint32_t object_id) {
+  struct drm_msm_event_resp event_resp = {};
+  event_resp.base.type = type;
+  event_resp.base.length = sizeof(event_resp) + sizeof(uint64_t);
+  event_resp.info.object_type = object_type;
+  event_resp.info.object_id = object_id;
+  auto begin = reinterpret_cast<uint8_t *>(&event_resp);
+  buffer->insert(buffer->end(), begin, begin + sizeof(event_resp));
+  buffer->insert(buffer->end(), sizeof(uint64_t), 0);
+}
+
+std::string GetEventEntry(const std::string &display, uint32_t type) {
+  return display + " event " + std::to_string(type);
+}
+
+// Reads the events from a pipe instead of the DRM device.
+class TestDispatcher : public DRMEventDispatcher {
+ public:
+  TestDispatcher() {
+    pipe2(pipe_, O_CLOEXEC);
+    fd_ = pipe_[0];
+  }
+
+  ~TestDispatcher() {
+    close(pipe_[0]);
+    close(pipe_[1]);
+  }
+
+  // Reads and delivers the events of buffer, as the reactor does once the fd is readable.
+  void Dispatch(const vector<uint8_t> &buffer) {
+    ASSERT_EQ(ssize_t(buffer.size()), write(pipe_[1], buffer.data(), buffer.size()));
+    HandleEvents(EPOLLIN);
+  }
+
+ private:
+  int pipe_[2] = {-1, -1};
+};
+
+// Records what the dispatcher hands to a display, in a log shared by all displays.
+class RecordingDisplay : public HWEventsDRM {
+ public:
+  RecordingDisplay(const std::string &name, uint32_t crtc_id, uint32_t conn_id,
+                   vector<std::string> *log)
+    : name_(name), log_(log) {
+    token_.crtc_id = crtc_id;
+    token_.conn_id = conn_id;
+  }
+
+  const sde_drm::DRMDisplayToken &token() { return token_; }
+
+  std::function<void()> on_vsync_;
+
+ protected:
+  void HandleVSync(const vector<int64_t> &timestamps) override {
+    std::string entry = name_ + " vsync";
+    for (auto timestamp : timestamps) {
+      entry += " " + std::to_string(timestamp);
+    }
+    log_->push_back(entry);
+    if (on_vsync_) {
+      on_vsync_();
+    }
+  }
+
+  void QueueDRMEvent(const struct drm_msm_event_resp *event_resp) override {
+    log_->push_back(GetEventEntry(name_, event_resp->base.type));
+  }
+
+ private:
+  std::string name_;
+  vector<std::string> *log_;
+};
+
+class DRMEventDispatcherTest : public ::testing::Test {
+ protected:
+  void Register(RecordingDisplay *display) {
+    int fd = -1;
+    ASSERT_EQ(kErrorNone, dispatcher_.Register(display, display->token(), &fd));
+  }
+
+  TestDispatcher dispatcher_;
+  vector<std::string> log_;
+  RecordingDisplay first_{"first", 10, 20, &log_};
+  RecordingDisplay second_{"second", 11, 21, &log_};
+};
+
+// Handles the panel dead event on the worker, and blocks in it until released.
+class BlockingHandler : public HWEventHandler {
+ public:
+  DisplayError VSync(int64_t timestamp) override { return kErrorNone; }
+  DisplayError Blank(bool blank) override { return kErrorNone; }
+  void CECMessage(char *message) override {}
+  void IdlePowerCollapse() override {}
+  void PingPongTimeout() override {}
+  void HwRecovery(const HWRecoveryEvent sdm_event_code) override {}
+  void Histogram(int histogram_fd, uint32_t blob_id) override {}
+  void HandleBacklightEvent(float brightness_level) override {}
+  void MMRMEvent(uint32_t clk) override {}
+  void HandlePowerEvent() override {}
+  void HandleVmReleaseEvent() override {}
+
+  void PanelDead() override {
+    std::unique_lock<std::mutex> lock(lock_);
+    thread_ = std::this_thread::get_id();
+    panel_dead_++;
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return released_; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(lock_);
+    released_ = true;
+    cv_.notify_all();
+  }
+
+  bool WaitForPanelDead(uint32_t count) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cv_.wait_for(lock, kTimeout, [this, count] { return panel_dead_ >= count; });
+  }
+
+  uint32_t panel_dead() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return panel_dead_;
+  }
+
+  std::thread::id thread() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return thread_;
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  uint32_t panel_dead_ = 0;
+  bool released_ = false;
+  std::thread::id thread_;
+};
+
+// A display with the real event handling, whose handler is the one above.
+class WorkerDisplay : public HWEventsDRM {
+ public:
+  WorkerDisplay(HWEventHandler *handler, uint32_t conn_id) {
+    event_handler_ = handler;
+    token_.conn_id = conn_id;
+  }
+
+  const sde_drm::DRMDisplayToken &token() { return token_; }
+};
+
+}  // namespace
+
+// The vblanks of each display are told apart by the user data the vsync was requested with, and
+// are delivered at once, ahead of the other events.
+TEST_F(DRMEventDispatcherTest, RoutesVBlankByUserData) {
+  Register(&first_);
+  Register(&second_);
+
+  vector<uint8_t> buffer;
+  AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, 20);
+  AddVBlank(&buffer, &second_, 1);
+  AddVBlank(&buffer, &first_, 2);
+  AddVBlank(&buffer, &second_, 3);
+  // Requested by a display that is gone.
+  RecordingDisplay unregistered("unregistered", 12, 22, &log_);
+  AddVBlank(&buffer, &unregistered, 4);
+  dispatcher_.Dispatch(buffer);
+
+  ASSERT_EQ(3u, log_.size());
+  std::string first_vsync = (&first_ < &second_) ? log_[0] : log_[1];
+  std::string second_vsync = (&first_ < &second_) ? log_[1] : log_[0];
+  EXPECT_EQ("first vsync 2000", first_vsync);
+  EXPECT_EQ("second vsync 1000 3000", second_vsync);
+  EXPECT_EQ(GetEventEntry("first", DRM_EVENT_PANEL_DEAD), log_[2]);
+}
+
+// The other events are routed by the id of the object they were raised for, of the type they
+// were raised for.
+TEST_F(DRMEventDispatcherTest, RoutesEventsByObjectId) {
+  Register(&first_);
+  Register(&second_);
+
+  vector<uint8_t> buffer;
+  AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, 21);
+  AddEvent(&buffer, DRM_EVENT_SDE_POWER, DRM_MODE_OBJECT_CRTC, 10);
+  // The connector id of first is no CRTC id.
+  AddEvent(&buffer, DRM_EVENT_HISTOGRAM, DRM_MODE_OBJECT_CRTC, 20);
+  AddEvent(&buffer, DRM_EVENT_HISTOGRAM, DRM_MODE_OBJECT_CRTC, 11);
+  dispatcher_.Dispatch(buffer);
+
+  vector<std::string> expected = {GetEventEntry("second", DRM_EVENT_PANEL_DEAD),
+                                  GetEventEntry("first", DRM_EVENT_SDE_POWER),
+                                  GetEventEntry("second", DRM_EVENT_HISTOGRAM)};
+  EXPECT_EQ(expected, log_);
+}
+
+// An event cut short ends the buffer, the events before it are delivered.
+TEST_F(DRMEventDispatcherTest, StopsAtTruncatedEvent) {
+  Register(&first_);
+
+  vector<uint8_t> buffer;
+  AddVBlank(&buffer, &first_, 1);
+  AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, 20);
+  buffer.resize(buffer.size() - 2);
+  dispatcher_.Dispatch(buffer);
+
+  vector<std::string> expected = {"first vsync 1000"};
+  EXPECT_EQ(expected, log_);
+}
+
+// A display unregistered by the handler of another one gets none of the events read with it.
+TEST_F(DRMEventDispatcherTest, UnregisterDuringDelivery) {
+  Register(&first_);
+  Register(&second_);
+  RecordingDisplay *first = (&first_ < &second_) ? &first_ : &second_;
+  RecordingDisplay *second = (first == &first_) ? &second_ : &first_;
+  first->on_vsync_ = [this, second] { dispatcher_.Unregister(second); };
+
+  vector<uint8_t> buffer;
+  AddVBlank(&buffer, first, 1);
+  AddVBlank(&buffer, second, 2);
+  AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, second->token().conn_id);
+  dispatcher_.Dispatch(buffer);
+
+  ASSERT_EQ(1u, log_.size());
+  EXPECT_EQ(0u, log_[0].find(first == &first_ ? "first vsync" : "second vsync"));
+}
+
+// Unregistering from another thread waits for the delivery in progress.
+TEST_F(DRMEventDispatcherTest, UnregisterWaitsForDelivery) {
+  Register(&first_);
+  std::mutex lock;
+  std::condition_variable cv;
+  bool delivering = false;
+  bool release = false;
+  first_.on_vsync_ = [&] {
+    std::unique_lock<std::mutex> guard(lock);
+    delivering = true;
+    cv.notify_all();
+    cv.wait(guard, [&] { return release; });
+  };
+
+  vector<uint8_t> buffer;
+  AddVBlank(&buffer, &first_, 1);
+  std::thread reactor([&] { dispatcher_.Dispatch(buffer); });
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    ASSERT_TRUE(cv.wait_for(guard, kTimeout, [&] { return delivering; }));
+  }
+
+  std::atomic<bool> unregistered(false);
+  std::thread client([&] {
+    dispatcher_.Unregister(&first_);
+    unregistered = true;
+  });
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_FALSE(unregistered);
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    release = true;
+    cv.notify_all();
+  }
+  client.join();
+  reactor.join();
+  EXPECT_TRUE(unregistered);
+}
+
+// A handler stuck on the worker of one display holds up neither the reactor nor the vsync of
+// the other displays.
+TEST_F(DRMEventDispatcherTest, EventsRunOnDisplayWorker) {
+  BlockingHandler handler;
+  WorkerDisplay worker(&handler, 30);
+  int fd = -1;
+  ASSERT_EQ(kErrorNone, dispatcher_.Register(&worker, worker.token(), &fd));
+  Register(&first_);
+
+  vector<uint8_t> buffer;
+  AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, 30);
+  dispatcher_.Dispatch(buffer);
+  ASSERT_TRUE(handler.WaitForPanelDead(1));
+  EXPECT_NE(std::this_thread::get_id(), handler.thread());
+
+  buffer.clear();
+  AddVBlank(&buffer, &first_, 1);
+  dispatcher_.Dispatch(buffer);
+  vector<std::string> expected = {"first vsync 1000"};
+  EXPECT_EQ(expected, log_);
+
+  handler.Release();
+  dispatcher_.Unregister(&worker);
+}
+
+// Events queued behind a stuck handler are dropped past the limit instead of blocking the reactor.
+TEST_F(DRMEventDispatcherTest, StuckWorkerDropsEvents) {
+  BlockingHandler handler;
+  WorkerDisplay worker(&handler, 30);
+  int fd = -1;
+  ASSERT_EQ(kErrorNone, dispatcher_.Register(&worker, worker.token(), &fd));
+
+  vector<uint8_t> buffer;
+  AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, 30);
+  dispatcher_.Dispatch(buffer);
+  ASSERT_TRUE(handler.WaitForPanelDead(1));
+
+  buffer.clear();
+  for (int i = 0; i < 40; i++) {
+    AddEvent(&buffer, DRM_EVENT_PANEL_DEAD, DRM_MODE_OBJECT_CONNECTOR, 30);
+  }
+  dispatcher_.Dispatch(buffer);
+
+  handler.Release();
+  dispatcher_.Unregister(&worker);
+  // The running one and the 31 queued behind it make the limit of 32.
+  EXPECT_TRUE(handler.WaitForPanelDead(32));
+  std::this_thread::sleep_for(milliseconds(20));
+  EXPECT_EQ(32u, handler.panel_dead());
+}
+
+}  // namespace sdm
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <sys/prctl.h>
+#include <utility>
+
+#include "hw_fb_id_worker.h"
+
+namespace sdm {
+
+HWFbIdWorker::HWFbIdWorker(const Remover &remove_fb_ids) : remove_fb_ids_(remove_fb_ids) {
+  thread_ = std::thread(&HWFbIdWorker::Run, this);
+}
+
+HWFbIdWorker::~HWFbIdWorker() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    exit_ = true;
+    cv_.notify_one();
+    for (auto &it : queues_) {
+      it.second->cv.notify_one();
+    }
+  }
+
+  thread_.join();
+  std::vector<uint32_t> fb_ids;
+  for (auto &it : queues_) {
+    DisplayQueue *queue = it.second.get();
+    if (queue->reaper.joinable()) {
+      queue->reaper.join();
+    }
+    for (auto &batch : queue->batches) {
+      fb_ids.insert(fb_ids.end(), batch.fb_ids.begin(), batch.fb_ids.end());
+    }
+    fb_ids.insert(fb_ids.end(), queue->unfenced_fb_ids.begin(), queue->unfenced_fb_ids.end());
+  }
+
+  if (!fb_ids.empty()) {
+    remove_fb_ids_(fb_ids);
+  }
+}
+
+bool HWFbIdWorker::Post(int32_t display_id, const Job &job) {
+  std::lock_guard<std::mutex> lock(lock_);
+  DisplayQueue *queue = GetQueue(display_id);
+  if (exit_ || queue->jobs.size() >= kMaxPendingJobs) {
+    stats_.dropped_jobs++;
+    return false;
+  }
+
+  queue->jobs.push_back(job);
+  pending_jobs_++;
+  cv_.notify_one();
+
+  return true;
+}
+
+void HWFbIdWorker::RemoveFbId(int32_t display_id, uint32_t fb_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  DisplayQueue *queue = GetQueue(display_id);
+  if (!queue->reaper.joinable()) {
+    queue->reaper = std::thread(&HWFbIdWorker::Reap, this, queue);
+  }
+
+  if (queue->unfenced_fb_ids.empty()) {
+    queue->unfenced_since = Clock::now();
+    queue->cv.notify_one();
+  }
+  queue->unfenced_fb_ids.push_back(fb_id);
+}
+
+void HWFbIdWorker::ReleaseFbIds(int32_t display_id, const shared_ptr<Fence> &retire_fence) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = queues_.find(display_id);
+  if (it == queues_.end() || it->second->unfenced_fb_ids.empty()) {
+    return;
+  }
+
+  DisplayQueue *queue = it->second.get();
+  Batch batch;
+  batch.retire_fence = retire_fence;
+  batch.fb_ids.swap(queue->unfenced_fb_ids);
+  queue->batches.push_back(std::move(batch));
+  queue->cv.notify_one();
+}
+
+HWFbIdWorker::Stats HWFbIdWorker::GetStats() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return stats_;
+}
+
+HWFbIdWorker::DisplayQueue *HWFbIdWorker::GetQueue(int32_t display_id) {
+  std::unique_ptr<DisplayQueue> &queue = queues_[display_id];
+  if (!queue) {
+    queue.reset(new DisplayQueue());
+  }
+
+  return queue.get();
+}
+
+bool HWFbIdWorker::TakeJob(Job *job) {
+  if (!pending_jobs_) {
+    return false;
+  }
+
+  // Displays take turns, starting from the one after the display of the previous job, so that a
+  // display with many new buffers does not hold up the others.
+  auto it = queues_.upper_bound(last_job_display_);
+  for (size_t i = 0; i < queues_.size(); i++, it++) {
+    if (it == queues_.end()) {
+      it = queues_.begin();
+    }
+    if (!it->second->jobs.empty()) {
+      break;
+    }
+  }
+
+  *job = std::move(it->second->jobs.front());
+  it->second->jobs.pop_front();
+  last_job_display_ = it->first;
+  pending_jobs_--;
+  stats_.jobs++;
+
+  return true;
+}
+
+void HWFbIdWorker::Run() {
+  prctl(PR_SET_NAME, "SDM_FbIdWorker", 0, 0, 0);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    cv_.wait(lock, [this] { return exit_ || pending_jobs_; });
+
+    Job job;
+    if (!TakeJob(&job)) {
+      // Exiting, and the pending jobs have run.
+      break;
+    }
+
+    lock.unlock();
+    job();
+    lock.lock();
+  }
+}
+
+void HWFbIdWorker::Reap(DisplayQueue *queue) {
+  prctl(PR_SET_NAME, "SDM_FbIdReaper", 0, 0, 0);
+
+  std::vector<uint32_t> fb_ids;
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!exit_) {
+    if (!queue->batches.empty()) {
+      shared_ptr<Fence> retire_fence = queue->batches.front().retire_fence;
+      lock.unlock();
+      Fence::Wait(retire_fence, kMaxFenceWaitMs);
+      lock.lock();
+
+      // Batches of later commits go along if they have retired by now too.
+      do {
+        Batch &batch = queue->batches.front();
+        fb_ids.insert(fb_ids.end(), batch.fb_ids.begin(), batch.fb_ids.end());
+        queue->batches.pop_front();
+      } while (!queue->batches.empty() &&
+               (Fence::GetStatus(queue->batches.front().retire_fence) ==
+                Fence::Status::kSignaled));
+    } else if (!queue->unfenced_fb_ids.empty()) {
+      Clock::time_point deadline = queue->unfenced_since +
+                                   std::chrono::milliseconds(kMaxUnfencedMs);
+      if (queue->cv.wait_until(lock, deadline, [this, queue] {
+            return exit_ || !queue->batches.empty();
+          })) {
+        continue;
+      }
+      fb_ids.swap(queue->unfenced_fb_ids);
+    } else {
+      queue->cv.wait(lock, [this, queue] {
+        return exit_ || !queue->batches.empty() || !queue->unfenced_fb_ids.empty();
+      });
+      continue;
+    }
+
+    stats_.removed += fb_ids.size();
+    stats_.batches++;
+    lock.unlock();
+    remove_fb_ids_(fb_ids);
+    fb_ids.clear();
+    lock.lock();
+  }
+}
+
+}  // namespace sdm
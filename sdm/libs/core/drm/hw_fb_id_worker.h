@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_FB_ID_WORKER_H__
+#define __HW_FB_ID_WORKER_H__
+
+#include <utils/fence.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sdm {
+
+// Takes framebuffer object creation and removal off the commit path. Creation jobs for buffers
+// expected to be committed soon run on the worker thread, one job of each display in turn.
+// Removed fb_ids are queued per display and removed in batches by a reaper thread of the display,
+// once the retire fence of the next commit on that display has signaled, or after a while if
+// there is no commit.
+class HWFbIdWorker {
+ public:
+  typedef std::function<void()> Job;
+  typedef std::function<void(const std::vector<uint32_t> &fb_ids)> Remover;
+
+  struct Stats {
+    uint64_t jobs = 0;
+    uint64_t dropped_jobs = 0;  // Not queued, too many pending.
+    uint64_t removed = 0;
+    uint64_t batches = 0;
+  };
+
+  // remove_fb_ids is called on the reaper threads, with batches of fb_ids of one display.
+  explicit HWFbIdWorker(const Remover &remove_fb_ids);
+  // Runs the pending jobs and removes the queued fb_ids without waiting for their fences.
+  ~HWFbIdWorker();
+
+  // Returns false if the job could not be queued, in which case the caller does it in place.
+  bool Post(int32_t display_id, const Job &job);
+  void RemoveFbId(int32_t display_id, uint32_t fb_id);
+  // fb_ids of the display queued so far are removed once retire_fence signals.
+  void ReleaseFbIds(int32_t display_id, const shared_ptr<Fence> &retire_fence);
+  Stats GetStats();
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  static constexpr uint32_t kMaxPendingJobs = 16;  // Per display.
+  // fb_ids not claimed by a commit within this time are removed without waiting.
+  static constexpr uint32_t kMaxUnfencedMs = 100;
+  // A retire fence that does not signal in this time does not hold up the fb_ids behind it.
+  static constexpr int kMaxFenceWaitMs = 1000;
+
+  struct Batch {
+    shared_ptr<Fence> retire_fence = nullptr;
+    std::vector<uint32_t> fb_ids;
+  };
+
+  struct DisplayQueue {
+    std::deque<Job> jobs;
+    std::deque<Batch> batches;
+    std::vector<uint32_t> unfenced_fb_ids;
+    Clock::time_point unfenced_since;
+    std::condition_variable cv;
+    std::thread reaper;
+  };
+
+  DisplayQueue *GetQueue(int32_t display_id);
+  bool TakeJob(Job *job);
+  void Run();
+  void Reap(DisplayQueue *queue);
+
+  const Remover remove_fb_ids_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::map<int32_t, std::unique_ptr<DisplayQueue>> queues_;
+  int32_t last_job_display_ = -1;
+  uint32_t pending_jobs_ = 0;
+  bool exit_ = false;
+  Stats stats_ = {};
+  std::thread thread_;
+};
+
+}  // namespace sdm
+
+#endif  // __HW_FB_ID_WORKER_H__
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utils/constants.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "hw_fb_id_worker.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const milliseconds kTimeout(2000);
+
+class TestSyncHandler : public BufferSyncHandler {
+ public:
+  int SyncWait(int fd, int timeout) override {
+    if (fd < 0) {
+      return 0;
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ret = poll(&pfd, 1, timeout);
+    return (ret > 0) ? 0 : (ret == 0 ? -ETIME : -errno);
+  }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override { }
+};
+
+class TestFence {
+ public:
+  TestFence() : fd_(eventfd(0, EFD_CLOEXEC)) { }
+  ~TestFence() { close(fd_); }
+
+  // The Fence owns a dup, the test keeps the fd to signal it.
+  shared_ptr<Fence> Get() { return Fence::Create(dup(fd_), "retire"); }
+
+  void Signal() {
+    uint64_t value = 1;
+    ASSERT_EQ(ssize_t(sizeof(value)), write(fd_, &value, sizeof(value)));
+  }
+
+ private:
+  int fd_;
+};
+
+// Records the batches of removed fb_ids and the order jobs ran in.
+class Recorder {
+ public:
+  HWFbIdWorker::Remover GetRemover() {
+    return [this](const std::vector<uint32_t> &fb_ids) {
+      std::lock_guard<std::mutex> lock(lock_);
+      batches_.push_back(fb_ids);
+      removed_.insert(removed_.end(), fb_ids.begin(), fb_ids.end());
+      cv_.notify_all();
+    };
+  }
+
+  HWFbIdWorker::Job GetJob(int value) {
+    return [this, value] {
+      std::unique_lock<std::mutex> lock(lock_);
+      cv_.wait(lock, [this] { return !blocked_; });
+      jobs_.push_back(value);
+      cv_.notify_all();
+    };
+  }
+
+  void Block() {
+    std::lock_guard<std::mutex> lock(lock_);
+    blocked_ = true;
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(lock_);
+    blocked_ = false;
+    cv_.notify_all();
+  }
+
+  bool WaitRemoved(uint32_t fb_id) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cv_.wait_for(lock, kTimeout, [this, fb_id] { return IsRemovedLocked(fb_id); });
+  }
+
+  bool WaitJobs(size_t count) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cv_.wait_for(lock, kTimeout, [this, count] { return jobs_.size() >= count; });
+  }
+
+  bool IsRemoved(uint32_t fb_id) {
+    std::lock_guard<std::mutex> lock(lock_);
+    return IsRemovedLocked(fb_id);
+  }
+
+  std::vector<std::vector<uint32_t>> batches() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return batches_;
+  }
+
+  std::vector<int> jobs() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return jobs_;
+  }
+
+ private:
+  bool IsRemovedLocked(uint32_t fb_id) {
+    return std::find(removed_.begin(), removed_.end(), fb_id) != removed_.end();
+  }
+
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool blocked_ = false;
+  std::vector<std::vector<uint32_t>> batches_;
+  std::vector<uint32_t> removed_;
+  std::vector<int> jobs_;
+};
+
+class HWFbIdWorkerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { Fence::Set(&sync_handler_); }
+
+  static TestSyncHandler sync_handler_;
+  Recorder recorder_;
+  HWFbIdWorker worker_{recorder_.GetRemover()};
+};
+
+TestSyncHandler HWFbIdWorkerTest::sync_handler_;
+
+}  // namespace
+
+TEST_F(HWFbIdWorkerTest, RunsJobs) {
+  for (int i = 0; i < 8; i++) {
+    EXPECT_TRUE(worker_.Post(0, recorder_.GetJob(i)));
+  }
+  ASSERT_TRUE(recorder_.WaitJobs(8));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}), recorder_.jobs());
+  EXPECT_EQ(8u, worker_.GetStats().jobs);
+}
+
+// A display with many new buffers does not hold up the jobs of another one.
+TEST_F(HWFbIdWorkerTest, DisplaysTakeTurns) {
+  recorder_.Block();
+  ASSERT_TRUE(worker_.Post(0, recorder_.GetJob(0)));
+  for (int i = 1; i < 8; i++) {
+    ASSERT_TRUE(worker_.Post(0, recorder_.GetJob(i)));
+  }
+  ASSERT_TRUE(worker_.Post(1, recorder_.GetJob(100)));
+  ASSERT_TRUE(worker_.Post(1, recorder_.GetJob(101)));
+  recorder_.Release();
+
+  ASSERT_TRUE(recorder_.WaitJobs(10));
+  EXPECT_EQ(std::vector<int>({0, 100, 1, 101, 2, 3, 4, 5, 6, 7}), recorder_.jobs());
+}
+
+TEST_F(HWFbIdWorkerTest, BoundsPendingJobsPerDisplay) {
+  recorder_.Block();
+  ASSERT_TRUE(worker_.Post(0, recorder_.GetJob(0)));
+  // The first job may or may not have been taken off the queue yet.
+  int accepted = 0;
+  while (worker_.Post(0, recorder_.GetJob(1))) {
+    ASSERT_LE(++accepted, 17);
+  }
+  EXPECT_GE(accepted, 15);
+  EXPECT_TRUE(worker_.Post(1, recorder_.GetJob(2)));
+  EXPECT_EQ(1u, worker_.GetStats().dropped_jobs);
+  recorder_.Release();
+  EXPECT_TRUE(recorder_.WaitJobs(size_t(accepted) + 2));
+}
+
+// fb_ids are held until the retire fence of the commit they were handed to signals.
+TEST_F(HWFbIdWorkerTest, RemovesOnceRetired) {
+  TestFence fence;
+  worker_.RemoveFbId(0, 10);
+  worker_.RemoveFbId(0, 11);
+  worker_.ReleaseFbIds(0, fence.Get());
+
+  // Longer than unfenced fb_ids are held.
+  std::this_thread::sleep_for(milliseconds(150));
+  EXPECT_FALSE(recorder_.IsRemoved(10));
+
+  fence.Signal();
+  ASSERT_TRUE(recorder_.WaitRemoved(11));
+  EXPECT_EQ(std::vector<std::vector<uint32_t>>({{10, 11}}), recorder_.batches());
+}
+
+TEST_F(HWFbIdWorkerTest, RemovesUnfencedAfterTimeout) {
+  auto start = std::chrono::steady_clock::now();
+  worker_.RemoveFbId(0, 10);
+  ASSERT_TRUE(recorder_.WaitRemoved(10));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(100));
+  // Nothing left to hand over.
+  worker_.ReleaseFbIds(0, nullptr);
+  EXPECT_EQ(1u, recorder_.batches().size());
+}
+
+// A display whose commit has not retired yet does not hold up the removal on another one.
+TEST_F(HWFbIdWorkerTest, DisplaysDoNotBlockEachOther) {
+  TestFence slow;
+  TestFence fast;
+  worker_.RemoveFbId(0, 10);
+  worker_.ReleaseFbIds(0, slow.Get());
+  worker_.RemoveFbId(1, 20);
+  worker_.ReleaseFbIds(1, fast.Get());
+
+  fast.Signal();
+  ASSERT_TRUE(recorder_.WaitRemoved(20));
+  EXPECT_FALSE(recorder_.IsRemoved(10));
+
+  slow.Signal();
+  EXPECT_TRUE(recorder_.WaitRemoved(10));
+}
+
+// fb_ids of later commits that have retired by the time an earlier one does go in one batch.
+TEST_F(HWFbIdWorkerTest, BatchesRetiredCommits) {
+  TestFence first;
+  TestFence second;
+  worker_.RemoveFbId(0, 10);
+  worker_.ReleaseFbIds(0, first.Get());
+  worker_.RemoveFbId(0, 11);
+  worker_.ReleaseFbIds(0, second.Get());
+
+  second.Signal();
+  std::this_thread::sleep_for(milliseconds(20));
+  EXPECT_FALSE(recorder_.IsRemoved(11));
+  first.Signal();
+  ASSERT_TRUE(recorder_.WaitRemoved(11));
+  EXPECT_EQ(std::vector<std::vector<uint32_t>>({{10, 11}}), recorder_.batches());
+  EXPECT_EQ(1u, worker_.GetStats().batches);
+}
+
+TEST_F(HWFbIdWorkerTest, ConcurrentDisplays) {
+  const int kDisplays = 4;
+  const uint32_t kFrames = 50;
+  std::vector<std::thread> threads;
+  for (int display = 0; display < kDisplays; display++) {
+    threads.emplace_back([this, display] {
+      for (uint32_t frame = 0; frame < kFrames; frame++) {
+        TestFence fence;
+        worker_.Post(display, [] { });
+        worker_.RemoveFbId(display, UINT32(display) * 1000 + frame);
+        worker_.ReleaseFbIds(display, fence.Get());
+        fence.Signal();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int display = 0; display < kDisplays; display++) {
+    EXPECT_TRUE(recorder_.WaitRemoved(UINT32(display) * 1000 + kFrames - 1));
+  }
+  EXPECT_EQ(uint64_t(kDisplays * kFrames), worker_.GetStats().removed);
+}
+
+TEST(HWFbIdWorker, DestructorRunsJobsAndRemoves) {
+  Recorder recorder;
+  std::thread releaser;
+  {
+    HWFbIdWorker worker(recorder.GetRemover());
+    recorder.Block();
+    ASSERT_TRUE(worker.Post(0, recorder.GetJob(0)));
+    ASSERT_TRUE(worker.Post(0, recorder.GetJob(1)));
+    worker.RemoveFbId(0, 10);
+    releaser = std::thread([&recorder] {
+      std::this_thread::sleep_for(milliseconds(20));
+      recorder.Release();
+    });
+  }
+  releaser.join();
+  EXPECT_EQ(std::vector<int>({0, 1}), recorder.jobs());
+  EXPECT_TRUE(recorder.IsRemoved(10));
+}
+
+}  // namespace sdm
@@ -975,6 +975,12 @@ DisplayError HWInfoDRM::GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) {
   return kErrorNone;
 }
 
+void HWInfoDRM::NotifyHotplug() {
+  if (drm_mgr_intf_) {
+    drm_mgr_intf_->InvalidateConnectorsInfo();
+  }
+}
+
 DisplayError HWInfoDRM::GetMaxDisplaysSupported(const DisplayType type, int32_t *max_displays) {
   static DebugTag log_once = kTagNone;
 
@@ -101,6 +101,17 @@ DisplayError HWPeripheralDRM::Init() {
 
   InitBrightnessFd();
   GetHWPanelMaxBrightness();
+
+  int hold_ms = 0;
+  if (Debug::Get()->GetProperty(BRIGHTNESS_FRAME_HOLD_MS, &hold_ms) != kErrorNone) {
+    hold_ms = 0;
+  }
+  brightness_writer_.Init(UINT32(std::max(hold_ms, 0)));
+
+  int value = 0;
+  if (Debug::Get()->GetProperty(ENABLE_POWER_ON_WITH_FRAME, &value) == kErrorNone) {
+    power_on_with_frame_ = (value == 1);
+  }
   InitDestScaler();
 
   PopulateBitClkRates();
@@ -110,6 +121,7 @@ DisplayError HWPeripheralDRM::Init() {
 }
 
 DisplayError HWPeripheralDRM::Deinit() {
+  brightness_writer_.Deinit();
   Sys::close_(brightness_fd_);
   Sys::close_(max_brightness_fd_);
 
@@ -238,25 +250,25 @@ DisplayError HWPeripheralDRM::SetDisplayMode(const HWDisplayMode hw_display_mode
   return kErrorNone;
 }
 
-DisplayError HWPeripheralDRM::Validate(HWLayersInfo *hw_layers_info) {
-  SetDestScalarData(*hw_layers_info);
+void HWPeripheralDRM::SetupFrameState(const HWLayersInfo &hw_layers_info) {
+  SetDestScalarData(hw_layers_info);
   SetIdlePCState();
   SetSelfRefreshState();
   SetVMReqState();
+}
+
+DisplayError HWPeripheralDRM::Validate(HWLayersInfo *hw_layers_info) {
+  SetupFrameState(*hw_layers_info);
 
   return HWDeviceDRM::Validate(hw_layers_info);
 }
 
 DisplayError HWPeripheralDRM::Commit(HWLayersInfo *hw_layers_info) {
-  SetDestScalarData(*hw_layers_info);
+  SetupFrameState(*hw_layers_info);
 
   int64_t cwb_fence_fd = -1;
   bool has_fence = SetupConcurrentWriteback(*hw_layers_info, false, &cwb_fence_fd);
 
-  SetIdlePCState();
-  SetSelfRefreshState();
-  SetVMReqState();
-
   DisplayError error = HWDeviceDRM::Commit(hw_layers_info);
   shared_ptr<Fence> cwb_fence = Fence::Create(INT(cwb_fence_fd), "cwb_fence");
   if (error != kErrorNone) {
@@ -273,6 +285,7 @@ DisplayError HWPeripheralDRM::Commit(HWLayersInfo *hw_layers_info) {
   // Initialize to default after successful commit
   synchronous_commit_ = false;
   active_ = true;
+  brightness_writer_.OnFrameCommitted();
 
   if (pending_poms_switch_) {
     HWDeviceDRM::SetDisplayMode(kModeCommand);
@@ -544,6 +557,8 @@ DisplayError HWPeripheralDRM::PowerOn(const HWQosData &qos_data, SyncPoints *syn
     HWDeviceDRM::SetDisplayMode(kModeVideo);
     hw_panel_info_.bitclk_rates = bitclk_rates_;
     doze_poms_switch_done_ = false;
+  } else if (power_on_with_frame_) {
+    return StagePowerOn(qos_data);
   }
 
   if (!idle_pc_enabled_) {
@@ -572,6 +587,25 @@ DisplayError HWPeripheralDRM::PowerOn(const HWQosData &qos_data, SyncPoints *syn
   return kErrorNone;
 }
 
+DisplayError HWPeripheralDRM::StagePowerOn(const HWQosData &qos_data) {
+  // Everything power on adds to the atomic request is kept in members the frame commit applies, so
+  // the display powers on with the first frame instead of waiting on a null commit of its own.
+  SetQOSData(qos_data);
+  if (!idle_pc_enabled_) {
+    idle_pc_state_ = sde_drm::DRMIdlePCState::ENABLE;
+    idle_pc_enabled_ = true;
+  }
+  if (sde_dest_scalar_data_.num_dest_scaler) {
+    needs_ds_update_ = true;
+  }
+  pending_poms_switch_ = false;
+
+  DLOGI("Power on deferred to the first frame on CRTC: %u", token_.crtc_id);
+  pending_power_state_ = kPowerStateOn;
+
+  return kErrorDeferred;
+}
+
 DisplayError HWPeripheralDRM::PowerOff(bool teardown, SyncPoints *sync_points) {
   DTRACE_SCOPED();
   if (!first_cycle_) {
@@ -587,6 +621,9 @@ DisplayError HWPeripheralDRM::PowerOff(bool teardown, SyncPoints *sync_points) {
     }
   }
 
+  // Backlight level requested before power off must not land after it.
+  brightness_writer_.Flush();
+
   err = HWDeviceDRM::PowerOff(teardown, sync_points);
   if (err != kErrorNone) {
     return err;
@@ -594,6 +631,7 @@ DisplayError HWPeripheralDRM::PowerOff(bool teardown, SyncPoints *sync_points) {
 
   pending_poms_switch_ = false;
   active_ = false;
+  brightness_writer_.Invalidate();
   SetTUIState();
 
   return kErrorNone;
@@ -724,8 +762,6 @@ DisplayError HWPeripheralDRM::SetPanelBrightness(int level) {
   }
 #endif
 
-  char buffer[kMaxSysfsCommandLength] = {0};
-
   if (!active_) {
     return kErrorNone;
   }
@@ -741,15 +777,14 @@ DisplayError HWPeripheralDRM::SetPanelBrightness(int level) {
     }
   }
 
-  int32_t bytes = snprintf(buffer, kMaxSysfsCommandLength, "%d\n", level);
-  ssize_t ret = Sys::pwrite_(brightness_fd_, buffer, static_cast<size_t>(bytes), 0);
-  if (ret <= 0) {
-    DLOGE("Failed to write to node = %s, error = %s ", brightness_node.c_str(),
-          strerror(errno));
-    return kErrorHardware;
+  // Written by the brightness writer thread, so that a burst of levels ends up in one write.
+  // After a level failed to be written, levels are written in place and failures reported.
+  DisplayError error = brightness_writer_.SetLevel(brightness_fd_, level);
+  if (error != kErrorNone) {
+    DLOGE("Failed to set brightness level %d", level);
   }
 
-  return kErrorNone;
+  return error;
 }
 
 DisplayError HWPeripheralDRM::GetPanelBrightness(int *level) {
@@ -761,6 +796,11 @@ DisplayError HWPeripheralDRM::GetPanelBrightness(int *level) {
     return kErrorParameters;
   }
 
+  // The node lags behind a level that is not written yet.
+  if (brightness_writer_.GetPendingLevel(level)) {
+    return kErrorNone;
+  }
+
   std::string brightness_node(brightness_base_path_ + "brightness");
 
   if (brightness_fd_ < 0) {
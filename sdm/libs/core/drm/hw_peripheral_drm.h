@@ -65,6 +65,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <map>
 #include <vector>
 #include <string>
+#include "hw_brightness_writer.h"
 #include "hw_device_drm.h"
 
 namespace sdm {
@@ -112,6 +113,11 @@ class HWPeripheralDRM : public HWDeviceDRM, public PanelFeaturePropertyIntf {
   virtual DisplayError SetBLScale(uint32_t level);
   virtual DisplayError EnableSelfRefresh();
   virtual DisplayError SetAlternateDisplayConfig(uint32_t *alt_config);
+  // Adds the peripheral state every frame carries, and what a power on staged for the frame, to
+  // the atomic request.
+  void SetupFrameState(const HWLayersInfo &hw_layers_info);
+
+  bool power_on_with_frame_ = false;
 
  private:
   void InitDestScaler();
@@ -128,6 +134,7 @@ class HWPeripheralDRM : public HWDeviceDRM, public PanelFeaturePropertyIntf {
   void ResetPropertyCache();
   void GetHWPanelMaxBrightness();
   void InitBrightnessFd();
+  DisplayError StagePowerOn(const HWQosData &qos_data);
 
   struct DestScalarCache {
     SDEScaler scalar_data = {};
@@ -146,6 +153,7 @@ class HWPeripheralDRM : public HWDeviceDRM, public PanelFeaturePropertyIntf {
   std::string brightness_base_path_ = "";
   int brightness_fd_ = -1;
   int max_brightness_fd_ = -1;
+  HWBrightnessWriter brightness_writer_{"SDM_Brightness"};
   SelfRefreshState self_refresh_state_ = kSelfRefreshNone;
   bool ltm_hist_en_ = false;
   bool aba_hist_en_ = false;
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <stdarg.h>
+
+#include <vector>
+
+#include "hw_peripheral_drm.h"
+
+namespace sdm {
+
+namespace {
+
+using sde_drm::DRMAtomicReqInterface;
+using sde_drm::DRMIdlePCState;
+using sde_drm::DRMOps;
+using sde_drm::DRMPowerMode;
+
+const uint32_t kCrtcId = 100;
+const uint32_t kConnId = 200;
+const uint32_t kClockHz = 300000000;
+
+struct Op {
+  DRMOps op;
+  uint32_t obj_id;
+  int value;  // The argument of the ops below, 0 for the others.
+};
+
+// Records the ops of each atomic request, and hands them over on commit.
+class MockAtomicReq : public DRMAtomicReqInterface {
+ public:
+  int Perform(DRMOps opcode, uint32_t obj_id, ...) override {
+    int value = 0;
+    va_list args;
+    va_start(args, obj_id);
+    switch (opcode) {
+      case DRMOps::CRTC_SET_ACTIVE:
+      case DRMOps::CRTC_SET_CORE_CLK:
+        value = static_cast<int>(va_arg(args, uint32_t));
+        break;
+      case DRMOps::CRTC_SET_IDLE_PC_STATE:
+      case DRMOps::CONNECTOR_SET_POWER_MODE:
+        value = va_arg(args, int);
+        break;
+      default:
+        break;
+    }
+    va_end(args);
+    staged_.push_back({opcode, obj_id, value});
+    return 0;
+  }
+
+  int Commit(bool synchronous, bool retain_planes) override {
+    commits_.push_back(staged_);
+    staged_.clear();
+    return commit_error_;
+  }
+
+  int Validate() override { return 0; }
+
+  // Returns the matching op of request, or nullptr.
+  static const Op *Find(const std::vector<Op> &request, DRMOps op) {
+    for (auto &it : request) {
+      if (it.op == op) {
+        return &it;
+      }
+    }
+    return nullptr;
+  }
+
+  std::vector<Op> staged_;
+  std::vector<std::vector<Op>> commits_;
+  int commit_error_ = 0;
+};
+
+// A peripheral past its first frame, with the driver replaced by the mock.
+class TestPeripheralDRM : public HWPeripheralDRM {
+ public:
+  TestPeripheralDRM(DRMAtomicReqInterface *atomic_req, bool power_on_with_frame)
+    : HWPeripheralDRM(0, nullptr, nullptr) {
+    drm_atomic_intf_ = atomic_req;
+    token_.crtc_id = kCrtcId;
+    token_.conn_id = kConnId;
+    first_cycle_ = false;
+    power_on_with_frame_ = power_on_with_frame;
+  }
+
+  using HWPeripheralDRM::ControlIdlePowerCollapse;
+  using HWPeripheralDRM::PowerOn;
+
+  // What a frame commit adds to the request besides its layers.
+  void SetupFrame(bool validate) {
+    HWLayersInfo hw_layers_info = {};
+    SetupFrameState(hw_layers_info);
+    SetupPowerState(validate);
+  }
+
+  HWPowerState pending_power_state() { return pending_power_state_; }
+};
+
+class HWPeripheralDRMTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    qos_data_.valid = true;
+    qos_data_.clock_hz = kClockHz;
+  }
+
+  // Checks request powers the display on with the QoS and idle power collapse of the power on.
+  void ExpectPowersOn(const std::vector<Op> &request) {
+    const Op *active = MockAtomicReq::Find(request, DRMOps::CRTC_SET_ACTIVE);
+    ASSERT_NE(nullptr, active);
+    EXPECT_EQ(kCrtcId, active->obj_id);
+    EXPECT_EQ(1, active->value);
+
+    const Op *power_mode = MockAtomicReq::Find(request, DRMOps::CONNECTOR_SET_POWER_MODE);
+    ASSERT_NE(nullptr, power_mode);
+    EXPECT_EQ(kConnId, power_mode->obj_id);
+    EXPECT_EQ(static_cast<int>(DRMPowerMode::ON), power_mode->value);
+
+    const Op *clock = MockAtomicReq::Find(request, DRMOps::CRTC_SET_CORE_CLK);
+    ASSERT_NE(nullptr, clock);
+    EXPECT_EQ(static_cast<int>(kClockHz), clock->value);
+
+    const Op *idle_pc = MockAtomicReq::Find(request, DRMOps::CRTC_SET_IDLE_PC_STATE);
+    ASSERT_NE(nullptr, idle_pc);
+    EXPECT_EQ(static_cast<int>(DRMIdlePCState::ENABLE), idle_pc->value);
+  }
+
+  MockAtomicReq atomic_req_;
+  HWQosData qos_data_ = {};
+  SyncPoints sync_points_ = {};
+};
+
+}  // namespace
+
+// The power on goes out with the first frame, in its request, without a null commit of its own.
+TEST_F(HWPeripheralDRMTest, StagePowerOnCommitsWithFrame) {
+  TestPeripheralDRM peripheral(&atomic_req_, true);
+  peripheral.ControlIdlePowerCollapse(false, false);
+
+  EXPECT_EQ(kErrorDeferred, peripheral.PowerOn(qos_data_, &sync_points_));
+  EXPECT_TRUE(atomic_req_.commits_.empty());
+  EXPECT_EQ(nullptr, MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CRTC_SET_ACTIVE));
+  EXPECT_EQ(kPowerStateOn, peripheral.pending_power_state());
+
+  peripheral.SetupFrame(false);
+  ASSERT_EQ(0, atomic_req_.Commit(false, false));
+  ASSERT_EQ(1u, atomic_req_.commits_.size());
+  ExpectPowersOn(atomic_req_.commits_[0]);
+}
+
+// Validating the first frame does not power the display on, only its commit does.
+TEST_F(HWPeripheralDRMTest, StagePowerOnNotInValidate) {
+  TestPeripheralDRM peripheral(&atomic_req_, true);
+  EXPECT_EQ(kErrorDeferred, peripheral.PowerOn(qos_data_, &sync_points_));
+
+  peripheral.SetupFrame(true);
+  EXPECT_EQ(nullptr, MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CRTC_SET_ACTIVE));
+  EXPECT_EQ(nullptr, MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CONNECTOR_SET_POWER_MODE));
+
+  peripheral.SetupFrame(false);
+  EXPECT_NE(nullptr, MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CRTC_SET_ACTIVE));
+}
+
+// Without power on with frame, the power on is a null commit of its own and the frame after it
+// does not repeat it.
+TEST_F(HWPeripheralDRMTest, PowerOnCommitsImmediately) {
+  TestPeripheralDRM peripheral(&atomic_req_, false);
+  peripheral.ControlIdlePowerCollapse(false, false);
+
+  EXPECT_EQ(kErrorNone, peripheral.PowerOn(qos_data_, &sync_points_));
+  ASSERT_EQ(1u, atomic_req_.commits_.size());
+  ExpectPowersOn(atomic_req_.commits_[0]);
+  EXPECT_EQ(kPowerStateNone, peripheral.pending_power_state());
+
+  peripheral.SetupFrame(false);
+  EXPECT_EQ(nullptr, MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CRTC_SET_ACTIVE));
+  const Op *idle_pc = MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CRTC_SET_IDLE_PC_STATE);
+  ASSERT_NE(nullptr, idle_pc);
+  EXPECT_EQ(static_cast<int>(DRMIdlePCState::NONE), idle_pc->value);
+}
+
+// A failed power on commit is a hard error, the display does not wait for a frame to power on.
+TEST_F(HWPeripheralDRMTest, PowerOnCommitFailure) {
+  TestPeripheralDRM peripheral(&atomic_req_, false);
+  atomic_req_.commit_error_ = -EINVAL;
+
+  EXPECT_EQ(kErrorHardware, peripheral.PowerOn(qos_data_, &sync_points_));
+  EXPECT_EQ(1u, atomic_req_.commits_.size());
+}
+
+// Idle power collapse already enabled is left alone.
+TEST_F(HWPeripheralDRMTest, StagePowerOnKeepsIdlePC) {
+  TestPeripheralDRM peripheral(&atomic_req_, true);
+  EXPECT_EQ(kErrorDeferred, peripheral.PowerOn(qos_data_, &sync_points_));
+
+  peripheral.SetupFrame(false);
+  const Op *idle_pc = MockAtomicReq::Find(atomic_req_.staged_, DRMOps::CRTC_SET_IDLE_PC_STATE);
+  ASSERT_NE(nullptr, idle_pc);
+  EXPECT_EQ(static_cast<int>(DRMIdlePCState::NONE), idle_pc->value);
+}
+
+}  // namespace sdm
@@ -179,6 +179,8 @@ class HWInterface {
   virtual DisplayError SetAlternateDisplayConfig(uint32_t *alt_config) = 0;
   virtual DisplayError GetQsyncFps(uint32_t *qsync_fps) = 0;
   virtual DisplayError CancelDeferredPowerMode() = 0;
+  virtual DisplayError PrefetchFbId(const LayerBuffer &buffer) = 0;
+  virtual void GetFbIdStats(HWFbIdStats *stats) = 0;
 
  protected:
   virtual ~HWInterface() { }
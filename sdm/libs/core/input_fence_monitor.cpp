@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/sys.h>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <sstream>
+#include <utility>
+
+#include "input_fence_monitor.h"
+
+#define __CLASS__ "InputFenceMonitor"
+
+namespace sdm {
+
+InputFenceMonitor *InputFenceMonitor::GetInstance() {
+  static std::mutex instance_lock;
+  static InputFenceMonitor *instance = nullptr;
+
+  std::lock_guard<std::mutex> lock(instance_lock);
+  if (!instance) {
+    // A reactor of its own, so that fences do not hold up vsync and other display events.
+    HWEventReactor *reactor = new HWEventReactor("SDM_FenceMonitor");
+    if (reactor->Init() != kErrorNone) {
+      delete reactor;
+      return nullptr;
+    }
+
+    InputFenceMonitor *monitor = new InputFenceMonitor(reactor);
+    if (monitor->Init() != kErrorNone) {
+      delete monitor;
+      delete reactor;
+      return nullptr;
+    }
+    // Lives as long as the process, displays come and go with hotplug.
+    instance = monitor;
+  }
+
+  return instance;
+}
+
+InputFenceMonitor::~InputFenceMonitor() {
+  std::map<int, Pending> pending;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    pending.swap(pending_);
+  }
+
+  // Not under the lock, handlers that are running wait on it.
+  for (auto &it : pending) {
+    reactor_->RemoveSource(it.first);
+    Sys::close_(it.first);
+  }
+
+  if (timer_fd_ >= 0) {
+    reactor_->RemoveSource(timer_fd_);
+    Sys::close_(timer_fd_);
+  }
+}
+
+DisplayError InputFenceMonitor::Init() {
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (timer_fd_ < 0) {
+    DLOGE("timerfd_create failed. error = %s", strerror(errno));
+    return kErrorResources;
+  }
+
+  DisplayError error = reactor_->AddSource(timer_fd_, EPOLLIN, [this](uint32_t) { OnTimer(); });
+  if (error != kErrorNone) {
+    Sys::close_(timer_fd_);
+    timer_fd_ = -1;
+  }
+
+  return error;
+}
+
+void InputFenceMonitor::Track(int32_t display_id, int64_t vsync_period_ns,
+                              const std::vector<LayerFence> &fences,
+                              const StuckHandler &stuck_handler) {
+  DTRACE_SCOPED();
+  int64_t commit_ns = GetTimeNs();
+
+  // Fences are polled and duped before taking the lock, the monitor thread waits on it.
+  std::vector<int> fds(fences.size(), -1);
+  for (size_t i = 0; i < fences.size(); i++) {
+    if (Fence::GetStatus(fences[i].fence) == Fence::Status::kPending) {
+      fds[i] = Fence::Dup(fences[i].fence);
+    }
+  }
+
+  std::vector<int> added_fds;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    DisplayStats &display = displays_[display_id];
+    display.frames++;
+    display.stuck_handler = stuck_handler;
+
+    for (size_t i = 0; i < fences.size(); i++) {
+      LayerStats *layer = GetLayerStats(&display, fences[i].layer_name);
+      if (fds[i] < 0) {
+        layer->histogram[kOnTime]++;
+        continue;
+      }
+
+      Pending &pending = pending_[fds[i]];
+      pending.display_id = display_id;
+      pending.layer_name = fences[i].layer_name;
+      pending.frame = display.frames;
+      pending.commit_ns = commit_ns;
+      pending.vsync_period_ns = vsync_period_ns;
+      added_fds.push_back(fds[i]);
+    }
+
+    if (stuck_handler && !added_fds.empty()) {
+      ArmTimer(commit_ns + kStuckTimeoutNs);
+    }
+  }
+
+  for (int fd : added_fds) {
+    DisplayError error = reactor_->AddSource(fd, EPOLLIN, [this, fd](uint32_t) {
+      OnSignaled(fd);
+    });
+    if (error != kErrorNone) {
+      std::lock_guard<std::mutex> lock(lock_);
+      pending_.erase(fd);
+      Sys::close_(fd);
+    }
+  }
+}
+
+void InputFenceMonitor::RemoveDisplay(int32_t display_id) {
+  std::vector<int> fds;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      if (it->second.display_id == display_id) {
+        fds.push_back(it->first);
+        it = pending_.erase(it);
+      } else {
+        it++;
+      }
+    }
+    displays_.erase(display_id);
+    dispatch_done_.wait(lock, [this, display_id] { return dispatching_display_ != display_id; });
+  }
+
+  // Not under the lock, a fence handler waiting on it may be the one being removed.
+  for (int fd : fds) {
+    reactor_->RemoveSource(fd);
+    Sys::close_(fd);
+  }
+}
+
+void InputFenceMonitor::Dump(int32_t display_id, std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = displays_.find(display_id);
+  if (it == displays_.end()) {
+    return;
+  }
+
+  DisplayStats &display = it->second;
+  *os << "\nInput fences: frames " << display.frames << " late frames " << display.late_frames;
+  *os << "\n Signaled (on time | <1/4 | <1/2 | <1 | <2 | >=2 vsyncs after commit):";
+  for (auto &layer : display.layers) {
+    *os << "\n  " << (layer.first.empty() ? "<unnamed>" : layer.first.c_str()) << ":";
+    for (uint32_t bucket = 0; bucket < kBucketMax; bucket++) {
+      *os << (bucket ? " | " : " ") << layer.second.histogram[bucket];
+    }
+    *os << " late " << layer.second.latched_late << " max "
+        << (layer.second.max_lateness_ns / 1000) << "us";
+  }
+}
+
+void InputFenceMonitor::OnSignaled(int fd) {
+  int64_t signal_ns = GetTimeNs();
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = pending_.find(fd);
+    if (it == pending_.end()) {
+      // Removed along with its display, which cleans it up.
+      return;
+    }
+
+    Pending &pending = it->second;
+    auto display = displays_.find(pending.display_id);
+    if (display != displays_.end()) {
+      LayerStats *layer = GetLayerStats(&display->second, pending.layer_name);
+      int64_t lateness_ns = signal_ns - pending.commit_ns;
+      layer->histogram[GetBucket(lateness_ns, pending.vsync_period_ns)]++;
+      layer->latched_late++;
+      layer->max_lateness_ns = std::max(layer->max_lateness_ns, lateness_ns);
+      if (display->second.last_late_frame != pending.frame) {
+        display->second.last_late_frame = pending.frame;
+        display->second.late_frames++;
+      }
+    }
+    pending_.erase(it);
+  }
+
+  reactor_->RemoveSource(fd);
+  Sys::close_(fd);
+}
+
+void InputFenceMonitor::OnTimer() {
+  uint64_t expirations = 0;
+  Sys::read_(timer_fd_, &expirations, sizeof(expirations));
+
+  int64_t now = GetTimeNs();
+  std::vector<std::pair<int32_t, StuckHandler>> handlers;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    timer_deadline_ns_ = 0;
+
+    std::set<int32_t> stuck_displays;
+    int64_t next_deadline_ns = 0;
+    for (auto &it : pending_) {
+      Pending &pending = it.second;
+      auto display = displays_.find(pending.display_id);
+      if ((pending.stack_dumps >= kMaxStackDumps) || (display == displays_.end()) ||
+          !display->second.stuck_handler) {
+        continue;
+      }
+
+      int64_t deadline_ns = pending.commit_ns + (kStuckTimeoutNs * (pending.stack_dumps + 1));
+      if (deadline_ns <= now) {
+        DLOGI("Acquire fence of %s on display %d not signaled in %" PRId64 " ms",
+              pending.layer_name.c_str(), pending.display_id, (now - pending.commit_ns) / 1000000);
+        if (stuck_displays.insert(pending.display_id).second) {
+          handlers.push_back(std::make_pair(pending.display_id, display->second.stuck_handler));
+        }
+        if (++pending.stack_dumps >= kMaxStackDumps) {
+          continue;
+        }
+        deadline_ns += kStuckTimeoutNs;
+      }
+      next_deadline_ns = next_deadline_ns ? std::min(next_deadline_ns, deadline_ns) : deadline_ns;
+    }
+
+    if (next_deadline_ns) {
+      ArmTimer(next_deadline_ns);
+    }
+  }
+
+  for (auto &handler : handlers) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (displays_.find(handler.first) == displays_.end()) {
+        continue;
+      }
+      dispatching_display_ = handler.first;
+    }
+
+    handler.second();
+
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      dispatching_display_ = -1;
+    }
+    dispatch_done_.notify_all();
+  }
+}
+
+void InputFenceMonitor::ArmTimer(int64_t deadline_ns) {
+  if (timer_deadline_ns_ && (timer_deadline_ns_ <= deadline_ns)) {
+    return;
+  }
+
+  struct itimerspec timer = {};
+  timer.it_value.tv_sec = deadline_ns / 1000000000;
+  timer.it_value.tv_nsec = deadline_ns % 1000000000;
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &timer, nullptr)) {
+    DLOGW("timerfd_settime failed. error = %s", strerror(errno));
+    return;
+  }
+  timer_deadline_ns_ = deadline_ns;
+}
+
+InputFenceMonitor::LayerStats *InputFenceMonitor::GetLayerStats(DisplayStats *display,
+                                                                const std::string &layer_name) {
+  auto it = display->layers.find(layer_name);
+  if (it == display->layers.end()) {
+    if (display->layers.size() >= kMaxLayers) {
+      // Layers come and go with apps, drop the one not seen for the longest.
+      auto oldest = std::min_element(display->layers.begin(), display->layers.end(),
+                                     [](const std::pair<const std::string, LayerStats> &lhs,
+                                        const std::pair<const std::string, LayerStats> &rhs) {
+                                       return lhs.second.last_frame < rhs.second.last_frame;
+                                     });
+      display->layers.erase(oldest);
+    }
+    it = display->layers.emplace(layer_name, LayerStats()).first;
+  }
+  it->second.last_frame = display->frames;
+
+  return &it->second;
+}
+
+InputFenceMonitor::Bucket InputFenceMonitor::GetBucket(int64_t lateness_ns,
+                                                       int64_t vsync_period_ns) {
+  if (vsync_period_ns <= 0) {
+    vsync_period_ns = 16666667;
+  }
+
+  if ((lateness_ns * 4) < vsync_period_ns) {
+    return kQuarterVSync;
+  } else if ((lateness_ns * 2) < vsync_period_ns) {
+    return kHalfVSync;
+  } else if (lateness_ns < vsync_period_ns) {
+    return kOneVSync;
+  } else if (lateness_ns < (vsync_period_ns * 2)) {
+    return kTwoVSyncs;
+  }
+
+  return kMoreVSyncs;
+}
+
+int64_t InputFenceMonitor::GetTimeNs() {
+  // Same clock as the timerfd, CLOCK_MONOTONIC.
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace sdm
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __INPUT_FENCE_MONITOR_H__
+#define __INPUT_FENCE_MONITOR_H__
+
+#include <core/sdm_types.h>
+#include <utils/fence.h>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "drm/hw_event_reactor.h"
+
+namespace sdm {
+
+// Timestamps the signal of the acquire fences of each committed frame without blocking the commit,
+// and keeps per layer histograms of how late they signal relative to the commit, in vsync periods.
+// Fences of all displays are waited on with a single epoll instance and thread.
+class InputFenceMonitor {
+ public:
+  // Called on the monitor thread when a fence has not signaled for a while.
+  typedef std::function<void()> StuckHandler;
+
+  struct LayerFence {
+    std::string layer_name;
+    shared_ptr<Fence> fence = nullptr;
+  };
+
+  static InputFenceMonitor *GetInstance();
+
+  // Fences and the stuck timer are waited on by reactor, which must outlive the monitor.
+  explicit InputFenceMonitor(HWEventReactor *reactor) : reactor_(reactor) {}
+  ~InputFenceMonitor();
+  DisplayError Init();
+
+  // Fences that are pending are waited on. stuck_handler may be empty.
+  void Track(int32_t display_id, int64_t vsync_period_ns, const std::vector<LayerFence> &fences,
+             const StuckHandler &stuck_handler);
+  // Stops waiting on the fences of the display. Once this returns, its stuck handler is neither
+  // running nor called anymore.
+  void RemoveDisplay(int32_t display_id);
+  void Dump(int32_t display_id, std::ostringstream *os);
+
+ private:
+  // Lateness buckets, the first one is for fences signaled by the time of the commit.
+  enum Bucket {
+    kOnTime,
+    kQuarterVSync,
+    kHalfVSync,
+    kOneVSync,
+    kTwoVSyncs,
+    kMoreVSyncs,
+    kBucketMax,
+  };
+
+  static const uint32_t kMaxLayers = 32;
+  static const int64_t kStuckTimeoutNs = 500000000;
+  static const uint32_t kMaxStackDumps = 2;
+
+  struct LayerStats {
+    uint64_t histogram[kBucketMax] = {};
+    uint64_t latched_late = 0;  // Signaled after the commit, the frame waited on it.
+    int64_t max_lateness_ns = 0;
+    uint64_t last_frame = 0;
+  };
+
+  struct DisplayStats {
+    uint64_t frames = 0;
+    uint64_t late_frames = 0;
+    uint64_t last_late_frame = 0;
+    StuckHandler stuck_handler = nullptr;
+    std::map<std::string, LayerStats> layers;
+  };
+
+  struct Pending {
+    int32_t display_id = -1;
+    std::string layer_name;
+    uint64_t frame = 0;
+    int64_t commit_ns = 0;
+    int64_t vsync_period_ns = 0;
+    uint32_t stack_dumps = 0;
+  };
+
+  void OnSignaled(int fd);
+  void OnTimer();
+  void ArmTimer(int64_t deadline_ns);
+  LayerStats *GetLayerStats(DisplayStats *display, const std::string &layer_name);
+  static Bucket GetBucket(int64_t lateness_ns, int64_t vsync_period_ns);
+  static int64_t GetTimeNs();
+
+  HWEventReactor *reactor_ = nullptr;
+  int timer_fd_ = -1;
+  int64_t timer_deadline_ns_ = 0;
+  std::mutex lock_;
+  std::condition_variable dispatch_done_;
+  int32_t dispatching_display_ = -1;
+  std::map<int, Pending> pending_;  // Keyed by the duped fence fd.
+  std::map<int32_t, DisplayStats> displays_;
+};
+
+}  // namespace sdm
+
+#endif  // __INPUT_FENCE_MONITOR_H__
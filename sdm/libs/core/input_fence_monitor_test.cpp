@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "input_fence_monitor.h"
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const int64_t kPeriod60 = 16666667;
+const int64_t kLongPeriod = 1000000000;
+
+class TestSyncHandler : public BufferSyncHandler {
+ public:
+  int SyncWait(int fd, int timeout) override {
+    if (fd < 0) {
+      return 0;
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ret = poll(&pfd, 1, timeout);
+    return (ret > 0) ? 0 : (ret == 0 ? -ETIME : -errno);
+  }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override { }
+};
+
+// An eventfd stands in for a sync_file, both poll readable once signaled.
+class TestFence {
+ public:
+  TestFence() : fd_(eventfd(0, EFD_CLOEXEC)) { }
+  ~TestFence() { close(fd_); }
+
+  // The Fence owns a dup, the test keeps the fd to signal it.
+  shared_ptr<Fence> Get() { return Fence::Create(dup(fd_), "acquire"); }
+
+  void Signal() {
+    uint64_t value = 1;
+    ASSERT_EQ(ssize_t(sizeof(value)), write(fd_, &value, sizeof(value)));
+  }
+
+ private:
+  int fd_;
+};
+
+class InputFenceMonitorTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { Fence::Set(&sync_handler_); }
+
+  void SetUp() override {
+    ASSERT_EQ(kErrorNone, reactor_.Init());
+    ASSERT_EQ(kErrorNone, monitor_.Init());
+  }
+
+  std::string Dump(int32_t display_id) {
+    std::ostringstream os;
+    monitor_.Dump(display_id, &os);
+    return os.str();
+  }
+
+  // Waits for the monitor thread to account for signaled fences.
+  bool WaitForDump(int32_t display_id, const std::string &expected) {
+    for (int i = 0; i < 200; i++) {
+      if (Dump(display_id).find(expected) != std::string::npos) {
+        return true;
+      }
+      std::this_thread::sleep_for(milliseconds(10));
+    }
+    return false;
+  }
+
+  static TestSyncHandler sync_handler_;
+  HWEventReactor reactor_{"monitor_test"};
+  InputFenceMonitor monitor_{&reactor_};
+};
+
+TestSyncHandler InputFenceMonitorTest::sync_handler_;
+
+}  // namespace
+
+TEST_F(InputFenceMonitorTest, SignaledFencesAreOnTime) {
+  TestFence fence;
+  fence.Signal();
+  monitor_.Track(0, kPeriod60, {{"app", fence.Get()}, {"no_fence", nullptr}}, nullptr);
+  monitor_.Track(0, kPeriod60, {{"app", fence.Get()}}, nullptr);
+
+  std::string dump = Dump(0);
+  EXPECT_NE(std::string::npos, dump.find("frames 2 late frames 0")) << dump;
+  EXPECT_NE(std::string::npos, dump.find("app: 2 | 0 | 0 | 0 | 0 | 0 late 0")) << dump;
+  EXPECT_NE(std::string::npos, dump.find("no_fence: 1 | 0")) << dump;
+  EXPECT_EQ("", Dump(1));
+}
+
+// Lateness is bucketed in vsync periods of the display at the time of the commit.
+TEST_F(InputFenceMonitorTest, BucketsLatenessInVSyncPeriods) {
+  TestFence fast;
+  TestFence slow;
+  monitor_.Track(0, kLongPeriod, {{"fast", fast.Get()}}, nullptr);
+  monitor_.Track(1, kPeriod60, {{"slow", slow.Get()}}, nullptr);
+  std::this_thread::sleep_for(milliseconds(40));
+  fast.Signal();
+  slow.Signal();
+
+  EXPECT_TRUE(WaitForDump(0, "fast: 0 | 1 | 0 | 0 | 0 | 0 late 1")) << Dump(0);
+  EXPECT_TRUE(WaitForDump(1, "slow: 0 | 0 | 0 | 0 | 0 | 1 late 1")) << Dump(1);
+  EXPECT_NE(std::string::npos, Dump(1).find("frames 1 late frames 1"));
+}
+
+// Late layers of one frame count as one late frame.
+TEST_F(InputFenceMonitorTest, CountsLateFrames) {
+  TestFence first;
+  TestFence second;
+  monitor_.Track(0, kLongPeriod, {{"a", first.Get()}, {"b", second.Get()}}, nullptr);
+  first.Signal();
+  second.Signal();
+  ASSERT_TRUE(WaitForDump(0, "a: 0 | 1 | 0 | 0 | 0 | 0 late 1")) << Dump(0);
+  ASSERT_TRUE(WaitForDump(0, "b: 0 | 1 | 0 | 0 | 0 | 0 late 1")) << Dump(0);
+
+  std::string dump = Dump(0);
+  EXPECT_NE(std::string::npos, dump.find("frames 1 late frames 1")) << dump;
+}
+
+// The commit thread never waits on a fence.
+TEST_F(InputFenceMonitorTest, TrackDoesNotBlock) {
+  std::vector<TestFence> fences(16);
+  std::vector<InputFenceMonitor::LayerFence> layer_fences;
+  for (size_t i = 0; i < fences.size(); i++) {
+    layer_fences.push_back({"layer" + std::to_string(i), fences[i].Get()});
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < 10; frame++) {
+    monitor_.Track(0, kLongPeriod, layer_fences, nullptr);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, milliseconds(100));
+
+  for (auto &fence : fences) {
+    fence.Signal();
+  }
+  EXPECT_TRUE(WaitForDump(0, "layer15: 0 | 10 | 0 | 0 | 0 | 0 late 10")) << Dump(0);
+}
+
+TEST_F(InputFenceMonitorTest, BoundsLayerEntries) {
+  TestFence fence;
+  fence.Signal();
+  for (int i = 0; i < 40; i++) {
+    monitor_.Track(0, kPeriod60, {{"layer" + std::to_string(i), fence.Get()}}, nullptr);
+  }
+
+  std::string dump = Dump(0);
+  EXPECT_EQ(std::string::npos, dump.find("layer7:")) << dump;
+  EXPECT_NE(std::string::npos, dump.find("layer8:")) << dump;
+  EXPECT_NE(std::string::npos, dump.find("layer39:")) << dump;
+}
+
+// A fence that does not signal gets the stack dumped at 500 ms and 1 s, then no more.
+TEST_F(InputFenceMonitorTest, StuckFence) {
+  TestFence fence;
+  std::atomic<int> dumps(0);
+  monitor_.Track(0, kPeriod60, {{"stuck", fence.Get()}}, [&dumps] { dumps++; });
+
+  std::this_thread::sleep_for(milliseconds(400));
+  EXPECT_EQ(0, dumps);
+  std::this_thread::sleep_for(milliseconds(800));
+  EXPECT_EQ(2, dumps);
+  std::this_thread::sleep_for(milliseconds(600));
+  EXPECT_EQ(2, dumps);
+
+  fence.Signal();
+  EXPECT_TRUE(WaitForDump(0, "stuck: 0 | 0 | 0 | 0 | 0 | 1")) << Dump(0);
+}
+
+// Once a display is removed, its fences are not waited on and its stuck handler is not called.
+TEST_F(InputFenceMonitorTest, RemoveDisplay) {
+  TestFence fence;
+  TestFence other;
+  std::atomic<int> dumps(0);
+  monitor_.Track(0, kPeriod60, {{"removed", fence.Get()}}, [&dumps] { dumps++; });
+  monitor_.Track(1, kPeriod60, {{"kept", other.Get()}}, nullptr);
+
+  monitor_.RemoveDisplay(0);
+  EXPECT_EQ("", Dump(0));
+  fence.Signal();
+  other.Signal();
+  EXPECT_TRUE(WaitForDump(1, "kept: 0 | 1")) << Dump(1);
+  std::this_thread::sleep_for(milliseconds(600));
+  EXPECT_EQ(0, dumps);
+  EXPECT_EQ("", Dump(0));
+}
+
+TEST_F(InputFenceMonitorTest, ConcurrentDisplays) {
+  const int kDisplays = 4;
+  const int kFrames = 100;
+  std::vector<std::thread> threads;
+  for (int display = 0; display < kDisplays; display++) {
+    threads.emplace_back([this, display] {
+      for (int frame = 0; frame < kFrames; frame++) {
+        TestFence fence;
+        monitor_.Track(display, kPeriod60, {{"layer", fence.Get()}}, nullptr);
+        fence.Signal();
+        if (frame == kFrames / 2 && display == 0) {
+          monitor_.RemoveDisplay(display);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int display = 1; display < kDisplays; display++) {
+    EXPECT_TRUE(WaitForDump(display, "frames 100 ")) << Dump(display);
+  }
+}
+
+// Pending fences are released along with the monitor.
+TEST(InputFenceMonitor, DestroyWithPendingFences) {
+  static TestSyncHandler sync_handler;
+  Fence::Set(&sync_handler);
+  HWEventReactor reactor("monitor_test");
+  ASSERT_EQ(kErrorNone, reactor.Init());
+  TestFence fence;
+  {
+    InputFenceMonitor monitor(&reactor);
+    ASSERT_EQ(kErrorNone, monitor.Init());
+    monitor.Track(0, kPeriod60, {{"pending", fence.Get()}}, [] { });
+  }
+  fence.Signal();
+  std::this_thread::sleep_for(milliseconds(20));
+}
+
+}  // namespace sdm
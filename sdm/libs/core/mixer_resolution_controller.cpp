@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/debug.h>
+
+#include "mixer_resolution_controller.h"
+
+#define __CLASS__ "MixerResolutionController"
+
+namespace sdm {
+
+void MixerResolutionController::Update(uint32_t current_width, uint32_t current_height,
+                                       uint32_t target_width, uint32_t target_height,
+                                       uint32_t display_width, uint32_t display_height,
+                                       int64_t now_ms, bool commit, uint32_t *width,
+                                       uint32_t *height) {
+  *width = current_width;
+  *height = current_height;
+  if ((target_width == current_width) && (target_height == current_height)) {
+    if (commit) {
+      ResetPending();
+    }
+    return;
+  }
+
+  uint64_t current_area = uint64_t(current_width) * current_height;
+  uint64_t target_area = uint64_t(target_width) * target_height;
+  uint64_t display_area = uint64_t(display_width) * display_height;
+  if (GetGainPercent(current_area, target_area, display_area) < config_.min_gain_percent) {
+    if (commit) {
+      ResetPending();
+      stats_.rejected++;
+    }
+    return;
+  }
+
+  uint32_t pending_frames = pending_frames_;
+  int64_t pending_since_ms = pending_since_ms_;
+  if ((target_width != pending_width_) || (target_height != pending_height_)) {
+    pending_frames = 0;
+    pending_since_ms = now_ms;
+  }
+  pending_frames++;
+
+  bool stable = (pending_frames >= config_.stable_frames) ||
+                ((pending_frames > 1) && (now_ms - pending_since_ms >= config_.stable_ms));
+  bool rate_limited = switched_ && (now_ms - last_switch_ms_ < config_.min_interval_ms);
+  if (stable && !rate_limited) {
+    *width = target_width;
+    *height = target_height;
+  }
+
+  if (!commit) {
+    return;
+  }
+
+  if (stable && !rate_limited) {
+    DLOGI_IF(kTagDisplay, "Switching mixer %dx%d -> %dx%d after %d frames", current_width,
+             current_height, target_width, target_height, pending_frames);
+    ResetPending();
+    last_switch_ms_ = now_ms;
+    switched_ = true;
+    stats_.switches++;
+    return;
+  }
+
+  pending_width_ = target_width;
+  pending_height_ = target_height;
+  pending_frames_ = pending_frames;
+  pending_since_ms_ = pending_since_ms;
+  stats_.held_frames++;
+}
+
+void MixerResolutionController::ApplyForced(bool changed, int64_t now_ms) {
+  ResetPending();
+  if (changed) {
+    last_switch_ms_ = now_ms;
+    switched_ = true;
+    stats_.forced++;
+  }
+}
+
+void MixerResolutionController::ResetPending() {
+  pending_width_ = 0;
+  pending_height_ = 0;
+  pending_frames_ = 0;
+  pending_since_ms_ = 0;
+}
+
+void MixerResolutionController::Dump(std::ostringstream *os) {
+  *os << "\nMixer resolution: switches " << stats_.switches << " held frames "
+      << stats_.held_frames << " rejected " << stats_.rejected << " forced " << stats_.forced;
+}
+
+uint64_t MixerResolutionController::GetGainPercent(uint64_t current_area, uint64_t target_area,
+                                                   uint64_t display_area) {
+  if (!display_area || !target_area) {
+    return 0;
+  }
+
+  // Cost of a mixer resolution for the content, in percent of the cost of a display sized mixer:
+  // bandwidth grows with the mixer area, and a mixer smaller than the content asks for loses
+  // quality in proportion to the missing area.
+  auto cost = [&](uint64_t area) {
+    uint64_t bandwidth = (area * 100) / display_area;
+    uint64_t quality = (area < target_area) ? ((target_area - area) * 100) / target_area : 0;
+    return (kBandwidthWeight * bandwidth) + (kQualityWeight * quality);
+  };
+
+  uint64_t current_cost = cost(current_area);
+  uint64_t target_cost = cost(target_area);
+
+  return (current_cost > target_cost) ? (current_cost - target_cost) : 0;
+}
+
+}  // namespace sdm
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __MIXER_RESOLUTION_CONTROLLER_H__
+#define __MIXER_RESOLUTION_CONTROLLER_H__
+
+#include <stdint.h>
+#include <sstream>
+
+namespace sdm {
+
+// Decides when the layer mixer follows the resolution the content asks for. A mixer
+// reconfiguration costs a full validate, so a new resolution is only switched to when it is
+// worth it by a bandwidth and quality cost, has been asked for consistently for a number of
+// frames or a time window, and not too soon after the previous switch. Content alternating
+// between layers of similar size then keeps the mixer as is. Not thread safe, the display lock
+// serializes it.
+class MixerResolutionController {
+ public:
+  struct Config {
+    uint32_t stable_frames = 3;  // Frames asking for the same resolution before a switch.
+    uint32_t stable_ms = 100;  // Or time since first asked for, over two frames at least.
+    uint32_t min_interval_ms = 500;  // Between two switches.
+    uint32_t min_gain_percent = 5;  // Cost reduction a switch needs, of the display cost.
+  };
+
+  struct Stats {
+    uint64_t switches = 0;
+    uint64_t held_frames = 0;  // Frames the mixer was kept while content asked otherwise.
+    uint64_t rejected = 0;  // Resolutions not worth a switch.
+    uint64_t forced = 0;  // Switches applied right away.
+  };
+
+  void SetConfig(const Config &config) { config_ = config; }
+  // Returns the mixer resolution to use given the current one and the one the content asks for.
+  // With commit false the decision is not recorded, for peeking within a frame.
+  void Update(uint32_t current_width, uint32_t current_height, uint32_t target_width,
+              uint32_t target_height, uint32_t display_width, uint32_t display_height,
+              int64_t now_ms, bool commit, uint32_t *width, uint32_t *height);
+  // Records a resolution the display applied without asking, e.g. the display size to avoid
+  // downscaling at the mixer. If it changed the mixer, it counts as a switch for the interval to
+  // the next one.
+  void ApplyForced(bool changed, int64_t now_ms);
+  // Forgets a resolution being asked for, e.g. when the content asks for none.
+  void ResetPending();
+  void Dump(std::ostringstream *os);
+  const Stats &GetStats() const { return stats_; }
+
+ private:
+  // Quality loss weighs more than bandwidth, a mixer smaller than needed is visible.
+  static const uint64_t kBandwidthWeight = 1;
+  static const uint64_t kQualityWeight = 2;
+
+  uint64_t GetGainPercent(uint64_t current_area, uint64_t target_area, uint64_t display_area);
+
+  Config config_;
+  Stats stats_;
+  uint32_t pending_width_ = 0;
+  uint32_t pending_height_ = 0;
+  uint32_t pending_frames_ = 0;
+  int64_t pending_since_ms_ = 0;
+  int64_t last_switch_ms_ = 0;
+  bool switched_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __MIXER_RESOLUTION_CONTROLLER_H__
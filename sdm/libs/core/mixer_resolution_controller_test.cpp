@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mixer_resolution_controller.h"
+
+namespace sdm {
+
+namespace {
+
+const uint32_t kDisplayWidth = 1920;
+const uint32_t kDisplayHeight = 1080;
+const int64_t kFrameMs = 16;
+// The first frame at least min_interval_ms after a switch.
+const int64_t kIntervalFrames = (500 + kFrameMs - 1) / kFrameMs;
+
+struct Size {
+  uint32_t width;
+  uint32_t height;
+
+  bool operator==(const Size &other) const {
+    return width == other.width && height == other.height;
+  }
+};
+
+const Size kDisplay = {kDisplayWidth, kDisplayHeight};
+const Size kVideo = {1280, 720};
+const Size kUI = {1600, 900};
+
+// Plays frames through the controller the way DisplayBase::NeedsMixerReconfiguration does, and
+// counts the mixer reconfigurations it leads to.
+class Simulator {
+ public:
+  explicit Simulator(const MixerResolutionController::Config &config = {}) {
+    controller_.SetConfig(config);
+  }
+
+  // A frame whose content asks for target. forced is the display size fall-back, applied
+  // without going through the controller. Returns whether the mixer was reconfigured.
+  bool Frame(const Size &target, int64_t frame_ms = kFrameMs, bool forced = false) {
+    now_ms_ += frame_ms;
+    Size next = target;
+    if (forced) {
+      controller_.ApplyForced(!(target == mixer_), now_ms_);
+    } else {
+      // Peeking within the frame gives the decision the commit makes.
+      Size peeked = {};
+      controller_.Update(mixer_.width, mixer_.height, target.width, target.height, kDisplayWidth,
+                         kDisplayHeight, now_ms_, false, &peeked.width, &peeked.height);
+      controller_.Update(mixer_.width, mixer_.height, target.width, target.height, kDisplayWidth,
+                         kDisplayHeight, now_ms_, true, &next.width, &next.height);
+      EXPECT_TRUE(peeked == next);
+    }
+
+    bool reconfigured = !(next == mixer_);
+    mixer_ = next;
+    reconfigs_ += reconfigured ? 1 : 0;
+    return reconfigured;
+  }
+
+  // Plays a sequence of targets, repeating each one hold frames, for frames in total.
+  void Play(const std::vector<Size> &targets, uint32_t hold, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; i++) {
+      Frame(targets[(i / hold) % targets.size()]);
+    }
+  }
+
+  const Size &mixer() { return mixer_; }
+  uint32_t reconfigs() { return reconfigs_; }
+  const MixerResolutionController::Stats &stats() { return controller_.GetStats(); }
+
+  MixerResolutionController controller_;
+
+ private:
+  Size mixer_ = kDisplay;
+  int64_t now_ms_ = 1000;
+  uint32_t reconfigs_ = 0;
+};
+
+// Without the controller every change of target reconfigures the mixer.
+uint32_t NaiveReconfigs(const std::vector<Size> &targets, uint32_t hold, uint32_t frames) {
+  Size mixer = kDisplay;
+  uint32_t reconfigs = 0;
+  for (uint32_t i = 0; i < frames; i++) {
+    const Size &target = targets[(i / hold) % targets.size()];
+    reconfigs += (target == mixer) ? 0 : 1;
+    mixer = target;
+  }
+  return reconfigs;
+}
+
+}  // namespace
+
+TEST(MixerResolutionController, AlternatingContentKeepsMixer) {
+  for (uint32_t hold : {1u, 2u}) {
+    Simulator sim;
+    sim.Play({kVideo, kUI}, hold, 120);
+    EXPECT_EQ(0u, sim.reconfigs()) << hold;
+    EXPECT_TRUE(sim.mixer() == kDisplay);
+    EXPECT_EQ(120u, sim.stats().held_frames);
+    EXPECT_EQ(120u / hold, NaiveReconfigs({kVideo, kUI}, hold, 120));
+  }
+}
+
+TEST(MixerResolutionController, StepChangeSwitchesOnce) {
+  Simulator sim;
+  EXPECT_FALSE(sim.Frame(kVideo));
+  EXPECT_FALSE(sim.Frame(kVideo));
+  EXPECT_TRUE(sim.Frame(kVideo));
+  sim.Play({kVideo}, 1, 117);
+  EXPECT_EQ(1u, sim.reconfigs());
+  EXPECT_TRUE(sim.mixer() == kVideo);
+  EXPECT_EQ(1u, sim.stats().switches);
+  EXPECT_EQ(2u, sim.stats().held_frames);
+}
+
+// At a low frame rate, the time window is reached before the frame count.
+TEST(MixerResolutionController, StableOverTime) {
+  Simulator sim;
+  EXPECT_FALSE(sim.Frame(kVideo, 100));
+  EXPECT_TRUE(sim.Frame(kVideo, 100));
+}
+
+// One frame is never enough, however long it stays.
+TEST(MixerResolutionController, SingleFrameIsNotStable) {
+  Simulator sim;
+  EXPECT_FALSE(sim.Frame(kVideo, 1000));
+  EXPECT_FALSE(sim.Frame(kUI, 1000));
+  EXPECT_TRUE(sim.Frame(kUI, 1000));
+}
+
+TEST(MixerResolutionController, RateLimitsSwitches) {
+  Simulator sim;
+  sim.Play({kVideo}, 1, 3);
+  ASSERT_TRUE(sim.mixer() == kVideo);
+
+  // Stable after 3 frames, but within 500 ms of the previous switch.
+  uint32_t frames = 0;
+  while (!sim.Frame(kUI)) {
+    frames++;
+  }
+  EXPECT_EQ(kIntervalFrames, int64_t(frames + 1));
+  EXPECT_EQ(2u, sim.stats().switches);
+}
+
+TEST(MixerResolutionController, RejectsSmallGains) {
+  Simulator sim;
+  sim.Play({{1904, 1072}}, 1, 10);
+  EXPECT_EQ(0u, sim.reconfigs());
+  EXPECT_EQ(10u, sim.stats().rejected);
+  EXPECT_EQ(0u, sim.stats().held_frames);
+}
+
+// A mixer smaller than the content loses quality, growing it back is worth a switch.
+TEST(MixerResolutionController, GrowsBackForQuality) {
+  Simulator sim;
+  sim.Play({kVideo}, 1, 3);
+  sim.Play({kUI}, 1, 60);
+  EXPECT_TRUE(sim.mixer() == kUI);
+  EXPECT_EQ(2u, sim.reconfigs());
+}
+
+// The display size fall-back applies on its frame, and the content does not switch away from it
+// right after.
+TEST(MixerResolutionController, ForcedSwitchIsImmediate) {
+  Simulator sim;
+  sim.Play({kVideo}, 1, 3);
+  ASSERT_TRUE(sim.mixer() == kVideo);
+
+  EXPECT_FALSE(sim.Frame(kUI));
+  EXPECT_TRUE(sim.Frame(kDisplay, kFrameMs, true));
+  EXPECT_TRUE(sim.mixer() == kDisplay);
+  EXPECT_EQ(1u, sim.stats().forced);
+
+  // The pending UI frame was forgotten and the next switch waits for the interval.
+  EXPECT_FALSE(sim.Frame(kUI));
+  EXPECT_FALSE(sim.Frame(kUI));
+  EXPECT_FALSE(sim.Frame(kUI));
+  uint32_t frames = 3;
+  while (!sim.Frame(kUI)) {
+    frames++;
+  }
+  EXPECT_EQ(kIntervalFrames, int64_t(frames + 1));
+}
+
+// A fall-back that keeps the mixer as is is not a switch.
+TEST(MixerResolutionController, ForcedWithoutChange) {
+  Simulator sim;
+  EXPECT_FALSE(sim.Frame(kVideo));
+  EXPECT_FALSE(sim.Frame(kDisplay, kFrameMs, true));
+  EXPECT_EQ(0u, sim.stats().forced);
+  EXPECT_FALSE(sim.Frame(kVideo));
+  EXPECT_FALSE(sim.Frame(kVideo));
+  EXPECT_TRUE(sim.Frame(kVideo));
+}
+
+// Content alternating with frames that need the display size keeps a display sized mixer, the
+// frames asking for less are held.
+TEST(MixerResolutionController, AlternatingWithForced) {
+  Simulator sim;
+  for (uint32_t i = 0; i < 60; i++) {
+    sim.Frame(kVideo);
+    sim.Frame(kDisplay, kFrameMs, true);
+  }
+  EXPECT_EQ(0u, sim.reconfigs());
+  EXPECT_TRUE(sim.mixer() == kDisplay);
+}
+
+TEST(MixerResolutionController, Config) {
+  MixerResolutionController::Config config;
+  config.stable_frames = 1;
+  config.min_interval_ms = 0;
+  Simulator sim(config);
+  sim.Play({kVideo, kUI}, 1, 10);
+  EXPECT_EQ(10u, sim.reconfigs());
+}
+
+TEST(MixerResolutionController, Dump) {
+  Simulator sim;
+  sim.Play({kVideo}, 1, 3);
+  sim.Frame(kDisplay, kFrameMs, true);
+  std::ostringstream os;
+  sim.controller_.Dump(&os);
+  EXPECT_EQ("\nMixer resolution: switches 1 held frames 2 rejected 0 forced 1", os.str());
+}
+
+}  // namespace sdm
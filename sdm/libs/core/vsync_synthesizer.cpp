@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <inttypes.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+
+#include "vsync_synthesizer.h"
+
+#define __CLASS__ "VSyncSynthesizer"
+
+namespace sdm {
+
+VSyncSynthesizer::VSyncSynthesizer(EventHandler *event_handler, int64_t error_threshold_ns,
+                                   uint32_t resync_ms)
+  : event_handler_(event_handler), resync_interval_ns_(static_cast<int64_t>(resync_ms) * 1000000),
+    model_(error_threshold_ns) {}
+
+VSyncSynthesizer::~VSyncSynthesizer() {
+  Deinit();
+}
+
+DisplayError VSyncSynthesizer::Init(const std::string &thread_name) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (thread_.joinable()) {
+    return kErrorNone;
+  }
+
+  exit_ = false;
+  thread_ = std::thread([this, thread_name] {
+    prctl(PR_SET_NAME, thread_name.c_str(), 0, 0, 0);
+    setpriority(PRIO_PROCESS, 0, kThreadPriorityUrgent);
+    Run();
+  });
+
+  return kErrorNone;
+}
+
+void VSyncSynthesizer::Deinit() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!thread_.joinable()) {
+      return;
+    }
+    exit_ = true;
+    cv_.notify_one();
+  }
+  thread_.join();
+}
+
+bool VSyncSynthesizer::OnHWVSync(int64_t timestamp, bool *hw_vsync_needed) {
+  std::lock_guard<std::mutex> lock(lock_);
+  stats_.hw_vsyncs++;
+
+  bool locked = model_.IsLocked();
+  int64_t error = std::abs(model_.GetError(timestamp));
+  bool fits = model_.AddSample(timestamp);
+  if (locked && fits) {
+    stats_.max_error_ns = std::max(stats_.max_error_ns, error);
+  } else if (locked) {
+    stats_.misses++;
+    DLOGI("vsync %" PRId64 " off by %" PRId64 " ns, back to hardware vsync", timestamp, error);
+  }
+
+  // Hardware vsync that was armed before the synthesizer took over, or that came in along with
+  // the synthesized one it is resyncing from.
+  bool duplicate = (last_vsync_ != 0) &&
+                   (std::abs(timestamp - last_vsync_) < (model_.GetPeriod() / 2));
+  if (synthesizing_) {
+    if (fits) {
+      *hw_vsync_needed = false;
+      return false;
+    }
+    synthesizing_ = false;
+    generation_++;
+    cv_.notify_one();
+  }
+
+  *hw_vsync_needed = true;
+  if (!fits || !model_.IsLocked() || (++resync_samples_ < kResyncSamples)) {
+    if (!fits) {
+      resync_samples_ = 0;
+    }
+    last_vsync_ = duplicate ? last_vsync_ : timestamp;
+    return !duplicate;
+  }
+
+  // Model is good, take over from the next vsync. A model fitted to a few jittery samples does
+  // not predict far, it is checked early and gets more precise with every resync.
+  *hw_vsync_needed = false;
+  synthesizing_ = true;
+  generation_++;
+  resync_samples_ = 0;
+  resync_deadline_ = timestamp + std::min(resync_interval_ns_, model_.GetPredictionHorizon());
+  last_vsync_ = duplicate ? last_vsync_ : timestamp;
+  cv_.notify_one();
+
+  return !duplicate;
+}
+
+bool VSyncSynthesizer::Reset(int64_t nominal_period_ns) {
+  std::lock_guard<std::mutex> lock(lock_);
+  bool synthesizing = synthesizing_;
+
+  model_.Reset(nominal_period_ns);
+  synthesizing_ = false;
+  generation_++;
+  resync_samples_ = 0;
+  last_vsync_ = 0;
+  cv_.notify_one();
+
+  return synthesizing;
+}
+
+bool VSyncSynthesizer::IsSynthesizing() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return synthesizing_;
+}
+
+VSyncSynthesizer::Stats VSyncSynthesizer::GetStats() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return stats_;
+}
+
+void VSyncSynthesizer::Run() {
+  // Vsync timestamps are in CLOCK_MONOTONIC, which steady_clock is on Linux.
+  typedef std::chrono::steady_clock Clock;
+
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    cv_.wait(lock, [this] { return exit_ || synthesizing_; });
+    if (exit_) {
+      break;
+    }
+
+    // Vsyncs that went by while the thread was held up are not delivered late.
+    uint32_t generation = generation_;
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  Clock::now().time_since_epoch()).count();
+    int64_t vsync = model_.GetNextVSync(std::max(last_vsync_ + (model_.GetPeriod() / 2), now));
+    Clock::time_point wake_time{std::chrono::nanoseconds(vsync)};
+    cv_.wait_until(lock, wake_time, [this, generation] {
+      return exit_ || (generation_ != generation);
+    });
+    if (exit_) {
+      break;
+    }
+    if (generation_ != generation) {
+      continue;
+    }
+
+    last_vsync_ = vsync;
+    stats_.synthesized++;
+    bool resync = (vsync >= resync_deadline_);
+    if (resync) {
+      synthesizing_ = false;
+      generation_++;
+      stats_.resyncs++;
+    }
+
+    lock.unlock();
+    bool wanted = event_handler_->OnSynthesizedVSync(vsync);
+    if (resync && wanted) {
+      event_handler_->EnableHWVSync();
+    }
+    lock.lock();
+
+    if (!wanted && (generation_ == generation)) {
+      synthesizing_ = false;
+      generation_++;
+    }
+  }
+}
+
+}  // namespace sdm
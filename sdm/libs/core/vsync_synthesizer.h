@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __VSYNC_SYNTHESIZER_H__
+#define __VSYNC_SYNTHESIZER_H__
+
+#include <core/sdm_types.h>
+#include <utils/vsync_model.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sdm {
+
+// Generates vsync events from a timer once the vsync model has locked on hardware vsync, so that
+// hardware vsync interrupts can be turned off while the client has vsync enabled. Hardware vsync
+// is turned back on for a few samples every resync interval to check the model, and for good on
+// a sample that does not fit the model.
+class VSyncSynthesizer {
+ public:
+  class EventHandler {
+   public:
+    virtual ~EventHandler() { }
+    // Called on the synthesizer thread. Returns false if vsync is not wanted anymore, which stops
+    // the synthesizer until it locks again on hardware vsync.
+    virtual bool OnSynthesizedVSync(int64_t timestamp) = 0;
+    // Called on the synthesizer thread when the model is to be checked against hardware vsync.
+    virtual void EnableHWVSync() = 0;
+  };
+
+  struct Stats {
+    uint64_t hw_vsyncs = 0;
+    uint64_t synthesized = 0;
+    uint64_t resyncs = 0;
+    uint64_t misses = 0;  // Samples that did not fit the model.
+    int64_t max_error_ns = 0;  // Largest error of a sample that fit the model.
+  };
+
+  VSyncSynthesizer(EventHandler *event_handler, int64_t error_threshold_ns, uint32_t resync_ms);
+  ~VSyncSynthesizer();
+
+  DisplayError Init(const std::string &thread_name);
+  void Deinit();
+  // Returns false if the hardware vsync is not to be propagated, because it has already been
+  // synthesized. hw_vsync_needed is set to false when hardware vsync can be turned off.
+  bool OnHWVSync(int64_t timestamp, bool *hw_vsync_needed);
+  // Drops the model on a mode or refresh rate change. Returns true if it was synthesizing, and
+  // hardware vsync needs to be turned back on.
+  bool Reset(int64_t nominal_period_ns);
+  bool IsSynthesizing();
+  Stats GetStats();
+
+ private:
+  static const uint32_t kResyncSamples = 2;
+
+  void Run();
+
+  EventHandler *event_handler_ = nullptr;
+  const int64_t resync_interval_ns_;
+  std::thread thread_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  VSyncModel model_;
+  int64_t last_vsync_ = 0;
+  int64_t resync_deadline_ = 0;
+  uint32_t resync_samples_ = 0;
+  uint32_t generation_ = 0;
+  bool synthesizing_ = false;
+  bool exit_ = false;
+  Stats stats_ = {};
+};
+
+}  // namespace sdm
+
+#endif  // __VSYNC_SYNTHESIZER_H__
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <utils/async_task.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace sdm {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+enum class TestCode { kRun, kOther };
+
+struct TestContext : public AsyncTask<TestCode>::TaskContext {
+  explicit TestContext(int value) : value(value) { }
+  int value;
+};
+
+// Records the tasks it runs. While blocked, tasks wait for Release.
+class TestHandler : public AsyncTask<TestCode>::TaskHandler {
+ public:
+  void OnTask(const TestCode &task_code, AsyncTask<TestCode>::TaskContext *task_context) override {
+    std::unique_lock<std::mutex> lock(lock_);
+    started_++;
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return !blocked_; });
+    values_.push_back(static_cast<TestContext *>(task_context)->value);
+  }
+
+  void OnTaskBatch(const TestCode &task_code,
+                   const std::vector<AsyncTask<TestCode>::TaskContext *> &task_contexts) override {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      batches_.push_back(task_contexts.size());
+    }
+    AsyncTask<TestCode>::TaskHandler::OnTaskBatch(task_code, task_contexts);
+  }
+
+  void Block() {
+    std::lock_guard<std::mutex> lock(lock_);
+    blocked_ = true;
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(lock_);
+    blocked_ = false;
+    cv_.notify_all();
+  }
+
+  void WaitStarted(int count) {
+    std::unique_lock<std::mutex> lock(lock_);
+    cv_.wait(lock, [this, count] { return started_ >= count; });
+  }
+
+  std::vector<int> values() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return values_;
+  }
+
+  std::vector<size_t> batches() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return batches_;
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool blocked_ = false;
+  int started_ = 0;
+  std::vector<int> values_;
+  std::vector<size_t> batches_;
+};
+
+std::shared_ptr<TestContext> Context(int value) {
+  return std::make_shared<TestContext>(value);
+}
+
+}  // namespace
+
+TEST(AsyncTask, RunsTasksInOrder) {
+  TestHandler handler;
+  AsyncTask<TestCode> task(handler, 4);
+  std::vector<std::future<bool>> done;
+  for (int i = 0; i < 16; i++) {
+    done.push_back(task.PostTask(TestCode::kRun, Context(i)));
+  }
+  task.Flush();
+
+  for (auto &future : done) {
+    EXPECT_TRUE(future.get());
+  }
+  std::vector<int> expected;
+  for (int i = 0; i < 16; i++) {
+    expected.push_back(i);
+  }
+  EXPECT_EQ(expected, handler.values());
+  EXPECT_EQ(0u, task.GetPendingCount());
+}
+
+// PostTask blocks while max_pending tasks are queued.
+TEST(AsyncTask, BoundsPendingTasks) {
+  TestHandler handler;
+  handler.Block();
+  AsyncTask<TestCode> task(handler, 2);
+  task.PostTask(TestCode::kRun, Context(0));
+  handler.WaitStarted(1);
+  task.PostTask(TestCode::kRun, Context(1));
+  task.PostTask(TestCode::kRun, Context(2));
+  EXPECT_EQ(3u, task.GetPendingCount());
+
+  std::atomic<bool> posted(false);
+  std::thread poster([&] {
+    task.PostTask(TestCode::kRun, Context(3));
+    posted = true;
+  });
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_FALSE(posted);
+
+  handler.Release();
+  poster.join();
+  EXPECT_TRUE(posted);
+  task.Flush();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), handler.values());
+}
+
+TEST(AsyncTask, BatchesTasksOfOneCode) {
+  TestHandler handler;
+  handler.Block();
+  AsyncTask<TestCode> task(handler, 8, true /* batching */);
+  task.PostTask(TestCode::kOther, Context(0));
+  handler.WaitStarted(1);
+  for (int i = 1; i <= 4; i++) {
+    task.PostTask(TestCode::kRun, Context(i));
+  }
+  task.PostTask(TestCode::kOther, Context(5));
+  handler.Release();
+  task.Flush();
+
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), handler.values());
+  EXPECT_EQ(std::vector<size_t>({4}), handler.batches());
+}
+
+TEST(AsyncTask, CancelPending) {
+  TestHandler handler;
+  handler.Block();
+  AsyncTask<TestCode> task(handler, 4);
+  auto running = task.PostTask(TestCode::kRun, Context(0));
+  handler.WaitStarted(1);
+  auto pending = task.PostTask(TestCode::kRun, Context(1));
+
+  EXPECT_EQ(1u, task.CancelPending());
+  EXPECT_FALSE(pending.get());
+  handler.Release();
+  EXPECT_TRUE(running.get());
+  EXPECT_EQ(std::vector<int>({0}), handler.values());
+}
+
+TEST(AsyncTask, DestructorCancelsPendingTasks) {
+  TestHandler handler;
+  handler.Block();
+  std::future<bool> running;
+  std::future<bool> pending;
+  {
+    AsyncTask<TestCode> task(handler, 4);
+    running = task.PostTask(TestCode::kRun, Context(0));
+    handler.WaitStarted(1);
+    pending = task.PostTask(TestCode::kRun, Context(1));
+
+    std::thread releaser([&handler] {
+      std::this_thread::sleep_for(milliseconds(50));
+      handler.Release();
+    });
+    releaser.detach();
+  }
+  EXPECT_TRUE(running.get());
+  EXPECT_FALSE(pending.get());
+}
+
+// A caller blocked on a full queue is released by the destructor, with a failed task.
+TEST(AsyncTask, DestructorReleasesBlockedCaller) {
+  TestHandler handler;
+  handler.Block();
+  std::future<bool> blocked;
+  std::atomic<bool> posted(false);
+  std::atomic<bool> released_by_post(false);
+  std::thread poster;
+  std::thread releaser;
+  {
+    AsyncTask<TestCode> task(handler, 1);
+    task.PostTask(TestCode::kRun, Context(0));
+    handler.WaitStarted(1);
+    task.PostTask(TestCode::kRun, Context(1));
+
+    poster = std::thread([&] {
+      blocked = task.PostTask(TestCode::kRun, Context(2));
+      posted = true;
+    });
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_FALSE(posted);
+
+    // The caller must be released while the running task is still blocked.
+    releaser = std::thread([&] {
+      for (int i = 0; i < 200 && !posted; i++) {
+        std::this_thread::sleep_for(milliseconds(10));
+      }
+      released_by_post = posted.load();
+      handler.Release();
+    });
+  }
+  releaser.join();
+  poster.join();
+  EXPECT_TRUE(released_by_post);
+  EXPECT_FALSE(blocked.get());
+  EXPECT_EQ(std::vector<int>({0}), handler.values());
+}
+
+// Tasks posted by the handler while the destructor runs fail instead of being queued.
+TEST(AsyncTask, PostFromHandlerWhileExiting) {
+  class PostingHandler : public AsyncTask<TestCode>::TaskHandler {
+   public:
+    void OnTask(const TestCode &, AsyncTask<TestCode>::TaskContext *) override {
+      std::this_thread::sleep_for(milliseconds(50));
+      result = task->PostTask(TestCode::kRun, Context(1));
+    }
+    AsyncTask<TestCode> *task = nullptr;
+    std::future<bool> result;
+  };
+
+  PostingHandler handler;
+  {
+    AsyncTask<TestCode> task(handler, 1);
+    handler.task = &task;
+    task.PostTask(TestCode::kRun, Context(0));
+    // Give the worker the time to pick the task up before destruction starts.
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  ASSERT_TRUE(handler.result.valid());
+  EXPECT_FALSE(handler.result.get());
+}
+
+}  // namespace sdm
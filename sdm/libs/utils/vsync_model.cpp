@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <utils/constants.h>
+#include <utils/vsync_model.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace sdm {
+
+VSyncModel::VSyncModel(int64_t error_threshold_ns, uint32_t history)
+  : error_threshold_ns_(error_threshold_ns),
+    history_((history < kMinSamples) ? kMinSamples : history) {
+  samples_.reserve(history_);
+}
+
+void VSyncModel::Reset(int64_t nominal_period_ns) {
+  nominal_period_ns_ = nominal_period_ns;
+  period_ns_ = nominal_period_ns;
+  phase_ns_ = 0;
+  period_error_ns_ = 0.0;
+  samples_.clear();
+  next_sample_ = 0;
+  locked_ = false;
+}
+
+bool VSyncModel::AddSample(int64_t timestamp_ns) {
+  if (period_ns_ <= 0) {
+    return false;
+  }
+
+  if (samples_.empty()) {
+    samples_.push_back(timestamp_ns);
+    phase_ns_ = timestamp_ns;
+    return true;
+  }
+
+  int64_t error = GetError(timestamp_ns);
+  if (std::abs(error) > error_threshold_ns_) {
+    // Period or phase has moved, start over from this sample.
+    Reset(nominal_period_ns_);
+    samples_.push_back(timestamp_ns);
+    phase_ns_ = timestamp_ns;
+    return false;
+  }
+
+  // The same vsync reported again.
+  int64_t latest = samples_[(next_sample_ + samples_.size() - 1) % samples_.size()];
+  if (std::abs(timestamp_ns - latest) < (period_ns_ / 2)) {
+    return true;
+  }
+
+  if (samples_.size() < history_) {
+    samples_.push_back(timestamp_ns);
+    next_sample_ = UINT32(samples_.size()) % history_;
+  } else {
+    samples_[next_sample_] = timestamp_ns;
+    next_sample_ = (next_sample_ + 1) % history_;
+  }
+  Fit();
+
+  return true;
+}
+
+int64_t VSyncModel::GetNextVSync(int64_t time_ns) const {
+  if (period_ns_ <= 0) {
+    return time_ns;
+  }
+
+  double periods = floor(static_cast<double>(time_ns - phase_ns_) / period_ns_);
+  return phase_ns_ + (static_cast<int64_t>(periods) + 1) * period_ns_;
+}
+
+int64_t VSyncModel::GetError(int64_t timestamp_ns) const {
+  if (period_ns_ <= 0) {
+    return 0;
+  }
+
+  int64_t elapsed = timestamp_ns - phase_ns_;
+  int64_t periods = llround(static_cast<double>(elapsed) / period_ns_);
+  return elapsed - (periods * period_ns_);
+}
+
+int64_t VSyncModel::GetPredictionHorizon() const {
+  if (!locked_) {
+    return 0;
+  }
+
+  // The error of the period adds up with every predicted vsync. Keep three standard errors of it
+  // within half the threshold, the other half is left to jitter and the error of the phase.
+  if (period_error_ns_ <= 0.0) {
+    return INT64_MAX;
+  }
+  double periods = static_cast<double>(error_threshold_ns_) / (6.0 * period_error_ns_);
+  if (periods >= static_cast<double>(INT64_MAX / period_ns_)) {
+    return INT64_MAX;
+  }
+
+  return static_cast<int64_t>(periods) * period_ns_;
+}
+
+void VSyncModel::Fit() {
+  // Least squares fit of timestamp = phase + period * n, where n is the vsync count of each
+  // sample relative to the first one. Sums are centered to keep precision on large timestamps.
+  size_t count = samples_.size();
+  int64_t base = samples_[0];
+  std::vector<double> n(count), t(count);
+  double mean_n = 0.0, mean_t = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    t[i] = static_cast<double>(samples_[i] - base);
+    n[i] = round(t[i] / period_ns_);
+    mean_n += n[i];
+    mean_t += t[i];
+  }
+  mean_n /= count;
+  mean_t /= count;
+
+  double covariance = 0.0, variance = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    covariance += (n[i] - mean_n) * (t[i] - mean_t);
+    variance += (n[i] - mean_n) * (n[i] - mean_n);
+  }
+  if (variance == 0.0) {
+    return;
+  }
+
+  double period = covariance / variance;
+  double intercept = mean_t - (period * mean_n);
+  period_ns_ = llround(period);
+  phase_ns_ = base + llround(intercept);
+
+  double residuals = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    double residual = t[i] - intercept - (period * n[i]);
+    residuals += residual * residual;
+  }
+  period_error_ns_ = 0.0;
+  if (count > 2) {
+    period_error_ns_ = sqrt(residuals / static_cast<double>(count - 2) / variance);
+  }
+
+  int64_t max_error = 0;
+  for (auto sample : samples_) {
+    max_error = std::max(max_error, std::abs(GetError(sample)));
+  }
+  locked_ = (count >= kMinSamples) && (max_error <= error_threshold_ns_);
+}
+
+}  // namespace sdm
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <utils/constants.h>
+#include <utils/vsync_model.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sdm {
+
+namespace {
+
+const int64_t kPeriod120 = 8333333;
+const int64_t kPeriod60 = 16666667;
+const int64_t kThreshold = 500000;
+// Start of the traces, in CLOCK_MONOTONIC, well away from 0 as on a device.
+const int64_t kBootTime = 3600LL * 1000000000LL;
+// Resync interval and samples of VSyncSynthesizer with the default properties.
+const int64_t kResyncInterval = 1000000000;
+const uint32_t kResyncSamples = 2;
+
+struct TraceParams {
+  int64_t period_ns = kPeriod120;
+  int64_t jitter_ns = 0;    // Timestamps are off by up to this much either way.
+  uint32_t drop_every = 0;  // Every nth vsync is not reported.
+  uint32_t seed = 1;
+};
+
+// Hardware vsync timestamps as the DRM event thread reports them, with scheduling jitter and
+// vsyncs missed while the thread was held up. The jitter comes from the raw mt19937 output,
+// so that a trace is the same with every standard library.
+std::vector<int64_t> MakeTrace(const TraceParams &params, uint32_t vsyncs,
+                               int64_t start = kBootTime) {
+  std::mt19937 random(params.seed);
+  std::vector<int64_t> trace;
+  for (uint32_t i = 0; i < vsyncs; i++) {
+    int64_t jitter = 0;
+    if (params.jitter_ns) {
+      jitter = static_cast<int64_t>(random() % (2 * params.jitter_ns + 1)) - params.jitter_ns;
+    }
+    if (params.drop_every && (i % params.drop_every) == params.drop_every - 1) {
+      continue;
+    }
+    trace.push_back(start + (params.period_ns * i) + jitter);
+  }
+
+  return trace;
+}
+
+// Feeds samples until the model locks. Returns the number of samples used, or 0 if it did not.
+uint32_t LockOn(VSyncModel *model, const std::vector<int64_t> &trace) {
+  for (uint32_t i = 0; i < trace.size(); i++) {
+    model->AddSample(trace[i]);
+    if (model->IsLocked()) {
+      return i + 1;
+    }
+  }
+
+  return 0;
+}
+
+// Largest distance between predicted vsyncs and the vsyncs of the trace, which is jitter free.
+int64_t MaxPredictionError(const VSyncModel &model, const std::vector<int64_t> &vsyncs) {
+  int64_t max_error = 0;
+  for (auto vsync : vsyncs) {
+    int64_t predicted = model.GetNextVSync(vsync - (model.GetPeriod() / 2));
+    max_error = std::max(max_error, std::abs(predicted - vsync));
+  }
+
+  return max_error;
+}
+
+struct ReplayResult {
+  uint32_t vsyncs = 0;
+  uint32_t interrupts = 0;  // Hardware vsyncs delivered while hardware vsync was enabled.
+  uint32_t misses = 0;
+  int64_t max_error_ns = 0;  // Largest error of a synthesized vsync against the hardware one.
+};
+
+// Replays a trace the way VSyncSynthesizer uses the model: hardware vsync stays on until the
+// model is locked and confirmed by kResyncSamples samples, then vsync is predicted until the
+// resync interval or the prediction horizon of the model is up, when hardware vsync comes back
+// on to check the model.
+ReplayResult Replay(const std::vector<int64_t> &trace, int64_t nominal_period_ns) {
+  VSyncModel model(kThreshold);
+  model.Reset(nominal_period_ns);
+  ReplayResult result = {};
+  result.vsyncs = UINT32(trace.size());
+  bool synthesizing = false;
+  int64_t resync_deadline = 0;
+  uint32_t resync_samples = 0;
+  for (auto timestamp : trace) {
+    if (synthesizing && timestamp < resync_deadline) {
+      int64_t predicted = model.GetNextVSync(timestamp - (model.GetPeriod() / 2));
+      result.max_error_ns = std::max(result.max_error_ns, std::abs(predicted - timestamp));
+      continue;
+    }
+    synthesizing = false;
+
+    result.interrupts++;
+    bool locked = model.IsLocked();
+    bool fits = model.AddSample(timestamp);
+    if (!fits) {
+      result.misses += locked;
+      resync_samples = 0;
+      continue;
+    }
+    if (model.IsLocked() && (++resync_samples >= kResyncSamples)) {
+      synthesizing = true;
+      resync_deadline = timestamp + std::min(kResyncInterval, model.GetPredictionHorizon());
+      resync_samples = 0;
+    }
+  }
+
+  return result;
+}
+
+}  // namespace
+
+TEST(VSyncModel, LocksOnCleanTrace) {
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod120);
+  std::vector<int64_t> trace = MakeTrace(TraceParams(), 20);
+
+  EXPECT_EQ(VSyncModel::kMinSamples, LockOn(&model, trace));
+  EXPECT_NEAR(kPeriod120, model.GetPeriod(), 1);
+  EXPECT_EQ(trace[10], model.GetNextVSync(trace[9]));
+  EXPECT_EQ(0, model.GetError(trace[15]));
+}
+
+// A 120 Hz trace with scheduling jitter and missed vsyncs, predicted for one second ahead.
+TEST(VSyncModel, JitteredTraceWithMissedVSyncs) {
+  TraceParams params;
+  params.jitter_ns = 30000;
+  params.drop_every = 5;
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod120);
+  std::vector<int64_t> trace = MakeTrace(params, 24);
+
+  uint32_t used = LockOn(&model, trace);
+  ASSERT_NE(0u, used);
+  EXPECT_LE(used, VSyncModel::kMinSamples + 2);
+  for (size_t i = used; i < trace.size(); i++) {
+    EXPECT_TRUE(model.AddSample(trace[i]));
+  }
+  EXPECT_NEAR(kPeriod120, model.GetPeriod(), 2000);
+
+  std::vector<int64_t> ahead = MakeTrace(TraceParams(), 120, kBootTime + kPeriod120 * 30);
+  int64_t max_error = MaxPredictionError(model, ahead);
+  EXPECT_LT(max_error, kThreshold);
+  ::testing::Test::RecordProperty("prediction_error_1s_us", std::to_string(max_error / 1000));
+}
+
+// Panels run off the nominal rate, the model follows the measured period.
+TEST(VSyncModel, FollowsOffNominalPanel) {
+  TraceParams params;
+  params.period_ns = kPeriod120 + 25000;
+  params.jitter_ns = 10000;
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod120);
+  std::vector<int64_t> trace = MakeTrace(params, 12);
+
+  ASSERT_NE(0u, LockOn(&model, trace));
+  EXPECT_NEAR(params.period_ns, model.GetPeriod(), 2000);
+}
+
+// The same vsync reported twice, as when hardware vsync is re-armed, counts once.
+TEST(VSyncModel, DuplicateTimestampIsIgnored) {
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod120);
+  std::vector<int64_t> trace = MakeTrace(TraceParams(), VSyncModel::kMinSamples);
+  for (size_t i = 0; i + 1 < trace.size(); i++) {
+    EXPECT_TRUE(model.AddSample(trace[i]));
+    EXPECT_TRUE(model.AddSample(trace[i] + 1000));
+  }
+  EXPECT_FALSE(model.IsLocked());
+  EXPECT_TRUE(model.AddSample(trace.back()));
+  EXPECT_TRUE(model.IsLocked());
+}
+
+TEST(VSyncModel, PhaseJumpRestartsTheModel) {
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod120);
+  std::vector<int64_t> trace = MakeTrace(TraceParams(), 12);
+  ASSERT_NE(0u, LockOn(&model, trace));
+
+  // The panel restarted its timing engine 2 ms off the old phase.
+  int64_t restart = trace.back() + kPeriod120 + 2000000;
+  std::vector<int64_t> shifted = MakeTrace(TraceParams(), 12, restart);
+  EXPECT_FALSE(model.AddSample(shifted[0]));
+  EXPECT_FALSE(model.IsLocked());
+  EXPECT_EQ(VSyncModel::kMinSamples - 1,
+            LockOn(&model, std::vector<int64_t>(shifted.begin() + 1, shifted.end())));
+  EXPECT_EQ(0, model.GetError(shifted.back()));
+}
+
+// After a refresh rate change the model is reset to the new nominal period and locks again.
+TEST(VSyncModel, RefreshRateChange) {
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod60);
+  TraceParams params;
+  params.period_ns = kPeriod60;
+  std::vector<int64_t> trace = MakeTrace(params, 12);
+  ASSERT_NE(0u, LockOn(&model, trace));
+
+  std::vector<int64_t> fast = MakeTrace(TraceParams(), 12, trace.back() + kPeriod120);
+  // 120 Hz vsyncs fall halfway between 60 Hz ones.
+  EXPECT_FALSE(model.AddSample(fast[0]));
+
+  model.Reset(kPeriod120);
+  EXPECT_EQ(VSyncModel::kMinSamples, LockOn(&model, fast));
+  EXPECT_NEAR(kPeriod120, model.GetPeriod(), 1);
+}
+
+TEST(VSyncModel, NoPeriodNoModel) {
+  VSyncModel model(kThreshold);
+  model.Reset(0);
+  EXPECT_FALSE(model.AddSample(kBootTime));
+  EXPECT_FALSE(model.IsLocked());
+  EXPECT_EQ(kBootTime, model.GetNextVSync(kBootTime));
+  EXPECT_EQ(0, model.GetError(kBootTime));
+}
+
+// A model fitted to jittery samples predicts less far, and further once the samples span more
+// time. A model fitted to exact samples predicts as far as asked.
+TEST(VSyncModel, PredictionHorizon) {
+  VSyncModel model(kThreshold);
+  model.Reset(kPeriod120);
+  EXPECT_EQ(0, model.GetPredictionHorizon());
+  ASSERT_NE(0u, LockOn(&model, MakeTrace(TraceParams(), 12)));
+  EXPECT_EQ(INT64_MAX, model.GetPredictionHorizon());
+
+  TraceParams params;
+  params.jitter_ns = 30000;
+  std::vector<int64_t> trace = MakeTrace(params, 240);
+  model.Reset(kPeriod120);
+  ASSERT_NE(0u, LockOn(&model, trace));
+  int64_t horizon = model.GetPredictionHorizon();
+  EXPECT_GT(horizon, 0);
+  EXPECT_LT(horizon, kResyncInterval);
+
+  // Resync samples a while later.
+  EXPECT_TRUE(model.AddSample(trace[100]));
+  EXPECT_TRUE(model.AddSample(trace[101]));
+  EXPECT_GT(model.GetPredictionHorizon(), horizon);
+}
+
+// Ten seconds at 120 Hz with jitter and missed vsyncs: hardware vsync is needed for a handful of
+// samples per resync interval, and synthesized vsyncs stay within the error threshold.
+TEST(VSyncModel, InterruptReduction) {
+  ReplayResult total = {};
+  for (uint32_t seed = 1; seed <= 10; seed++) {
+    TraceParams params;
+    params.jitter_ns = 30000;
+    params.drop_every = 7;
+    params.seed = seed;
+    ReplayResult result = Replay(MakeTrace(params, 1200), kPeriod120);
+
+    EXPECT_EQ(0u, result.misses) << "seed " << seed;
+    EXPECT_LT(result.max_error_ns, kThreshold) << "seed " << seed;
+    total.vsyncs += result.vsyncs;
+    total.interrupts += result.interrupts;
+    total.max_error_ns = std::max(total.max_error_ns, result.max_error_ns);
+  }
+
+  EXPECT_LT(total.interrupts * 20, total.vsyncs);
+  ::testing::Test::RecordProperty("vsyncs", std::to_string(total.vsyncs));
+  ::testing::Test::RecordProperty("hw_interrupts", std::to_string(total.interrupts));
+  ::testing::Test::RecordProperty("max_error_us", std::to_string(total.max_error_ns / 1000));
+}
+
+// A trace with a 2 ms phase jump halfway: the jump shows up as a miss at the next resync, after
+// which hardware vsync stays on until the model locks again.
+TEST(VSyncModel, ReplayRecoversFromPhaseJump) {
+  TraceParams params;
+  params.jitter_ns = 30000;
+  std::vector<int64_t> trace = MakeTrace(params, 600);
+  std::vector<int64_t> shifted = MakeTrace(params, 600, trace.back() + kPeriod120 + 2000000);
+  trace.insert(trace.end(), shifted.begin(), shifted.end());
+  ReplayResult result = Replay(trace, kPeriod120);
+
+  EXPECT_EQ(1u, result.misses);
+  EXPECT_LT(result.interrupts * 20, result.vsyncs);
+}
+
+}  // namespace sdm